@@ -0,0 +1,266 @@
+#!/usr/bin/env python3
+"""Builds the stress projects `make PLATFORM=headless bench` runs.
+
+Every project runs the same way each time (no random numbers, no timers), so
+results only change when the runtime does. Run from anywhere:
+    python3 bench/generate.py
+"""
+import hashlib
+import json
+import os
+import zipfile
+
+BENCH_FOLDER = os.path.dirname(os.path.abspath(__file__))
+
+STAGE_SVG = b'<svg xmlns="http://www.w3.org/2000/svg" width="480" height="360"><rect width="480" height="360" fill="#ffffff"/></svg>'
+DOT_SVG = b'<svg xmlns="http://www.w3.org/2000/svg" width="16" height="16"><circle cx="8" cy="8" r="8" fill="#4c97ff"/></svg>'
+ARROW_SVG = b'<svg xmlns="http://www.w3.org/2000/svg" width="40" height="20"><rect width="30" height="20" fill="#ff8c1a"/><rect x="30" y="5" width="10" height="10" fill="#cf63cf"/></svg>'
+
+
+def md5(data):
+    return hashlib.md5(data).hexdigest()
+
+
+def num(value):
+    return [1, [4, str(value)]]
+
+
+def text(value):
+    return [1, [10, str(value)]]
+
+
+class Target:
+    """One sprite (or the Stage) and its scripts, with block IDs made up as they're added."""
+
+    def __init__(self, name, costume, is_stage=False):
+        self.name = name
+        self.costume = costume
+        self.is_stage = is_stage
+        self.blocks = {}
+        self.variables = {}
+        self.lists = {}
+        self.count = 0
+
+    def variable(self, name):
+        self.variables[name] = [name, 0]
+        return name
+
+    def list(self, name):
+        self.lists[name] = [name, []]
+        return name
+
+    def block(self, opcode, inputs=None, fields=None, shadow=False, mutation=None):
+        self.count += 1
+        block_id = "%s%d" % (self.name[0].lower(), self.count)
+        block = {"opcode": opcode, "next": None, "parent": None, "inputs": inputs or {}, "fields": fields or {},
+                 "shadow": shadow, "topLevel": False}
+        if mutation:
+            block["mutation"] = dict(mutation, tagName="mutation", children=[])
+        self.blocks[block_id] = block
+        for value in block["inputs"].values():
+            if isinstance(value[1], str) and value[1] in self.blocks:
+                self.blocks[value[1]]["parent"] = block_id
+        return block_id
+
+    def report(self, opcode, inputs=None, fields=None):
+        return [3, self.block(opcode, inputs, fields), [10, ""]]
+
+    def var(self, name):
+        return [3, [12, name, name], [10, ""]]
+
+    def condition(self, opcode, inputs, fields=None):
+        return [2, self.block(opcode, inputs, fields)]
+
+    def stack(self, *block_ids):
+        """Links blocks one after another, and gives back an input for C blocks to hold them."""
+        for previous, current in zip(block_ids, block_ids[1:]):
+            self.blocks[previous]["next"] = current
+            self.blocks[current]["parent"] = previous
+        return [2, block_ids[0]]
+
+    def script(self, hat, *block_ids):
+        self.blocks[hat]["topLevel"] = True
+        self.blocks[hat]["x"] = 0
+        self.blocks[hat]["y"] = len(self.blocks) * 10
+        self.stack(hat, *block_ids)
+
+    def procedure(self, proccode, argument_names):
+        """Adds a custom block that runs without screen refresh, and gives back a function that makes calls to it."""
+        argument_ids = ["%s_%s" % (proccode.split(" ")[0], name) for name in argument_names]
+        mutation = {"proccode": proccode, "argumentids": json.dumps(argument_ids), "warp": "true"}
+        prototype_inputs = {}
+        for argument_id, name in zip(argument_ids, argument_names):
+            prototype_inputs[argument_id] = [1, self.block("argument_reporter_string_number", fields={"VALUE": [name, None]}, shadow=True)]
+        prototype = self.block("procedures_prototype", prototype_inputs, shadow=True, mutation=dict(
+            mutation, argumentnames=json.dumps(argument_names), argumentdefaults=json.dumps([""] * len(argument_names))))
+        definition = self.block("procedures_definition", {"custom_block": [1, prototype]})
+        self.blocks[prototype]["parent"] = definition
+
+        def call(*arguments):
+            return self.block("procedures_call", dict(zip(argument_ids, arguments)), mutation=mutation)
+
+        return definition, call
+
+    def argument(self, name):
+        return self.report("argument_reporter_string_number", fields={"VALUE": [name, None]})
+
+    def to_json(self, layer):
+        costume = self.costume
+        target = {"isStage": self.is_stage, "name": self.name, "variables": self.variables, "lists": self.lists,
+                  "broadcasts": {}, "blocks": self.blocks, "comments": {}, "currentCostume": 0,
+                  "costumes": [{"name": "costume", "dataFormat": "svg", "assetId": md5(costume), "md5ext": md5(costume) + ".svg",
+                                "rotationCenterX": 240 if self.is_stage else 8, "rotationCenterY": 180 if self.is_stage else 8}],
+                  "sounds": [], "volume": 100, "layerOrder": layer}
+        if self.is_stage:
+            target.update({"tempo": 60, "videoTransparency": 50, "videoState": "on", "textToSpeechLanguage": None})
+        else:
+            target.update({"visible": True, "x": 0, "y": 0, "size": 100, "direction": 90, "draggable": False, "rotationStyle": "all around"})
+        return target
+
+
+def save(file_name, stage, sprites, extensions=()):
+    targets = [stage.to_json(0)] + [sprite.to_json(layer + 1) for layer, sprite in enumerate(sprites)]
+    project = {"targets": targets, "monitors": [], "extensions": list(extensions), "meta": {"semver": "3.0.0", "vm": "0.2.0", "agent": ""}}
+    files = {"project.json": json.dumps(project).encode()}
+    for target in [stage] + sprites:
+        files[md5(target.costume) + ".svg"] = target.costume
+    # a fixed date keeps the files the same every time they're generated
+    with zipfile.ZipFile(os.path.join(BENCH_FOLDER, file_name), "w", zipfile.ZIP_DEFLATED) as archive:
+        for name, data in files.items():
+            archive.writestr(zipfile.ZipInfo(name, (1980, 1, 1, 0, 0, 0)), data, zipfile.ZIP_DEFLATED)
+
+
+def clone_storm():
+    """Keeps close to the clone limit, with every clone moving and bouncing, and more clones while space is held."""
+    stage = Target("Stage", STAGE_SVG, is_stage=True)
+    stage.variable("spawned")
+    dot = Target("Dot", DOT_SVG)
+
+    def create_clone():
+        menu = dot.block("control_create_clone_of_menu", fields={"CLONE_OPTION": ["_myself_", None]}, shadow=True)
+        return dot.block("control_create_clone_of", {"CLONE_OPTION": [1, menu]})
+
+    dot.script(dot.block("event_whenflagclicked"),
+               dot.block("looks_hide"),
+               dot.block("control_forever", {"SUBSTACK": dot.stack(
+                   dot.block("control_repeat", {"TIMES": num(8), "SUBSTACK": dot.stack(create_clone())}))}))
+    dot.script(dot.block("control_start_as_clone"),
+               dot.block("data_changevariableby", {"VALUE": num(1)}, {"VARIABLE": ["spawned", "spawned"]}),
+               dot.block("motion_gotoxy", {"X": num(0), "Y": num(0)}),
+               dot.block("motion_pointindirection", {"DIRECTION": dot.report("operator_mod", {
+                   "NUM1": dot.report("operator_multiply", {"NUM1": dot.var("spawned"), "NUM2": num(37)}), "NUM2": num(360)})}),
+               dot.block("looks_show"),
+               dot.block("control_repeat", {"TIMES": num(40), "SUBSTACK": dot.stack(
+                   dot.block("motion_movesteps", {"STEPS": num(6)}),
+                   dot.block("motion_ifonedgebounce"),
+                   dot.block("motion_turnright", {"DEGREES": num(3)}))}),
+               dot.block("control_delete_this_clone"))
+    dot.script(dot.block("event_whenkeypressed", fields={"KEY_OPTION": ["space", None]}),
+               dot.block("control_repeat", {"TIMES": num(20), "SUBSTACK": dot.stack(create_clone())}))
+    save("cloneStorm.sb3", stage, [dot])
+
+
+def list_crunching():
+    """Fills a list with 2000 numbers every frame, then sums it, rewrites half of it as text and searches it."""
+    stage = Target("Stage", STAGE_SVG, is_stage=True)
+    for name in ("i", "sum", "hits"):
+        stage.variable(name)
+    stage.list("numbers")
+    crunch = Target("Cruncher", DOT_SVG)
+    numbers = {"LIST": ["numbers", "numbers"]}
+
+    def set_variable(name, value):
+        return crunch.block("data_setvariableto", {"VALUE": value}, {"VARIABLE": [name, name]})
+
+    def change_variable(name, value):
+        return crunch.block("data_changevariableby", {"VALUE": value}, {"VARIABLE": [name, name]})
+
+    definition, call = crunch.procedure("crunch", [])
+    crunch.script(definition,
+                  crunch.block("data_deletealloflist", fields=numbers),
+                  set_variable("i", num(0)),
+                  crunch.block("control_repeat", {"TIMES": num(2000), "SUBSTACK": crunch.stack(
+                      change_variable("i", num(1)),
+                      crunch.block("data_addtolist", {"ITEM": crunch.report("operator_mod", {
+                          "NUM1": crunch.report("operator_multiply", {"NUM1": crunch.var("i"), "NUM2": num(7919)}), "NUM2": num(1000)})}, numbers))}),
+                  set_variable("sum", num(0)),
+                  set_variable("i", num(0)),
+                  crunch.block("control_repeat", {"TIMES": crunch.report("data_lengthoflist", fields=numbers), "SUBSTACK": crunch.stack(
+                      change_variable("i", num(1)),
+                      change_variable("sum", crunch.report("data_itemoflist", {"INDEX": crunch.var("i")}, numbers)))}),
+                  set_variable("i", num(0)),
+                  crunch.block("control_repeat", {"TIMES": num(1000), "SUBSTACK": crunch.stack(
+                      change_variable("i", num(2)),
+                      crunch.block("data_replaceitemoflist", {"INDEX": crunch.var("i"), "ITEM": crunch.report("operator_join", {
+                          "STRING1": crunch.report("data_itemoflist", {"INDEX": crunch.var("i")}, numbers), "STRING2": text("x")})}, numbers))}),
+                  crunch.block("control_if", {"CONDITION": crunch.condition("data_listcontainsitem", {"ITEM": text("919x")}, numbers),
+                                              "SUBSTACK": crunch.stack(change_variable("hits", num(1)))}))
+    crunch.script(crunch.block("event_whenflagclicked"),
+                  crunch.block("looks_hide"),
+                  crunch.block("control_forever", {"SUBSTACK": crunch.stack(call())}))
+    save("listCrunching.sb3", stage, [crunch])
+
+
+def deep_calls():
+    """Runs a tree of custom blocks 11 levels deep every frame, where every level calls the next one twice.
+
+    This stands in for deep recursion, since a custom block that calls itself never finishes in this runtime yet:
+    arguments and the state of a call are kept once per block, not once per call.
+    """
+    stage = Target("Stage", STAGE_SVG, is_stage=True)
+    stage.variable("result")
+    calls = Target("Calls", DOT_SVG)
+
+    levels = [calls.procedure("level%d %%s" % level, ["n"]) for level in range(11)]
+    for (definition, _), (_, call_next) in zip(levels, levels[1:]):
+        calls.script(definition,
+                     call_next(calls.report("operator_add", {"NUM1": calls.argument("n"), "NUM2": num(1)})),
+                     call_next(calls.report("operator_multiply", {"NUM1": calls.argument("n"), "NUM2": num(2)})))
+    calls.script(levels[-1][0], calls.block("data_changevariableby", {"VALUE": calls.argument("n")}, {"VARIABLE": ["result", "result"]}))
+
+    calls.script(calls.block("event_whenflagclicked"),
+                 calls.block("looks_hide"),
+                 calls.block("control_forever", {"SUBSTACK": calls.stack(
+                     calls.block("data_setvariableto", {"VALUE": num(0)}, {"VARIABLE": ["result", "result"]}),
+                     levels[0][1](num(1)))}))
+    save("deepCalls.sb3", stage, [calls])
+
+
+def pen_heavy():
+    """Clears the pen every frame, then draws 400 lines in changing colors and 36 stamps."""
+    stage = Target("Stage", STAGE_SVG, is_stage=True)
+    stage.variable("i")
+    pen = Target("Pen", ARROW_SVG)
+
+    color_menu = pen.block("pen_menu_colorParam", fields={"colorParam": ["color", None]}, shadow=True)
+    draw, call_draw = pen.procedure("draw", [])
+    pen.script(draw,
+               pen.block("pen_clear"),
+               pen.block("pen_penUp"),
+               pen.block("motion_gotoxy", {"X": num(-240), "Y": num(-180)}),
+               pen.block("pen_setPenSizeTo", {"SIZE": num(3)}),
+               pen.block("pen_penDown"),
+               pen.block("control_repeat", {"TIMES": num(400), "SUBSTACK": pen.stack(
+                   pen.block("data_changevariableby", {"VALUE": num(1)}, {"VARIABLE": ["i", "i"]}),
+                   pen.block("pen_changePenColorParamBy", {"COLOR_PARAM": [1, color_menu], "VALUE": num(2)}),
+                   pen.block("motion_gotoxy", {
+                       "X": pen.report("operator_subtract", {"NUM1": pen.report("operator_mod", {
+                           "NUM1": pen.report("operator_multiply", {"NUM1": pen.var("i"), "NUM2": num(37)}), "NUM2": num(480)}), "NUM2": num(240)}),
+                       "Y": pen.report("operator_subtract", {"NUM1": pen.report("operator_mod", {
+                           "NUM1": pen.report("operator_multiply", {"NUM1": pen.var("i"), "NUM2": num(53)}), "NUM2": num(360)}), "NUM2": num(180)})}))}),
+               pen.block("pen_penUp"),
+               pen.block("motion_gotoxy", {"X": num(0), "Y": num(0)}),
+               pen.block("control_repeat", {"TIMES": num(36), "SUBSTACK": pen.stack(
+                   pen.block("motion_turnright", {"DEGREES": num(10)}),
+                   pen.block("motion_movesteps", {"STEPS": num(4)}),
+                   pen.block("pen_stamp"))}))
+    pen.script(pen.block("event_whenflagclicked"),
+               pen.block("control_forever", {"SUBSTACK": pen.stack(call_draw())}))
+    save("penHeavy.sb3", stage, [pen], ["pen"])
+
+
+if __name__ == "__main__":
+    clone_storm()
+    list_crunching()
+    deep_calls()
+    pen_heavy()
@@ -0,0 +1,230 @@
+// Microbenchmarks for the primitives every block goes through: Value math and conversions, number parsing,
+// variable access and collision. Built with `make PLATFORM=pc microbench` (or `PLATFORM=headless`),
+// which links against the runtime without its main(), so no window gets opened.
+// Usage: Scratch-microbench [filter], to only run benchmarks with `filter` in their name.
+#include "blockExecutor.hpp"
+#include "input.hpp"
+#include "interpret.hpp"
+#include "math.hpp"
+#include "sprite.hpp"
+#include "value.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+// GCC can't tell these replace the global operators, so it warns about memory from `new` going to `free()`
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// every allocation in the process gets counted, so each benchmark can report how many it made per operation
+static std::atomic<size_t> allocationCount{0};
+
+void *operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+// results get added to this, so the compiler can't skip the work that made them
+static volatile double sink = 0;
+
+// how long each benchmark runs for, after working out how many operations fit in it
+static constexpr double TARGET_MS = 200;
+
+static const char *filter = nullptr;
+
+template <typename Function>
+static void run(const char *name, Function &&operation) {
+    if (filter && std::string(name).find(filter) == std::string::npos) return;
+
+    using Clock = std::chrono::steady_clock;
+    size_t iterations = 1;
+    double elapsedMs = 0;
+    size_t allocations = 0;
+
+    // double the iterations until a run takes long enough to time well
+    while (true) {
+        const size_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        const auto start = Clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            operation(i);
+        }
+        elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        allocations = allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+        if (elapsedMs >= TARGET_MS || iterations >= (size_t(1) << 40)) break;
+        iterations = elapsedMs > 1 ? static_cast<size_t>(iterations * TARGET_MS / elapsedMs) + 1 : iterations * 2;
+    }
+
+    std::printf("%-44s %12.2f ns/op %10.2f allocs/op\n", name, elapsedMs * 1e6 / iterations,
+                static_cast<double>(allocations) / iterations);
+}
+
+static Sprite *makeSprite(const std::string &name, double x, double y) {
+    Sprite *sprite = new Sprite();
+    sprite->name = name;
+    sprite->id = name;
+    sprite->isStage = false;
+    sprite->isClone = false;
+    sprite->visible = true;
+    sprite->toDelete = false;
+    sprite->draggable = false;
+    sprite->xPosition = x;
+    sprite->yPosition = y;
+    sprite->size = 100;
+    sprite->rotation = 90;
+    sprite->rotationStyle = Sprite::ALL_AROUND;
+    sprite->spriteWidth = 96;
+    sprite->spriteHeight = 100;
+    sprite->rotationCenterX = 48;
+    sprite->rotationCenterY = 50;
+    return sprite;
+}
+
+static void benchValues() {
+    const Value integer(42);
+    const Value decimal(3.75);
+    const Value numericString(std::string("123.5"));
+    const Value hexString(std::string("0x1F"));
+    const Value exponentString(std::string("-1.5e3"));
+    const Value text(std::string("apple"));
+    const Value boolean(true);
+
+    run("Value int + int", [&](size_t) { sink = sink + (integer + integer).asDouble(); });
+    run("Value double * double", [&](size_t) { sink = sink + (decimal * decimal).asDouble(); });
+    run("Value numeric string + int", [&](size_t) { sink = sink + (numericString + integer).asDouble(); });
+    run("Value non-numeric string + int", [&](size_t) { sink = sink + (text + integer).asDouble(); });
+    run("Value hex string asDouble", [&](size_t) { sink = sink + hexString.asDouble(); });
+    run("Value exponent string asDouble", [&](size_t) { sink = sink + exponentString.asDouble(); });
+    run("Value numeric string asInt", [&](size_t) { sink = sink + numericString.asInt(); });
+    run("Value double asString", [&](size_t) { sink = sink + decimal.asString().size(); });
+    run("Value int == numeric string", [&](size_t) { sink = sink + (integer == numericString); });
+    run("Value string == string", [&](size_t) { sink = sink + (text == text); });
+    run("Value numeric string < int", [&](size_t) { sink = sink + (numericString < integer); });
+    run("Value string < bool", [&](size_t) { sink = sink + (text < boolean); });
+    run("Value copy string", [&](size_t) { Value copy = text; sink = sink + copy.isString(); });
+
+    const nlohmann::json jsonNumber = "-12.25";
+    run("Value::fromJson numeric string", [&](size_t) { sink = sink + Value::fromJson(jsonNumber).asDouble(); });
+}
+
+static void benchNumbers() {
+    const std::string decimal = "-12.25";
+    const std::string exponent = "6.02e23";
+    const std::string hex = "0x1F";
+    const std::string word = "hello world";
+    const std::string empty = "";
+
+    run("Math::isNumber decimal", [&](size_t) { sink = sink + Math::isNumber(decimal); });
+    run("Math::isNumber exponent", [&](size_t) { sink = sink + Math::isNumber(exponent); });
+    run("Math::isNumber hex", [&](size_t) { sink = sink + Math::isNumber(hex); });
+    run("Math::isNumber word", [&](size_t) { sink = sink + Math::isNumber(word); });
+    run("Math::isNumber empty", [&](size_t) { sink = sink + Math::isNumber(empty); });
+}
+
+static void addVariable(Sprite *sprite, const std::string &id, const Value &value) {
+    Variable variable;
+    variable.id = id;
+    variable.name = id;
+    variable.value = value;
+    sprite->variables[id] = variable;
+}
+
+static void benchVariables(Sprite *stage, Sprite *sprite) {
+    addVariable(stage, "global", Value(1));
+    addVariable(sprite, "local", Value(2));
+    List list;
+    list.id = "list";
+    list.name = "list";
+    for (int i = 0; i < 100; i++) {
+        list.items.push_back(Value(i));
+    }
+    sprite->lists["list"] = list;
+
+    run("getVariableValue local", [&](size_t) { sink = sink + BlockExecutor::getVariableValue("local", sprite).asDouble(); });
+    run("getVariableValue global", [&](size_t) { sink = sink + BlockExecutor::getVariableValue("global", sprite).asDouble(); });
+    run("getVariableValue missing (1000 clones)", [&](size_t) { sink = sink + BlockExecutor::getVariableValue("missing", sprite).asDouble(); });
+    run("getVariableValue list of 100", [&](size_t) { sink = sink + BlockExecutor::getVariableValue("list", sprite).asString().size(); });
+
+    const Value number(5);
+    const Value text(std::string("some text"));
+    run("setVariableValue local number", [&](size_t) { BlockExecutor::setVariableValue("local", number, sprite); });
+    run("setVariableValue global number", [&](size_t) { BlockExecutor::setVariableValue("global", number, sprite); });
+    run("setVariableValue local string", [&](size_t) { BlockExecutor::setVariableValue("local", text, sprite); });
+}
+
+static void benchCollision(Sprite *sprite, Sprite *target) {
+    sprite->rotation = 75;
+    Input::mousePointer.x = 10;
+    Input::mousePointer.y = 10;
+
+    run("getCollisionPoints", [&](size_t) { sink = sink + getCollisionPoints(sprite)[0].first; });
+    run("isColliding mouse", [&](size_t) { sink = sink + isColliding("mouse", sprite); });
+    run("isColliding edge", [&](size_t) { sink = sink + isColliding("edge", sprite); });
+    run("isColliding sprite, overlapping", [&](size_t) { sink = sink + isColliding("sprite", sprite, target); });
+
+    target->xPosition = 300;
+    run("isColliding sprite, apart", [&](size_t) { sink = sink + isColliding("sprite", sprite, target); });
+
+    // the original is hidden, so the lookup by name has to go through the clones
+    target->visible = false;
+    run("isColliding by name (1000 clones)", [&](size_t) { sink = sink + isColliding("sprite", sprite, nullptr, "Target"); });
+    target->visible = true;
+    target->xPosition = 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) filter = argv[1];
+
+    // the Stage goes first like in a loaded project, with the clones made while it runs after every original sprite
+    Sprite *stage = makeSprite("Stage", 0, 0);
+    stage->isStage = true;
+    Sprite *sprite = makeSprite("Player", 0, 0);
+    Sprite *target = makeSprite("Target", 20, 10);
+    sprites = {stage, sprite, target};
+    spriteLookup["_stage_"] = stage;
+    spriteLookup["Player"] = sprite;
+    spriteLookup["Target"] = target;
+    for (int i = 0; i < 1000; i++) {
+        Sprite *clone = makeSprite("Target", (i % 40) * 12 - 240, (i / 40) * 14 - 180);
+        clone->isClone = true;
+        clone->visible = i == 999;
+        sprites.push_back(clone);
+    }
+
+    benchValues();
+    benchNumbers();
+    benchVariables(stage, sprite);
+    benchCollision(sprite, target);
+
+    for (Sprite *toFree : sprites) {
+        delete toFree;
+    }
+    sprites.clear();
+    spriteLookup.clear();
+    return 0;
+}
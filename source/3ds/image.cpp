@@ -1,6 +1,13 @@
 #include "image.hpp"
+#include "../scratch/costumePrefetch.hpp"
+#include "../scratch/effects.hpp"
+#include "../scratch/frameScheduler.hpp"
+#include "../scratch/lruCache.hpp"
 #include "../scratch/os.hpp"
+#include "../scratch/renderState.hpp"
+#include "../scratch/texturePolicy.hpp"
 #include <algorithm>
+#include <deque>
 #include <iostream>
 #include <vector>
 #define STBI_NO_GIF
@@ -19,8 +26,52 @@ std::unordered_map<std::string, ImageData> imageC2Ds;
 std::vector<imageRGBA> imageRGBAS;
 static std::vector<imageRGBA *> imageLoadQueue;
 static std::vector<std::string> toDelete;
+static std::deque<std::string> prefetchQueue;
 #define MAX_IMAGE_VRAM 30000000
 
+// frames a `C2D_Image` can go unused before it's freed
+#define MAX_UNUSED_FRAMES 240
+
+// fractions of the RAM or VRAM budget where images start getting freed before they expire, and where that stops
+#define LOW_MEMORY_START 0.8
+#define LOW_MEMORY_STOP 0.5
+
+// every `C2D_Image` by when it was last drawn
+static LruCache imageCache(MAX_UNUSED_FRAMES);
+
+// costumes with graphic effects applied, by `Effects::getCacheKey()`
+static std::unordered_map<std::string, ImageData> effectC2Ds;
+static LruCache effectImageCache(MAX_UNUSED_FRAMES);
+
+// textures can't be bigger than 1024x1024, so most SVGs only have room to double
+#define MAX_SVG_RESOLUTION 2
+
+// an SVG costume waiting to be rasterized bigger than its native size
+struct SVGRasterJob {
+    std::string key;
+    std::string costumeId;
+    std::string fileName;
+    int resolution;
+};
+
+// SVG costumes rasterized bigger than their native size, by costume ID and resolution
+static std::unordered_map<std::string, ImageData> svgC2Ds;
+static std::deque<SVGRasterJob> svgQueue;
+static LruCache svgImageCache(MAX_UNUSED_FRAMES);
+
+/**
+ * Starts freeing a `C2D_Image` once it goes unused, as the most recently used one.
+ */
+static void trackImage(const std::string &id, size_t memorySize) {
+    ImageData &data = imageC2Ds[id];
+    data.cache = &imageCache;
+    data.cacheEntry = imageCache.add(id, memorySize);
+}
+
+void ImageData::markUsed() {
+    if (cache) cache->touch(cacheEntry);
+}
+
 const u32 next_pow2(u32 n) {
     n--;
     n |= n >> 1;
@@ -77,7 +128,7 @@ void Image::render(double xPos, double yPos, bool centered) {
     });
     if (rgbaIt != imageRGBAS.end()) {
         if (imageC2Ds.find(rgbaIt->name) != imageC2Ds.end()) {
-            imageC2Ds[rgbaIt->name].freeTimer = 240;
+            imageC2Ds[rgbaIt->name].markUsed();
             C2D_ImageTint tinty;
             C2D_AlphaImageTint(&tinty, opacity);
 
@@ -246,6 +297,7 @@ bool Image::loadImageFromFile(std::string filePath, bool fromScratchProject) {
 
     newRGBA.name = path2;
     newRGBA.fullName = filename;
+    newRGBA.isCostume = fromScratchProject;
     newRGBA.width = width;
     newRGBA.height = height;
     newRGBA.textureWidth = clamp(next_pow2(newRGBA.width), 64, 1024);
@@ -347,6 +399,7 @@ void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId)
     // Set up the image data structure
     newRGBA.name = imageId;
     newRGBA.fullName = costumeId;
+    newRGBA.isCostume = true;
     newRGBA.width = width;
     newRGBA.height = height;
     newRGBA.textureWidth = clamp(next_pow2(newRGBA.width), 64, 1024);
@@ -366,9 +419,9 @@ void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId)
 }
 
 /**
- * Loads SVG data and converts it to RGBA pixel data
+ * Loads SVG data and converts it to RGBA pixel data, `resolution` times its native size if that still fits in a texture
  */
-unsigned char *SVGToRGBA(const void *svg_data, size_t svg_size, int &width, int &height) {
+unsigned char *SVGToRGBA(const void *svg_data, size_t svg_size, int &width, int &height, int resolution) {
     // Create a null-terminated string from the SVG data
     char *svg_string = (char *)malloc(svg_size + 1);
     if (!svg_string) {
@@ -401,6 +454,7 @@ unsigned char *SVGToRGBA(const void *svg_data, size_t svg_size, int &width, int
     // Clamp to 3DS limits
     width = clamp(width, 64, 1024);
     height = clamp(height, 64, 1024);
+    if (width * resolution > 1024 || height * resolution > 1024) resolution = 1;
 
     // Create rasterizer
     NSVGrasterizer *rast = nsvgCreateRasterizer();
@@ -426,6 +480,9 @@ unsigned char *SVGToRGBA(const void *svg_data, size_t svg_size, int &width, int
         float scaleY = (float)height / image->height;
         scale = std::min(scaleX, scaleY);
     }
+    width *= resolution;
+    height *= resolution;
+    scale *= resolution;
 
     // Rasterize SVG
     nsvgRasterize(rast, image, 0, 0, scale, rgba_data, width, height, width * 4);
@@ -468,60 +525,62 @@ bool getImageFromT3x(const std::string &filePath) {
     // Log::log("Successfully loaded image from t3x!");
     imageRGBAS.push_back(newRGBA);
 
-    imageC2Ds[newRGBA.name] = {image, 240, sheet};
+    imageC2Ds[newRGBA.name] = {image, sheet, imageSize, TexturePolicy::getFullLayout(newRGBA.width, newRGBA.height)};
+    trackImage(newRGBA.name, imageSize);
 
     return true;
 }
 
 /**
- * Reads an `imageRGBA` image, and adds a `C2D_Image` object to `imageC2Ds`.
- * Assumes image data is stored left->right, top->bottom.
- * Dimensions must be within 64x64 and 1024x1024.
+ * Makes a texture from pixels laid out the way `layout` says.
  * Code here originally from https://gbatemp.net/threads/citro2d-c2d_image-example.668574/
  * then edited to fit my code
+ * @param pixels RGBA8888 pixels, `layout.textureWidth` wide.
+ * @param layout
+ * @param image Gets the texture and subtexture, which have to be deleted with `delete`.
+ * @param textureSize Gets how much memory the texture takes.
+ * @return `false` if the texture couldn't be made.
  */
-bool get_C2D_Image(imageRGBA rgba) {
+static bool createTexture(const u8 *pixels, const TexturePolicy::Layout &layout, C2D_Image &image, size_t &textureSize) {
+    const int storedWidth = std::min(layout.textureWidth, 1024);
+    const int storedHeight = std::min(layout.textureHeight, 1024);
 
-    // u32 px_count = rgba.width * rgba.height;
-    u32 *rgba_raw = reinterpret_cast<u32 *>(rgba.data);
+    GPU_TEXCOLOR format = GPU_RGBA8;
+    if (layout.format == TexturePolicy::RGBA4444) format = GPU_RGBA4;
+    else if (layout.format == TexturePolicy::RGB565) format = GPU_RGB565;
+    else if (layout.format == TexturePolicy::A8) format = GPU_A8;
 
-    // Image data
-    C2D_Image image;
+    const u32 *rgba_raw = reinterpret_cast<const u32 *>(pixels);
 
     // Base texture
     C3D_Tex *tex = new C3D_Tex();
-    // C3D_Tex *tex = MemoryTracker::allocate<C3D_Tex>();
-    // new (tex) C3D_Tex();
     image.tex = tex;
 
     // Texture dimensions must be square powers of two between 64x64 and 1024x1024
-    tex->width = rgba.textureWidth;
-    tex->height = rgba.textureHeight;
+    tex->width = clamp(next_pow2(storedWidth), 64, 1024);
+    tex->height = clamp(next_pow2(storedHeight), 64, 1024);
 
-    size_t textureSize = rgba.textureMemSize;
+    const size_t bytesPerPixel = format == GPU_RGBA8 ? 4 : (format == GPU_A8 ? 1 : 2);
+    textureSize = tex->width * tex->height * bytesPerPixel;
 
     // Subtexture
     Tex3DS_SubTexture *subtex = new Tex3DS_SubTexture();
-    // Tex3DS_SubTexture *subtex = MemoryTracker::allocate<Tex3DS_SubTexture>();
-    // new (subtex) Tex3DS_SubTexture();
 
+    // drawn at the size of the part of the costume it holds, even if it was shrunk
     image.subtex = subtex;
-    subtex->width = rgba.width;
-    subtex->height = rgba.height;
+    subtex->width = layout.width;
+    subtex->height = layout.height;
 
     // (U, V) coordinates
     subtex->left = 0.0f;
     subtex->top = 1.0f;
-    subtex->right = (float)rgba.width / (float)tex->width;
-    subtex->bottom = 1.0 - ((float)rgba.height / (float)tex->height);
+    subtex->right = (float)storedWidth / (float)tex->width;
+    subtex->bottom = 1.0 - ((float)storedHeight / (float)tex->height);
 
-    if (!C3D_TexInit(tex, tex->width, tex->height, GPU_RGBA8)) {
+    if (!C3D_TexInit(tex, tex->width, tex->height, format)) {
         Log::logWarning("Texture initializing failed!");
         delete tex;
         delete subtex;
-        // MemoryTracker::deallocate(tex);
-        // MemoryTracker::deallocate(subtex);
-        Image::cleanupImages();
         return false;
     }
     C3D_TexSetFilter(tex, GPU_LINEAR, GPU_LINEAR);
@@ -531,56 +590,279 @@ bool get_C2D_Image(imageRGBA rgba) {
         C3D_TexDelete(tex);
         delete tex;
         delete subtex;
-        // MemoryTracker::deallocate(tex);
-        // MemoryTracker::deallocate(subtex);
-        Image::cleanupImages();
         return false;
     }
 
     memset(tex->data, 0, textureSize);
-    for (u32 i = 0; i < (u32)rgba.width; i++) {
-        for (u32 j = 0; j < (u32)rgba.height; j++) {
-            u32 src_idx = (j * rgba.width) + i;
-            u32 rgba_px = rgba_raw[src_idx];
-            u32 abgr_px = rgba_to_abgr(rgba_px);
+    for (u32 i = 0; i < (u32)storedWidth; i++) {
+        for (u32 j = 0; j < (u32)storedHeight; j++) {
+            u32 src_idx = (j * layout.textureWidth) + i;
 
             // Swizzle magic to convert into a t3x format
             u32 dst_ptr_offset = ((((j >> 3) * (tex->width >> 3) + (i >> 3)) << 6) +
                                   ((i & 1) | ((j & 1) << 1) | ((i & 2) << 1) |
                                    ((j & 2) << 2) | ((i & 4) << 2) | ((j & 4) << 3)));
-            ((u32 *)tex->data)[dst_ptr_offset] = abgr_px;
+
+            const u8 *px = &pixels[src_idx * 4];
+            switch (format) {
+            case GPU_RGBA4:
+                ((u16 *)tex->data)[dst_ptr_offset] = (px[0] >> 4) << 12 | (px[1] >> 4) << 8 | (px[2] >> 4) << 4 | px[3] >> 4;
+                break;
+            case GPU_RGB565:
+                ((u16 *)tex->data)[dst_ptr_offset] = (px[0] >> 3) << 11 | (px[1] >> 2) << 5 | px[2] >> 3;
+                break;
+            case GPU_A8:
+                ((u8 *)tex->data)[dst_ptr_offset] = px[3];
+                break;
+            default:
+                ((u32 *)tex->data)[dst_ptr_offset] = rgba_to_abgr(rgba_raw[src_idx]);
+                break;
+            }
         }
     }
 
-    // Log::log("C2D Image Successfully loaded!");
+    MemoryTracker::allocateVRAM(textureSize);
+    return true;
+}
+
+/**
+ * Reads an `imageRGBA` image, and adds a `C2D_Image` object to `imageC2Ds`.
+ * Assumes image data is stored left->right, top->bottom.
+ * Dimensions must be within 64x64 and 1024x1024.
+ */
+bool get_C2D_Image(imageRGBA rgba) {
 
-    MemoryTracker::allocateVRAM(rgba.textureMemSize);
+    // costumes can be trimmed, shrunk and stored with less bits per pixel
+    TexturePolicy::Layout layout = TexturePolicy::getFullLayout(rgba.width, rgba.height);
+    const u8 *pixels = rgba.data;
+    std::vector<u8> compacted;
+    if (TexturePolicy::enabled && rgba.isCostume) {
+        layout = TexturePolicy::plan(rgba.data, rgba.width, rgba.height, TexturePolicy::getScale(rgba.name));
+        compacted = TexturePolicy::apply(layout, rgba.data, rgba.width);
+        pixels = compacted.data();
+    }
 
-    imageC2Ds[rgba.name] = {image, 240};
+    C2D_Image image;
+    size_t textureSize;
+    if (!createTexture(pixels, layout, image, textureSize)) {
+        Image::cleanupImages();
+        return false;
+    }
+
+    // Log::log("C2D Image Successfully loaded!");
+
+    imageC2Ds[rgba.name] = {image, nullptr, textureSize, layout};
+    trackImage(rgba.name, textureSize);
     C3D_FrameSync(); // wait for Async functions to finish
     return true;
 }
 
 /**
- * Frees a `C2D_Image` from memory using `costumeId` string to find it.
+ * Frees a costume with effects applied, and its texture.
  */
-void Image::freeImage(const std::string &costumeId) {
-    auto it = imageC2Ds.find(costumeId);
-    if (it != imageC2Ds.end()) {
-        // Log::log("freed image!");
+static void freeEffectImage(std::unordered_map<std::string, ImageData>::iterator it) {
+    MemoryTracker::deallocateVRAM(it->second.memorySize);
+    C3D_TexDelete(it->second.image.tex);
+    delete it->second.image.tex;
+    delete it->second.image.subtex;
+    effectImageCache.remove(it->second.cacheEntry);
+    effectC2Ds.erase(it);
+}
 
-        if (it->second.sheet) {
-            if (it->second.image.tex) {
-                size_t textureSize = it->second.image.subtex->width * it->second.image.subtex->height * 4;
-                MemoryTracker::deallocateVRAM(textureSize);
-            }
+ImageData *getEffectImage(const std::string &costumeId, const GraphicEffects &effects) {
+    const std::string key = Effects::getCacheKey(costumeId, effects);
+    auto effectFind = effectC2Ds.find(key);
+    if (effectFind != effectC2Ds.end()) {
+        effectFind->second.markUsed();
+        return &effectFind->second;
+    }
 
-            C2D_SpriteSheetFree(it->second.sheet);
+    // effects work on the RGBA data, which costumes from t3x files don't have
+    auto rgbaFind = std::find_if(imageRGBAS.begin(), imageRGBAS.end(), [&](const imageRGBA &rgba) { return rgba.name == costumeId; });
+    if (rgbaFind == imageRGBAS.end() || rgbaFind->data == nullptr) return nullptr;
+    const int width = rgbaFind->width;
+    const int height = rgbaFind->height;
+    const size_t memorySize = clamp(next_pow2(width), 64, 1024) * clamp(next_pow2(height), 64, 1024) * 4;
+
+    // make room by freeing whatever went unused the longest, but not what's already drawn this frame, since the GPU still needs it
+    const size_t maxSize = MemoryTracker::getMaxVRAMUsage() / 8;
+    while (!effectImageCache.empty() && !effectImageCache.isOldestInUse() && effectImageCache.getMemorySize() + memorySize > maxSize) {
+        freeEffectImage(effectC2Ds.find(effectImageCache.getOldest().id));
+    }
 
-            // Log::log("Freed sprite sheet for: " + costumeId);
-            goto afterFreeing;
-        }
+    // the RGBA data is straight alpha like the textures, and it's the whole costume even if `TexturePolicy` stored less of it
+    std::vector<uint32_t> pixels(static_cast<size_t>(width) * height);
+    Effects::apply(reinterpret_cast<const uint32_t *>(rgbaFind->data), pixels.data(), width, height, Effects::quantize(effects));
+
+    ImageData data;
+    data.layout = TexturePolicy::getFullLayout(width, height);
+    data.sheet = nullptr;
+    if (!createTexture(reinterpret_cast<const u8 *>(pixels.data()), data.layout, data.image, data.memorySize)) return nullptr;
+
+    ImageData &image = effectC2Ds.emplace(key, data).first->second;
+    image.cache = &effectImageCache;
+    image.cacheEntry = effectImageCache.add(key, image.memorySize);
+    return &image;
+}
+
+/**
+ * Reads a costume file from the project, without decoding it.
+ */
+static bool readCostumeFile(const std::string &fileName, std::vector<char> &data) {
+    if (projectType == UNZIPPED) {
+        FILE *file = fopen(("romfs:/project/" + fileName).c_str(), "rb");
+        if (!file) return false;
+        fseek(file, 0, SEEK_END);
+        data.resize(ftell(file));
+        fseek(file, 0, SEEK_SET);
+        const bool read = fread(data.data(), 1, data.size(), file) == data.size();
+        fclose(file);
+        return read;
+    }
+
+    int fileIndex = mz_zip_reader_locate_file(&Unzip::zipArchive, fileName.c_str(), nullptr, 0);
+    if (fileIndex < 0) return false;
 
+    size_t fileSize;
+    void *fileData = mz_zip_reader_extract_to_heap(&Unzip::zipArchive, fileIndex, &fileSize, 0);
+    if (!fileData) return false;
+    data.assign(static_cast<const char *>(fileData), static_cast<const char *>(fileData) + fileSize);
+    mz_free(fileData);
+    return true;
+}
+
+static void freeSVGImage(std::unordered_map<std::string, ImageData>::iterator it) {
+    MemoryTracker::deallocateVRAM(it->second.memorySize);
+    C3D_TexDelete(it->second.image.tex);
+    delete it->second.image.tex;
+    delete it->second.image.subtex;
+    svgImageCache.remove(it->second.cacheEntry);
+    svgC2Ds.erase(it);
+}
+
+/**
+ * Rasterizes an SVG costume at a bigger resolution, and adds its texture to `svgC2Ds`.
+ */
+static void rasterizeSVG(const SVGRasterJob &job) {
+    std::vector<char> svgData;
+    if (!readCostumeFile(job.fileName, svgData)) {
+        Log::logWarning("Failed to read SVG costume: " + job.fileName);
+        return;
+    }
+
+    int width, height;
+    unsigned char *rgba = SVGToRGBA(svgData.data(), svgData.size(), width, height, job.resolution);
+    if (!rgba) return;
+
+    // make room by freeing whatever went unused the longest
+    const size_t memorySize = clamp(next_pow2(width), 64, 1024) * clamp(next_pow2(height), 64, 1024) * 4;
+    const size_t maxSize = MemoryTracker::getMaxVRAMUsage() / 4;
+    while (!svgImageCache.empty() && svgImageCache.getMemorySize() + memorySize > maxSize) {
+        freeSVGImage(svgC2Ds.find(svgImageCache.getOldest().id));
+    }
+
+    // drawn at the costume's native size, with more texture pixels per costume pixel
+    ImageData data;
+    data.layout = TexturePolicy::getFullLayout(width, height);
+    data.layout.width = width / job.resolution;
+    data.layout.height = height / job.resolution;
+    data.layout.scale = job.resolution;
+    data.sheet = nullptr;
+    const bool created = createTexture(rgba, data.layout, data.image, data.memorySize);
+    free(rgba);
+    if (!created) return;
+
+    ImageData &image = svgC2Ds.emplace(job.key, data).first->second;
+    image.cache = &svgImageCache;
+    image.cacheEntry = svgImageCache.add(job.key, image.memorySize);
+    RenderState::markChanged();
+}
+
+ImageData *getSVGImage(const std::string &costumeId, double screenScale) {
+    if (screenScale <= 1) return nullptr;
+    auto rgbaFind = std::find_if(imageRGBAS.begin(), imageRGBAS.end(), [&](const imageRGBA &rgba) { return rgba.name == costumeId; });
+    if (rgbaFind == imageRGBAS.end() || !rgbaFind->isSVG || !rgbaFind->isCostume) return nullptr;
+
+    // resolutions go up in powers of 2, so scaling a sprite doesn't rasterize it again every frame
+    int resolution = 2;
+    while (resolution < screenScale && resolution < MAX_SVG_RESOLUTION) {
+        resolution *= 2;
+    }
+    while (resolution > 1 && (rgbaFind->width * resolution > 1024 || rgbaFind->height * resolution > 1024)) {
+        resolution /= 2;
+    }
+    if (resolution == 1) return nullptr;
+
+    const std::string key = costumeId + "@" + std::to_string(resolution);
+    auto svgFind = svgC2Ds.find(key);
+    if (svgFind != svgC2Ds.end()) {
+        svgFind->second.markUsed();
+        return &svgFind->second;
+    }
+
+    // rasterized by `updatePrefetch()` once the frame is done, so the native size gets drawn in the meantime
+    if (std::none_of(svgQueue.begin(), svgQueue.end(), [&](const SVGRasterJob &job) { return job.key == key; })) {
+        svgQueue.push_back({key, costumeId, rgbaFind->fullName, resolution});
+    }
+    return nullptr;
+}
+
+/**
+ * Loads costumes one after another, since textures get made as they're drawn anyway.
+ */
+void Image::loadImagesFromProject(const std::vector<std::string> &fileNames, const std::function<void(size_t)> &onLoaded) {
+    size_t loadedCount = 0;
+    for (const std::string &fileName : fileNames) {
+        if (projectType == UNZIPPED) loadImageFromFile(fileName);
+        else loadImageFromSB3(&Unzip::zipArchive, fileName);
+        loadedCount++;
+        if (onLoaded) onLoaded(loadedCount);
+    }
+}
+
+/**
+ * Decodes on the main thread for up to `CostumePrefetch::MS_PER_FRAME` each frame, since there's no core to spare.
+ * Prefetched RGBA data only gets a texture once it's drawn, like any other loaded costume.
+ */
+void Image::prefetchImages(const std::vector<std::string> &fileNames) {
+    prefetchQueue.insert(prefetchQueue.end(), fileNames.begin(), fileNames.end());
+}
+
+void Image::updatePrefetch() {
+    const double startTime = FrameScheduler::getTimeMs();
+
+    // sharper SVGs for sprites drawn big come first, since they're already on screen
+    while (!svgQueue.empty() && FrameScheduler::getTimeMs() - startTime < CostumePrefetch::MS_PER_FRAME) {
+        const SVGRasterJob job = svgQueue.front();
+        svgQueue.pop_front();
+        rasterizeSVG(job);
+    }
+
+    while (!prefetchQueue.empty() && CostumePrefetch::hasMemoryForMore() && FrameScheduler::getTimeMs() - startTime < CostumePrefetch::MS_PER_FRAME) {
+        const std::string fileName = prefetchQueue.front();
+        prefetchQueue.pop_front();
+
+        const std::string imageId = fileName.substr(0, fileName.find_last_of('.'));
+        auto it = std::find_if(imageRGBAS.begin(), imageRGBAS.end(), [&](const imageRGBA &img) {
+            return img.name == imageId;
+        });
+        if (it != imageRGBAS.end()) continue;
+
+        if (projectType == UNZIPPED) loadImageFromFile(fileName);
+        else loadImageFromSB3(&Unzip::zipArchive, fileName);
+    }
+}
+
+/**
+ * Frees the texture of a `C2D_Image`, leaving its RGBA data.
+ */
+static void freeTexture(std::unordered_map<std::string, ImageData>::iterator it) {
+    if (it->second.image.tex) MemoryTracker::deallocateVRAM(it->second.memorySize);
+
+    if (it->second.sheet) {
+        C2D_SpriteSheetFree(it->second.sheet);
+        // Log::log("Freed sprite sheet for: " + it->first);
+    } else {
         if (it->second.image.tex) {
             C3D_TexDelete(it->second.image.tex);
             delete it->second.image.tex;
@@ -589,12 +871,21 @@ void Image::freeImage(const std::string &costumeId) {
         if (it->second.image.subtex) {
             delete it->second.image.subtex;
         }
+    }
 
-    afterFreeing:
+    if (it->second.cache) imageCache.remove(it->second.cacheEntry);
+    imageC2Ds.erase(it);
+}
 
-        imageC2Ds.erase(it);
-    } else return;
+/**
+ * Frees a `C2D_Image` from memory using `costumeId` string to find it.
+ */
+void Image::freeImage(const std::string &costumeId) {
+    auto it = imageC2Ds.find(costumeId);
+    if (it == imageC2Ds.end()) return;
+    // Log::log("freed image!");
 
+    freeTexture(it);
     freeRGBA(costumeId);
 }
 
@@ -611,10 +902,19 @@ void Image::cleanupImages() {
         freeImage(id);
     }
 
+    while (!effectC2Ds.empty()) {
+        freeEffectImage(effectC2Ds.begin());
+    }
+    while (!svgC2Ds.empty()) {
+        freeSVGImage(svgC2Ds.begin());
+    }
+    svgQueue.clear();
+
     // Clear maps & queues to prevent dangling references
     imageC2Ds.clear();
     imageLoadQueue.clear();
     toDelete.clear();
+    prefetchQueue.clear();
 
     // Log::log("Image cleanup completed.");
 }
@@ -633,7 +933,6 @@ void freeRGBA(const std::string &imageName) {
             } else {
                 MemoryTracker::deallocate(it->data, dataSize);
             }
-            MemoryTracker::deallocateVRAM(it->textureMemSize);
 
             // Log::log("Freed RGBA data for " + imageName);
         }
@@ -650,58 +949,42 @@ void Image::queueFreeImage(const std::string &costumeId) {
 }
 
 /**
- * Checks every `C2D_Image` in memory to see if they can be freed.
- * A `C2D_Image` will get freed if there's either too many images in memory,
- * or if a `C2D_Image` goes unused for 120 frames.
+ * Frees every `C2D_Image` that went unused for `MAX_UNUSED_FRAMES` frames,
+ * and when RAM or VRAM runs low, every one that wasn't drawn this frame until enough is free.
  */
 void Image::FlushImages() {
+    for (const std::string &id : toDelete) {
+        Image::freeImage(id);
+    }
+    toDelete.clear();
 
-    // free unused images if vram usage is high
-    if (MemoryTracker::getVRAMUsage() + MemoryTracker::getCurrentUsage() > MemoryTracker::getMaxVRAMUsage() * 0.8) {
-        size_t times = 0;
-
-        // keep freeing until usage is low enough
-        while (MemoryTracker::getVRAMUsage() + MemoryTracker::getCurrentUsage() > MemoryTracker::getMaxVRAMUsage() * 0.5 && !imageC2Ds.empty()) {
-            ImageData *imgToDelete = nullptr;
-            std::string toDeleteStr = "";
-
-            for (auto &[id, img] : imageC2Ds) {
-                if (img.freeTimer == 240) continue;
-
-                if (imgToDelete == nullptr) {
-                    imgToDelete = &img;
-                    toDeleteStr = id;
-                    continue;
-                }
-
-                if (img.freeTimer < imgToDelete->freeTimer) {
-                    imgToDelete = &img;
-                    toDeleteStr = id;
-                }
-            }
+    // the RGBA data is still there, so only the texture has to be made again, next time the costume gets drawn
+    for (const std::string &fileName : TexturePolicy::takeReloads()) {
+        auto it = imageC2Ds.find(fileName.substr(0, fileName.find_last_of('.')));
+        if (it != imageC2Ds.end() && !it->second.sheet) freeTexture(it);
+    }
 
-            if (toDeleteStr != "") {
-                Image::freeImage(toDeleteStr);
-            } else {
-                break;
-            }
+    imageCache.keepDrawn();
+    effectImageCache.keepDrawn();
+    svgImageCache.keepDrawn();
 
-            times++;
-            if (times > 15) break;
-        }
-    } else {
-        // timer based freeing
-        for (auto &[id, img] : imageC2Ds) {
-            if (img.freeTimer <= 0) {
-                toDelete.push_back(id);
-            } else {
-                img.freeTimer -= 1;
-            }
+    if (LruCache::isOverBudget(LOW_MEMORY_START)) {
+        while (LruCache::isOverBudget(LOW_MEMORY_STOP) && !imageCache.empty() && !imageCache.isOldestInUse()) {
+            const std::string id = imageCache.getOldest().id;
+            Image::freeImage(id);
         }
     }
-
-    for (const std::string &id : toDelete) {
+    while (imageCache.hasExpired()) {
+        const std::string id = imageCache.getOldest().id;
         Image::freeImage(id);
     }
-    toDelete.clear();
-}
\ No newline at end of file
+
+    while (effectImageCache.hasExpired()) {
+        freeEffectImage(effectC2Ds.find(effectImageCache.getOldest().id));
+    }
+    while (svgImageCache.hasExpired()) {
+        freeSVGImage(svgC2Ds.find(svgImageCache.getOldest().id));
+    }
+
+    LruCache::nextFrame();
+}
@@ -1,5 +1,8 @@
 #pragma once
 #include "../scratch/image.hpp"
+#include "../scratch/lruCache.hpp"
+#include "../scratch/sprite.hpp"
+#include "../scratch/texturePolicy.hpp"
 #include <3ds.h>
 #include <citro2d.h>
 #include <citro3d.h>
@@ -8,8 +11,16 @@
 
 struct ImageData {
     C2D_Image image;
-    u16 freeTimer = 240;
     C2D_SpriteSheet sheet;
+    size_t memorySize = 0;
+    TexturePolicy::Layout layout;  // the part of the costume in the texture, and how it's stored
+    LruCache *cache = nullptr; // the cache that frees the image once it goes unused
+    LruCache::Handle cacheEntry;
+
+    /**
+     * Marks the image as used this frame, so it doesn't get freed.
+     */
+    void markUsed();
 };
 
 struct imageRGBA {
@@ -18,6 +29,7 @@ struct imageRGBA {
     int width;
     int height;
     bool isSVG = false;
+    bool isCostume = false; // costumes from the project can be stored with `TexturePolicy`
 
     //  same as width/height but as powers of 2 for 3DS
     int textureWidth;
@@ -31,7 +43,24 @@ extern std::vector<imageRGBA> imageRGBAS;
 
 bool get_C2D_Image(imageRGBA rgba);
 void freeRGBA(const std::string &imageName);
-unsigned char *SVGToRGBA(const void *svg_data, size_t svg_size, int &width, int &height);
+unsigned char *SVGToRGBA(const void *svg_data, size_t svg_size, int &width, int &height, int resolution = 1);
 bool getImageFromT3x(const std::string &filePath);
 
-extern std::unordered_map<std::string, ImageData> imageC2Ds;
\ No newline at end of file
+extern std::unordered_map<std::string, ImageData> imageC2Ds;
+
+/**
+ * Gets a costume with graphic effects applied. Results are cached, up to an eighth of the max VRAM usage.
+ * @param costumeId
+ * @param effects
+ * @return The image with effects, or `nullptr` if the costume's RGBA data isn't loaded.
+ */
+ImageData *getEffectImage(const std::string &costumeId, const GraphicEffects &effects);
+
+/**
+ * Gets an SVG costume rasterized at a resolution that suits how big it's drawn, up to twice its native size.
+ * Missing resolutions get rasterized by `Image::updatePrefetch()`, so the first frames still use the native size.
+ * @param costumeId
+ * @param screenScale Screen pixels per costume pixel.
+ * @return The sharper image, or `nullptr` if the native size should be drawn.
+ */
+ImageData *getSVGImage(const std::string &costumeId, double screenScale);
\ No newline at end of file
@@ -6,8 +6,14 @@
 #include "../scratch/render.hpp"
 #include "../scratch/text.hpp"
 #include "../scratch/unzip.hpp"
+#include "effects.hpp"
 #include "image.hpp"
 #include "interpret.hpp"
+#include "layers.hpp"
+#include "lruCache.hpp"
+#include "penLayer.hpp"
+#include "profiler.hpp"
+#include "renderState.hpp"
 #ifdef ENABLE_AUDIO
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
@@ -39,6 +45,13 @@ bool Render::hasFrameBegan;
 static int currentScreen = 0;
 std::vector<Monitor> Render::visibleVariables;
 
+// everything the pen has drawn, between the Stage and the sprites. Only made once a project uses the pen
+#define PEN_TEXTURE_SIZE 512
+static C3D_Tex penTexture;
+static C3D_RenderTarget *penTarget = nullptr;
+static Tex3DS_SubTexture penSubtex;
+static bool penTextureFailed = false;
+
 #ifdef ENABLE_CLOUDVARS
 static uint32_t *SOC_buffer = NULL;
 #endif
@@ -117,6 +130,13 @@ int Render::getWidth() {
 int Render::getHeight() {
     return SCREEN_HEIGHT;
 }
+int Render::getRefreshRate() {
+    return 60;
+}
+bool Render::hasVsync() {
+    // C3D_FrameBegin() waits for the screen to be ready for the next frame
+    return true;
+}
 
 void Render::beginFrame(int screen, int colorR, int colorG, int colorB) {
     if (!hasFrameBegan) {
@@ -138,6 +158,7 @@ void Render::beginFrame(int screen, int colorR, int colorG, int colorB) {
 void Render::endFrame(bool shouldFlush) {
     C2D_Flush();
     C3D_FrameEnd(0);
+    LruCache::markDrawn();
     if (shouldFlush) Image::FlushImages();
     hasFrameBegan = false;
 }
@@ -184,10 +205,12 @@ void renderImage(C2D_Image *image, Sprite *currentSprite, std::string costumeId,
     bool isSVG = false;
     double screenOffset = (bottom && Render::renderMode != Render::BOTTOM_SCREEN_ONLY) ? -SCREEN_HEIGHT : 0;
     bool imageLoaded = false;
+    std::string fileName;
     for (imageRGBA rgba : imageRGBAS) {
         if (rgba.name == costumeId) {
 
             if (rgba.isSVG) isSVG = true;
+            if (rgba.isCostume) fileName = rgba.fullName;
             legacyDrawing = false;
             currentSprite->spriteWidth = rgba.width / 2;
             currentSprite->spriteHeight = rgba.height / 2;
@@ -234,7 +257,15 @@ void renderImage(C2D_Image *image, Sprite *currentSprite, std::string costumeId,
     scale = bottom ? 1.0 : std::min(scaleX, scaleY);
 
     if (!legacyDrawing) {
-        imageC2Ds[costumeId].freeTimer = 240;
+        ImageData &costumeData = imageC2Ds[costumeId];
+        costumeData.markUsed();
+        if (TexturePolicy::enabled && fileName != "") TexturePolicy::observeScale(costumeId, fileName, spriteSizeY * scale / 2.0f, costumeData.layout);
+
+        // effects other than ghost get drawn from a copy of the costume with them applied, and big SVGs from a sharper copy
+        ImageData *copy = nullptr;
+        if (Effects::isActive(currentSprite->effects)) copy = getEffectImage(costumeId, currentSprite->effects);
+        else if (isSVG) copy = getSVGImage(costumeId, currentSprite->size * 0.01 * scale);
+        ImageData &data = copy ? *copy : costumeData;
         double rotation = Math::degreesToRadians(currentSprite->rotation - 90.0f);
         bool flipX = false;
 
@@ -250,20 +281,28 @@ void renderImage(C2D_Image *image, Sprite *currentSprite, std::string costumeId,
             rotation = 0;
         }
 
-        // Center the sprite's pivot point
-        double rotationCenterX = ((((currentSprite->rotationCenterX - currentSprite->spriteWidth)) / 2) * scale);
-        double rotationCenterY = ((((currentSprite->rotationCenterY - currentSprite->spriteHeight)) / 2) * scale);
-        if (flipX) rotationCenterX -= currentSprite->spriteWidth;
+        // Center the sprite's pivot point, on the part of the costume that's in the texture in case `TexturePolicy` trimmed the rest
+        const int halfWidth = data.layout.width / 2;
+        const int halfHeight = data.layout.height / 2;
+        double rotationCenterX = ((((currentSprite->rotationCenterX - data.layout.x - halfWidth)) / 2) * scale);
+        double rotationCenterY = ((((currentSprite->rotationCenterY - data.layout.y - halfHeight)) / 2) * scale);
+        if (flipX) rotationCenterX -= halfWidth;
 
         float alpha = 1.0f - (currentSprite->ghostEffect / 100.0f);
         C2D_ImageTint tinty;
-        C2D_AlphaImageTint(&tinty, alpha);
+        if (data.layout.format == TexturePolicy::A8) {
+            // the texture only has the opacity, so the color comes from the tint
+            const u8 *color = reinterpret_cast<const u8 *>(&data.layout.color);
+            C2D_PlainImageTint(&tinty, C2D_Color32(color[0], color[1], color[2], static_cast<u8>(alpha * 255)), 1.0f);
+        } else {
+            C2D_AlphaImageTint(&tinty, alpha);
+        }
 
         const double offsetX = rotationCenterX * spriteSizeX;
         const double offsetY = rotationCenterY * spriteSizeY;
 
         C2D_DrawImageAtRotated(
-            imageC2Ds[costumeId].image,
+            data.image,
             static_cast<int>((currentSprite->xPosition * scale) + (screenWidth / 2) - offsetX * std::cos(rotation) + offsetY * std::sin(rotation)) + x3DOffset,
             static_cast<int>((currentSprite->yPosition * -1 * scale) + (SCREEN_HEIGHT * heightMultiplier) + screenOffset - offsetX * std::sin(rotation) - offsetY * std::cos(rotation)),
             1,
@@ -303,36 +342,232 @@ void renderImage(C2D_Image *image, Sprite *currentSprite, std::string costumeId,
     currentSprite->lastCostumeId = costumeId;
 }
 
+/**
+ * Gets how many pen texture pixels a Scratch unit takes, so the whole Stage fits in the texture.
+ */
+static float getPenScale() {
+    return std::min({1.0f, static_cast<float>(PEN_TEXTURE_SIZE) / Scratch::projectWidth, static_cast<float>(PEN_TEXTURE_SIZE) / Scratch::projectHeight});
+}
+
+/**
+ * Makes the texture the pen draws onto, the first time anything gets drawn with the pen.
+ * @return `false` if there's no VRAM left for it.
+ */
+static bool createPenTexture() {
+    if (penTarget) return true;
+    if (penTextureFailed) return false;
+
+    if (!C3D_TexInitVRAM(&penTexture, PEN_TEXTURE_SIZE, PEN_TEXTURE_SIZE, GPU_RGBA8)) {
+        Log::logWarning("Not enough VRAM for the pen layer");
+        penTextureFailed = true;
+        return false;
+    }
+    penTarget = C3D_RenderTargetCreateFromTex(&penTexture, GPU_TEXFACE_2D, 0, -1);
+    if (!penTarget) {
+        Log::logWarning("Couldn't create the pen layer");
+        C3D_TexDelete(&penTexture);
+        penTextureFailed = true;
+        return false;
+    }
+    C3D_TexSetFilter(&penTexture, GPU_LINEAR, GPU_LINEAR);
+    MemoryTracker::allocateVRAM(PEN_TEXTURE_SIZE * PEN_TEXTURE_SIZE * 4);
+
+    // VRAM starts out with whatever was there before
+    C2D_TargetClear(penTarget, 0);
+    return true;
+}
+
+/**
+ * Draws a costume onto the pen layer, placed the same way `renderImage()` places sprites.
+ */
+static void drawPenStamp(const PenStamp &stamp, float penScale) {
+    auto imageFind = imageC2Ds.find(stamp.costumeId);
+    if (imageFind == imageC2Ds.end() || imageFind->second.image.tex == nullptr) {
+        auto rgbaFind = std::find_if(imageRGBAS.begin(), imageRGBAS.end(), [&](const imageRGBA &rgba) { return rgba.name == stamp.costumeId; });
+        if (rgbaFind == imageRGBAS.end() || !get_C2D_Image(*rgbaFind)) return;
+        imageFind = imageC2Ds.find(stamp.costumeId);
+        if (imageFind == imageC2Ds.end()) return;
+    }
+    imageFind->second.markUsed();
+
+    const bool isSVG = std::any_of(imageRGBAS.begin(), imageRGBAS.end(), [&](const imageRGBA &rgba) { return rgba.name == stamp.costumeId && rgba.isSVG; });
+    ImageData *copy = nullptr;
+    if (Effects::isActive(stamp.effects)) copy = getEffectImage(stamp.costumeId, stamp.effects);
+    else if (isSVG) copy = getSVGImage(stamp.costumeId, stamp.size * 0.01 * penScale);
+    ImageData &data = copy ? *copy : imageFind->second;
+    double spriteSizeX = stamp.size * 0.01;
+    double spriteSizeY = stamp.size * 0.01;
+    if (isSVG) {
+        spriteSizeX *= 2;
+        spriteSizeY *= 2;
+    }
+
+    double rotation = Math::degreesToRadians(stamp.rotation - 90.0f);
+    bool flipX = false;
+    if (stamp.rotationStyle == Sprite::LEFT_RIGHT) {
+        if (std::cos(rotation) < 0) {
+            spriteSizeX *= -1;
+            flipX = true;
+        }
+        rotation = 0;
+    }
+    if (stamp.rotationStyle == Sprite::NONE) rotation = 0;
+
+    const int halfWidth = data.layout.width / 2;
+    const int halfHeight = data.layout.height / 2;
+    double rotationCenterX = (((stamp.rotationCenterX - data.layout.x - halfWidth)) / 2) * penScale;
+    double rotationCenterY = (((stamp.rotationCenterY - data.layout.y - halfHeight)) / 2) * penScale;
+    if (flipX) rotationCenterX -= halfWidth;
+
+    const float alpha = 1.0f - (std::clamp(stamp.ghostEffect, 0.0f, 100.0f) / 100.0f);
+    C2D_ImageTint tint;
+    if (data.layout.format == TexturePolicy::A8) {
+        const u8 *color = reinterpret_cast<const u8 *>(&data.layout.color);
+        C2D_PlainImageTint(&tint, C2D_Color32(color[0], color[1], color[2], static_cast<u8>(alpha * 255)), 1.0f);
+    } else {
+        C2D_AlphaImageTint(&tint, alpha);
+    }
+
+    const double offsetX = rotationCenterX * spriteSizeX;
+    const double offsetY = rotationCenterY * spriteSizeY;
+    C2D_DrawImageAtRotated(
+        data.image,
+        (stamp.xPosition * penScale) + (Scratch::projectWidth * penScale / 2) - offsetX * std::cos(rotation) + offsetY * std::sin(rotation),
+        (stamp.yPosition * -penScale) + (Scratch::projectHeight * penScale / 2) - offsetX * std::sin(rotation) - offsetY * std::cos(rotation),
+        1,
+        rotation,
+        &tint,
+        spriteSizeX * penScale / 2.0f,
+        spriteSizeY * penScale / 2.0f);
+}
+
+/**
+ * Draws a pen line onto the pen layer, with a circle on each end.
+ */
+static void drawPenLine(const PenLine &line, float penScale) {
+    const float originX = Scratch::projectWidth * penScale / 2;
+    const float originY = Scratch::projectHeight * penScale / 2;
+    const float x1 = originX + line.x1 * penScale;
+    const float y1 = originY - line.y1 * penScale;
+    const float x2 = originX + line.x2 * penScale;
+    const float y2 = originY - line.y2 * penScale;
+    const float thickness = std::max(line.size * penScale, 1.0f);
+    const u32 color = C2D_Color32(line.r, line.g, line.b, line.a);
+
+    if (x1 != x2 || y1 != y2) C2D_DrawLine(x1, y1, color, x2, y2, color, thickness, 1);
+    // round ends, like Scratch
+    C2D_DrawCircleSolid(x1, y1, 1, thickness / 2, color);
+    if (x1 != x2 || y1 != y2) C2D_DrawCircleSolid(x2, y2, 1, thickness / 2, color);
+}
+
+/**
+ * Draws everything the pen blocks queued up since the last frame onto the pen texture.
+ * Has to be called between `C3D_FrameBegin()` and `C3D_FrameEnd()`.
+ */
+static void drawPenQueue() {
+    if (!createPenTexture()) {
+        PenLayer::clearQueue();
+        return;
+    }
+
+    if (PenLayer::shouldClear) C2D_TargetClear(penTarget, 0);
+    C2D_SceneBegin(penTarget);
+    C3D_DepthTest(false, GPU_ALWAYS, GPU_WRITE_COLOR);
+    // the texture starts out transparent, so colors get stored premultiplied to blend right once it's drawn
+    C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA, GPU_ONE, GPU_ONE_MINUS_SRC_ALPHA);
+
+    const float penScale = getPenScale();
+    size_t line = 0;
+    for (const PenStamp &stamp : PenLayer::stamps) {
+        for (; line < stamp.lineCount; line++) {
+            drawPenLine(PenLayer::lines[line], penScale);
+        }
+        drawPenStamp(stamp, penScale);
+    }
+    for (; line < PenLayer::lines.size(); line++) {
+        drawPenLine(PenLayer::lines[line], penScale);
+    }
+
+    C2D_Flush();
+    C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA);
+    PenLayer::clearQueue();
+}
+
+/**
+ * Draws the pen layer over the Stage, on the screen the current scene is on.
+ * @param bottom Same as in `renderImage()`.
+ * @param x3DOffset
+ */
+static void renderPenLayer(bool bottom, float x3DOffset) {
+    if (!penTarget) return;
+
+    double scaleX = static_cast<double>(SCREEN_WIDTH) / Scratch::projectWidth;
+    double scaleY = static_cast<double>(SCREEN_HEIGHT) / Scratch::projectHeight;
+    double heightMultiplier = 0.5;
+    const int screenWidth = bottom ? BOTTOM_SCREEN_WIDTH : SCREEN_WIDTH;
+    const double screenOffset = (bottom && Render::renderMode != Render::BOTTOM_SCREEN_ONLY) ? -SCREEN_HEIGHT : 0;
+    if (Render::renderMode == Render::BOTH_SCREENS) {
+        scaleY = static_cast<double>(SCREEN_HEIGHT) / (Scratch::projectHeight / 2.0);
+        heightMultiplier = 1.0;
+    }
+    const double scale = bottom ? 1.0 : std::min(scaleX, scaleY);
+
+    // the Stage takes up the top left corner of the texture
+    const float penScale = getPenScale();
+    const float width = Scratch::projectWidth * penScale;
+    const float height = Scratch::projectHeight * penScale;
+    penSubtex = {static_cast<u16>(width), static_cast<u16>(height), 0.0f, 1.0f, width / PEN_TEXTURE_SIZE, 1.0f - height / PEN_TEXTURE_SIZE};
+    const C2D_Image penImage = {&penTexture, &penSubtex};
+
+    // what's in the texture is premultiplied
+    C2D_Flush();
+    C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_ONE, GPU_ONE_MINUS_SRC_ALPHA, GPU_ONE, GPU_ONE_MINUS_SRC_ALPHA);
+    C2D_DrawImageAt(penImage,
+                    (screenWidth / 2) - (Scratch::projectWidth * scale / 2) + x3DOffset,
+                    (SCREEN_HEIGHT * heightMultiplier) + screenOffset - (Scratch::projectHeight * scale / 2),
+                    1, nullptr, scale / penScale, scale / penScale);
+    C2D_Flush();
+    C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA);
+}
+
 void Render::renderSprites() {
+    // the 3D slider and the mouse pointer change the screen without any blocks running
+    static float lastSlider = -1;
+    float slider = osGet3DSliderState();
+    if (slider != lastSlider || Input::mousePointer.isMoving) RenderState::markChanged();
+    lastSlider = slider;
+
+    // nothing changed, so the last frame is still on screen
+    if (!RenderState::shouldRedraw()) return;
+
     C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
     C2D_TargetClear(topScreen, clrWhite);
     C2D_TargetClear(topScreenRightEye, clrWhite);
     C2D_TargetClear(bottomScreen, clrWhite);
 
-    float slider = osGet3DSliderState();
     const float depthScale = 8.0f / sprites.size();
 
     auto stage = *std::find_if(sprites.begin(), sprites.end(), [](const Sprite *sprite) {
         return sprite->isStage;
     }); // TODO: Add handling for the stage is missing for some reason
 
-    std::vector<Sprite *> spritesByLayer = sprites;
-    std::sort(spritesByLayer.begin(), spritesByLayer.end(),
-              [](const Sprite *a, const Sprite *b) {
-                  return a->layer < b->layer;
-              });
+    if (PenLayer::hasQueued()) drawPenQueue();
+
+    const size_t totalSprites = sprites.size();
 
     // ---------- LEFT EYE ----------
     if (Render::renderMode != Render::BOTTOM_SCREEN_ONLY) {
         C2D_SceneBegin(topScreen);
         C3D_DepthTest(false, GPU_ALWAYS, GPU_WRITE_COLOR);
 
-        renderImage(&imageC2Ds[stage->costumes[stage->currentCostume].id].image, stage, stage->costumes[stage->currentCostume].id, false, -slider * (static_cast<float>(spritesByLayer.size() - 1) * depthScale)); // TODO: figure out if the 3d stuff is correct
+        renderImage(&imageC2Ds[stage->costumes[stage->currentCostume].id].image, stage, stage->costumes[stage->currentCostume].id, false, -slider * (static_cast<float>(totalSprites - 1) * depthScale)); // TODO: figure out if the 3d stuff is correct
+        renderPenLayer(false, -slider * (static_cast<float>(totalSprites - 1) * depthScale));
 
-        for (size_t i = 0; i < spritesByLayer.size(); i++) {
-            Sprite *currentSprite = spritesByLayer[i];
+        // the Stage is layer 0, so sprites start at 1
+        size_t i = 0;
+        for (Sprite *currentSprite = Layers::getBottom(); currentSprite != nullptr; currentSprite = currentSprite->layerAbove) {
+            i++;
             if (!currentSprite->visible) continue;
-            if (currentSprite->isStage) continue;
 
             int costumeIndex = 0;
             for (const auto &costume : currentSprite->costumes) {
@@ -340,7 +575,6 @@ void Render::renderSprites() {
                     currentSprite->rotationCenterX = costume.rotationCenterX;
                     currentSprite->rotationCenterY = costume.rotationCenterY;
 
-                    size_t totalSprites = spritesByLayer.size();
                     float eyeOffset = -slider * (static_cast<float>(totalSprites - 1 - i) * depthScale);
 
                     renderImage(&imageC2Ds[costume.id].image,
@@ -354,6 +588,9 @@ void Render::renderSprites() {
             }
         }
         renderVisibleVariables();
+#ifdef ENABLE_PROFILER
+        Profiler::renderOverlay();
+#endif
     }
 
     if (Render::renderMode != Render::BOTH_SCREENS)
@@ -364,12 +601,14 @@ void Render::renderSprites() {
         C2D_SceneBegin(topScreenRightEye);
         C3D_DepthTest(false, GPU_ALWAYS, GPU_WRITE_COLOR);
 
-        renderImage(&imageC2Ds[stage->costumes[stage->currentCostume].id].image, stage, stage->costumes[stage->currentCostume].id, false, slider * (static_cast<float>(spritesByLayer.size() - 1) * depthScale)); // TODO: figure out if the 3d stuff is correct
+        renderImage(&imageC2Ds[stage->costumes[stage->currentCostume].id].image, stage, stage->costumes[stage->currentCostume].id, false, slider * (static_cast<float>(totalSprites - 1) * depthScale)); // TODO: figure out if the 3d stuff is correct
+        renderPenLayer(false, slider * (static_cast<float>(totalSprites - 1) * depthScale));
 
-        for (size_t i = 0; i < spritesByLayer.size(); i++) {
-            Sprite *currentSprite = spritesByLayer[i];
+        // the Stage is layer 0, so sprites start at 1
+        size_t i = 0;
+        for (Sprite *currentSprite = Layers::getBottom(); currentSprite != nullptr; currentSprite = currentSprite->layerAbove) {
+            i++;
             if (!currentSprite->visible) continue;
-            if (currentSprite->isStage) continue;
 
             int costumeIndex = 0;
             for (const auto &costume : currentSprite->costumes) {
@@ -377,7 +616,6 @@ void Render::renderSprites() {
                     currentSprite->rotationCenterX = costume.rotationCenterX;
                     currentSprite->rotationCenterY = costume.rotationCenterY;
 
-                    size_t totalSprites = spritesByLayer.size();
                     float eyeOffset = slider * (static_cast<float>(totalSprites - 1 - i) * depthScale);
 
                     renderImage(&imageC2Ds[costume.id].image,
@@ -401,11 +639,10 @@ void Render::renderSprites() {
         C2D_SceneBegin(bottomScreen);
 
         renderImage(&imageC2Ds[stage->costumes[stage->currentCostume].id].image, stage, stage->costumes[stage->currentCostume].id, false, 0.0f);
+        renderPenLayer(true, 0.0f);
 
-        for (size_t i = 0; i < spritesByLayer.size(); i++) {
-            Sprite *currentSprite = spritesByLayer[i];
+        for (Sprite *currentSprite = Layers::getBottom(); currentSprite != nullptr; currentSprite = currentSprite->layerAbove) {
             if (!currentSprite->visible) continue;
-            if (!currentSprite->isStage) continue;
 
             int costumeIndex = 0;
             for (const auto &costume : currentSprite->costumes) {
@@ -430,7 +667,6 @@ void Render::renderSprites() {
 
     C2D_Flush();
     C3D_FrameEnd(0);
-    Image::FlushImages();
     osSetSpeedupEnable(true);
 }
 
@@ -492,6 +728,12 @@ void Render::deInit() {
 
     Image::cleanupImages();
     SoundPlayer::deinit();
+    if (penTarget) {
+        C3D_RenderTargetDelete(penTarget);
+        C3D_TexDelete(&penTexture);
+        MemoryTracker::deallocateVRAM(PEN_TEXTURE_SIZE * PEN_TEXTURE_SIZE * 4);
+        penTarget = nullptr;
+    }
     C2D_Fini();
     C3D_Fini();
 #ifdef ENABLE_AUDIO
@@ -8,7 +8,6 @@ std::string Unzip::loadingState = "";
 volatile bool Unzip::threadFinished = false;
 std::string Unzip::filePath = "";
 mz_zip_archive Unzip::zipArchive;
-std::vector<char> Unzip::zipBuffer;
 
 int Unzip::openFile(std::ifstream *file) {
     Log::log("Unzipping Scratch Project...");
@@ -25,7 +24,8 @@ int Unzip::openFile(std::ifstream *file) {
         Log::log("No unzipped project, trying embedded.");
 
         // try embedded zipped sb3
-        file->open("romfs:/" + std::string(filename), std::ios::binary | std::ios::ate); // loads file from romfs
+        archivePath = "romfs:/" + std::string(filename);
+        file->open(archivePath, std::ios::binary | std::ios::ate); // loads file from romfs
         projectType = EMBEDDED;
         if (!(*file)) {
             Log::log("No embedded Scratch project, trying SD card");
@@ -35,7 +35,8 @@ int Unzip::openFile(std::ifstream *file) {
             if (filePath == "") return -1;
 
             // if main menu was loaded, load the selected file from main menu
-            file->open(OS::getScratchFolderLocation() + filePath, std::ios::binary | std::ios::ate);
+            archivePath = OS::getScratchFolderLocation() + filePath;
+            file->open(archivePath, std::ios::binary | std::ios::ate);
             if (!(*file)) {
                 Log::logError("Couldnt find file. jinkies.");
                 return 0;
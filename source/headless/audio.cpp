@@ -0,0 +1,67 @@
+#include "../scratch/audio.hpp"
+#include "interpret.hpp"
+#include "miniz/miniz.h"
+#include "sprite.hpp"
+#include <string>
+#include <unordered_map>
+
+// Headless runs have no audio output. Sounds are never loaded and finish playing instantly.
+
+std::unordered_map<std::string, Sound> SoundPlayer::soundsPlaying;
+
+bool SoundPlayer::loadSoundFromSB3(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId, const bool &streamed) {
+    return false;
+}
+
+void SoundPlayer::startSoundLoader(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId) {
+}
+
+void SoundPlayer::preloadSound(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId) {
+}
+
+void SoundPlayer::updateSoundLoader() {
+}
+
+bool SoundPlayer::loadSoundFromFile(Sprite *sprite, std::string fileName, const bool &streamed) {
+    return false;
+}
+
+int SoundPlayer::playSound(const std::string &soundId) {
+    return -1;
+}
+
+void SoundPlayer::setSoundVolume(const std::string &soundId, float volume) {
+}
+
+float SoundPlayer::getSoundVolume(const std::string &soundId) {
+    return 0.0f;
+}
+
+void SoundPlayer::setSoundEffects(const std::string &soundId, float pitch, float pan) {
+}
+
+void SoundPlayer::stopSound(const std::string &soundId) {
+}
+
+void SoundPlayer::stopStreamedSound() {
+}
+
+void SoundPlayer::checkAudio() {
+}
+
+bool SoundPlayer::isSoundPlaying(const std::string &soundId) {
+    return false;
+}
+
+bool SoundPlayer::isSoundLoaded(const std::string &soundId) {
+    return false;
+}
+
+void SoundPlayer::freeAudio(const std::string &soundId) {
+}
+
+void SoundPlayer::cleanupAudio() {
+}
+
+void SoundPlayer::deinit() {
+}
@@ -0,0 +1,538 @@
+#include "../scratch/image.hpp"
+#include "../scratch/costumePrefetch.hpp"
+#include "../scratch/frameScheduler.hpp"
+#include "../scratch/lruCache.hpp"
+#include "../scratch/os.hpp"
+#include "../scratch/texturePolicy.hpp"
+#include "../scratch/unzip.hpp"
+#include "../scratch/workerPool.hpp"
+#include "effects.hpp"
+#include "image.hpp"
+#include "miniz/miniz.h"
+#include "render.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#define NANOSVG_IMPLEMENTATION
+#include "nanosvg.h"
+#define NANOSVGRAST_IMPLEMENTATION
+#include "nanosvgrast.h"
+
+std::unordered_map<std::string, HeadlessImage *> images;
+static std::vector<std::string> toDelete;
+
+// frames an image can go unused before it's freed
+#define MAX_UNUSED_FRAMES 480
+
+// fractions of the RAM or VRAM budget where images start getting freed before they expire, and where that stops
+#define LOW_MEMORY_START 0.8
+#define LOW_MEMORY_STOP 0.5
+
+// costumes by when they were last drawn. Prefetched ones only join once something asks for them
+static LruCache imageCache(MAX_UNUSED_FRAMES);
+
+// costumes with graphic effects applied, by `Effects::getCacheKey()`
+static std::unordered_map<std::string, HeadlessImage *> effectImages;
+static LruCache effectImageCache(MAX_UNUSED_FRAMES);
+
+// costumes waiting to be prefetched, and prefetched ones nothing has asked for yet
+static std::deque<std::string> prefetchQueue;
+static std::unordered_set<std::string> prefetchedImages;
+
+/**
+ * Starts freeing an image once it goes unused, as the most recently used one in `cache`.
+ */
+static void trackImage(LruCache &cache, const std::string &id, HeadlessImage *image) {
+    image->cache = &cache;
+    image->cacheEntry = cache.add(id, image->memorySize);
+}
+
+/**
+ * Makes a prefetched image expire like any other, now that something asked for it.
+ */
+static void claimPrefetchedImage(const std::string &imgId, HeadlessImage *image) {
+    if (prefetchedImages.erase(imgId) != 0) trackImage(imageCache, imgId, image);
+}
+
+/**
+ * Rasterizes SVG data at its native size.
+ * @return RGBA data that has to be freed with `free()`, or `nullptr` if the SVG couldn't be parsed.
+ */
+static unsigned char *SVGToRGBA(const void *svgData, size_t svgSize, int &width, int &height) {
+    // nanosvg wants a null-terminated string it can modify
+    std::vector<char> svgString(svgSize + 1);
+    memcpy(svgString.data(), svgData, svgSize);
+    svgString[svgSize] = '\0';
+
+    NSVGimage *svg = nsvgParse(svgString.data(), "px", 96.0f);
+    if (!svg) return nullptr;
+
+    width = std::max(1, static_cast<int>(std::ceil(svg->width)));
+    height = std::max(1, static_cast<int>(std::ceil(svg->height)));
+
+    NSVGrasterizer *rasterizer = nsvgCreateRasterizer();
+    unsigned char *rgba = static_cast<unsigned char *>(malloc(width * height * 4));
+    if (!rasterizer || !rgba) {
+        if (rasterizer) nsvgDeleteRasterizer(rasterizer);
+        free(rgba);
+        nsvgDelete(svg);
+        return nullptr;
+    }
+    nsvgRasterize(rasterizer, svg, 0, 0, 1.0f, rgba, width, height, width * 4);
+
+    nsvgDeleteRasterizer(rasterizer);
+    nsvgDelete(svg);
+    return rgba;
+}
+
+/**
+ * Gets the size a project costume gets stored at, if `TexturePolicy` is on. Only call from the main thread.
+ * @return The scale to pass to `decodePixels()`.
+ */
+static double getTextureScale(const std::string &imgId) {
+    return TexturePolicy::enabled ? TexturePolicy::getScale(imgId) : 0;
+}
+
+/**
+ * Decodes bitmap or SVG data into premultiplied pixels. Doesn't touch anything shared, so it's safe on worker threads.
+ * @param textureScale From `getTextureScale()`, or 0 to keep the whole image as it is.
+ * @return `false` if the data couldn't be decoded.
+ */
+static bool decodePixels(const void *data, size_t size, bool isSVG, double textureScale, std::vector<uint32_t> &pixels,
+                         int &width, int &height, TexturePolicy::Layout &layout) {
+    unsigned char *rgba;
+    if (isSVG) {
+        rgba = SVGToRGBA(data, size, width, height);
+    } else {
+        int channels;
+        rgba = stbi_load_from_memory(static_cast<const stbi_uc *>(data), size, &width, &height, &channels, 4);
+    }
+    if (!rgba) {
+        width = 0;
+        height = 0;
+        return false;
+    }
+
+    // stored the way a console would, so it looks the same as it would there
+    std::vector<uint8_t> compacted;
+    const unsigned char *stored = rgba;
+    layout = TexturePolicy::getFullLayout(width, height);
+    if (textureScale > 0) {
+        layout = TexturePolicy::plan(rgba, width, height, textureScale);
+        compacted = TexturePolicy::apply(layout, rgba, width);
+        stored = compacted.data();
+    }
+
+    // premultiply alpha, so drawing onto the transparent pen layer blends correctly
+    const int pixelCount = layout.textureWidth * layout.textureHeight;
+    pixels.resize(pixelCount);
+    for (int i = 0; i < pixelCount; i++) {
+        const unsigned char *pixel = &stored[i * 4];
+        const uint32_t alpha = pixel[3];
+        pixels[i] = ((pixel[0] * alpha + 127) / 255) |
+                    ((pixel[1] * alpha + 127) / 255) << 8 |
+                    ((pixel[2] * alpha + 127) / 255) << 16 |
+                    alpha << 24;
+    }
+    if (isSVG) free(rgba);
+    else stbi_image_free(rgba);
+    return true;
+}
+
+HeadlessImage::HeadlessImage() {}
+
+HeadlessImage::HeadlessImage(const void *data, size_t size, bool isSVG, double textureScale) : isSVG(isSVG) {
+    if (!decodePixels(data, size, isSVG, textureScale, pixels, width, height, layout)) return;
+    memorySize = TexturePolicy::getMemorySize(layout);
+    MemoryTracker::allocateVRAM(memorySize);
+}
+
+HeadlessImage::~HeadlessImage() {
+    if (cache) cache->remove(cacheEntry);
+    MemoryTracker::deallocateVRAM(memorySize);
+}
+
+void HeadlessImage::markUsed() {
+    if (cache) cache->touch(cacheEntry);
+}
+
+static void freeEffectImage(std::unordered_map<std::string, HeadlessImage *>::iterator it) {
+    it->second->~HeadlessImage();
+    MemoryTracker::deallocate<HeadlessImage>(it->second);
+    effectImages.erase(it);
+}
+
+HeadlessImage *getEffectImage(const std::string &costumeId, const GraphicEffects &effects) {
+    const std::string key = Effects::getCacheKey(costumeId, effects);
+    auto effectFind = effectImages.find(key);
+    if (effectFind != effectImages.end()) {
+        effectFind->second->markUsed();
+        return effectFind->second;
+    }
+
+    auto imgFind = images.find(costumeId);
+    if (imgFind == images.end()) return nullptr;
+    const HeadlessImage *source = imgFind->second;
+    const size_t memorySize = source->pixels.size() * 4;
+
+    // make room by freeing whatever went unused the longest
+    const size_t maxSize = MemoryTracker::getMaxVRAMUsage() / 8;
+    while (!effectImageCache.empty() && effectImageCache.getMemorySize() + memorySize > maxSize) {
+        freeEffectImage(effectImages.find(effectImageCache.getOldest().id));
+    }
+
+    // effects work on straight alpha
+    std::vector<uint32_t> straight(source->pixels.size());
+    for (size_t i = 0; i < source->pixels.size(); i++) {
+        const uint32_t pixel = source->pixels[i];
+        const uint32_t alpha = pixel >> 24;
+        if (alpha == 0) {
+            straight[i] = 0;
+            continue;
+        }
+        straight[i] = std::min(255u, ((pixel & 0xFF) * 255 + alpha / 2) / alpha) |
+                      std::min(255u, (((pixel >> 8) & 0xFF) * 255 + alpha / 2) / alpha) << 8 |
+                      std::min(255u, (((pixel >> 16) & 0xFF) * 255 + alpha / 2) / alpha) << 16 |
+                      alpha << 24;
+    }
+
+    HeadlessImage *image = MemoryTracker::allocate<HeadlessImage>();
+    new (image) HeadlessImage();
+    image->width = source->width;
+    image->height = source->height;
+    image->isSVG = source->isSVG;
+    // effects get applied to what's stored, so `TexturePolicy` trimming or shrinking the costume carries over
+    image->layout = source->layout;
+    image->layout.format = TexturePolicy::RGBA8888;
+    image->pixels.resize(straight.size());
+    Effects::apply(straight.data(), image->pixels.data(), image->layout.textureWidth, image->layout.textureHeight, Effects::quantize(effects));
+
+    for (uint32_t &pixel : image->pixels) {
+        const uint32_t alpha = pixel >> 24;
+        pixel = ((pixel & 0xFF) * alpha + 127) / 255 |
+                ((((pixel >> 8) & 0xFF) * alpha + 127) / 255) << 8 |
+                ((((pixel >> 16) & 0xFF) * alpha + 127) / 255) << 16 |
+                alpha << 24;
+    }
+
+    image->memorySize = memorySize;
+    MemoryTracker::allocateVRAM(memorySize);
+    trackImage(effectImageCache, key, image);
+    effectImages[key] = image;
+    return image;
+}
+
+static bool isSVGFile(const std::string &fileName) {
+    return fileName.size() >= 4 &&
+           (fileName.substr(fileName.size() - 4) == ".svg" ||
+            fileName.substr(fileName.size() - 4) == ".SVG");
+}
+
+Image::Image(std::string filePath) {
+    if (!loadImageFromFile(filePath, false)) return;
+    std::string imgId = filePath.substr(0, filePath.find_last_of('.'));
+    imageId = imgId;
+    width = images[imgId]->width;
+    height = images[imgId]->height;
+    scale = 1.0;
+    rotation = 0.0;
+    opacity = 1.0;
+}
+
+Image::~Image() {
+    auto it = images.find(imageId);
+    if (it != images.end()) {
+        freeImage(imageId);
+    }
+}
+
+void Image::render(double xPos, double yPos, bool centered) {
+    auto imgFind = images.find(imageId);
+    if (imgFind == images.end()) return;
+    HeadlessImage *image = imgFind->second;
+    image->markUsed();
+
+    double centerX = xPos;
+    double centerY = yPos;
+    if (!centered) {
+        centerX += image->width * scale / 2;
+        centerY += image->height * scale / 2;
+    }
+    blitImage(framebuffer.data(), image, centerX, centerY, scale, scale, rotation * (M_PI / 180.0), static_cast<uint8_t>(opacity * 255));
+}
+
+/**
+ * Images get loaded when they're first needed, so this does nothing.
+ */
+void Image::loadImages(mz_zip_archive *zip) {
+}
+
+bool Image::loadImageFromFile(std::string filePath, bool fromScratchProject) {
+    std::string imgId = filePath.substr(0, filePath.find_last_of('.'));
+    auto imgFind = images.find(imgId);
+    if (imgFind != images.end()) {
+        claimPrefetchedImage(imgId, imgFind->second);
+        return true;
+    }
+
+    std::string finalPath = filePath;
+    if (fromScratchProject) finalPath = "project/" + finalPath;
+
+    std::ifstream file(finalPath, std::ios::binary);
+    if (!file) {
+        Log::logWarning("Error loading image: " + finalPath);
+        return false;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    HeadlessImage *image = MemoryTracker::allocate<HeadlessImage>();
+    new (image) HeadlessImage(data.data(), data.size(), isSVGFile(filePath), fromScratchProject ? getTextureScale(imgId) : 0);
+    if (image->pixels.empty()) {
+        Log::logWarning("Failed to decode image: " + finalPath);
+        image->~HeadlessImage();
+        MemoryTracker::deallocate<HeadlessImage>(image);
+        return false;
+    }
+
+    trackImage(imageCache, imgId, image);
+    images[imgId] = image;
+    return true;
+}
+
+void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId) {
+    std::string imgId = costumeId.substr(0, costumeId.find_last_of('.'));
+    auto imgFind = images.find(imgId);
+    if (imgFind != images.end()) {
+        claimPrefetchedImage(imgId, imgFind->second);
+        return;
+    }
+
+    int file_index = mz_zip_reader_locate_file(zip, costumeId.c_str(), nullptr, 0);
+    if (file_index < 0) {
+        Log::logWarning("Image file not found in zip: " + costumeId);
+        return;
+    }
+
+    size_t file_size;
+    void *file_data = mz_zip_reader_extract_to_heap(zip, file_index, &file_size, 0);
+    if (!file_data) {
+        Log::logWarning("Failed to extract: " + costumeId);
+        return;
+    }
+
+    HeadlessImage *image = MemoryTracker::allocate<HeadlessImage>();
+    new (image) HeadlessImage(file_data, file_size, isSVGFile(costumeId), getTextureScale(imgId));
+    mz_free(file_data);
+
+    if (image->pixels.empty()) {
+        Log::logWarning("Failed to decode image: " + costumeId);
+        image->~HeadlessImage();
+        MemoryTracker::deallocate<HeadlessImage>(image);
+        return;
+    }
+
+    trackImage(imageCache, imgId, image);
+    images[imgId] = image;
+}
+
+/**
+ * Reads a costume file from the current project, without decoding it.
+ */
+static bool readCostumeFile(const std::string &fileName, std::vector<char> &data) {
+    if (projectType == UNZIPPED) {
+        std::ifstream file("project/" + fileName, std::ios::binary);
+        if (!file) return false;
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    // reading a zip that's in memory doesn't change it, so worker threads can all do it at once
+    int fileIndex = mz_zip_reader_locate_file(&Unzip::zipArchive, fileName.c_str(), nullptr, 0);
+    if (fileIndex < 0) return false;
+
+    size_t fileSize;
+    void *fileData = mz_zip_reader_extract_to_heap(&Unzip::zipArchive, fileIndex, &fileSize, 0);
+    if (!fileData) return false;
+    data.assign(static_cast<const char *>(fileData), static_cast<const char *>(fileData) + fileSize);
+    mz_free(fileData);
+    return true;
+}
+
+struct DecodeJob {
+    std::string fileName;
+    double textureScale = 0;
+    std::vector<uint32_t> pixels;
+    int width = 0;
+    int height = 0;
+    TexturePolicy::Layout layout;
+    bool found = false;
+};
+
+void Image::loadImagesFromProject(const std::vector<std::string> &fileNames, const std::function<void(size_t)> &onLoaded) {
+    std::vector<DecodeJob> jobs;
+    for (const std::string &fileName : fileNames) {
+        const std::string imgId = fileName.substr(0, fileName.find_last_of('.'));
+        if (images.find(imgId) != images.end()) continue;
+        if (std::any_of(jobs.begin(), jobs.end(), [&fileName](const DecodeJob &job) { return job.fileName == fileName; })) continue;
+        jobs.emplace_back();
+        jobs.back().fileName = fileName;
+        jobs.back().textureScale = getTextureScale(imgId);
+    }
+
+    size_t loadedCount = 0;
+    WorkerPool::run(
+        jobs.size(),
+        [&jobs](size_t i) {
+            DecodeJob &job = jobs[i];
+            std::vector<char> data;
+            job.found = readCostumeFile(job.fileName, data);
+            if (job.found) decodePixels(data.data(), data.size(), isSVGFile(job.fileName), job.textureScale, job.pixels, job.width, job.height, job.layout);
+        },
+        [&jobs, &loadedCount, &onLoaded](size_t i) {
+            DecodeJob &job = jobs[i];
+            if (!job.found) {
+                Log::logWarning("Image file not found: " + job.fileName);
+            } else if (job.pixels.empty()) {
+                Log::logWarning("Failed to decode image: " + job.fileName);
+            } else {
+                HeadlessImage *image = MemoryTracker::allocate<HeadlessImage>();
+                new (image) HeadlessImage();
+                image->isSVG = isSVGFile(job.fileName);
+                image->width = job.width;
+                image->height = job.height;
+                image->layout = job.layout;
+                image->pixels.swap(job.pixels);
+                image->memorySize = TexturePolicy::getMemorySize(image->layout);
+                MemoryTracker::allocateVRAM(image->memorySize);
+                const std::string imgId = job.fileName.substr(0, job.fileName.find_last_of('.'));
+                trackImage(imageCache, imgId, image);
+                images[imgId] = image;
+            }
+            loadedCount++;
+            if (onLoaded) onLoaded(loadedCount);
+        });
+}
+
+/**
+ * Decodes on the main thread, for up to `CostumePrefetch::MS_PER_FRAME` each frame.
+ */
+void Image::prefetchImages(const std::vector<std::string> &fileNames) {
+    prefetchQueue.insert(prefetchQueue.end(), fileNames.begin(), fileNames.end());
+}
+
+void Image::updatePrefetch() {
+    const double startTime = FrameScheduler::getTimeMs();
+    while (!prefetchQueue.empty() && CostumePrefetch::hasMemoryForMore() && FrameScheduler::getTimeMs() - startTime < CostumePrefetch::MS_PER_FRAME) {
+        const std::string fileName = prefetchQueue.front();
+        prefetchQueue.pop_front();
+
+        const std::string imgId = fileName.substr(0, fileName.find_last_of('.'));
+        if (images.find(imgId) != images.end()) continue;
+
+        if (projectType == UNZIPPED) loadImageFromFile(fileName);
+        else loadImageFromSB3(&Unzip::zipArchive, fileName);
+        auto imgFind = images.find(imgId);
+        if (imgFind == images.end()) continue;
+
+        // it doesn't expire until something asks for it
+        HeadlessImage *image = imgFind->second;
+        imageCache.remove(image->cacheEntry);
+        image->cache = nullptr;
+        prefetchedImages.insert(imgId);
+    }
+}
+
+void Image::cleanupImages() {
+    for (auto &[id, image] : images) {
+        image->~HeadlessImage();
+        MemoryTracker::deallocate<HeadlessImage>(image);
+    }
+    images.clear();
+    toDelete.clear();
+    prefetchQueue.clear();
+    prefetchedImages.clear();
+
+    while (!effectImages.empty()) {
+        freeEffectImage(effectImages.begin());
+    }
+}
+
+void Image::freeImage(const std::string &costumeId) {
+    auto imageIt = images.find(costumeId);
+    if (imageIt != images.end()) {
+        HeadlessImage *image = imageIt->second;
+        image->~HeadlessImage();
+        MemoryTracker::deallocate<HeadlessImage>(image);
+        images.erase(imageIt);
+        prefetchedImages.erase(costumeId);
+    }
+}
+
+void Image::queueFreeImage(const std::string &costumeId) {
+    toDelete.push_back(costumeId);
+}
+
+/**
+ * Frees the costume that went unused the longest.
+ */
+static void freeOldestImage() {
+    const std::string id = imageCache.getOldest().id;
+    Image::freeImage(id);
+}
+
+/**
+ * Loads costumes `TexturePolicy` wants stored at another size again.
+ */
+static void reloadResizedImages() {
+    for (const std::string &fileName : TexturePolicy::takeReloads()) {
+        const std::string imgId = fileName.substr(0, fileName.find_last_of('.'));
+        if (images.find(imgId) == images.end()) continue;
+        Image::freeImage(imgId);
+        if (projectType == UNZIPPED) Image::loadImageFromFile(fileName);
+        else Image::loadImageFromSB3(&Unzip::zipArchive, fileName);
+    }
+}
+
+/**
+ * Frees images that went unused for `MAX_UNUSED_FRAMES` frames, or sooner when memory runs low, same as the SDL version.
+ */
+void Image::FlushImages() {
+    for (const std::string &id : toDelete) {
+        Image::freeImage(id);
+    }
+    toDelete.clear();
+    reloadResizedImages();
+
+    imageCache.keepDrawn();
+    effectImageCache.keepDrawn();
+
+    if (LruCache::isOverBudget(LOW_MEMORY_START)) {
+        // prefetched images nothing asked for yet go first
+        while (LruCache::isOverBudget(LOW_MEMORY_STOP) && !prefetchedImages.empty()) {
+            const std::string id = *prefetchedImages.begin();
+            Image::freeImage(id);
+        }
+        while (LruCache::isOverBudget(LOW_MEMORY_STOP) && !imageCache.empty() && !imageCache.isOldestInUse()) {
+            freeOldestImage();
+        }
+    }
+    while (imageCache.hasExpired()) {
+        freeOldestImage();
+    }
+
+    while (effectImageCache.hasExpired()) {
+        freeEffectImage(effectImages.find(effectImageCache.getOldest().id));
+    }
+
+    LruCache::nextFrame();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "lruCache.hpp"
+#include "sprite.hpp"
+#include "texturePolicy.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class HeadlessImage {
+  public:
+    std::vector<uint32_t> pixels; // premultiplied RGBA8888, one row after another, `layout.textureWidth` wide
+    size_t memorySize = 0;
+    int width = 0; // size of the whole costume, even if `layout` trimmed some of it off
+    int height = 0;
+    TexturePolicy::Layout layout;
+    bool isSVG = false;
+    LruCache *cache = nullptr; // the cache that frees the image once it goes unused, if any
+    LruCache::Handle cacheEntry;
+
+    /**
+     * Marks the image as used this frame, so it doesn't get freed.
+     */
+    void markUsed();
+
+    /**
+     * An image decoded into CPU memory, for the headless renderer.
+     */
+    HeadlessImage();
+    /**
+     * An image decoded into CPU memory, for the headless renderer.
+     * @param data Encoded bitmap or SVG data.
+     * @param size
+     * @param isSVG
+     * @param textureScale Scale to store it at with `TexturePolicy`, or 0 to keep it as it is.
+     */
+    HeadlessImage(const void *data, size_t size, bool isSVG, double textureScale);
+
+    ~HeadlessImage();
+};
+
+extern std::unordered_map<std::string, HeadlessImage *> images;
+
+/**
+ * Gets a costume with graphic effects applied. Results are cached, up to an eighth of the max VRAM usage.
+ * @param costumeId
+ * @param effects
+ * @return The image with effects, or `nullptr` if the costume isn't loaded.
+ */
+HeadlessImage *getEffectImage(const std::string &costumeId, const GraphicEffects &effects);
@@ -0,0 +1,102 @@
+#include "../scratch/input.hpp"
+#include "../scratch/blockExecutor.hpp"
+#include "render.hpp"
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+Input::Mouse Input::mousePointer;
+Sprite *Input::draggingSprite = nullptr;
+
+std::vector<std::string> Input::inputButtons;
+std::map<std::string, std::string> Input::inputControls;
+int Input::keyHeldFrames = 0;
+
+struct ScriptedInput {
+    int frame;
+    int heldFrames;
+    std::string key; // empty for mouse clicks
+    int mouseX = 0;
+    int mouseY = 0;
+};
+
+static std::vector<ScriptedInput> inputScript;
+
+bool Headless::loadInputScript(const std::string &filePath) {
+    std::ifstream file(filePath);
+    if (!file.is_open()) {
+        Log::logError("Couldn't open input file: " + filePath);
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream stream(line);
+        ScriptedInput input;
+        if (!(stream >> input.frame >> input.heldFrames)) {
+            Log::logError("Invalid input on line " + std::to_string(lineNumber) + " of " + filePath);
+            return false;
+        }
+        std::getline(stream >> std::ws, input.key);
+        if (input.key.rfind("mouse", 0) == 0) {
+            std::istringstream mouse(input.key.substr(5));
+            if (!(mouse >> input.mouseX >> input.mouseY)) {
+                Log::logError("Invalid mouse position on line " + std::to_string(lineNumber) + " of " + filePath);
+                return false;
+            }
+            input.key = "";
+        } else if (input.key.empty()) {
+            Log::logError("Missing key on line " + std::to_string(lineNumber) + " of " + filePath);
+            return false;
+        }
+        inputScript.push_back(input);
+    }
+    return true;
+}
+
+std::vector<int> Input::getTouchPosition() {
+    return {0, 0};
+}
+
+/**
+ * Headless runs don't have any input devices, so the only input is what `Headless::loadInputScript()` loaded.
+ */
+void Input::getInput() {
+    inputButtons.clear();
+    mousePointer.isPressed = false;
+    mousePointer.isMoving = false;
+
+    bool anyKeyPressed = false;
+    for (const ScriptedInput &input : inputScript) {
+        if (Headless::frameCount < input.frame || Headless::frameCount >= input.frame + input.heldFrames) continue;
+
+        if (input.key.empty()) {
+            if (mousePointer.x != input.mouseX || mousePointer.y != input.mouseY) mousePointer.isMoving = true;
+            mousePointer.x = input.mouseX;
+            mousePointer.y = input.mouseY;
+            mousePointer.isPressed = true;
+        } else {
+            inputButtons.push_back(input.key);
+            anyKeyPressed = true;
+        }
+    }
+
+    if (anyKeyPressed) {
+        keyHeldFrames++;
+        inputButtons.push_back("any");
+        if (keyHeldFrames == 1 || keyHeldFrames > 13)
+            BlockExecutor::runAllBlocksByOpcode("event_whenkeypressed");
+    } else keyHeldFrames = 0;
+
+    doSpriteClicking();
+}
+
+std::string Input::getUsername() {
+    return "Player";
+}
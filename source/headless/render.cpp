@@ -0,0 +1,552 @@
+#include "../scratch/render.hpp"
+#include "../scratch/audio.hpp"
+#include "../scratch/image.hpp"
+#include "bench.hpp"
+#include "blockExecutor.hpp"
+#include "effects.hpp"
+#include "image.hpp"
+#include "interpret.hpp"
+#include "layers.hpp"
+#include "lruCache.hpp"
+#include "math.hpp"
+#include "miniz/miniz.h"
+#include "penLayer.hpp"
+#include "render.hpp"
+#include "renderState.hpp"
+#include "sprite.hpp"
+#include "text.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+int windowWidth = 480;
+int windowHeight = 360;
+std::vector<uint32_t> framebuffer;
+
+Render::RenderModes Render::renderMode = Render::TOP_SCREEN_ONLY;
+bool Render::hasFrameBegan;
+std::vector<Monitor> Render::visibleVariables;
+std::chrono::_V2::system_clock::time_point Render::startTime = std::chrono::high_resolution_clock::now();
+std::chrono::_V2::system_clock::time_point Render::endTime = std::chrono::high_resolution_clock::now();
+
+std::string Headless::projectPath = "";
+std::string Headless::dumpFolder = "";
+std::string Headless::benchPath = "";
+int Headless::maxFrames = -1;
+int Headless::frameCount = 0;
+bool Headless::fixedTimestep = false;
+
+static std::chrono::high_resolution_clock::time_point runStartTime;
+
+// pixels to blend into the framebuffer, reused between draws
+static std::vector<uint32_t> rowBuffer;
+
+// everything the pen has drawn, between the Stage and the sprites
+static std::vector<uint32_t> penLayer;
+static bool penLayerEmpty = true;
+
+// Pixels are stored as premultiplied RGBA bytes, so on little endian machines alpha is the top byte of each pixel.
+static inline uint32_t packColor(int r, int g, int b, int a) {
+    const uint32_t alpha = std::clamp(a, 0, 255);
+    return (std::clamp(r, 0, 255) * alpha + 127) / 255 |
+           ((std::clamp(g, 0, 255) * alpha + 127) / 255) << 8 |
+           ((std::clamp(b, 0, 255) * alpha + 127) / 255) << 16 |
+           alpha << 24;
+}
+
+/**
+ * Draws premultiplied `src` over `dst`.
+ * `(c + (c >> 8)) >> 8` is a divide by 255 that's exact for every value we can get here.
+ */
+static inline uint32_t blendPixel(uint32_t dst, uint32_t src) {
+    const uint32_t alpha = src >> 24;
+    if (alpha == 0) return dst;
+    if (alpha == 255) return src;
+
+    const uint32_t inverse = 255 - alpha;
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const uint32_t c = ((dst >> shift) & 0xFF) * inverse + 128;
+        out |= (((src >> shift) & 0xFF) + ((c + (c >> 8)) >> 8)) << shift;
+    }
+    return out;
+}
+
+#ifdef __SSE2__
+/**
+ * Same as `blendPixel()`, for two pixels unpacked into 16 bit lanes.
+ */
+static inline __m128i blendPixels(__m128i src, __m128i dst) {
+    const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    const __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+
+    const __m128i c = _mm_add_epi16(_mm_mullo_epi16(dst, inverse), _mm_set1_epi16(128));
+    return _mm_add_epi16(src, _mm_srli_epi16(_mm_add_epi16(c, _mm_srli_epi16(c, 8)), 8));
+}
+#endif
+
+static void blendRow(uint32_t *dst, const uint32_t *src, int count) {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        const __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+
+        // skip fully transparent pixels, since most sprites have a lot of them
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(source, zero)) == 0xFFFF) continue;
+
+        const __m128i destination = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        const __m128i low = blendPixels(_mm_unpacklo_epi8(source, zero), _mm_unpacklo_epi8(destination, zero));
+        const __m128i high = blendPixels(_mm_unpackhi_epi8(source, zero), _mm_unpackhi_epi8(destination, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = blendPixel(dst[i], src[i]);
+    }
+}
+
+/**
+ * Multiplies every channel of a premultiplied pixel by `alpha`.
+ */
+static inline uint32_t fadePixel(uint32_t pixel, uint32_t alpha) {
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        out |= ((((pixel >> shift) & 0xFF) * alpha + 127) / 255) << shift;
+    }
+    return out;
+}
+
+void blitImage(uint32_t *target, HeadlessImage *image, double centerX, double centerY, double scaleX, double scaleY, double rotation, uint8_t alpha) {
+    if (alpha == 0 || image->pixels.empty() || scaleX == 0 || scaleY == 0) return;
+
+    const double cosRotation = std::cos(rotation);
+    const double sinRotation = std::sin(rotation);
+    const double halfWidth = image->width * std::abs(scaleX) / 2.0;
+    const double halfHeight = image->height * std::abs(scaleY) / 2.0;
+
+    // screen space bounding box of the rotated image
+    const double extentX = std::abs(halfWidth * cosRotation) + std::abs(halfHeight * sinRotation);
+    const double extentY = std::abs(halfWidth * sinRotation) + std::abs(halfHeight * cosRotation);
+    const int minX = std::max(0, static_cast<int>(std::floor(centerX - extentX)));
+    const int maxX = std::min(windowWidth, static_cast<int>(std::ceil(centerX + extentX)));
+    const int minY = std::max(0, static_cast<int>(std::floor(centerY - extentY)));
+    const int maxY = std::min(windowHeight, static_cast<int>(std::ceil(centerY + extentY)));
+    if (minX >= maxX || minY >= maxY) return;
+
+    // how far one screen pixel moves through the image
+    const double stepUX = cosRotation / scaleX;
+    const double stepVX = -sinRotation / scaleY;
+    const double stepUY = sinRotation / scaleX;
+    const double stepVY = cosRotation / scaleY;
+
+    // the same, through what's stored, in case `TexturePolicy` trimmed or shrunk the costume
+    const TexturePolicy::Layout &layout = image->layout;
+    const double texelsX = static_cast<double>(layout.textureWidth) / layout.width;
+    const double texelsY = static_cast<double>(layout.textureHeight) / layout.height;
+    const double texelStepUX = stepUX * texelsX;
+    const double texelStepVX = stepVX * texelsY;
+
+    const int spanWidth = maxX - minX;
+    rowBuffer.resize(spanWidth);
+
+    for (int y = minY; y < maxY; y++) {
+        const double dx = minX + 0.5 - centerX;
+        const double dy = y + 0.5 - centerY;
+        double u = (image->width / 2.0 + dx * stepUX + dy * stepUY - layout.x) * texelsX;
+        double v = (image->height / 2.0 + dx * stepVX + dy * stepVY - layout.y) * texelsY;
+
+        for (int i = 0; i < spanWidth; i++, u += texelStepUX, v += texelStepVX) {
+            if (u < 0 || v < 0 || u >= layout.textureWidth || v >= layout.textureHeight) {
+                rowBuffer[i] = 0;
+                continue;
+            }
+            const uint32_t pixel = image->pixels[static_cast<int>(v) * layout.textureWidth + static_cast<int>(u)];
+            rowBuffer[i] = alpha == 255 ? pixel : fadePixel(pixel, alpha);
+        }
+        blendRow(&target[y * windowWidth + minX], rowBuffer.data(), spanWidth);
+    }
+}
+
+void fillRect(int x, int y, int w, int h, int colorR, int colorG, int colorB, int colorA) {
+    const int minX = std::max(0, x);
+    const int maxX = std::min(windowWidth, x + w);
+    const int minY = std::max(0, y);
+    const int maxY = std::min(windowHeight, y + h);
+    if (minX >= maxX || minY >= maxY || colorA <= 0) return;
+
+    rowBuffer.assign(maxX - minX, packColor(colorR, colorG, colorB, colorA));
+    for (int row = minY; row < maxY; row++) {
+        blendRow(&framebuffer[row * windowWidth + minX], rowBuffer.data(), maxX - minX);
+    }
+}
+
+/**
+ * Tells `TexturePolicy` how big a costume is about to be drawn, if it's on.
+ * @param screenScale Screen pixels per pixel of the image.
+ */
+static void observeScale(const std::string &costumeId, const std::string &fileName, const HeadlessImage *image, double screenScale) {
+    if (!TexturePolicy::enabled) return;
+    TexturePolicy::observeScale(costumeId, fileName, std::abs(screenScale), image->layout);
+}
+
+/**
+ * Gets how many screen pixels a pixel of a costume covers at a sprite size, same as `drawCostume()`.
+ */
+static double getCostumeScale(const HeadlessImage *image, double size) {
+    // bitmaps usually have twice the resolution, while SVGs get rasterized at their own size
+    const double imageScale = (size * 0.01) / 2.0f;
+    return image->isSVG ? imageScale * 2 : imageScale;
+}
+
+/**
+ * Draws a costume the same way the SDL renderer places it, so sprites and stamps end up on the same pixels.
+ */
+static void drawCostume(uint32_t *target, HeadlessImage *image, double xPosition, double yPosition, double size, double direction,
+                        Sprite::RotationStyle rotationStyle, int costumeCenterX, int costumeCenterY, float ghostEffect) {
+    // the framebuffer is always the size of the project
+    const double scale = 1.0;
+
+    double imageScale = (size * 0.01) * scale / 2.0f;
+    const int spriteWidth = image->width / 2;
+    const int spriteHeight = image->height / 2;
+    if (image->isSVG) imageScale *= 2;
+
+    const double rotation = Math::degreesToRadians(direction - 90.0f);
+    double renderRotation = rotation;
+    bool flip = false;
+
+    if (rotationStyle == Sprite::LEFT_RIGHT) {
+        if (std::cos(rotation) < 0) {
+            flip = true;
+        }
+        renderRotation = 0;
+    }
+    if (rotationStyle == Sprite::NONE) {
+        renderRotation = 0;
+    }
+
+    double rotationCenterX = ((((costumeCenterX - spriteWidth)) / 2) * scale);
+    double rotationCenterY = ((((costumeCenterY - spriteHeight)) / 2) * scale);
+
+    const double offsetX = rotationCenterX * (size * 0.01);
+    const double offsetY = rotationCenterY * (size * 0.01);
+
+    const double centerX = (xPosition * scale) + (windowWidth / 2) - offsetX * std::cos(rotation) + offsetY * std::sin(renderRotation);
+    const double centerY = (yPosition * -scale) + (windowHeight / 2) - offsetX * std::sin(rotation) - offsetY * std::cos(renderRotation);
+
+    // ghost effect
+    float ghost = std::clamp(ghostEffect, 0.0f, 100.0f);
+    uint8_t alpha = static_cast<uint8_t>(255 * (1.0f - ghost / 100.0f));
+
+    blitImage(target, image, centerX, centerY, flip ? -imageScale : imageScale, imageScale, renderRotation, alpha);
+}
+
+/**
+ * Draws a pen line with round ends, using the distance of every pixel to the line for antialiasing.
+ */
+static void drawPenLine(const PenLine &line) {
+    const double radius = line.size / 2.0;
+    const double x1 = windowWidth / 2.0 + line.x1;
+    const double y1 = windowHeight / 2.0 - line.y1;
+    const double dx = line.x2 - line.x1;
+    const double dy = line.y1 - line.y2;
+    const double lengthSquared = dx * dx + dy * dy;
+
+    const int minX = std::max(0, static_cast<int>(std::floor(std::min(x1, x1 + dx) - radius - 1)));
+    const int maxX = std::min(windowWidth, static_cast<int>(std::ceil(std::max(x1, x1 + dx) + radius + 1)));
+    const int minY = std::max(0, static_cast<int>(std::floor(std::min(y1, y1 + dy) - radius - 1)));
+    const int maxY = std::min(windowHeight, static_cast<int>(std::ceil(std::max(y1, y1 + dy) + radius + 1)));
+    if (minX >= maxX || minY >= maxY) return;
+
+    const int spanWidth = maxX - minX;
+    rowBuffer.resize(spanWidth);
+
+    for (int y = minY; y < maxY; y++) {
+        for (int i = 0; i < spanWidth; i++) {
+            const double px = minX + i + 0.5 - x1;
+            const double py = y + 0.5 - y1;
+            const double t = lengthSquared > 0 ? std::clamp((px * dx + py * dy) / lengthSquared, 0.0, 1.0) : 0.0;
+            const double distance = std::hypot(px - t * dx, py - t * dy);
+            const double coverage = std::clamp(radius + 0.5 - distance, 0.0, 1.0);
+            rowBuffer[i] = coverage > 0 ? packColor(line.r, line.g, line.b, static_cast<int>(line.a * coverage + 0.5)) : 0;
+        }
+        blendRow(&penLayer[y * windowWidth + minX], rowBuffer.data(), spanWidth);
+    }
+}
+
+/**
+ * Draws everything the pen blocks queued up since the last frame onto the pen layer.
+ */
+static void drawPenQueue() {
+    if (PenLayer::shouldClear) {
+        std::fill(penLayer.begin(), penLayer.end(), 0);
+        penLayerEmpty = true;
+    }
+
+    size_t line = 0;
+    for (const PenStamp &stamp : PenLayer::stamps) {
+        for (; line < stamp.lineCount; line++) {
+            drawPenLine(PenLayer::lines[line]);
+        }
+        auto imgFind = images.find(stamp.costumeId);
+        if (imgFind != images.end()) {
+            imgFind->second->markUsed();
+            HeadlessImage *image = imgFind->second;
+            observeScale(stamp.costumeId, stamp.costumeFile, image, getCostumeScale(image, stamp.size));
+            if (Effects::isActive(stamp.effects)) {
+                HeadlessImage *effectImage = getEffectImage(stamp.costumeId, stamp.effects);
+                if (effectImage) image = effectImage;
+            }
+            drawCostume(penLayer.data(), image, stamp.xPosition, stamp.yPosition, stamp.size, stamp.rotation,
+                        stamp.rotationStyle, stamp.rotationCenterX, stamp.rotationCenterY, stamp.ghostEffect);
+        }
+    }
+    for (; line < PenLayer::lines.size(); line++) {
+        drawPenLine(PenLayer::lines[line]);
+    }
+
+    if (!PenLayer::lines.empty() || !PenLayer::stamps.empty()) penLayerEmpty = false;
+    PenLayer::clearQueue();
+}
+
+bool Headless::parseArguments(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) {
+            maxFrames = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--fixed-timestep") {
+            fixedTimestep = true;
+        } else if (arg == "--dump-frames" && i + 1 < argc) {
+            dumpFolder = argv[++i];
+        } else if (arg == "--compact-textures") {
+            TexturePolicy::enabled = true;
+        } else if (arg == "--input" && i + 1 < argc) {
+            if (!loadInputScript(argv[++i])) return false;
+#ifdef ENABLE_BENCH
+        } else if (arg == "--bench" && i + 1 < argc) {
+            benchPath = argv[++i];
+#endif
+        } else if (arg.rfind("--", 0) == 0) {
+            Log::logError("Unknown or incomplete option: " + arg);
+            return false;
+        } else {
+            projectPath = arg;
+        }
+    }
+
+    if (projectPath == "") {
+        Log::logError("Usage: " + std::string(argv[0]) + " <project.sb3> [--frames N] [--fixed-timestep] [--dump-frames <folder>] [--compact-textures] [--input <file>] [--bench <file>]");
+        return false;
+    }
+    if (dumpFolder != "") {
+        std::error_code error;
+        std::filesystem::create_directories(dumpFolder, error);
+        if (error) {
+            Log::logError("Couldn't create frame dump folder: " + dumpFolder);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Headless::saveFramebuffer(const std::string &filePath) {
+    size_t pngSize = 0;
+    void *png = tdefl_write_image_to_png_file_in_memory(framebuffer.data(), windowWidth, windowHeight, 4, &pngSize);
+    if (!png) return false;
+
+    std::ofstream file(filePath, std::ios::binary);
+    file.write(static_cast<const char *>(png), pngSize);
+    mz_free(png);
+    return file.good();
+}
+
+bool Render::Init() {
+    windowWidth = Scratch::projectWidth;
+    windowHeight = Scratch::projectHeight;
+    framebuffer.assign(windowWidth * windowHeight, packColor(255, 255, 255, 255));
+    penLayer.assign(windowWidth * windowHeight, 0);
+    Timer::useVirtualTime = Headless::fixedTimestep;
+    runStartTime = std::chrono::high_resolution_clock::now();
+    return true;
+}
+
+void Render::deInit() {
+    const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - runStartTime).count();
+    if (Headless::frameCount > 0 && elapsed > 0) {
+        Log::log("Rendered " + std::to_string(Headless::frameCount) + " frames in " + std::to_string(static_cast<int>(elapsed)) +
+                 " ms (" + std::to_string(Headless::frameCount * 1000.0 / elapsed) + " fps)");
+    }
+#ifdef ENABLE_BENCH
+    if (Headless::benchPath != "") Bench::save(Headless::benchPath, std::filesystem::path(Headless::projectPath).stem().string());
+#endif
+    SoundPlayer::deinit();
+    framebuffer.clear();
+    penLayer.clear();
+}
+
+void *Render::getRenderer() {
+    return nullptr;
+}
+
+int Render::getWidth() {
+    return windowWidth;
+}
+int Render::getHeight() {
+    return windowHeight;
+}
+int Render::getRefreshRate() {
+    // every frame gets dumped anyway, so there's nothing to draw in between ticks
+    return Scratch::FPS;
+}
+bool Render::hasVsync() {
+    return false;
+}
+
+void Render::beginFrame(int screen, int colorR, int colorG, int colorB) {
+    if (!hasFrameBegan) {
+        std::fill(framebuffer.begin(), framebuffer.end(), packColor(colorR, colorG, colorB, 255));
+        hasFrameBegan = true;
+    }
+}
+
+void Render::endFrame(bool shouldFlush) {
+    LruCache::markDrawn();
+    if (shouldFlush) Image::FlushImages();
+    hasFrameBegan = false;
+}
+
+void Render::drawBox(int w, int h, int x, int y, int colorR, int colorG, int colorB, int colorA) {
+    fillRect(x - (w / 2), y - (h / 2), w, h, colorR, colorG, colorB, colorA);
+}
+
+/**
+ * Draws the Stage, the pen layer, every sprite and the monitors into the framebuffer.
+ */
+static void drawScene() {
+    if (windowWidth != Scratch::projectWidth || windowHeight != Scratch::projectHeight) {
+        windowWidth = Scratch::projectWidth;
+        windowHeight = Scratch::projectHeight;
+        framebuffer.resize(windowWidth * windowHeight);
+        penLayer.assign(windowWidth * windowHeight, 0);
+        penLayerEmpty = true;
+    }
+    std::fill(framebuffer.begin(), framebuffer.end(), packColor(255, 255, 255, 255));
+
+    auto stage = std::find_if(sprites.begin(), sprites.end(), [](const Sprite *sprite) {
+        return sprite->isStage;
+    });
+    if (stage != sprites.end()) {
+        auto stageImgFind = images.find((*stage)->costumes[(*stage)->currentCostume].id);
+        if (stageImgFind != images.end()) {
+            HeadlessImage *image = stageImgFind->second;
+            image->markUsed();
+            const Costume &costume = (*stage)->costumes[(*stage)->currentCostume];
+            observeScale(costume.id, costume.fullName, image, static_cast<double>(windowWidth) / image->width);
+            if (Effects::isActive((*stage)->effects)) {
+                HeadlessImage *effectImage = getEffectImage((*stage)->costumes[(*stage)->currentCostume].id, (*stage)->effects);
+                if (effectImage) image = effectImage;
+            }
+            blitImage(framebuffer.data(), image, windowWidth / 2.0, windowHeight / 2.0,
+                      static_cast<double>(windowWidth) / image->width, static_cast<double>(windowHeight) / image->height, 0, 255);
+        }
+    }
+
+    if (PenLayer::hasQueued()) drawPenQueue();
+    if (!penLayerEmpty) {
+        blendRow(framebuffer.data(), penLayer.data(), windowWidth * windowHeight);
+    }
+
+    for (Sprite *currentSprite = Layers::getBottom(); currentSprite != nullptr; currentSprite = currentSprite->layerAbove) {
+        if (!currentSprite->visible) continue;
+
+        auto imgFind = images.find(currentSprite->costumes[currentSprite->currentCostume].id);
+        if (imgFind == images.end()) {
+            currentSprite->spriteWidth = 64;
+            currentSprite->spriteHeight = 64;
+            const int x = currentSprite->xPosition + (windowWidth / 2);
+            const int y = currentSprite->yPosition * -1 + (windowHeight * 0.5);
+            fillRect(x, y, 16, 1, 0, 0, 0);
+            fillRect(x, y + 15, 16, 1, 0, 0, 0);
+            fillRect(x, y, 1, 16, 0, 0, 0);
+            fillRect(x + 15, y, 1, 16, 0, 0, 0);
+            continue;
+        }
+        currentSprite->rotationCenterX = currentSprite->costumes[currentSprite->currentCostume].rotationCenterX;
+        currentSprite->rotationCenterY = currentSprite->costumes[currentSprite->currentCostume].rotationCenterY;
+
+        HeadlessImage *image = imgFind->second;
+        image->markUsed();
+        currentSprite->spriteWidth = image->width / 2;
+        currentSprite->spriteHeight = image->height / 2;
+        const Costume &costume = currentSprite->costumes[currentSprite->currentCostume];
+        observeScale(costume.id, costume.fullName, image, getCostumeScale(image, currentSprite->size));
+        if (Effects::isActive(currentSprite->effects)) {
+            HeadlessImage *effectImage = getEffectImage(currentSprite->costumes[currentSprite->currentCostume].id, currentSprite->effects);
+            if (effectImage) image = effectImage;
+        }
+
+        drawCostume(framebuffer.data(), image, currentSprite->xPosition, currentSprite->yPosition, currentSprite->size, currentSprite->rotation,
+                    currentSprite->rotationStyle, currentSprite->rotationCenterX, currentSprite->rotationCenterY, currentSprite->ghostEffect);
+    }
+
+    Render::renderVisibleVariables();
+}
+
+void Render::renderSprites() {
+    // when nothing changed the framebuffer still has the last frame, which gets dumped again
+    if (RenderState::shouldRedraw()) drawScene();
+
+    if (Headless::dumpFolder != "") {
+        char fileName[32];
+        snprintf(fileName, sizeof(fileName), "/frame_%06d.png", Headless::frameCount);
+        if (!Headless::saveFramebuffer(Headless::dumpFolder + fileName)) {
+            Log::logWarning("Failed to save frame " + std::to_string(Headless::frameCount));
+        }
+    }
+    Headless::frameCount++;
+    if (Headless::fixedTimestep) Timer::virtualTimeMs += 1000.0 / Scratch::FPS;
+}
+
+std::unordered_map<std::string, TextObject *> Render::monitorTexts;
+
+void Render::renderVisibleVariables() {
+    for (auto &var : visibleVariables) {
+        if (var.visible) {
+            std::string renderText = BlockExecutor::getMonitorValue(var).asString();
+            if (monitorTexts.find(var.id) == monitorTexts.end()) {
+                monitorTexts[var.id] = createTextObject(renderText, var.x, var.y);
+            } else {
+                monitorTexts[var.id]->setText(renderText);
+            }
+            monitorTexts[var.id]->setColor(0x000000FF);
+            monitorTexts[var.id]->setCenterAligned(var.mode == "large");
+            monitorTexts[var.id]->setScale(var.mode == "large" ? 0.625f : 0.5f);
+            monitorTexts[var.id]->render(var.x, var.y);
+        } else {
+            if (monitorTexts.find(var.id) != monitorTexts.end()) {
+                delete monitorTexts[var.id];
+                monitorTexts.erase(var.id);
+            }
+        }
+    }
+}
+
+bool Render::appShouldRun() {
+    if (toExit) return false;
+    if (Headless::maxFrames >= 0 && Headless::frameCount >= Headless::maxFrames) {
+        toExit = true;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "image.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+extern int windowWidth;
+extern int windowHeight;
+
+/**
+ * The in-memory screen everything gets drawn to, premultiplied RGBA8888 one row after another.
+ */
+extern std::vector<uint32_t> framebuffer;
+
+class Headless {
+  public:
+    static std::string projectPath;
+    static std::string dumpFolder;
+    static std::string benchPath;
+    static int maxFrames;
+    static int frameCount;
+    static bool fixedTimestep;
+
+    /**
+     * Reads the command line: `<project.sb3> [--frames N] [--fixed-timestep] [--dump-frames <folder>] [--compact-textures] [--input <file>] [--bench <file>]`.
+     * `--compact-textures` turns on `TexturePolicy`, to see how a project would look on a console with it.
+     * `--bench` saves the `Bench` results when the app closes, and only exists in builds with `ENABLE_BENCH`.
+     * @return `false` if the arguments are invalid and the app should close.
+     */
+    static bool parseArguments(int argc, char **argv);
+
+    /**
+     * Loads input to play back, so runs that need keys or the mouse still come out the same every time.
+     * Every line is `<frame> <frames to hold> <key>`, or `<frame> <frames to hold> mouse <x> <y>` to click,
+     * where keys use Scratch's names (like `space` or `left arrow`). Lines starting with `#` are skipped.
+     * @param filePath
+     * @return `false` if the file couldn't be read or has an invalid line.
+     */
+    static bool loadInputScript(const std::string &filePath);
+
+    /**
+     * Saves the framebuffer as a PNG file.
+     * @param filePath
+     * @return `true` if the file was written, `false` otherwise.
+     */
+    static bool saveFramebuffer(const std::string &filePath);
+};
+
+/**
+ * Draws an image, rotated and scaled around its center.
+ * @param target The framebuffer, or another buffer of the same size.
+ * @param image
+ * @param centerX Where the center of the image goes on screen.
+ * @param centerY
+ * @param scaleX Negative to flip the image horizontally.
+ * @param scaleY
+ * @param rotation In radians, clockwise.
+ * @param alpha 0-255, multiplied with the image's own alpha.
+ */
+void blitImage(uint32_t *target, HeadlessImage *image, double centerX, double centerY, double scaleX, double scaleY, double rotation, uint8_t alpha);
+
+/**
+ * Blends a solid rectangle into the framebuffer.
+ */
+void fillRect(int x, int y, int w, int h, int colorR, int colorG, int colorB, int colorA = 255);
@@ -0,0 +1,23 @@
+#include "text_headless.hpp"
+
+// roughly the size of the default font, in pixels
+#define GLYPH_WIDTH 16
+#define GLYPH_HEIGHT 32
+
+TextObjectHeadless::TextObjectHeadless(std::string txt, double posX, double posY, std::string fontPath)
+    : TextObject(txt, posX, posY, fontPath) {
+}
+
+void TextObjectHeadless::setText(std::string txt) {
+    text = txt;
+}
+
+/**
+ * There's no font to draw with, so this does nothing.
+ */
+void TextObjectHeadless::render(int xPos, int yPos) {
+}
+
+std::vector<float> TextObjectHeadless::getSize() {
+    return {static_cast<float>(text.size() * GLYPH_WIDTH * scale), static_cast<float>(GLYPH_HEIGHT * scale)};
+}
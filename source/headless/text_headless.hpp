@@ -0,0 +1,14 @@
+#pragma once
+#include "../scratch/text.hpp"
+
+class TextObjectHeadless : public TextObject {
+  public:
+    /**
+     * Text without a font, only its size is tracked so layouts still work.
+     */
+    TextObjectHeadless(std::string txt, double posX, double posY, std::string fontPath = "");
+
+    void setText(std::string txt) override;
+    void render(int xPos, int yPos) override;
+    std::vector<float> getSize() override;
+};
@@ -0,0 +1,37 @@
+#include "../scratch/unzip.hpp"
+#include "interpret.hpp"
+#include "miniz/miniz.h"
+#include "os.hpp"
+#include "render.hpp"
+#include <fstream>
+#include <ios>
+#include <string>
+#include <vector>
+
+volatile int Unzip::projectOpened;
+volatile bool Unzip::threadFinished;
+std::string Unzip::filePath = "";
+std::string Unzip::loadingState = "";
+mz_zip_archive Unzip::zipArchive;
+
+/**
+ * Opens the project given on the command line. There's no main menu to fall back to.
+ */
+int Unzip::openFile(std::ifstream *file) {
+    Log::log("Loading SB3 into memory...");
+    projectType = EMBEDDED;
+    file->open(Headless::projectPath, std::ios::binary | std::ios::ate);
+    if (!(*file)) {
+        Log::logError("Couldn't find file: " + Headless::projectPath);
+        return 0;
+    }
+    archivePath = Headless::projectPath;
+    return 1;
+}
+
+bool Unzip::load() {
+    openScratchProject(NULL);
+    if (Unzip::projectOpened == 1)
+        return true;
+    else return false;
+}
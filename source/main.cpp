@@ -13,6 +13,10 @@
 #include <SDL2/SDL.h>
 #endif
 
+#ifdef HEADLESS_BUILD
+#include "headless/render.hpp"
+#endif
+
 static void exitApp() {
     Render::deInit();
 }
@@ -22,6 +26,10 @@ static bool initApp() {
 }
 
 int main(int argc, char **argv) {
+#ifdef HEADLESS_BUILD
+    if (!Headless::parseArguments(argc, argv)) return 1;
+#endif
+
     if (!initApp()) {
         exitApp();
         return 1;
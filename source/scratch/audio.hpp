@@ -8,11 +8,14 @@ class SoundPlayer {
     static std::unordered_map<std::string, Sound> soundsPlaying;
 
     static bool loadSoundFromSB3(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId, const bool &streamed = false);
-    static void startSoundLoaderThread(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId);
+    static void startSoundLoader(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId);
+    static void preloadSound(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId);
+    static void updateSoundLoader();
     static bool loadSoundFromFile(Sprite *sprite, std::string fileName, const bool &streamed = false);
     static int playSound(const std::string &soundId);
     static void setSoundVolume(const std::string &soundId, float volume);
     static float getSoundVolume(const std::string &soundId);
+    static void setSoundEffects(const std::string &soundId, float pitch, float pan);
     static void stopSound(const std::string &soundId);
     static void stopStreamedSound();
     static void checkAudio();
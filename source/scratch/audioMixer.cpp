@@ -0,0 +1,303 @@
+#include "audioMixer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// sounds that can play at once. Starting one more stops the one that's been playing longest
+#if defined(__3DS__) || defined(__OGC__)
+#define MAX_VOICES 16
+#else
+#define MAX_VOICES 32
+#endif
+
+// frames mixed at a time, so the buffers can be fixed size
+#define MIX_BLOCK_FRAMES 256
+
+// positions are in frames, with 32 bits of fraction
+static constexpr uint64_t ONE_FRAME = 1ull << 32;
+
+struct Voice {
+    int id = -1; // -1 when the voice is free
+    const int16_t *samples = nullptr;
+    size_t frameCount = 0;
+    uint64_t position = 0;
+    uint64_t step = ONE_FRAME;
+    uint32_t started = 0; // when `play()` got it, to find the oldest voice
+    float volume = 100;
+    float pan = 0;
+    // how much of each input channel goes to each output channel, with the volume applied
+    float leftFromLeft = 1;
+    float rightFromRight = 1;
+    float leftFromRight = 0;
+    float rightFromLeft = 0;
+};
+
+static Voice voices[MAX_VOICES];
+static int outputChannels = 2;
+static uint32_t playCount = 0;
+
+// only touched by `mix()`
+static float mixBuffer[MIX_BLOCK_FRAMES * 2];
+static float voiceBuffer[MIX_BLOCK_FRAMES * 2];
+
+static Voice *findVoice(int id) {
+    if (id < 0) return nullptr;
+    Voice &voice = voices[id % MAX_VOICES];
+    return voice.id == id ? &voice : nullptr;
+}
+
+/**
+ * Works out the gains of a voice from its volume and pan, the same way the Web Audio `StereoPannerNode` Scratch uses does.
+ */
+static void updateGains(Voice &voice) {
+    const float volume = std::clamp(voice.volume, 0.0f, 100.0f) / 100;
+    if (outputChannels == 1) {
+        voice.leftFromLeft = volume;
+        voice.rightFromRight = voice.leftFromRight = voice.rightFromLeft = 0;
+        return;
+    }
+
+    // constant power: one side keeps its channel and gets some of the other, the other side gets quieter
+    const float pan = std::clamp(voice.pan, -100.0f, 100.0f) / 100;
+    const float angle = (pan <= 0 ? pan + 1 : pan) * static_cast<float>(M_PI) / 2;
+    const float towardsLeft = std::cos(angle);
+    const float towardsRight = std::sin(angle);
+    if (pan <= 0) {
+        voice.leftFromLeft = volume;
+        voice.leftFromRight = towardsLeft * volume;
+        voice.rightFromRight = towardsRight * volume;
+        voice.rightFromLeft = 0;
+    } else {
+        voice.leftFromLeft = towardsLeft * volume;
+        voice.leftFromRight = 0;
+        voice.rightFromRight = volume;
+        voice.rightFromLeft = towardsRight * volume;
+    }
+}
+
+static uint64_t getStep(float pitch) {
+    // Scratch limits pitch to 3 octaves either way, with 10 units per half step
+    const double rate = std::pow(2.0, std::clamp(pitch, -360.0f, 360.0f) / 120.0);
+    return static_cast<uint64_t>(rate * ONE_FRAME);
+}
+
+void AudioMixer::init(int channels) {
+    stopAll();
+    outputChannels = channels == 1 ? 1 : 2;
+}
+
+int AudioMixer::play(const int16_t *samples, size_t frameCount, float volume, float pitch, float pan) {
+    int index = 0;
+    for (int i = 0; i < MAX_VOICES; i++) {
+        if (voices[i].id == -1) {
+            index = i;
+            break;
+        }
+        if (voices[i].started < voices[index].started) index = i;
+    }
+
+    Voice &voice = voices[index];
+    playCount++;
+    // the play count keeps IDs of voices that got reused different, so old ones can't stop the new sound
+    voice.id = static_cast<int>(playCount % (0x7FFFFFFF / MAX_VOICES)) * MAX_VOICES + index;
+    voice.samples = samples;
+    voice.frameCount = frameCount;
+    voice.position = 0;
+    voice.step = getStep(pitch);
+    voice.started = playCount;
+    voice.volume = volume;
+    voice.pan = pan;
+    updateGains(voice);
+    return voice.id;
+}
+
+void AudioMixer::stop(int id) {
+    Voice *voice = findVoice(id);
+    if (voice) voice->id = -1;
+}
+
+void AudioMixer::stopAll() {
+    for (Voice &voice : voices) {
+        voice.id = -1;
+    }
+}
+
+bool AudioMixer::isPlaying(int id) {
+    return findVoice(id) != nullptr;
+}
+
+void AudioMixer::setVolume(int id, float volume) {
+    Voice *voice = findVoice(id);
+    if (!voice) return;
+    voice->volume = volume;
+    updateGains(*voice);
+}
+
+void AudioMixer::setEffects(int id, float pitch, float pan) {
+    Voice *voice = findVoice(id);
+    if (!voice) return;
+    voice->step = getStep(pitch);
+    voice->pan = pan;
+    updateGains(*voice);
+}
+
+/**
+ * Reads the next frames of a voice into `voiceBuffer`, resampled to its pitch with linear interpolation.
+ * @return How many frames it had left, up to `frameCount`.
+ */
+static size_t readVoice(Voice &voice, size_t frameCount) {
+    const int channels = outputChannels;
+    size_t frame = 0;
+
+    if (voice.step == ONE_FRAME && (voice.position & (ONE_FRAME - 1)) == 0) {
+        // no pitch effect, so the samples only need converting
+        const size_t start = voice.position >> 32;
+        frame = std::min(frameCount, voice.frameCount - start);
+        const int16_t *source = voice.samples + start * channels;
+        const size_t count = frame * channels;
+        size_t i = 0;
+#ifdef __SSE2__
+        for (; i + 8 <= count; i += 8) {
+            const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+            // sign extend by putting each sample in the top half, then shifting it down
+            const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+            const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16);
+            _mm_storeu_ps(voiceBuffer + i, _mm_cvtepi32_ps(low));
+            _mm_storeu_ps(voiceBuffer + i + 4, _mm_cvtepi32_ps(high));
+        }
+#elif defined(__ARM_NEON)
+        for (; i + 8 <= count; i += 8) {
+            const int16x8_t value = vld1q_s16(source + i);
+            vst1q_f32(voiceBuffer + i, vcvtq_f32_s32(vmovl_s16(vget_low_s16(value))));
+            vst1q_f32(voiceBuffer + i + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(value))));
+        }
+#endif
+        for (; i < count; i++) {
+            voiceBuffer[i] = source[i];
+        }
+        voice.position += static_cast<uint64_t>(frame) << 32;
+        return frame;
+    }
+
+    for (; frame < frameCount; frame++) {
+        const size_t index = voice.position >> 32;
+        if (index >= voice.frameCount) break;
+        const size_t next = std::min(index + 1, voice.frameCount - 1);
+        const float fraction = static_cast<float>(voice.position & (ONE_FRAME - 1)) / ONE_FRAME;
+        for (int channel = 0; channel < channels; channel++) {
+            const float first = voice.samples[index * channels + channel];
+            const float second = voice.samples[next * channels + channel];
+            voiceBuffer[frame * channels + channel] = first + (second - first) * fraction;
+        }
+        voice.position += voice.step;
+    }
+    return frame;
+}
+
+/**
+ * Adds `voiceBuffer` to `mixBuffer` with the gains of a voice.
+ */
+static void addVoice(const Voice &voice, size_t frameCount) {
+    size_t i = 0;
+    if (outputChannels == 1) {
+        const float gain = voice.leftFromLeft;
+#ifdef __SSE2__
+        const __m128 gains = _mm_set1_ps(gain);
+        for (; i + 4 <= frameCount; i += 4) {
+            const __m128 sum = _mm_add_ps(_mm_loadu_ps(mixBuffer + i), _mm_mul_ps(_mm_loadu_ps(voiceBuffer + i), gains));
+            _mm_storeu_ps(mixBuffer + i, sum);
+        }
+#elif defined(__ARM_NEON)
+        for (; i + 4 <= frameCount; i += 4) {
+            vst1q_f32(mixBuffer + i, vmlaq_n_f32(vld1q_f32(mixBuffer + i), vld1q_f32(voiceBuffer + i), gain));
+        }
+#endif
+        for (; i < frameCount; i++) {
+            mixBuffer[i] += voiceBuffer[i] * gain;
+        }
+        return;
+    }
+
+    // two frames at a time, with the channels swapped for the gains across sides
+    const size_t count = frameCount * 2;
+#ifdef __SSE2__
+    const __m128 direct = _mm_setr_ps(voice.leftFromLeft, voice.rightFromRight, voice.leftFromLeft, voice.rightFromRight);
+    const __m128 across = _mm_setr_ps(voice.leftFromRight, voice.rightFromLeft, voice.leftFromRight, voice.rightFromLeft);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 value = _mm_loadu_ps(voiceBuffer + i);
+        const __m128 swapped = _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1));
+        const __m128 sum = _mm_add_ps(_mm_mul_ps(value, direct), _mm_mul_ps(swapped, across));
+        _mm_storeu_ps(mixBuffer + i, _mm_add_ps(_mm_loadu_ps(mixBuffer + i), sum));
+    }
+#elif defined(__ARM_NEON)
+    const float directGains[4] = {voice.leftFromLeft, voice.rightFromRight, voice.leftFromLeft, voice.rightFromRight};
+    const float acrossGains[4] = {voice.leftFromRight, voice.rightFromLeft, voice.leftFromRight, voice.rightFromLeft};
+    const float32x4_t direct = vld1q_f32(directGains);
+    const float32x4_t across = vld1q_f32(acrossGains);
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t value = vld1q_f32(voiceBuffer + i);
+        const float32x4_t swapped = vrev64q_f32(value);
+        float32x4_t sum = vmlaq_f32(vld1q_f32(mixBuffer + i), value, direct);
+        vst1q_f32(mixBuffer + i, vmlaq_f32(sum, swapped, across));
+    }
+#endif
+    for (; i < count; i += 2) {
+        const float left = voiceBuffer[i];
+        const float right = voiceBuffer[i + 1];
+        mixBuffer[i] += left * voice.leftFromLeft + right * voice.leftFromRight;
+        mixBuffer[i + 1] += right * voice.rightFromRight + left * voice.rightFromLeft;
+    }
+}
+
+/**
+ * Adds `mixBuffer` to the output, clamping to the 16 bit range.
+ */
+static void addToOutput(int16_t *output, size_t count) {
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 8 <= count; i += 8) {
+        // packing and adding both saturate
+        const __m128i low = _mm_cvtps_epi32(_mm_loadu_ps(mixBuffer + i));
+        const __m128i high = _mm_cvtps_epi32(_mm_loadu_ps(mixBuffer + i + 4));
+        __m128i *chunk = reinterpret_cast<__m128i *>(output + i);
+        _mm_storeu_si128(chunk, _mm_adds_epi16(_mm_loadu_si128(chunk), _mm_packs_epi32(low, high)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        const int16x4_t low = vqmovn_s32(vcvtq_s32_f32(vld1q_f32(mixBuffer + i)));
+        const int16x4_t high = vqmovn_s32(vcvtq_s32_f32(vld1q_f32(mixBuffer + i + 4)));
+        vst1q_s16(output + i, vqaddq_s16(vld1q_s16(output + i), vcombine_s16(low, high)));
+    }
+#endif
+    for (; i < count; i++) {
+        const float sum = output[i] + std::nearbyint(mixBuffer[i]);
+        output[i] = static_cast<int16_t>(std::clamp(sum, -32768.0f, 32767.0f));
+    }
+}
+
+void AudioMixer::mix(int16_t *output, size_t frameCount) {
+    const int channels = outputChannels;
+    for (size_t start = 0; start < frameCount; start += MIX_BLOCK_FRAMES) {
+        const size_t blockFrames = std::min(frameCount - start, static_cast<size_t>(MIX_BLOCK_FRAMES));
+        bool mixed = false;
+
+        for (Voice &voice : voices) {
+            if (voice.id == -1) continue;
+            if (!mixed) {
+                std::memset(mixBuffer, 0, blockFrames * channels * sizeof(float));
+                mixed = true;
+            }
+            const size_t read = readVoice(voice, blockFrames);
+            addVoice(voice, read);
+            if (read < blockFrames) voice.id = -1; // played to the end
+        }
+
+        if (mixed) addToOutput(output + start * channels, blockFrames * channels);
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Mixes sounds in software, so they can play faster or slower for the pitch effect and get panned.
+ * There's a fixed number of voices, each playing 16 bit samples it doesn't own, in the same channel layout as the output.
+ * Nothing in here locks, so the platform has to keep `mix()` from running on the audio thread while voices change.
+ */
+class AudioMixer {
+  public:
+    /**
+     * Stops every voice and sets up the output layout.
+     * @param channels 1 for mono or 2 for stereo. Samples given to `play()` have to match.
+     */
+    static void init(int channels);
+
+    /**
+     * Starts playing samples on a free voice, or on the one that has been playing longest if none are free.
+     * @param samples Interleaved samples, which have to stay around until the voice stops.
+     * @param frameCount Samples per channel.
+     * @param volume 0-100.
+     * @param pitch The pitch effect, in Scratch's units of a tenth of a half step.
+     * @param pan The pan effect, -100 (left) to 100 (right).
+     * @return ID of the voice, for the other functions.
+     */
+    static int play(const int16_t *samples, size_t frameCount, float volume, float pitch, float pan);
+
+    /**
+     * Stops a voice. Does nothing if it already stopped.
+     * @param voice
+     */
+    static void stop(int voice);
+
+    static void stopAll();
+
+    /**
+     * Checks if a voice is still playing.
+     * @param voice
+     * @return `false` once it played to the end, or got stopped or taken by another sound.
+     */
+    static bool isPlaying(int voice);
+
+    /**
+     * Changes the volume of a playing voice.
+     * @param voice
+     * @param volume 0-100.
+     */
+    static void setVolume(int voice, float volume);
+
+    /**
+     * Changes the pitch and pan effects of a playing voice.
+     * @param voice
+     * @param pitch
+     * @param pan
+     */
+    static void setEffects(int voice, float pitch, float pan);
+
+    /**
+     * Adds every playing voice to a buffer of audio, and moves them forward. Call from the audio thread.
+     * @param output Interleaved samples in the layout from `init()`, which already has anything else that's playing.
+     * @param frameCount Samples per channel.
+     */
+    static void mix(int16_t *output, size_t frameCount);
+};
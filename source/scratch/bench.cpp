@@ -0,0 +1,90 @@
+#include "bench.hpp"
+
+#ifdef ENABLE_BENCH
+#include "blockExecutor.hpp"
+#include "frameScheduler.hpp"
+#include "os.hpp"
+#include <algorithm>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+// set before main() runs, so loading the project counts from the very start
+static const double startTime = FrameScheduler::getTimeMs();
+static double loadMs = -1;
+static double lastPhaseEnd = -1;
+
+static double phaseMs[Bench::PHASE_COUNT] = {};
+static double currentFrameMs = 0;
+static std::vector<double> frameTimes;
+static uint64_t totalBlocks = 0;
+static size_t peakVRAM = 0;
+
+void Bench::endPhase(Phase phase) {
+    const double now = FrameScheduler::getTimeMs();
+    if (loadMs < 0) {
+        loadMs = now - startTime;
+        lastPhaseEnd = now;
+    }
+
+    const double elapsed = now - lastPhaseEnd;
+    lastPhaseEnd = now;
+    phaseMs[phase] += elapsed;
+    if (phase != WAIT) currentFrameMs += elapsed;
+
+    // the count is reset by runRepeatBlocks(), so this has both the repeating scripts and the broadcasts
+    if (phase == BROADCASTS) totalBlocks += blocksRun;
+}
+
+void Bench::endFrame() {
+    frameTimes.push_back(currentFrameMs);
+    currentFrameMs = 0;
+    peakVRAM = std::max(peakVRAM, MemoryTracker::getVRAMUsage());
+}
+
+/**
+ * Gets the frame time that `fraction` of frames are faster than, by nearest rank.
+ */
+static double getPercentile(std::vector<double> &sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+    return sorted[index];
+}
+
+bool Bench::save(const std::string &path, const std::string &projectName) {
+    std::vector<double> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double totalMs = 0;
+    for (double frameMs : sorted) {
+        totalMs += frameMs;
+    }
+
+    const double scriptMs = phaseMs[REPEAT_BLOCKS] + phaseMs[BROADCASTS];
+    nlohmann::json phases = {
+        {"input", phaseMs[INPUT]},
+        {"repeatBlocks", phaseMs[REPEAT_BLOCKS]},
+        {"broadcasts", phaseMs[BROADCASTS]},
+        {"render", phaseMs[RENDER]},
+        {"loading", phaseMs[LOADING]}};
+    nlohmann::json results = {
+        {"project", projectName},
+        {"frames", sorted.size()},
+        {"loadMs", std::max(loadMs, 0.0)},
+        {"blocks", totalBlocks},
+        {"blocksPerSecond", scriptMs > 0 ? totalBlocks * 1000.0 / scriptMs : 0.0},
+        {"phaseMs", phases},
+        {"frameMs", {{"mean", sorted.empty() ? 0 : totalMs / sorted.size()}, {"p50", getPercentile(sorted, 0.5)}, {"p95", getPercentile(sorted, 0.95)}, {"p99", getPercentile(sorted, 0.99)}, {"max", sorted.empty() ? 0 : sorted.back()}}},
+        {"peakRamBytes", MemoryTracker::getPeakUsage()},
+        {"peakVramBytes", peakVRAM}};
+
+    std::ofstream file(path);
+    file << results.dump() << "\n";
+    if (!file) {
+        Log::logWarning("Couldn't save benchmark results to " + path);
+        return false;
+    }
+    Log::log("Saved benchmark results to " + path);
+    return true;
+}
+
+#endif
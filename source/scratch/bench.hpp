@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+
+/**
+ * Measures where each frame's time goes, for comparing runs of the same project with `make PLATFORM=headless bench`.
+ * Only built with `ENABLE_BENCH`, so the hooks in the main loop cost nothing otherwise.
+ */
+class Bench {
+  public:
+    enum Phase {
+        WAIT,          // waiting for the frame to start, which doesn't count towards the frame time
+        INPUT,         // Input::getInput()
+        REPEAT_BLOCKS, // BlockExecutor::runRepeatBlocks()
+        BROADCASTS,    // BlockExecutor::runBroadcasts()
+        RENDER,        // Render::renderSprites()
+        LOADING,       // prefetching costumes and sounds after the frame
+        PHASE_COUNT
+    };
+
+    /**
+     * Adds the time since the last phase ended to `phase`. The first call also marks the end of loading the project.
+     * @param phase
+     */
+    static void endPhase(Phase phase);
+
+    /**
+     * Finishes timing a frame, and checks how much memory is in use.
+     */
+    static void endFrame();
+
+    /**
+     * Writes the results as one line of JSON, so results from several projects can be joined into one file.
+     * Times are in milliseconds, and blocks per second only counts the time spent running scripts.
+     * @param path
+     * @param projectName Name to put in the results.
+     * @return `false` if the file couldn't be written.
+     */
+    static bool save(const std::string &path, const std::string &projectName);
+};
+
+#ifdef ENABLE_BENCH
+#define BENCH_PHASE(phase) Bench::endPhase(Bench::phase)
+#define BENCH_END_FRAME() Bench::endFrame()
+#else
+#define BENCH_PHASE(phase)
+#define BENCH_END_FRAME()
+#endif
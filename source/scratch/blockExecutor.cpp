@@ -5,12 +5,17 @@
 #include "blocks/looks.hpp"
 #include "blocks/motion.hpp"
 #include "blocks/operator.hpp"
+#include "blocks/pen.hpp"
 #include "blocks/procedure.hpp"
 #include "blocks/sensing.hpp"
 #include "blocks/sound.hpp"
 #include "interpret.hpp"
+#include "layers.hpp"
 #include "math.hpp"
 #include "os.hpp"
+#include "penLayer.hpp"
+#include "profiler.hpp"
+#include "renderState.hpp"
 #include "sprite.hpp"
 #include <algorithm>
 #include <chrono>
@@ -164,6 +169,22 @@ void BlockExecutor::registerHandlers() {
     valueHandlers["sensing_mousedown"] = SensingBlocks::mouseDown;
     valueHandlers["sensing_username"] = SensingBlocks::username;
 
+    // pen
+    handlers["pen_clear"] = PenBlocks::clear;
+    handlers["pen_stamp"] = PenBlocks::stamp;
+    handlers["pen_penDown"] = PenBlocks::penDown;
+    handlers["pen_penUp"] = PenBlocks::penUp;
+    handlers["pen_setPenColorToColor"] = PenBlocks::setPenColorToColor;
+    handlers["pen_changePenColorParamBy"] = PenBlocks::changePenColorParamBy;
+    handlers["pen_setPenColorParamTo"] = PenBlocks::setPenColorParamTo;
+    handlers["pen_changePenSizeBy"] = PenBlocks::changePenSizeBy;
+    handlers["pen_setPenSizeTo"] = PenBlocks::setPenSizeTo;
+    handlers["pen_setPenShadeToNumber"] = PenBlocks::setPenShadeToNumber;
+    handlers["pen_changePenShadeBy"] = PenBlocks::changePenShadeBy;
+    handlers["pen_setPenHueToNumber"] = PenBlocks::setPenHueToNumber;
+    handlers["pen_changePenHueBy"] = PenBlocks::changePenHueBy;
+    valueHandlers["pen_menu_colorParam"] = PenBlocks::colorParamMenu;
+
     // procedures / arguments
     handlers["procedures_call"] = ProcedureBlocks::call;
     handlers["procedures_definition"] = ProcedureBlocks::definition;
@@ -230,7 +251,13 @@ std::vector<Block *> BlockExecutor::runBlock(Block &block, Sprite *sprite, bool
 BlockResult BlockExecutor::executeBlock(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     auto iterator = handlers.find(block.opcode);
     if (iterator != handlers.end()) {
-        return iterator->second(block, sprite, withoutScreenRefresh, fromRepeat);
+        PROFILE_BLOCK(block, sprite);
+        BlockResult result = iterator->second(block, sprite, withoutScreenRefresh, fromRepeat);
+
+        // any block can move a sprite, so pen lines get drawn here instead of in every motion block
+        if (sprite->pen.down) PenLayer::moveTo(sprite);
+        if (block.visual) RenderState::markChanged();
+        return result;
     }
 
     return BlockResult::CONTINUE;
@@ -267,6 +294,7 @@ void BlockExecutor::runRepeatBlocks() {
                 }
             }
         }
+        Layers::remove(toDelete);
         toDelete->isDeleted = true;
     }
     // std::cout << "\x1b[19;1HBlocks Running: " << blocksRun << std::endl;
@@ -286,46 +314,45 @@ void BlockExecutor::runRepeatsWithoutRefresh(Sprite *sprite, std::string blockCh
 }
 
 void BlockExecutor::runCustomBlock(Sprite *sprite, Block &block, Block *callerBlock, bool *withoutScreenRefresh) {
-    for (auto &[id, data] : sprite->customBlocks) {
-        if (id == block.mutation.at("proccode").get<std::string>()) {
-            // Set up argument values
-            for (std::string arg : data.argumentIds) {
-                if (block.parsedInputs.find(arg) != block.parsedInputs.end()) {
-                    data.argumentValues[arg] = Scratch::getInputValue(block, arg, sprite);
-                }
+    auto customBlockFind = sprite->customBlocks.find(block.procCode);
+    if (customBlockFind != sprite->customBlocks.end()) {
+        CustomBlock &data = customBlockFind->second;
+
+        // Set up argument values
+        for (std::string arg : data.argumentIds) {
+            if (block.parsedInputs.find(arg) != block.parsedInputs.end()) {
+                data.argumentValues[arg] = Scratch::getInputValue(block, arg, sprite);
             }
+        }
 
-            // std::cout << "running custom block " << data.blockId << std::endl;
-
-            // Get the parent of the prototype block (the definition containing all blocks)
-            Block *customBlockDefinition = &sprite->blocks[sprite->blocks[data.blockId].parent];
+        // std::cout << "running custom block " << data.blockId << std::endl;
 
-            callerBlock->customBlockPtr = customBlockDefinition;
+        // Get the parent of the prototype block (the definition containing all blocks)
+        Block *customBlockDefinition = &sprite->blocks[sprite->blocks[data.blockId].parent];
 
-            bool localWithoutRefresh = data.runWithoutScreenRefresh;
+        callerBlock->customBlockPtr = customBlockDefinition;
 
-            // If the parent chain is running without refresh, force this one to also run without refresh
-            if (!localWithoutRefresh && withoutScreenRefresh != nullptr) {
-                localWithoutRefresh = *withoutScreenRefresh;
-            }
+        bool localWithoutRefresh = data.runWithoutScreenRefresh;
 
-            // std::cout << "RWSR = " << localWithoutRefresh << std::endl;
+        // If the parent chain is running without refresh, force this one to also run without refresh
+        if (!localWithoutRefresh && withoutScreenRefresh != nullptr) {
+            localWithoutRefresh = *withoutScreenRefresh;
+        }
 
-            // Execute the custom block definition
-            customBlockDefinition->waitingIfBlock = callerBlock->waitingIfBlock;
-            executor.runBlock(*customBlockDefinition, sprite, &localWithoutRefresh);
+        // std::cout << "RWSR = " << localWithoutRefresh << std::endl;
 
-            if (localWithoutRefresh) {
-                BlockExecutor::runRepeatsWithoutRefresh(sprite, customBlockDefinition->blockChainID);
-            }
+        // Execute the custom block definition
+        customBlockDefinition->waitingIfBlock = callerBlock->waitingIfBlock;
+        executor.runBlock(*customBlockDefinition, sprite, &localWithoutRefresh);
 
-            break;
+        if (localWithoutRefresh) {
+            BlockExecutor::runRepeatsWithoutRefresh(sprite, customBlockDefinition->blockChainID);
         }
     }
 
-    if (block.mutation.at("proccode").get<std::string>() == "\u200B\u200Blog\u200B\u200B %s") Log::log("[PROJECT] " + Scratch::getInputValue(block, "arg0", sprite).asString());
-    if (block.mutation.at("proccode").get<std::string>() == "\u200B\u200Bwarn\u200B\u200B %s") Log::logWarning("[PROJECT] " + Scratch::getInputValue(block, "arg0", sprite).asString());
-    if (block.mutation.at("proccode").get<std::string>() == "\u200B\u200Berror\u200B\u200B %s") Log::logError("[PROJECT] " + Scratch::getInputValue(block, "arg0", sprite).asString());
+    if (block.procCode == "\u200B\u200Blog\u200B\u200B %s") Log::log("[PROJECT] " + Scratch::getInputValue(block, "arg0", sprite).asString());
+    if (block.procCode == "\u200B\u200Bwarn\u200B\u200B %s") Log::logWarning("[PROJECT] " + Scratch::getInputValue(block, "arg0", sprite).asString());
+    if (block.procCode == "\u200B\u200Berror\u200B\u200B %s") Log::logError("[PROJECT] " + Scratch::getInputValue(block, "arg0", sprite).asString());
 }
 
 std::vector<std::pair<Block *, Sprite *>> BlockExecutor::runBroadcast(std::string broadcastToRun) {
@@ -335,7 +362,7 @@ std::vector<std::pair<Block *, Sprite *>> BlockExecutor::runBroadcast(std::strin
     for (auto *currentSprite : sprites) {
         for (auto &[id, block] : currentSprite->blocks) {
             if (block.opcode == "event_whenbroadcastreceived" &&
-                block.fields["BROADCAST_OPTION"][0] == broadcastToRun) {
+                block.getField("BROADCAST_OPTION").value == broadcastToRun) {
                 blocksToRun.push_back({&block, currentSprite});
             }
         }
@@ -394,11 +421,66 @@ Value BlockExecutor::getBlockValue(Block &block, Sprite *sprite) {
     return Value();
 }
 
+void BlockExecutor::setVariableValue(Variable &variable, const Value &newValue) {
+    variable.value = newValue;
+    if (variable.monitored) RenderState::markChanged();
+#ifdef ENABLE_CLOUDVARS
+    if (variable.cloud) cloudConnection->set(variable.name, variable.value.asString());
+#endif
+}
+
+Variable *BlockExecutor::getFieldVariable(const Block &block, const char *fieldName, Sprite *sprite) {
+    const ParsedField *field = block.findField(fieldName);
+    if (field == nullptr) return nullptr;
+    if (field->localTo == nullptr || field->localTo == sprite) return field->variable;
+
+    auto it = sprite->variables.find(field->id);
+    return it != sprite->variables.end() ? &it->second : nullptr;
+}
+
+List *BlockExecutor::getFieldList(const Block &block, const char *fieldName, Sprite *sprite) {
+    const ParsedField *field = block.findField(fieldName);
+    if (field == nullptr) return nullptr;
+    if (field->localTo == nullptr || field->localTo == sprite) return field->list;
+
+    auto it = sprite->lists.find(field->id);
+    return it != sprite->lists.end() ? &it->second : nullptr;
+}
+
+void BlockExecutor::resolveDataFields(Sprite *sprite) {
+    Sprite *stage = findSprite("_stage_");
+    for (auto &[id, block] : sprite->blocks) {
+        for (ParsedField &field : block.fields) {
+            field.variable = nullptr;
+            field.list = nullptr;
+            field.localTo = nullptr;
+
+            if (field.name == "VARIABLE") {
+                auto it = sprite->variables.find(field.id);
+                if (it != sprite->variables.end()) {
+                    field.variable = &it->second;
+                    if (sprite != stage) field.localTo = sprite;
+                } else if (stage != nullptr && (it = stage->variables.find(field.id)) != stage->variables.end()) {
+                    field.variable = &it->second;
+                }
+            } else if (field.name == "LIST") {
+                auto it = sprite->lists.find(field.id);
+                if (it != sprite->lists.end()) {
+                    field.list = &it->second;
+                    if (sprite != stage) field.localTo = sprite;
+                } else if (stage != nullptr && (it = stage->lists.find(field.id)) != stage->lists.end()) {
+                    field.list = &it->second;
+                }
+            }
+        }
+    }
+}
+
 void BlockExecutor::setVariableValue(const std::string &variableId, const Value &newValue, Sprite *sprite) {
     // Set sprite variable
     auto it = sprite->variables.find(variableId);
     if (it != sprite->variables.end()) {
-        it->second.value = newValue;
+        setVariableValue(it->second, newValue);
         return;
     }
 
@@ -407,28 +489,29 @@ void BlockExecutor::setVariableValue(const std::string &variableId, const Value
         if (currentSprite->isStage) {
             auto globalIt = currentSprite->variables.find(variableId);
             if (globalIt != currentSprite->variables.end()) {
-                globalIt->second.value = newValue;
-#ifdef ENABLE_CLOUDVARS
-                if (globalIt->second.cloud) cloudConnection->set(globalIt->second.name, globalIt->second.value.asString());
-#endif
+                setVariableValue(globalIt->second, newValue);
                 return;
             }
         }
     }
 }
 
-Value BlockExecutor::getMonitorValue(Monitor &var) {
-    Sprite *sprite = nullptr;
-    for (auto &spr : sprites) {
-        if (var.spriteName == "" && spr->isStage) {
-            sprite = spr;
-            break;
-        }
-        if (spr->name == var.spriteName && !spr->isClone) {
-            sprite = spr;
-            break;
-        }
+void BlockExecutor::updateMonitored(Monitor &var) {
+    Sprite *sprite = findSprite(var.spriteName == "" ? "_stage_" : var.spriteName);
+    if (sprite == nullptr) return;
+
+    if (var.opcode == "data_variable") {
+        auto it = sprite->variables.find(var.id);
+        if (it != sprite->variables.end()) it->second.monitored = var.visible;
+    } else if (var.opcode == "data_listcontents") {
+        auto it = sprite->lists.find(var.id);
+        if (it != sprite->lists.end()) it->second.monitored = var.visible;
     }
+    RenderState::markChanged();
+}
+
+Value BlockExecutor::getMonitorValue(Monitor &var) {
+    Sprite *sprite = findSprite(var.spriteName == "" ? "_stage_" : var.spriteName);
 
     std::string monitorName = "";
     if (var.opcode == "data_variable") {
@@ -559,6 +642,7 @@ void BlockExecutor::handleCloudVariableChange(const std::string &name, const std
             for (auto it = currentSprite->variables.begin(); it != currentSprite->variables.end(); ++it) {
                 if (it->second.name == name) {
                     it->second.value = Value(value);
+                    if (it->second.monitored) RenderState::markChanged();
                     return;
                 }
             }
@@ -567,7 +651,7 @@ void BlockExecutor::handleCloudVariableChange(const std::string &name, const std
 }
 #endif
 
-Value BlockExecutor::getCustomBlockValue(std::string valueName, Sprite *sprite, Block block) {
+Value BlockExecutor::getCustomBlockValue(const std::string &valueName, Sprite *sprite, const Block &block) {
 
     // get the parent prototype block
     Block *definitionBlock = getBlockParent(&block);
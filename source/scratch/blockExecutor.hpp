@@ -93,6 +93,12 @@ class BlockExecutor {
      */
     static Value getVariableValue(std::string variableId, Sprite *sprite);
 
+    /**
+     * Marks the variable or list a Monitor shows, so changing it redraws the screen only while the Monitor is visible.
+     * @param var The Monitor that got loaded, shown or hidden.
+     */
+    static void updateMonitored(Monitor &var);
+
     /**
      * Gets the Value of the specified Monitor (a Monitor is just a variable that shows up on the screen).
      * @param var The Monitor to find the value of
@@ -107,7 +113,7 @@ class BlockExecutor {
      * @param block The block the variable is inside.
      * @return The Value of the custom block variable.
      */
-    static Value getCustomBlockValue(std::string valueName, Sprite *sprite, Block block);
+    static Value getCustomBlockValue(const std::string &valueName, Sprite *sprite, const Block &block);
 
     /**
      * Sets the Value of the specified Scratch variable.
@@ -117,6 +123,38 @@ class BlockExecutor {
      */
     static void setVariableValue(const std::string &variableId, const Value &newValue, Sprite *sprite);
 
+    /**
+     * Sets the Value of a Scratch variable that was already found.
+     * @param variable
+     * @param newValue the new Value to set.
+     */
+    static void setVariableValue(Variable &variable, const Value &newValue);
+
+    /**
+     * Gets the variable a block's field picks, from the sprite's own variables or else the Stage's.
+     * It's found when the project loads or the clone gets made, so this only has to look it up when a clone runs one of the original sprite's blocks, like a reporter in an input.
+     * @param block
+     * @param fieldName Usually `"VARIABLE"`.
+     * @param sprite Pointer to the sprite running the block.
+     * @return The variable, or `nullptr` if the block doesn't have the field or the variable doesn't exist.
+     */
+    static Variable *getFieldVariable(const Block &block, const char *fieldName, Sprite *sprite);
+
+    /**
+     * Gets the list a block's field picks, the same way as `getFieldVariable()`.
+     * @param block
+     * @param fieldName Usually `"LIST"`.
+     * @param sprite Pointer to the sprite running the block.
+     * @return The list, or `nullptr` if the block doesn't have the field or the list doesn't exist.
+     */
+    static List *getFieldList(const Block &block, const char *fieldName, Sprite *sprite);
+
+    /**
+     * Finds the variables and lists picked by the fields of every block in a sprite, so they don't have to be looked up while running.
+     * @param sprite
+     */
+    static void resolveDataFields(Sprite *sprite);
+
 #ifdef ENABLE_CLOUDVARS
     /**
      * Called when a cloud variable is changed by another user. Updates that variable
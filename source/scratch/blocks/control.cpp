@@ -1,6 +1,7 @@
 #include "control.hpp"
 #include "blockExecutor.hpp"
 #include "interpret.hpp"
+#include "layers.hpp"
 #include "math.hpp"
 #include "os.hpp"
 #include "sprite.hpp"
@@ -102,31 +103,28 @@ BlockResult ControlBlocks::ifElse(Block &block, Sprite *sprite, bool *withoutScr
 BlockResult ControlBlocks::createCloneOf(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     // std::cout << "Trying " << std::endl;
 
-    Block *cloneOptions = nullptr;
-    auto it = block.parsedInputs.find("CLONE_OPTION");
-    cloneOptions = &sprite->blocks[it->second.literalValue.asString()];
+    Sprite *cloneTemplate;
+    const std::string &cloneOption = resolveObjectMenu(block, "CLONE_OPTION", sprite, &cloneTemplate);
+    if (cloneOption == "_myself_") cloneTemplate = sprite;
+    if (cloneTemplate == nullptr || cloneTemplate->isStage) return BlockResult::CONTINUE;
 
     Sprite *spriteToClone = getAvailableSprite();
     if (!spriteToClone) return BlockResult::CONTINUE;
-    if (cloneOptions->fields["CLONE_OPTION"][0] == "_myself_") {
-        *spriteToClone = *sprite;
-    } else {
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->name == Math::removeQuotations(cloneOptions->fields["CLONE_OPTION"][0]) && !currentSprite->isClone) {
-                *spriteToClone = *currentSprite;
-            }
-        }
-    }
+    *spriteToClone = *cloneTemplate;
     spriteToClone->blockChains.clear();
+    // the copied blocks still point at the template's variables and lists
+    BlockExecutor::resolveDataFields(spriteToClone);
 
     if (spriteToClone != nullptr && !spriteToClone->name.empty()) {
         spriteToClone->isClone = true;
         spriteToClone->isStage = false;
         spriteToClone->toDelete = false;
         spriteToClone->id = Math::generateRandomString(15);
+        spriteToClone->interpolation.valid = false;
         // Log::log("Cloned " + sprite->name);
         //  add clone to sprite list
         sprites.push_back(spriteToClone);
+        Layers::addBehind(spriteToClone, cloneTemplate);
         Sprite *addedSprite = sprites.back();
         // Run "when I start as a clone" scripts for the clone
         for (Sprite *currentSprite : sprites) {
@@ -153,7 +151,7 @@ BlockResult ControlBlocks::deleteThisClone(Block &block, Sprite *sprite, bool *w
 
 BlockResult ControlBlocks::stop(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     block.shouldStop = false;
-    std::string stopType = block.fields.at("STOP_OPTION")[0];
+    const std::string &stopType = block.getField("STOP_OPTION").value;
     if (stopType == "all") {
         Scratch::shouldStop = true;
         return BlockResult::RETURN;
@@ -3,34 +3,36 @@
 #include "blockExecutor.hpp"
 #include "interpret.hpp"
 #include "math.hpp"
+#include "renderState.hpp"
 #include "sprite.hpp"
 #include "value.hpp"
 
 BlockResult DataBlocks::setVariable(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value val = Scratch::getInputValue(block, "VALUE", sprite);
-    std::string varId = block.fields.at("VARIABLE")[1];
-    BlockExecutor::setVariableValue(varId, val, sprite);
+    Variable *variable = BlockExecutor::getFieldVariable(block, "VARIABLE", sprite);
+    if (variable) BlockExecutor::setVariableValue(*variable, val);
     return BlockResult::CONTINUE;
 }
 
 BlockResult DataBlocks::changeVariable(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value val = Scratch::getInputValue(block, "VALUE", sprite);
-    std::string varId = block.fields.at("VARIABLE")[1];
-    Value oldVariable = BlockExecutor::getVariableValue(varId, sprite);
+    Variable *variable = BlockExecutor::getFieldVariable(block, "VARIABLE", sprite);
+    if (!variable) return BlockResult::CONTINUE;
 
-    if (val.isNumeric() && oldVariable.isNumeric()) {
-        val = val + oldVariable;
+    if (val.isNumeric() && variable->value.isNumeric()) {
+        val = val + variable->value;
     }
 
-    BlockExecutor::setVariableValue(varId, val, sprite);
+    BlockExecutor::setVariableValue(*variable, val);
     return BlockResult::CONTINUE;
 }
 
 BlockResult DataBlocks::showVariable(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    std::string varId = block.fields["VARIABLE"][1].get<std::string>();
+    const std::string &varId = block.getField("VARIABLE").id;
     for (Monitor &var : Render::visibleVariables) {
         if (var.id == varId) {
             var.visible = true;
+            BlockExecutor::updateMonitored(var);
             break;
         }
     }
@@ -39,10 +41,11 @@ BlockResult DataBlocks::showVariable(Block &block, Sprite *sprite, bool *without
 }
 
 BlockResult DataBlocks::hideVariable(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    std::string varId = block.fields["VARIABLE"][1].get<std::string>();
+    const std::string &varId = block.getField("VARIABLE").id;
     for (Monitor &var : Render::visibleVariables) {
         if (var.id == varId) {
             var.visible = false;
+            BlockExecutor::updateMonitored(var);
             break;
         }
     }
@@ -51,10 +54,11 @@ BlockResult DataBlocks::hideVariable(Block &block, Sprite *sprite, bool *without
 
 
 BlockResult DataBlocks::showList(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    std::string varId = block.fields["LIST"][1].get<std::string>();
+    const std::string &varId = block.getField("LIST").id;
     for (Monitor &var : Render::visibleVariables) {
         if (var.id == varId) {
             var.visible = true;
+            BlockExecutor::updateMonitored(var);
             break;
         }
     }
@@ -63,10 +67,11 @@ BlockResult DataBlocks::showList(Block &block, Sprite *sprite, bool *withoutScre
 }
 
 BlockResult DataBlocks::hideList(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    std::string varId = block.fields["LIST"][1].get<std::string>();
+    const std::string &varId = block.getField("LIST").id;
     for (Monitor &var : Render::visibleVariables) {
         if (var.id == varId) {
             var.visible = false;
+            BlockExecutor::updateMonitored(var);
             break;
         }
     }
@@ -75,25 +80,11 @@ BlockResult DataBlocks::hideList(Block &block, Sprite *sprite, bool *withoutScre
 
 BlockResult DataBlocks::addToList(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value val = Scratch::getInputValue(block, "ITEM", sprite);
-    std::string listId = block.fields.at("LIST")[1];
-
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listId) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listId) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
+    List *list = BlockExecutor::getFieldList(block, "LIST", sprite);
 
-    if (targetSprite) {
-        targetSprite->lists[listId].items.push_back(val);
+    if (list) {
+        list->items.push_back(val);
+        if (list->monitored) RenderState::markChanged();
     }
 
     return BlockResult::CONTINUE;
@@ -101,26 +92,12 @@ BlockResult DataBlocks::addToList(Block &block, Sprite *sprite, bool *withoutScr
 
 BlockResult DataBlocks::deleteFromList(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value val = Scratch::getInputValue(block, "INDEX", sprite);
-    std::string listId = block.fields.at("LIST")[1];
-
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listId) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listId) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
+    List *list = BlockExecutor::getFieldList(block, "LIST", sprite);
 
-    if (!targetSprite) return BlockResult::CONTINUE;
+    if (!list) return BlockResult::CONTINUE;
 
-    auto &items = targetSprite->lists[listId].items;
+    auto &items = list->items;
+    if (list->monitored) RenderState::markChanged();
 
     if (val.isNumeric()) {
         int index = val.asInt() - 1; // Convert to 0-based index
@@ -147,25 +124,11 @@ BlockResult DataBlocks::deleteFromList(Block &block, Sprite *sprite, bool *witho
 }
 
 BlockResult DataBlocks::deleteAllOfList(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    std::string listId = block.fields.at("LIST")[1];
-
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listId) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listId) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
+    List *list = BlockExecutor::getFieldList(block, "LIST", sprite);
 
-    if (targetSprite) {
-        targetSprite->lists[listId].items.clear(); // Clear the list
+    if (list) {
+        list->items.clear(); // Clear the list
+        if (list->monitored) RenderState::markChanged();
     }
 
     return BlockResult::CONTINUE;
@@ -173,29 +136,15 @@ BlockResult DataBlocks::deleteAllOfList(Block &block, Sprite *sprite, bool *with
 
 BlockResult DataBlocks::insertAtList(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value val = Scratch::getInputValue(block, "ITEM", sprite);
-    std::string listId = block.fields.at("LIST")[1];
+    List *list = BlockExecutor::getFieldList(block, "LIST", sprite);
     Value index = Scratch::getInputValue(block, "INDEX", sprite);
 
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listId) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listId) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
-
-    if (!targetSprite) return BlockResult::CONTINUE;
+    if (!list) return BlockResult::CONTINUE;
+    if (list->monitored) RenderState::markChanged();
 
+    auto &items = list->items;
     if (index.isNumeric()) {
         int idx = index.asInt() - 1; // Convert to 0-based index
-        auto &items = targetSprite->lists[listId].items;
 
         // Check if the index is within bounds
         if (idx >= 0 && idx <= static_cast<int>(items.size())) {
@@ -204,10 +153,9 @@ BlockResult DataBlocks::insertAtList(Block &block, Sprite *sprite, bool *without
 
         return BlockResult::CONTINUE;
     }
-    if (index.asString() == "last") targetSprite->lists[listId].items.push_back(val);
+    if (index.asString() == "last") items.push_back(val);
 
     if (index.asString() == "random") {
-        auto &items = targetSprite->lists[listId].items;
         int idx = rand() % (items.size() + 1);
         items.insert(items.begin() + idx, val);
     }
@@ -217,26 +165,13 @@ BlockResult DataBlocks::insertAtList(Block &block, Sprite *sprite, bool *without
 
 BlockResult DataBlocks::replaceItemOfList(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value val = Scratch::getInputValue(block, "ITEM", sprite);
-    std::string listId = block.fields.at("LIST")[1];
+    List *list = BlockExecutor::getFieldList(block, "LIST", sprite);
     Value index = Scratch::getInputValue(block, "INDEX", sprite);
 
-    Sprite *targetSprite = nullptr;
-
-    if (sprite->lists.find(listId) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listId) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
+    if (!list) return BlockResult::CONTINUE;
 
-    // If we found the target sprite with the list, attempt the replacement
-    if (!targetSprite) return BlockResult::CONTINUE;
-
-    auto &items = targetSprite->lists[listId].items;
+    auto &items = list->items;
+    if (list->monitored) RenderState::markChanged();
 
     if (index.isNumeric()) {
         int idx = index.asInt() - 1;
@@ -261,26 +196,11 @@ BlockResult DataBlocks::replaceItemOfList(Block &block, Sprite *sprite, bool *wi
 Value DataBlocks::itemOfList(Block &block, Sprite *sprite) {
     Value indexStr = Scratch::getInputValue(block, "INDEX", sprite);
     int index = indexStr.asInt() - 1;
-    std::string listName = block.fields.at("LIST")[1];
-
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listName) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listName) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
+    List *list = BlockExecutor::getFieldList(block, "LIST", sprite);
 
-    if (!targetSprite) return Value();
+    if (!list) return Value();
 
-    auto &items = targetSprite->lists[listName].items;
+    auto &items = list->items;
 
     if (indexStr.asString() == "last") return Value(Math::removeQuotations(items.back().asString()));
 
@@ -297,28 +217,12 @@ Value DataBlocks::itemOfList(Block &block, Sprite *sprite) {
 }
 
 Value DataBlocks::itemNumOfList(Block &block, Sprite *sprite) {
-    std::string listName = block.fields.at("LIST")[1];
+    List *list = BlockExecutor::getFieldList(block, "LIST", sprite);
     Value itemToFind = Scratch::getInputValue(block, "ITEM", sprite);
 
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listName) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listName) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
-
-    if (targetSprite) {
-        auto &list = targetSprite->lists[listName];
+    if (list) {
         int index = 1;
-        for (auto &item : list.items) {
+        for (auto &item : list->items) {
             if (Math::removeQuotations(item.asString()) == itemToFind.asString()) {
                 return Value(index);
             }
@@ -330,52 +234,21 @@ Value DataBlocks::itemNumOfList(Block &block, Sprite *sprite) {
 }
 
 Value DataBlocks::lengthOfList(Block &block, Sprite *sprite) {
-    std::string listName = block.fields.at("LIST")[1];
-
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listName) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listName) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
+    List *list = BlockExecutor::getFieldList(block, "LIST", sprite);
 
-    if (targetSprite) {
-        return Value(static_cast<int>(targetSprite->lists[listName].items.size()));
+    if (list) {
+        return Value(static_cast<int>(list->items.size()));
     }
 
     return Value();
 }
 
 Value DataBlocks::listContainsItem(Block &block, Sprite *sprite) {
-    std::string listName = block.fields.at("LIST")[1];
+    List *list = BlockExecutor::getFieldList(block, "LIST", sprite);
     Value itemToFind = Scratch::getInputValue(block, "ITEM", sprite);
 
-    Sprite *targetSprite = nullptr;
-
-    // First check if the current sprite has the list
-    if (sprite->lists.find(listName) != sprite->lists.end()) {
-        targetSprite = sprite;
-    } else {
-        // If not found in current sprite, check stage (global lists)
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage && currentSprite->lists.find(listName) != currentSprite->lists.end()) {
-                targetSprite = currentSprite;
-                break;
-            }
-        }
-    }
-
-    if (targetSprite) {
-        auto &list = targetSprite->lists[listName];
-        for (const auto &item : list.items) {
+    if (list) {
+        for (const auto &item : list->items) {
             if (item == itemToFind) {
                 return Value(true);
             }
@@ -383,4 +256,4 @@ Value DataBlocks::listContainsItem(Block &block, Sprite *sprite) {
     }
 
     return Value(false);
-}
+}
\ No newline at end of file
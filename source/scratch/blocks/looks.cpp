@@ -3,6 +3,7 @@
 #include "blockExecutor.hpp"
 #include "image.hpp"
 #include "interpret.hpp"
+#include "layers.hpp"
 #include "math.hpp"
 #include "sprite.hpp"
 #include "value.hpp"
@@ -31,8 +32,9 @@ BlockResult LooksBlocks::switchCostumeTo(Block &block, Sprite *sprite, bool *wit
     if (inputFind != block.parsedInputs.end() && inputFind->second.inputType == ParsedInput::LITERAL) {
         Block *inputBlock = findBlock(inputValue.asString());
         if (inputBlock != nullptr) {
-            if (!inputBlock->fields["COSTUME"][0].is_null())
-                inputString = inputBlock->fields["COSTUME"][0].get<std::string>();
+            const ParsedField *costumeField = inputBlock->findField("COSTUME");
+            if (costumeField != nullptr)
+                inputString = costumeField->value;
             else return BlockResult::CONTINUE;
         }
     }
@@ -83,8 +85,9 @@ BlockResult LooksBlocks::switchBackdropTo(Block &block, Sprite *sprite, bool *wi
     if (inputFind != block.parsedInputs.end() && inputFind->second.inputType == ParsedInput::LITERAL) {
         Block *inputBlock = findBlock(inputString);
         if (inputBlock != nullptr) {
-            if (!inputBlock->fields["BACKDROP"][0].is_null())
-                inputString = inputBlock->fields["BACKDROP"][0].get<std::string>();
+            const ParsedField *backdropField = inputBlock->findField("BACKDROP");
+            if (backdropField != nullptr)
+                inputString = backdropField->value;
             else return BlockResult::CONTINUE;
         }
     }
@@ -121,7 +124,7 @@ BlockResult LooksBlocks::switchBackdropTo(Block &block, Sprite *sprite, bool *wi
         for (auto &[id, spriteBlock] : currentSprite->blocks) {
             if (spriteBlock.opcode != "event_whenbackdropswitchesto") continue;
             try {
-                if (spriteBlock.fields["BACKDROP"][0] == sprite->costumes[sprite->currentCostume].name) {
+                if (spriteBlock.getField("BACKDROP").value == sprite->costumes[sprite->currentCostume].name) {
                     executor.runBlock(spriteBlock, currentSprite, withoutScreenRefresh, fromRepeat);
                 }
             } catch (...) {
@@ -153,7 +156,7 @@ BlockResult LooksBlocks::nextBackdrop(Block &block, Sprite *sprite, bool *withou
         for (auto &[id, spriteBlock] : currentSprite->blocks) {
             if (spriteBlock.opcode != "event_whenbackdropswitchesto") continue;
             try {
-                if (spriteBlock.fields["BACKDROP"][0] == sprite->costumes[sprite->currentCostume].name) {
+                if (spriteBlock.getField("BACKDROP").value == sprite->costumes[sprite->currentCostume].name) {
                     executor.runBlock(spriteBlock, currentSprite, withoutScreenRefresh, fromRepeat);
                 }
             } catch (...) {
@@ -167,64 +170,27 @@ BlockResult LooksBlocks::nextBackdrop(Block &block, Sprite *sprite, bool *withou
 
 BlockResult LooksBlocks::goForwardBackwardLayers(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
     Value value = Scratch::getInputValue(block, "NUM", sprite);
-    std::string forwardBackward = block.fields.at("FORWARD_BACKWARD")[0];
+    const std::string &forwardBackward = block.getField("FORWARD_BACKWARD").value;
     if (!value.isNumeric()) return BlockResult::CONTINUE;
 
     int shift = value.asInt();
     if (shift == 0) return BlockResult::CONTINUE;
 
     if (forwardBackward == "forward") {
-        int targetLayer = sprite->layer + shift;
-
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage || currentSprite == sprite) continue;
-            if (currentSprite->layer >= targetLayer) {
-                currentSprite->layer++;
-            }
-        }
-
-        sprite->layer = targetLayer;
-
+        Layers::moveBy(sprite, shift);
     } else if (forwardBackward == "backward") {
-        int targetLayer = sprite->layer - shift;
-
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage || currentSprite == sprite) continue;
-            if (currentSprite->layer <= targetLayer) {
-                currentSprite->layer--;
-                if (currentSprite->layer < 0) currentSprite->layer = 0;
-            }
-        }
-
-        sprite->layer = targetLayer;
+        Layers::moveBy(sprite, -shift);
     }
 
     return BlockResult::CONTINUE;
 }
 
 BlockResult LooksBlocks::goToFrontBack(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    std::string value = block.fields.at("FRONT_BACK")[0];
+    const std::string &value = block.getField("FRONT_BACK").value;
     if (value == "front") {
-
-        double maxLayer = 0.0;
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->layer > maxLayer) {
-                maxLayer = currentSprite->layer;
-            }
-        }
-
-        sprite->layer = maxLayer + 1;
-
+        Layers::goToFront(sprite);
     } else if (value == "back") {
-        double minLayer = std::numeric_limits<double>::max();
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->isStage) continue;
-            if (currentSprite->layer < minLayer) {
-                minLayer = currentSprite->layer;
-            }
-        }
-
-        sprite->layer = minLayer - 1;
+        Layers::goToBack(sprite);
     }
     return BlockResult::CONTINUE;
 }
@@ -274,23 +240,23 @@ BlockResult LooksBlocks::changeSizeBy(Block &block, Sprite *sprite, bool *withou
 
 BlockResult LooksBlocks::setEffectTo(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
 
-    std::string effect = block.fields.at("EFFECT")[0];
+    const std::string &effect = block.getField("EFFECT").value;
     Value amount = Scratch::getInputValue(block, "VALUE", sprite);
 
     if (!amount.isNumeric()) return BlockResult::CONTINUE;
 
     if (effect == "COLOR") {
-        // doable....
+        sprite->effects.color = amount.asDouble();
     } else if (effect == "FISHEYE") {
-        // blehhh
+        sprite->effects.fisheye = amount.asDouble();
     } else if (effect == "WHIRL") {
-        // blehhh
+        sprite->effects.whirl = amount.asDouble();
     } else if (effect == "PIXELATE") {
-        // blehhh
+        sprite->effects.pixelate = amount.asDouble();
     } else if (effect == "MOSAIC") {
-        // blehhh
+        sprite->effects.mosaic = amount.asDouble();
     } else if (effect == "BRIGHTNESS") {
-        // doable....
+        sprite->effects.brightness = std::clamp(amount.asDouble(), -100.0, 100.0);
     } else if (effect == "GHOST") {
         sprite->ghostEffect = std::clamp(amount.asDouble(), 0.0, 100.0);
     } else {
@@ -299,23 +265,23 @@ BlockResult LooksBlocks::setEffectTo(Block &block, Sprite *sprite, bool *without
     return BlockResult::CONTINUE;
 }
 BlockResult LooksBlocks::changeEffectBy(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    std::string effect = block.fields.at("EFFECT")[0];
+    const std::string &effect = block.getField("EFFECT").value;
     Value amount = Scratch::getInputValue(block, "CHANGE", sprite);
 
     if (!amount.isNumeric()) return BlockResult::CONTINUE;
 
     if (effect == "COLOR") {
-        // doable....
+        sprite->effects.color += amount.asDouble();
     } else if (effect == "FISHEYE") {
-        // blehhh
+        sprite->effects.fisheye += amount.asDouble();
     } else if (effect == "WHIRL") {
-        // blehhh
+        sprite->effects.whirl += amount.asDouble();
     } else if (effect == "PIXELATE") {
-        // blehhh
+        sprite->effects.pixelate += amount.asDouble();
     } else if (effect == "MOSAIC") {
-        // blehhh
+        sprite->effects.mosaic += amount.asDouble();
     } else if (effect == "BRIGHTNESS") {
-        // doable....
+        sprite->effects.brightness = std::clamp(sprite->effects.brightness + amount.asDouble(), -100.0, 100.0);
     } else if (effect == "GHOST") {
         sprite->ghostEffect += amount.asDouble();
         sprite->ghostEffect = std::clamp(sprite->ghostEffect, 0.0f, 100.0f);
@@ -326,7 +292,7 @@ BlockResult LooksBlocks::changeEffectBy(Block &block, Sprite *sprite, bool *with
 BlockResult LooksBlocks::clearGraphicEffects(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
 
     sprite->ghostEffect = 0.0f;
-    sprite->colorEffect = -99999;
+    sprite->effects = GraphicEffects();
 
     return BlockResult::CONTINUE;
 }
@@ -336,15 +302,15 @@ Value LooksBlocks::size(Block &block, Sprite *sprite) {
 }
 
 Value LooksBlocks::costume(Block &block, Sprite *sprite) {
-    return Value(block.fields.at("COSTUME")[0].get<std::string>());
+    return Value(block.getField("COSTUME").value);
 }
 
 Value LooksBlocks::backdrops(Block &block, Sprite *sprite) {
-    return Value(block.fields.at("BACKDROP")[0].get<std::string>());
+    return Value(block.getField("BACKDROP").value);
 }
 
 Value LooksBlocks::costumeNumberName(Block &block, Sprite *sprite) {
-    std::string value = block.fields.at("NUMBER_NAME")[0];
+    const std::string &value = block.getField("NUMBER_NAME").value;
     if (value == "name") {
         return Value(sprite->costumes[sprite->currentCostume].name);
     } else if (value == "number") {
@@ -354,7 +320,7 @@ Value LooksBlocks::costumeNumberName(Block &block, Sprite *sprite) {
 }
 
 Value LooksBlocks::backdropNumberName(Block &block, Sprite *sprite) {
-    std::string value = block.fields.at("NUMBER_NAME")[0];
+    const std::string &value = block.getField("NUMBER_NAME").value;
     if (value == "name") {
         for (Sprite *currentSprite : sprites) {
             if (currentSprite->isStage) {
@@ -27,9 +27,8 @@ BlockResult MotionBlocks::moveSteps(Block &block, Sprite *sprite, bool *withoutS
 }
 
 BlockResult MotionBlocks::goTo(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    auto inputValue = block.parsedInputs.find("TO");
-    Block *inputBlock = findBlock(inputValue->second.literalValue.asString());
-    std::string objectName = inputBlock->fields["TO"][0];
+    Sprite *objectSprite;
+    const std::string &objectName = resolveObjectMenu(block, "TO", sprite, &objectSprite);
 
     if (objectName == "_random_") {
         sprite->xPosition = rand() % Scratch::projectWidth - Scratch::projectWidth / 2;
@@ -43,12 +42,9 @@ BlockResult MotionBlocks::goTo(Block &block, Sprite *sprite, bool *withoutScreen
         return BlockResult::CONTINUE;
     }
 
-    for (Sprite *currentSprite : sprites) {
-        if (currentSprite->name == objectName) {
-            sprite->xPosition = currentSprite->xPosition;
-            sprite->yPosition = currentSprite->yPosition;
-            break;
-        }
+    if (objectSprite != nullptr) {
+        sprite->xPosition = objectSprite->xPosition;
+        sprite->yPosition = objectSprite->yPosition;
     }
     if (Scratch::fencing) Scratch::fenceSpriteWithinBounds(sprite);
     return BlockResult::CONTINUE;
@@ -201,12 +197,8 @@ BlockResult MotionBlocks::glideTo(Block &block, Sprite *sprite, bool *withoutScr
         block.glideStartX = sprite->xPosition;
         block.glideStartY = sprite->yPosition;
 
-        Block *inputBlock;
-        auto itVal = block.parsedInputs.find("TO");
-        inputBlock = findBlock(itVal->second.literalValue.asString());
-        if (!inputBlock) return BlockResult::CONTINUE;
-
-        std::string inputValue = inputBlock->fields["TO"][0];
+        Sprite *objectSprite;
+        const std::string &inputValue = resolveObjectMenu(block, "TO", sprite, &objectSprite);
         std::string positionXStr;
         std::string positionYStr;
 
@@ -216,14 +208,9 @@ BlockResult MotionBlocks::glideTo(Block &block, Sprite *sprite, bool *withoutScr
         } else if (inputValue == "_mouse_") {
             positionXStr = std::to_string(Input::mousePointer.x);
             positionYStr = std::to_string(Input::mousePointer.y);
-        } else {
-            for (auto &currentSprite : sprites) {
-                if (currentSprite->name == inputValue) {
-                    positionXStr = std::to_string(currentSprite->xPosition);
-                    positionYStr = std::to_string(currentSprite->yPosition);
-                    break;
-                }
-            }
+        } else if (objectSprite != nullptr) {
+            positionXStr = std::to_string(objectSprite->xPosition);
+            positionYStr = std::to_string(objectSprite->yPosition);
         }
 
         block.glideEndX = Math::isNumber(positionXStr) ? std::stod(positionXStr) : block.glideStartX;
@@ -255,14 +242,12 @@ BlockResult MotionBlocks::glideTo(Block &block, Sprite *sprite, bool *withoutScr
 }
 
 BlockResult MotionBlocks::pointToward(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    auto itVal = block.parsedInputs.find("TOWARDS");
-    Block *inputBlock = findBlock(itVal->second.literalValue.asString());
-    if (inputBlock->fields.find("TOWARDS") == inputBlock->fields.end()) {
+    Sprite *objectSprite;
+    const std::string &objectName = resolveObjectMenu(block, "TOWARDS", sprite, &objectSprite);
+    if (objectName.empty()) {
         // std::cerr << "Error: Unable to find object for POINT_TOWARD block." << std::endl;
         return BlockResult::CONTINUE;
     }
-
-    std::string objectName = inputBlock->fields["TOWARDS"][0];
     double targetX = 0;
     double targetY = 0;
 
@@ -274,14 +259,9 @@ BlockResult MotionBlocks::pointToward(Block &block, Sprite *sprite, bool *withou
     if (objectName == "_mouse_") {
         targetX = Input::mousePointer.x;
         targetY = Input::mousePointer.y;
-    } else {
-        for (Sprite *currentSprite : sprites) {
-            if (currentSprite->name == objectName) {
-                targetX = currentSprite->xPosition;
-                targetY = currentSprite->yPosition;
-                break;
-            }
-        }
+    } else if (objectSprite != nullptr) {
+        targetX = objectSprite->xPosition;
+        targetY = objectSprite->yPosition;
     }
 
     const double dx = targetX - sprite->xPosition;
@@ -293,13 +273,12 @@ BlockResult MotionBlocks::pointToward(Block &block, Sprite *sprite, bool *withou
 }
 
 BlockResult MotionBlocks::setRotationStyle(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
-    std::string value;
-    try {
-        value = block.fields.at("STYLE")[0];
-    } catch (...) {
+    const ParsedField *styleField = block.findField("STYLE");
+    if (styleField == nullptr) {
         std::cerr << "unable to find rotation style." << std::endl;
         return BlockResult::CONTINUE;
     }
+    const std::string &value = styleField->value;
 
     if (value == "left-right") {
         sprite->rotationStyle = sprite->LEFT_RIGHT;
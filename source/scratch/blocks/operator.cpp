@@ -103,7 +103,7 @@ Value OperatorBlocks::round(Block &block, Sprite *sprite) {
 Value OperatorBlocks::mathOp(Block &block, Sprite *sprite) {
     Value inputValue = Scratch::getInputValue(block, "NUM", sprite);
     if (inputValue.isNumeric()) {
-        std::string operation = block.fields.at("OPERATOR")[0];
+        const std::string &operation = block.getField("OPERATOR").value;
         double value = inputValue.asDouble();
 
         if (operation == "abs") {
@@ -0,0 +1,190 @@
+#include "pen.hpp"
+#include "blockExecutor.hpp"
+#include "interpret.hpp"
+#include "penLayer.hpp"
+#include "sprite.hpp"
+#include "value.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+static double wrapColor(double color) {
+    color = std::fmod(color, 100.0);
+    if (color < 0) color += 100;
+    return color;
+}
+
+static void setColorFromRGB(PenState &pen, int r, int g, int b) {
+    const double red = r / 255.0, green = g / 255.0, blue = b / 255.0;
+    const double max = std::max({red, green, blue});
+    const double min = std::min({red, green, blue});
+    const double delta = max - min;
+
+    double hue = 0;
+    if (delta > 0) {
+        if (max == red) hue = std::fmod((green - blue) / delta, 6.0);
+        else if (max == green) hue = (blue - red) / delta + 2;
+        else hue = (red - green) / delta + 4;
+    }
+    pen.color = wrapColor(hue / 6.0 * 100);
+    pen.saturation = max > 0 ? delta / max * 100 : 0;
+    pen.brightness = max * 100;
+}
+
+/**
+ * Recalculates the pen color with the Scratch 2 shade model, for the old hue and shade blocks.
+ */
+static void updateLegacyColor(PenState &pen) {
+    pen.saturation = 100;
+    pen.brightness = 100;
+    PenLayer::updateColor(pen);
+
+    double r = pen.r, g = pen.g, b = pen.b;
+    const double shade = pen.shade > 100 ? 200 - pen.shade : pen.shade;
+    if (shade < 50) {
+        const double amount = (10 + shade) / 60;
+        r *= amount, g *= amount, b *= amount;
+    } else {
+        const double amount = (shade - 50) / 60;
+        r += (255 - r) * amount, g += (255 - g) * amount, b += (255 - b) * amount;
+    }
+
+    setColorFromRGB(pen, std::round(r), std::round(g), std::round(b));
+    PenLayer::updateColor(pen);
+}
+
+static void setOrChangeColorParam(PenState &pen, const std::string &param, double value, bool change) {
+    if (param == "color") {
+        pen.color = wrapColor(change ? pen.color + value : value);
+    } else if (param == "saturation") {
+        pen.saturation = std::clamp(change ? pen.saturation + value : value, 0.0, 100.0);
+    } else if (param == "brightness") {
+        pen.brightness = std::clamp(change ? pen.brightness + value : value, 0.0, 100.0);
+    } else if (param == "transparency") {
+        pen.transparency = std::clamp(change ? pen.transparency + value : value, 0.0, 100.0);
+    } else {
+        Log::logWarning("Unknown pen color parameter: " + param);
+        return;
+    }
+    PenLayer::updateColor(pen);
+}
+
+static std::string getColorParam(Block &block, Sprite *sprite) {
+    Value inputValue = Scratch::getInputValue(block, "COLOR_PARAM", sprite);
+
+    // if no blocks are inside the input
+    auto inputFind = block.parsedInputs.find("COLOR_PARAM");
+    if (inputFind != block.parsedInputs.end() && inputFind->second.inputType == ParsedInput::LITERAL) {
+        Block *inputBlock = findBlock(inputValue.asString());
+        if (inputBlock != nullptr) return PenBlocks::colorParamMenu(*inputBlock, sprite).asString();
+    }
+    return inputValue.asString();
+}
+
+BlockResult PenBlocks::clear(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    PenLayer::clear();
+    return BlockResult::CONTINUE;
+}
+
+BlockResult PenBlocks::stamp(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    if (!sprite->isStage) PenLayer::stamp(sprite);
+    return BlockResult::CONTINUE;
+}
+
+BlockResult PenBlocks::penDown(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    if (!sprite->isStage) PenLayer::penDown(sprite);
+    return BlockResult::CONTINUE;
+}
+
+BlockResult PenBlocks::penUp(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    PenLayer::penUp(sprite);
+    return BlockResult::CONTINUE;
+}
+
+BlockResult PenBlocks::setPenColorToColor(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    Value inputValue = Scratch::getInputValue(block, "COLOR", sprite);
+    const std::string colorString = inputValue.asString();
+    PenState &pen = sprite->pen;
+
+    if (!colorString.empty() && colorString[0] == '#') {
+        std::string hex = colorString.substr(1);
+        if (hex.size() == 3) hex = {hex[0], hex[0], hex[1], hex[1], hex[2], hex[2]};
+        const long color = std::strtol(hex.c_str(), nullptr, 16);
+        setColorFromRGB(pen, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);
+        pen.transparency = 0;
+    } else {
+        // numbers are 0xAARRGGBB, where an alpha of 0 means opaque
+        const uint32_t color = static_cast<uint32_t>(static_cast<int64_t>(inputValue.asDouble()));
+        setColorFromRGB(pen, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);
+        const uint32_t alpha = color >> 24;
+        pen.transparency = alpha > 0 ? 100 * (1 - alpha / 255.0) : 0;
+    }
+    PenLayer::updateColor(pen);
+    return BlockResult::CONTINUE;
+}
+
+BlockResult PenBlocks::changePenColorParamBy(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    Value value = Scratch::getInputValue(block, "VALUE", sprite);
+    setOrChangeColorParam(sprite->pen, getColorParam(block, sprite), value.asDouble(), true);
+    return BlockResult::CONTINUE;
+}
+
+BlockResult PenBlocks::setPenColorParamTo(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    Value value = Scratch::getInputValue(block, "VALUE", sprite);
+    setOrChangeColorParam(sprite->pen, getColorParam(block, sprite), value.asDouble(), false);
+    return BlockResult::CONTINUE;
+}
+
+BlockResult PenBlocks::changePenSizeBy(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    Value value = Scratch::getInputValue(block, "SIZE", sprite);
+    sprite->pen.size = std::clamp(sprite->pen.size + value.asDouble(), 1.0, 1200.0);
+    return BlockResult::CONTINUE;
+}
+
+BlockResult PenBlocks::setPenSizeTo(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    Value value = Scratch::getInputValue(block, "SIZE", sprite);
+    sprite->pen.size = std::clamp(value.asDouble(), 1.0, 1200.0);
+    return BlockResult::CONTINUE;
+}
+
+BlockResult PenBlocks::setPenShadeToNumber(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    Value value = Scratch::getInputValue(block, "SHADE", sprite);
+    double shade = std::fmod(value.asDouble(), 200.0);
+    if (shade < 0) shade += 200;
+    sprite->pen.shade = shade;
+    updateLegacyColor(sprite->pen);
+    return BlockResult::CONTINUE;
+}
+
+BlockResult PenBlocks::changePenShadeBy(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    Value value = Scratch::getInputValue(block, "SHADE", sprite);
+    double shade = std::fmod(sprite->pen.shade + value.asDouble(), 200.0);
+    if (shade < 0) shade += 200;
+    sprite->pen.shade = shade;
+    updateLegacyColor(sprite->pen);
+    return BlockResult::CONTINUE;
+}
+
+BlockResult PenBlocks::setPenHueToNumber(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    Value value = Scratch::getInputValue(block, "HUE", sprite);
+    sprite->pen.color = wrapColor(value.asDouble() / 2);
+    sprite->pen.transparency = 0;
+    updateLegacyColor(sprite->pen);
+    return BlockResult::CONTINUE;
+}
+
+BlockResult PenBlocks::changePenHueBy(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    Value value = Scratch::getInputValue(block, "HUE", sprite);
+    sprite->pen.color = wrapColor(sprite->pen.color + value.asDouble() / 2);
+    updateLegacyColor(sprite->pen);
+    return BlockResult::CONTINUE;
+}
+
+Value PenBlocks::colorParamMenu(Block &block, Sprite *sprite) {
+    const ParsedField *colorParamField = block.findField("colorParam");
+    if (colorParamField != nullptr) {
+        return Value(colorParamField->value);
+    }
+    return Value(std::string("color"));
+}
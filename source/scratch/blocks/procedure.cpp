@@ -4,21 +4,22 @@
 #include "value.hpp"
 
 Value ProcedureBlocks::stringNumber(Block &block, Sprite *sprite) {
-    if (block.fields.at("VALUE")[0].get<std::string>() == "Scratch Everywhere! platform") {
+    const std::string &name = block.getField("VALUE").value;
+    if (name == "Scratch Everywhere! platform") {
         return Value(OS::getPlatform());
     }
 
-    return BlockExecutor::getCustomBlockValue(block.fields.at("VALUE")[0], sprite, block);
+    return BlockExecutor::getCustomBlockValue(name, sprite, block);
 }
 
 Value ProcedureBlocks::booleanArgument(Block &block, Sprite *sprite) {
-    const std::string name = block.fields.at("VALUE")[0].get<std::string>();
+    const std::string &name = block.getField("VALUE").value;
     if (name == "is Scratch Everywhere!?") return Value(true);
     if (name == "is New 3DS?") {
         return Value(OS::isNew3DS());
     }
 
-    Value value = BlockExecutor::getCustomBlockValue(block.fields.at("VALUE")[0], sprite, block);
+    Value value = BlockExecutor::getCustomBlockValue(name, sprite, block);
     return Value(value.asInt() == 1);
 }
 
@@ -25,7 +25,7 @@ BlockResult SensingBlocks::askAndWait(Block &block, Sprite *sprite, bool *withou
 
 BlockResult SensingBlocks::setDragMode(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
 
-    std::string mode = block.fields.at("DRAG_MODE")[0];
+    const std::string &mode = block.getField("DRAG_MODE").value;
 
     if (mode == "draggable") {
         sprite->draggable = true;
@@ -41,22 +41,9 @@ Value SensingBlocks::sensingTimer(Block &block, Sprite *sprite) {
 }
 
 Value SensingBlocks::of(Block &block, Sprite *sprite) {
-    std::string value = block.fields.at("PROPERTY")[0];
-    std::string object;
-    auto objectFind = block.parsedInputs.find("OBJECT");
-    Block *objectBlock = findBlock(objectFind->second.literalValue.asString());
-    if (!objectBlock || objectBlock == nullptr)
-        return Value();
-
-    object = objectBlock->fields.at("OBJECT")[0];
-
-    Sprite *spriteObject = nullptr;
-    for (Sprite *currentSprite : sprites) {
-        if (currentSprite->name == object && !currentSprite->isClone) {
-            spriteObject = currentSprite;
-            break;
-        }
-    }
+    const std::string &value = block.getField("PROPERTY").value;
+    Sprite *spriteObject;
+    resolveObjectMenu(block, "OBJECT", sprite, &spriteObject);
 
     if (!spriteObject) return Value(0);
 
@@ -78,10 +65,9 @@ Value SensingBlocks::of(Block &block, Sprite *sprite) {
         return Value(spriteObject->volume);
     }
 
-    for (const auto &[id, variable] : spriteObject->variables) {
-        if (value == variable.name) {
-            return variable.value;
-        }
+    auto variableFind = spriteObject->variableIdsByName.find(value);
+    if (variableFind != spriteObject->variableIdsByName.end()) {
+        return spriteObject->variables[variableFind->second].value;
     }
     return Value(0);
 }
@@ -95,21 +81,18 @@ Value SensingBlocks::mouseY(Block &block, Sprite *sprite) {
 }
 
 Value SensingBlocks::distanceTo(Block &block, Sprite *sprite) {
-    auto inputFind = block.parsedInputs.find("DISTANCETOMENU");
-    Block *inputBlock = findBlock(inputFind->second.literalValue.asString());
-    std::string object = inputBlock->fields.at("DISTANCETOMENU")[0];
+    Sprite *objectSprite;
+    const std::string &object = resolveObjectMenu(block, "DISTANCETOMENU", sprite, &objectSprite);
 
     if (object == "_mouse_") {
         return Value(sqrt(pow(Input::mousePointer.x - sprite->xPosition, 2) +
                           pow(Input::mousePointer.y - sprite->yPosition, 2)));
     }
 
-    for (Sprite *currentSprite : sprites) {
-        if (currentSprite->name == object && !currentSprite->isClone) {
-            double distance = sqrt(pow(currentSprite->xPosition - sprite->xPosition, 2) +
-                                   pow(currentSprite->yPosition - sprite->yPosition, 2));
-            return Value(distance);
-        }
+    if (objectSprite != nullptr && !objectSprite->isStage) {
+        double distance = sqrt(pow(objectSprite->xPosition - sprite->xPosition, 2) +
+                               pow(objectSprite->yPosition - sprite->yPosition, 2));
+        return Value(distance);
     }
     return Value(10000);
 }
@@ -119,12 +102,7 @@ Value SensingBlocks::daysSince2000(Block &block, Sprite *sprite) {
 }
 
 Value SensingBlocks::current(Block &block, Sprite *sprite) {
-    std::string inputValue;
-    try {
-        inputValue = block.fields.at("CURRENTMENU")[0];
-    } catch (...) {
-        return Value();
-    }
+    const std::string &inputValue = block.getField("CURRENTMENU").value;
 
     if (inputValue == "YEAR") return Value(Time::getYear());
     if (inputValue == "MONTH") return Value(Time::getMonth());
@@ -148,8 +126,9 @@ Value SensingBlocks::keyPressed(Block &block, Sprite *sprite) {
     // if no variable block is in the input
     if (inputFind->second.inputType == ParsedInput::LITERAL) {
         Block *inputBlock = findBlock(inputFind->second.literalValue.asString());
-        if (!inputBlock->fields["KEY_OPTION"][0].is_null())
-            buttonCheck = inputBlock->fields["KEY_OPTION"][0];
+        const ParsedField *keyField = inputBlock->findField("KEY_OPTION");
+        if (keyField != nullptr)
+            buttonCheck = keyField->value;
     } else {
         buttonCheck = Scratch::getInputValue(block, "KEY_OPTION", sprite).asString();
     }
@@ -164,20 +143,17 @@ Value SensingBlocks::keyPressed(Block &block, Sprite *sprite) {
 }
 
 Value SensingBlocks::touchingObject(Block &block, Sprite *sprite) {
-    auto inputFind = block.parsedInputs.find("TOUCHINGOBJECTMENU");
-    Block *inputBlock = findBlock(inputFind->second.literalValue.asString());
-    std::string objectName;
-    try {
-        objectName = inputBlock->fields["TOUCHINGOBJECTMENU"][0];
-    } catch (...) {
-        return Value(false);
-    }
+    Sprite *objectSprite;
+    const std::string &objectName = resolveObjectMenu(block, "TOUCHINGOBJECTMENU", sprite, &objectSprite);
 
-    if (objectName == "_mouse_") {
+    if (objectName.empty()) {
+        return Value(false);
+    } else if (objectName == "_mouse_") {
         return Value(isColliding("mouse", sprite));
     } else if (objectName == "_edge_") {
         return Value(isColliding("edge", sprite));
-    } else {
+    } else if (objectSprite != nullptr) {
+        // the original and every clone of it can be touched
         for (size_t i = 0; i < sprites.size(); i++) {
             Sprite *currentSprite = sprites[i];
             if (currentSprite->name == objectName &&
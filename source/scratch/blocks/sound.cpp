@@ -5,6 +5,28 @@
 #include "interpret.hpp"
 #include "sprite.hpp"
 #include "value.hpp"
+#include <algorithm>
+
+/**
+ * Plays a sound with the volume and effects of a sprite, loading it first if it isn't loaded.
+ */
+static void startSound(Sprite *sprite, const Sound &sound) {
+    const bool loaded = SoundPlayer::isSoundLoaded(sound.fullName);
+    if (!loaded) SoundPlayer::startSoundLoader(sprite, &Unzip::zipArchive, sound.fullName);
+
+    // sounds are shared by sprites, so they get the effects of the one playing them before they start
+    SoundPlayer::setSoundEffects(sound.fullName, sprite->soundEffects.pitch, sprite->soundEffects.pan);
+    if (loaded) SoundPlayer::playSound(sound.fullName);
+}
+
+/**
+ * Applies a sprite's sound effects to its sounds, including the ones playing right now.
+ */
+static void updateSoundEffects(Sprite *sprite) {
+    for (auto &[id, sound] : sprite->sounds) {
+        SoundPlayer::setSoundEffects(sound.fullName, sprite->soundEffects.pitch, sprite->soundEffects.pan);
+    }
+}
 
 BlockResult SoundBlocks::playSoundUntilDone(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
 
@@ -15,8 +37,9 @@ BlockResult SoundBlocks::playSoundUntilDone(Block &block, Sprite *sprite, bool *
     auto inputFind = block.parsedInputs.find("SOUND_MENU");
     if (inputFind != block.parsedInputs.end() && inputFind->second.inputType == ParsedInput::LITERAL) {
         Block *inputBlock = findBlock(inputValue.asString());
-        if (inputBlock != nullptr && inputBlock->fields["SOUND_MENU"][0].is_string()) {
-            inputString = inputBlock->fields["SOUND_MENU"][0].get<std::string>();
+        const ParsedField *soundField = inputBlock != nullptr ? inputBlock->findField("SOUND_MENU") : nullptr;
+        if (soundField != nullptr) {
+            inputString = soundField->value;
         }
     }
 
@@ -35,11 +58,7 @@ BlockResult SoundBlocks::playSoundUntilDone(Block &block, Sprite *sprite, bool *
 
         auto soundFind = sprite->sounds.find(inputString);
         if (soundFind != sprite->sounds.end()) {
-            const Sound *sound = &soundFind->second;
-            if (!SoundPlayer::isSoundLoaded(sprite->sounds[inputString].fullName))
-                SoundPlayer::startSoundLoaderThread(sprite, &Unzip::zipArchive, sound->fullName);
-            else
-                SoundPlayer::playSound(sprite->sounds[inputString].fullName);
+            startSound(sprite, soundFind->second);
         }
 
         BlockExecutor::addToRepeatQueue(sprite, &block);
@@ -62,8 +81,9 @@ BlockResult SoundBlocks::playSound(Block &block, Sprite *sprite, bool *withoutSc
     auto inputFind = block.parsedInputs.find("SOUND_MENU");
     if (inputFind != block.parsedInputs.end() && inputFind->second.inputType == ParsedInput::LITERAL) {
         Block *inputBlock = findBlock(inputValue.asString());
-        if (inputBlock != nullptr && inputBlock->fields["SOUND_MENU"][0].is_string()) {
-            inputString = inputBlock->fields["SOUND_MENU"][0].get<std::string>();
+        const ParsedField *soundField = inputBlock != nullptr ? inputBlock->findField("SOUND_MENU") : nullptr;
+        if (soundField != nullptr) {
+            inputString = soundField->value;
         }
     }
 
@@ -75,11 +95,7 @@ BlockResult SoundBlocks::playSound(Block &block, Sprite *sprite, bool *withoutSc
 
     auto soundFind = sprite->sounds.find(inputString);
     if (soundFind != sprite->sounds.end()) {
-        const Sound *sound = &soundFind->second;
-        if (!SoundPlayer::isSoundLoaded(sprite->sounds[inputString].fullName))
-            SoundPlayer::startSoundLoaderThread(sprite, &Unzip::zipArchive, sound->fullName);
-        else
-            SoundPlayer::playSound(sprite->sounds[inputString].fullName);
+        startSound(sprite, soundFind->second);
     }
 
     return BlockResult::CONTINUE;
@@ -93,14 +109,38 @@ BlockResult SoundBlocks::stopAllSounds(Block &block, Sprite *sprite, bool *witho
 }
 
 BlockResult SoundBlocks::changeEffectBy(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    const std::string &effect = block.getField("EFFECT").value;
+    Value amount = Scratch::getInputValue(block, "VALUE", sprite);
+
+    if (!amount.isNumeric()) return BlockResult::CONTINUE;
+
+    if (effect == "PITCH") {
+        sprite->soundEffects.pitch = std::clamp(sprite->soundEffects.pitch + amount.asDouble(), -360.0, 360.0);
+    } else if (effect == "PAN") {
+        sprite->soundEffects.pan = std::clamp(sprite->soundEffects.pan + amount.asDouble(), -100.0, 100.0);
+    }
+    updateSoundEffects(sprite);
     return BlockResult::CONTINUE;
 }
 
 BlockResult SoundBlocks::setEffectTo(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    const std::string &effect = block.getField("EFFECT").value;
+    Value amount = Scratch::getInputValue(block, "VALUE", sprite);
+
+    if (!amount.isNumeric()) return BlockResult::CONTINUE;
+
+    if (effect == "PITCH") {
+        sprite->soundEffects.pitch = std::clamp(amount.asDouble(), -360.0, 360.0);
+    } else if (effect == "PAN") {
+        sprite->soundEffects.pan = std::clamp(amount.asDouble(), -100.0, 100.0);
+    }
+    updateSoundEffects(sprite);
     return BlockResult::CONTINUE;
 }
 
 BlockResult SoundBlocks::clearSoundEffects(Block &block, Sprite *sprite, bool *withoutScreenRefresh, bool fromRepeat) {
+    sprite->soundEffects = SoundEffects();
+    updateSoundEffects(sprite);
     return BlockResult::CONTINUE;
 }
 
@@ -0,0 +1,98 @@
+#include "costumePrefetch.hpp"
+#include "image.hpp"
+#include "interpret.hpp"
+#include "lruCache.hpp"
+#include "os.hpp"
+#include "sprite.hpp"
+#include <unordered_set>
+
+/**
+ * Adds every costume of a sprite, starting with the one after its current costume.
+ */
+static void addAllCostumes(std::vector<std::string> &costumes, const Sprite *sprite) {
+    if (sprite == nullptr) return;
+    const size_t count = sprite->costumes.size();
+    for (size_t i = 1; i <= count; i++) {
+        costumes.push_back(sprite->costumes[(sprite->currentCostume + i) % count].fullName);
+    }
+}
+
+/**
+ * Adds the costume a costume or backdrop menu picks, if the sprite has a costume with that name.
+ */
+static void addMenuCostume(std::vector<std::string> &costumes, const Sprite *sprite, const Block &menuBlock, const char *fieldName) {
+    if (sprite == nullptr) return;
+    const ParsedField *field = menuBlock.findField(fieldName);
+    if (field == nullptr) return;
+
+    for (const Costume &costume : sprite->costumes) {
+        if (costume.name == field->value) {
+            costumes.push_back(costume.fullName);
+            return;
+        }
+    }
+}
+
+/**
+ * Checks if a block's input gets worked out while the project runs, instead of coming from a menu.
+ */
+static bool isComputedInput(const Block &block, const std::string &inputName) {
+    auto inputFind = block.parsedInputs.find(inputName);
+    return inputFind != block.parsedInputs.end() &&
+           (inputFind->second.inputType == ParsedInput::BLOCK || inputFind->second.inputType == ParsedInput::VARIABLE);
+}
+
+void CostumePrefetch::start() {
+    const std::vector<std::string> costumes = findReachableCostumes();
+    if (costumes.empty()) return;
+    Log::log("Prefetching up to " + std::to_string(costumes.size()) + " costumes.");
+    Image::prefetchImages(costumes);
+}
+
+std::vector<std::string> CostumePrefetch::findReachableCostumes() {
+    const Sprite *stage = nullptr;
+    for (const Sprite *sprite : sprites) {
+        if (sprite->isStage) stage = sprite;
+    }
+
+    std::vector<std::string> shown;
+    std::vector<std::string> picked;
+    std::vector<std::string> cycled;
+    std::vector<std::string> computed;
+
+    for (Sprite *sprite : sprites) {
+        if (sprite->isClone) continue;
+
+        for (auto &[id, block] : sprite->blocks) {
+            if (block.opcode == "looks_show") {
+                if (!sprite->costumes.empty()) shown.push_back(sprite->costumes[sprite->currentCostume].fullName);
+            } else if (block.opcode == "looks_costume") {
+                addMenuCostume(picked, sprite, block, "COSTUME");
+            } else if (block.opcode == "looks_backdrops") {
+                addMenuCostume(picked, stage, block, "BACKDROP");
+            } else if (block.opcode == "looks_nextcostume") {
+                addAllCostumes(cycled, sprite);
+            } else if (block.opcode == "looks_nextbackdrop") {
+                addAllCostumes(cycled, stage);
+            } else if (block.opcode == "looks_switchcostumeto") {
+                if (isComputedInput(block, "COSTUME")) addAllCostumes(computed, sprite);
+            } else if (block.opcode == "looks_switchbackdropto" || block.opcode == "looks_switchbackdroptoandwait") {
+                if (isComputedInput(block, "BACKDROP")) addAllCostumes(computed, stage);
+            }
+        }
+    }
+
+    std::vector<std::string> costumes;
+    std::unordered_set<std::string> added;
+    for (const std::vector<std::string> *group : {&shown, &picked, &cycled, &computed}) {
+        for (const std::string &costume : *group) {
+            if (added.insert(costume).second) costumes.push_back(costume);
+        }
+    }
+    return costumes;
+}
+
+bool CostumePrefetch::hasMemoryForMore() {
+    // once RAM or VRAM goes over 80% of its budget, images get freed until both are under 50%, so stay under that
+    return !LruCache::isOverBudget(0.5);
+}
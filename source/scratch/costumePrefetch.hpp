@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * Loads costumes the project's scripts can switch to before they're needed,
+ * so the first time a sprite animates doesn't stutter while its costumes decode.
+ */
+class CostumePrefetch {
+  public:
+    // how long prefetching can keep the main thread busy each frame
+    static constexpr double MS_PER_FRAME = 4;
+
+    /**
+     * Looks through every sprite's scripts for costumes they can show, and starts loading them in the background.
+     */
+    static void start();
+
+    /**
+     * Finds the costumes a project's scripts can reach, most likely to be needed first:
+     * costumes of hidden sprites that get shown, costumes picked in a costume or backdrop menu,
+     * every costume of sprites that use 'next costume' or 'next backdrop',
+     * then every costume of sprites that switch to a costume they work out while running.
+     * Costumes that are already loaded are included too; loading skips them.
+     * @return File names of the costumes, without duplicates.
+     */
+    static std::vector<std::string> findReachableCostumes();
+
+    /**
+     * Checks if there's memory left to load costumes nothing is showing yet.
+     * Stops well before images that are in use start getting freed to make room.
+     */
+    static bool hasMemoryForMore();
+};
@@ -0,0 +1,225 @@
+#include "effects.hpp"
+#include "math.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// how many tiles the mosaic effect makes on each axis
+static int getMosaicCount(double mosaic) {
+    return std::clamp(static_cast<int>(std::round((std::abs(mosaic) + 10) / 10)), 1, 512);
+}
+
+bool Effects::isActive(const GraphicEffects &effects) {
+    const GraphicEffects quantized = quantize(effects);
+    return quantized.color != 0 || quantized.brightness != 0 || quantized.fisheye != 0 ||
+           quantized.whirl != 0 || quantized.pixelate != 0 || quantized.mosaic != 0;
+}
+
+GraphicEffects Effects::quantize(const GraphicEffects &effects) {
+    GraphicEffects quantized;
+    quantized.color = std::fmod(std::round(effects.color), 200.0);
+    if (quantized.color < 0) quantized.color += 200;
+    quantized.brightness = std::round(std::clamp(effects.brightness, -100.0, 100.0));
+    quantized.fisheye = std::round(std::max(effects.fisheye, -100.0));
+    quantized.whirl = std::round(effects.whirl);
+    quantized.pixelate = std::round(std::abs(effects.pixelate));
+
+    // mosaic only changes in steps of 10, so every value in a step shares a cache entry
+    quantized.mosaic = (getMosaicCount(effects.mosaic) - 1) * 10;
+    return quantized;
+}
+
+std::string Effects::getCacheKey(const std::string &costumeId, const GraphicEffects &effects) {
+    const GraphicEffects quantized = quantize(effects);
+    std::string key = costumeId;
+    for (double value : {quantized.color, quantized.brightness, quantized.fisheye, quantized.whirl, quantized.pixelate, quantized.mosaic}) {
+        key += '|' + std::to_string(static_cast<long long>(value));
+    }
+    return key;
+}
+
+/**
+ * Moves every pixel to where the mosaic, pixelate, whirl and fisheye effects put it.
+ * Texture coordinates go from 0 to 1 like in Scratch's shader, and get clamped to the edge.
+ */
+static void applyDistortion(const uint32_t *source, uint32_t *dest, int width, int height, const GraphicEffects &effects) {
+    const int mosaic = getMosaicCount(effects.mosaic);
+    const double pixelate = effects.pixelate / 10;
+    const double whirl = -effects.whirl * M_PI / 180;
+    const double fisheye = std::max(0.0, (effects.fisheye + 100) / 100);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            double u = (x + 0.5) / width;
+            double v = (y + 0.5) / height;
+
+            if (mosaic > 1) {
+                u = u * mosaic - std::floor(u * mosaic);
+                v = v * mosaic - std::floor(v * mosaic);
+            }
+            if (pixelate > 0) {
+                const double texelsX = width / pixelate;
+                const double texelsY = height / pixelate;
+                u = (std::floor(u * texelsX) + 0.5) / texelsX;
+                v = (std::floor(v * texelsY) + 0.5) / texelsY;
+            }
+            if (whirl != 0) {
+                const double offsetX = u - 0.5;
+                const double offsetY = v - 0.5;
+                const double factor = std::max(1.0 - std::hypot(offsetX, offsetY) / 0.5, 0.0);
+                const double angle = whirl * factor * factor;
+                const double sinWhirl = std::sin(angle);
+                const double cosWhirl = std::cos(angle);
+                u = cosWhirl * offsetX + sinWhirl * offsetY + 0.5;
+                v = -sinWhirl * offsetX + cosWhirl * offsetY + 0.5;
+            }
+            if (fisheye != 1) {
+                const double vecX = (u - 0.5) / 0.5;
+                const double vecY = (v - 0.5) / 0.5;
+                const double length = std::hypot(vecX, vecY);
+                if (length > 0) {
+                    const double r = std::pow(std::min(length, 1.0), fisheye) * std::max(1.0, length);
+                    u = 0.5 + r * (vecX / length) * 0.5;
+                    v = 0.5 + r * (vecY / length) * 0.5;
+                }
+            }
+
+            const int sampleX = std::clamp(static_cast<int>(u * width), 0, width - 1);
+            const int sampleY = std::clamp(static_cast<int>(v * height), 0, height - 1);
+            dest[y * width + x] = source[sampleY * width + sampleX];
+        }
+    }
+}
+
+/**
+ * Shifts the hue of every pixel. Flat colored costumes (like most SVGs) reuse the last result.
+ * Pixels are handled as bytes, so this works the same on big endian consoles.
+ */
+static void applyColor(uint32_t *pixels, int count, double color) {
+    const double shift = color / 200;
+    uint32_t lastInput = 0;
+    uint32_t lastOutput = 0;
+
+    for (int i = 0; i < count; i++) {
+        const uint32_t pixel = pixels[i];
+        uint8_t *channels = reinterpret_cast<uint8_t *>(&pixels[i]);
+        if (channels[3] == 0) continue;
+        if (pixel == lastInput && i > 0) {
+            pixels[i] = lastOutput;
+            continue;
+        }
+        lastInput = pixel;
+
+        const double r = channels[0] / 255.0;
+        const double g = channels[1] / 255.0;
+        const double b = channels[2] / 255.0;
+        const double max = std::max({r, g, b});
+        const double min = std::min({r, g, b});
+        const double delta = max - min;
+
+        double hue = 0;
+        if (delta > 0) {
+            if (max == r) hue = std::fmod((g - b) / delta + 6, 6.0);
+            else if (max == g) hue = (b - r) / delta + 2;
+            else hue = (r - g) / delta + 4;
+            hue /= 6;
+        }
+        double saturation = max > 0 ? delta / max : 0;
+        double value = max;
+
+        // grays get a tiny bit of saturation so the effect still does something, same as Scratch
+        if (value < 0.11 / 2) {
+            hue = 0, saturation = 1, value = 0.11 / 2;
+        } else if (saturation < 0.09) {
+            hue = 0, saturation = 0.09;
+        }
+
+        hue = std::fmod(hue + shift, 1.0) * 6;
+        const int sector = static_cast<int>(hue) % 6;
+        const double fraction = hue - std::floor(hue);
+        const double p = value * (1 - saturation);
+        const double q = value * (1 - saturation * fraction);
+        const double t = value * (1 - saturation * (1 - fraction));
+
+        double outR, outG, outB;
+        switch (sector) {
+        case 0:
+            outR = value, outG = t, outB = p;
+            break;
+        case 1:
+            outR = q, outG = value, outB = p;
+            break;
+        case 2:
+            outR = p, outG = value, outB = t;
+            break;
+        case 3:
+            outR = p, outG = q, outB = value;
+            break;
+        case 4:
+            outR = t, outG = p, outB = value;
+            break;
+        default:
+            outR = value, outG = p, outB = q;
+            break;
+        }
+
+        channels[0] = static_cast<uint8_t>(std::round(outR * 255));
+        channels[1] = static_cast<uint8_t>(std::round(outG * 255));
+        channels[2] = static_cast<uint8_t>(std::round(outB * 255));
+        lastOutput = pixels[i];
+    }
+}
+
+/**
+ * Adds the same amount to the red, green and blue of every pixel, clamping to 0-255.
+ */
+static void applyBrightness(uint32_t *pixels, int count, double brightness) {
+    const int amount = static_cast<int>(std::round(std::abs(brightness) / 100 * 255));
+    const bool brighten = brightness > 0;
+    uint8_t addBytes[16];
+    for (int i = 0; i < 16; i++) {
+        addBytes[i] = i % 4 == 3 ? 0 : amount; // leave alpha alone
+    }
+
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i add = _mm_loadu_si128(reinterpret_cast<const __m128i *>(addBytes));
+    for (; i + 4 <= count; i += 4) {
+        __m128i *chunk = reinterpret_cast<__m128i *>(pixels + i);
+        const __m128i value = _mm_loadu_si128(chunk);
+        _mm_storeu_si128(chunk, brighten ? _mm_adds_epu8(value, add) : _mm_subs_epu8(value, add));
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t add = vld1q_u8(addBytes);
+    for (; i + 4 <= count; i += 4) {
+        uint8_t *chunk = reinterpret_cast<uint8_t *>(pixels + i);
+        const uint8x16_t value = vld1q_u8(chunk);
+        vst1q_u8(chunk, brighten ? vqaddq_u8(value, add) : vqsubq_u8(value, add));
+    }
+#endif
+    for (; i < count; i++) {
+        uint8_t *channels = reinterpret_cast<uint8_t *>(&pixels[i]);
+        for (int channel = 0; channel < 3; channel++) {
+            channels[channel] = std::clamp(brighten ? channels[channel] + amount : channels[channel] - amount, 0, 255);
+        }
+    }
+}
+
+void Effects::apply(const uint32_t *source, uint32_t *dest, int width, int height, const GraphicEffects &effects) {
+    const int count = width * height;
+    if (effects.mosaic != 0 || effects.pixelate != 0 || effects.whirl != 0 || effects.fisheye != 0) {
+        applyDistortion(source, dest, width, height, effects);
+    } else {
+        std::memcpy(dest, source, count * sizeof(uint32_t));
+    }
+
+    // Scratch does color before brightness
+    if (effects.color != 0) applyColor(dest, count, effects.color);
+    if (effects.brightness != 0) applyBrightness(dest, count, effects.brightness);
+}
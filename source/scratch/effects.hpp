@@ -0,0 +1,44 @@
+#pragma once
+#include "sprite.hpp"
+#include <cstdint>
+#include <string>
+
+/**
+ * Applies the looks block graphic effects (except ghost, which renderers do with alpha) to costume pixels.
+ * Results are meant to be cached by the renderer, so effect values get rounded to
+ * whole steps to keep the amount of different results small.
+ */
+class Effects {
+  public:
+    /**
+     * Checks if any effect that changes pixels is set.
+     * @param effects
+     * @return `true` if the costume has to go through `apply()` before drawing.
+     */
+    static bool isActive(const GraphicEffects &effects);
+
+    /**
+     * Rounds effects to the steps results get cached at, and clamps them to the ranges Scratch uses.
+     * @param effects
+     * @return
+     */
+    static GraphicEffects quantize(const GraphicEffects &effects);
+
+    /**
+     * Makes a key that's the same for every costume and effect combination that looks the same.
+     * @param costumeId
+     * @param effects
+     * @return
+     */
+    static std::string getCacheKey(const std::string &costumeId, const GraphicEffects &effects);
+
+    /**
+     * Applies effects to an image, the same way Scratch's sprite shader does.
+     * @param source Straight alpha RGBA8888 pixels, one row after another.
+     * @param dest Gets `width * height` pixels, can't be the same as `source`.
+     * @param width
+     * @param height
+     * @param effects Should already be quantized.
+     */
+    static void apply(const uint32_t *source, uint32_t *dest, int width, int height, const GraphicEffects &effects);
+};
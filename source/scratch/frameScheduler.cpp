@@ -0,0 +1,110 @@
+#include "frameScheduler.hpp"
+#include "os.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+#ifdef __3DS__
+#include <3ds.h>
+#elif !defined(HEADLESS_BUILD)
+#include <SDL2/SDL.h>
+#endif
+#ifdef __OGC__
+#include <gccore.h>
+#endif
+
+// how much the averages move towards each new frame
+static constexpr double AVERAGE_WEIGHT = 0.05;
+
+FrameScheduler::FrameScheduler(DropPolicy policy) : dropPolicy(policy) {
+}
+
+double FrameScheduler::getTimeMs() {
+#ifdef __OGC__
+    return ticks_to_microsecs(gettime()) / 1000.0;
+#else
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double, std::milli>(now).count();
+#endif
+}
+
+#ifndef HEADLESS_BUILD
+static void sleepMs(double ms) {
+#ifdef __3DS__
+    svcSleepThread(static_cast<s64>(ms * 1000000));
+#else
+    // SDL only sleeps in whole milliseconds, round up so it doesn't wake up early and need a second sleep
+    SDL_Delay(static_cast<Uint32>(std::ceil(ms)));
+#endif
+}
+#endif
+
+void FrameScheduler::reset() {
+    stats = Stats();
+    nextDeadline = -1;
+    lastFrameStart = -1;
+}
+
+void FrameScheduler::waitForFrame(double fps) {
+    const double targetMs = 1000.0 / std::max(fps, 1.0);
+    double now = getTimeMs();
+
+    if (nextDeadline < 0 || targetMs != frameMs) {
+        frameMs = targetMs;
+        nextDeadline = now;
+    }
+
+    double sleptMs = 0;
+#ifndef HEADLESS_BUILD // headless runs go as fast as they can
+    if (now < nextDeadline) {
+        sleepMs(nextDeadline - now);
+        const double woke = getTimeMs();
+        sleptMs = woke - now;
+        now = woke;
+    }
+#endif
+
+    // deadlines move by exactly one frame each time, so sleeping a bit too long doesn't add up over time
+    const double behind = now - nextDeadline;
+    nextDeadline += frameMs;
+    if (behind >= frameMs) {
+        const uint64_t missed = static_cast<uint64_t>(behind / frameMs);
+        if (dropPolicy == SKIP || missed > MAX_CATCH_UP_FRAMES) {
+            stats.droppedFrames += missed;
+            nextDeadline = now + frameMs;
+        }
+    }
+
+    if (lastFrameStart >= 0) {
+        const double frameTime = now - lastFrameStart;
+        if (stats.frames <= 1) {
+            stats.averageFrameMs = frameTime;
+            stats.averageSleepMs = sleptMs;
+        } else {
+            stats.averageFrameMs += (frameTime - stats.averageFrameMs) * AVERAGE_WEIGHT;
+            stats.averageSleepMs += (sleptMs - stats.averageSleepMs) * AVERAGE_WEIGHT;
+        }
+        stats.worstFrameMs = std::max(stats.worstFrameMs, frameTime);
+    }
+    lastFrameStart = now;
+    stats.frames++;
+}
+
+bool FrameScheduler::isFrameDue() const {
+    return nextDeadline < 0 || getTimeMs() >= nextDeadline;
+}
+
+double FrameScheduler::getFrameProgress() const {
+    if (nextDeadline < 0 || frameMs <= 0) return 1;
+    return std::clamp(1 - (nextDeadline - getTimeMs()) / frameMs, 0.0, 1.0);
+}
+
+void FrameScheduler::logStats(const char *name) const {
+    if (stats.frames == 0) return;
+    Log::log(std::string(name) + ": " + std::to_string(stats.frames) + " frames, " +
+             std::to_string(stats.droppedFrames) + " dropped, " +
+             std::to_string(stats.averageFrameMs) + " ms average, " +
+             std::to_string(stats.worstFrameMs) + " ms worst, " +
+             std::to_string(stats.averageSleepMs) + " ms asleep per frame");
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Keeps frames on a fixed rate by sleeping until each frame's deadline, instead of polling a timer.
+ * Deadlines are kept in fractions of a millisecond, so rates that don't divide 1000 evenly (like 60) stay exact.
+ */
+class FrameScheduler {
+  public:
+    /**
+     * What to do when a frame finishes after the next one should've already started.
+     */
+    enum DropPolicy {
+        SKIP,    // forget the missed frames and start timing again from now (what Scratch does)
+        CATCH_UP // run the missed frames back to back, up to `MAX_CATCH_UP_FRAMES`
+    };
+
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t droppedFrames = 0;
+        double averageFrameMs = 0; // time from one frame starting to the next
+        double averageSleepMs = 0; // time spent sleeping before each frame
+        double worstFrameMs = 0;
+    };
+
+    static constexpr int MAX_CATCH_UP_FRAMES = 4;
+
+    DropPolicy dropPolicy;
+
+    FrameScheduler(DropPolicy policy = SKIP);
+
+    /**
+     * Forgets the last deadline and the stats, so time spent before this (like loading) doesn't count as lag.
+     */
+    void reset();
+
+    /**
+     * Sleeps until the next frame should start.
+     * @param fps The rate to run at. Changing it restarts the timing.
+     */
+    void waitForFrame(double fps);
+
+    /**
+     * Checks if the next frame's deadline has already passed, without waiting.
+     * @return `true` if `waitForFrame()` would return right away.
+     */
+    bool isFrameDue() const;
+
+    /**
+     * Gets how far the current time is between the last frame's deadline and the next one.
+     * @return 0 right at the last deadline, up to 1 when the next frame is due.
+     */
+    double getFrameProgress() const;
+
+    const Stats &getStats() const { return stats; }
+
+    /**
+     * Prints the frame time stats to the log.
+     * @param name What the frames were for, to tell schedulers apart.
+     */
+    void logStats(const char *name) const;
+
+    /**
+     * Gets a steady clock with sub-millisecond precision.
+     * @return time in milliseconds, from an unspecified starting point.
+     */
+    static double getTimeMs();
+
+  private:
+    Stats stats;
+    double frameMs = 0;
+    double nextDeadline = -1;
+    double lastFrameStart = -1;
+};
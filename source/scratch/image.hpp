@@ -1,5 +1,6 @@
 #pragma once
 #include "miniz/miniz.h"
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -48,6 +49,28 @@ class Image {
      */
     static void loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId);
 
+    /**
+     * Loads many costumes from the current project at once. Where the platform has threads to spare,
+     * reading and decoding happens on worker threads, and only making textures happens on the calling thread.
+     * @param fileNames File names of the costumes in the project.
+     * @param onLoaded Called on the calling thread after each costume is done, with how many are done so far.
+     */
+    static void loadImagesFromProject(const std::vector<std::string> &fileNames, const std::function<void(size_t)> &onLoaded = nullptr);
+
+    /**
+     * Queues costumes from the current project to be loaded before they're needed, in order.
+     * Prefetched costumes don't expire until something asks for them, but get freed first when memory runs low.
+     * `SDL`: Decodes on a background thread.
+     * `3DS` and headless: Decodes on the main thread, for a few milliseconds each frame.
+     * @param fileNames File names of the costumes in the project, most important first.
+     */
+    static void prefetchImages(const std::vector<std::string> &fileNames);
+
+    /**
+     * Moves prefetching along while there's memory to spare. Gets called once per frame, even if nothing got drawn.
+     */
+    static void updatePrefetch();
+
     /**
      * `3DS`: Frees a `C2D_Image` from memory.
      * `SDL`: Frees an `SDL_Image` from memory.
@@ -64,7 +87,7 @@ class Image {
     static void queueFreeImage(const std::string &costumeId);
 
     /**
-     * Checks every Image in memory to see if they can be freed.
+     * Checks every Image in memory to see if they can be freed. Gets called once per frame, even if nothing got drawn.
      */
     static void FlushImages();
 };
\ No newline at end of file
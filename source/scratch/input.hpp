@@ -1,6 +1,8 @@
 #pragma once
 #include "interpret.hpp"
 #include "os.hpp"
+#include "penLayer.hpp"
+#include "renderState.hpp"
 #include <algorithm>
 #include <fstream>
 #include <map>
@@ -39,14 +41,15 @@ class Input {
                 file >> controlsJson;
 
                 // Access the "controls" object specifically
+                file.close();
                 if (controlsJson.contains("controls")) {
                     for (auto &[key, value] : controlsJson["controls"].items()) {
                         inputControls[value.get<std::string>()] = key;
                         Log::log("Loaded control: " + key + " -> " + value.get<std::string>());
                     }
+                    return;
                 }
-                file.close();
-                return;
+                // the file can also just have project settings, so fall back to the default controls
             } else {
                 Log::logWarning("Failed to open controls file: " + controlsFilePath);
             }
@@ -117,6 +120,8 @@ class Input {
             }
             draggingSprite->xPosition = mousePointer.x - (draggingSprite->spriteWidth / 2);
             draggingSprite->yPosition = mousePointer.y + (draggingSprite->spriteHeight / 2);
+            PenLayer::moveTo(draggingSprite);
+            RenderState::markChanged();
         }
     }
 
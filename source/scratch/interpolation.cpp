@@ -0,0 +1,81 @@
+#include "interpolation.hpp"
+#include "interpret.hpp"
+#include "renderState.hpp"
+#include "sprite.hpp"
+#include <cmath>
+#include <vector>
+
+struct SavedTransform {
+    Sprite *sprite;
+    double xPosition;
+    double yPosition;
+    double rotation;
+    double size;
+};
+
+static std::vector<SavedTransform> savedTransforms;
+static bool drewInterpolated = false;
+
+void Interpolation::beginTick() {
+    for (Sprite *sprite : sprites) {
+        sprite->interpolation.valid = true;
+        sprite->interpolation.xPosition = sprite->xPosition;
+        sprite->interpolation.yPosition = sprite->yPosition;
+        sprite->interpolation.rotation = sprite->rotation;
+        sprite->interpolation.size = sprite->size;
+        sprite->interpolation.costume = sprite->currentCostume;
+    }
+}
+
+void Interpolation::apply(double progress) {
+    bool moved = false;
+
+    for (Sprite *sprite : sprites) {
+        const InterpolationState &last = sprite->interpolation;
+        if (sprite->isStage || !sprite->visible || !last.valid) continue;
+
+        const SavedTransform saved = {sprite, sprite->xPosition, sprite->yPosition, sprite->rotation, sprite->size};
+        bool changed = false;
+
+        const double distance = std::hypot(sprite->xPosition - last.xPosition, sprite->yPosition - last.yPosition);
+        const double halfDiagonal = std::hypot(sprite->spriteWidth, sprite->spriteHeight) * sprite->size / 100;
+        if (distance > 0 && distance < halfDiagonal) {
+            sprite->xPosition = last.xPosition + (saved.xPosition - last.xPosition) * progress;
+            sprite->yPosition = last.yPosition + (saved.yPosition - last.yPosition) * progress;
+            changed = true;
+        }
+
+        // a new costume can have a completely different shape, so turning or resizing it would look wrong
+        if (sprite->currentCostume == last.costume) {
+            if (sprite->rotationStyle == Sprite::ALL_AROUND && sprite->rotation != last.rotation) {
+                // go the short way around, so turning from 170 to -170 doesn't spin the whole circle
+                const double turn = std::remainder(saved.rotation - last.rotation, 360.0);
+                sprite->rotation = last.rotation + turn * progress;
+                changed = true;
+            }
+            if (sprite->size != last.size) {
+                sprite->size = last.size + (saved.size - last.size) * progress;
+                changed = true;
+            }
+        }
+
+        if (changed) {
+            savedTransforms.push_back(saved);
+            moved = true;
+        }
+    }
+
+    // the frame after the last interpolated one has to be drawn too, so sprites end up exactly where they stopped
+    if (moved || drewInterpolated) RenderState::markChanged();
+    drewInterpolated = moved;
+}
+
+void Interpolation::restore() {
+    for (const SavedTransform &saved : savedTransforms) {
+        saved.sprite->xPosition = saved.xPosition;
+        saved.sprite->yPosition = saved.yPosition;
+        saved.sprite->rotation = saved.rotation;
+        saved.sprite->size = saved.size;
+    }
+    savedTransforms.clear();
+}
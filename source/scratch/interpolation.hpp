@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * Smooths out sprite movement when frames get drawn more often than the project ticks (like TurboWarp's interpolation).
+ * Sprites get drawn between where they were at the start of the last tick and where they are now.
+ */
+class Interpolation {
+  public:
+    /**
+     * Remembers where every sprite is, right before a tick runs.
+     */
+    static void beginTick();
+
+    /**
+     * Moves sprites to where they should be drawn. Has to be undone with `restore()` after drawing.
+     * Sprites that moved further than about their own size are treated as teleporting, and don't get interpolated.
+     * @param progress How far along the current tick is, from 0 to 1.
+     */
+    static void apply(double progress);
+
+    /**
+     * Puts every sprite moved by `apply()` back where the project has it.
+     */
+    static void restore();
+};
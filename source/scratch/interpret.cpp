@@ -1,17 +1,27 @@
 #include "interpret.hpp"
 #include "audio.hpp"
+#include "bench.hpp"
+#include "costumePrefetch.hpp"
+#include "frameScheduler.hpp"
 #include "image.hpp"
 #include "input.hpp"
+#include "interpolation.hpp"
+#include "layers.hpp"
 #include "math.hpp"
 #include "miniz/miniz.h"
 #include "nlohmann/json.hpp"
 #include "os.hpp"
+#include "penLayer.hpp"
+#include "profiler.hpp"
+#include "renderState.hpp"
 #include "render.hpp"
 #include "sprite.hpp"
+#include "texturePolicy.hpp"
 #include "unzip.hpp"
 #include <cmath>
 #include <cstddef>
 #include <cstring>
+#include <fstream>
 #include <math.h>
 #include <string>
 #include <unordered_map>
@@ -42,17 +52,21 @@ std::vector<Sprite *> sprites;
 std::vector<Sprite> spritePool;
 std::vector<std::string> broadcastQueue;
 std::unordered_map<std::string, Block *> blockLookup;
+std::unordered_map<std::string, Sprite *> spriteLookup;
 std::string answer;
 bool toExit = false;
 ProjectType projectType;
 
 BlockExecutor executor;
+static FrameScheduler frameScheduler;
+static FrameScheduler renderScheduler;
 
 int Scratch::projectWidth = 480;
 int Scratch::projectHeight = 360;
 int Scratch::FPS = 30;
 bool Scratch::fencing = true;
 bool Scratch::miscellaneousLimits = true;
+bool Scratch::interpolation = false;
 bool Scratch::shouldStop = false;
 
 #ifdef ENABLE_CLOUDVARS
@@ -121,31 +135,75 @@ bool Scratch::startScratchProject() {
     if (cloudProject && !projectJSON.empty()) initMist();
 #endif
 
+    for (Monitor &var : Render::visibleVariables) {
+        BlockExecutor::updateMonitored(var);
+    }
     BlockExecutor::runAllBlocksByOpcode("event_whenflagclicked");
     BlockExecutor::timer.start();
+    frameScheduler.reset();
+    renderScheduler.reset();
 
     while (Render::appShouldRun()) {
-        if (Render::checkFramerate()) {
+        // when interpolating, frames get drawn at the screen's rate, and ticks only run when they're due
+        const bool interpolate = interpolation && Render::getRefreshRate() > FPS;
+        // presenting already waits for vsync, unless nothing got presented since nothing changed
+        if (interpolate && (!Render::hasVsync() || !RenderState::didRedraw())) renderScheduler.waitForFrame(Render::getRefreshRate());
+        BENCH_PHASE(WAIT);
+
+        if (!interpolate || frameScheduler.isFrameDue()) {
+            frameScheduler.waitForFrame(FPS);
+            BENCH_PHASE(WAIT);
+            if (interpolate) Interpolation::beginTick();
             Input::getInput();
+            BENCH_PHASE(INPUT);
             BlockExecutor::runRepeatBlocks();
+            BENCH_PHASE(REPEAT_BLOCKS);
             BlockExecutor::runBroadcasts();
-            Render::renderSprites();
+            BENCH_PHASE(BROADCASTS);
+#ifdef ENABLE_PROFILER
+            Profiler::endFrame();
+#endif
+        }
 
-            if (shouldStop) {
+        if (interpolate) {
+            Interpolation::apply(frameScheduler.getFrameProgress());
+            Render::renderSprites();
+            Interpolation::restore();
+        } else {
+            Render::renderSprites();
+        }
+        BENCH_PHASE(RENDER);
+        // runs even when nothing got drawn, so finished SVG rasters get swapped in and memory still gets freed
+        Image::FlushImages();
+        Image::updatePrefetch();
+        SoundPlayer::updateSoundLoader();
+        BENCH_PHASE(LOADING);
+        BENCH_END_FRAME();
+
+        if (shouldStop) {
+            frameScheduler.logStats("Project frames");
+            renderScheduler.logStats("Interpolated frames");
+#ifdef ENABLE_PROFILER
+            Profiler::save(OS::getScratchFolderLocation() + "profile");
+#endif
 #ifdef __WIIU__ // wii u freezes for some reason.. TODO fix that but for now just exit app
+            toExit = true;
+            return false;
+#endif
+            if (projectType != UNEMBEDDED) {
                 toExit = true;
                 return false;
-#endif
-                if (projectType != UNEMBEDDED) {
-                    toExit = true;
-                    return false;
-                }
-                cleanupScratchProject();
-                shouldStop = false;
-                return true;
             }
+            cleanupScratchProject();
+            shouldStop = false;
+            return true;
         }
     }
+    frameScheduler.logStats("Project frames");
+    renderScheduler.logStats("Interpolated frames");
+#ifdef ENABLE_PROFILER
+    Profiler::save(OS::getScratchFolderLocation() + "profile");
+#endif
     return false;
 }
 
@@ -154,24 +212,13 @@ void Scratch::cleanupScratchProject() {
     Image::cleanupImages();
     SoundPlayer::cleanupAudio();
     blockLookup.clear();
+    spriteLookup.clear();
+    PenLayer::clear();
     Render::visibleVariables.clear();
+    RenderState::markChanged();
 
     // Clean up ZIP archive if it was initialized
-    if (projectType != UNZIPPED) {
-        mz_zip_reader_end(&Unzip::zipArchive);
-
-        // Clear the ZIP buffer and deallocate its memory
-        size_t bufferSize = Unzip::zipBuffer.size();
-        Unzip::zipBuffer.clear();
-        Unzip::zipBuffer.shrink_to_fit();
-
-        // Update memory tracker for the buffer
-        if (bufferSize > 0) {
-            MemoryTracker::deallocate(nullptr, bufferSize);
-        }
-
-        memset(&Unzip::zipArchive, 0, sizeof(Unzip::zipArchive));
-    }
+    if (projectType != UNZIPPED) Unzip::closeArchive();
 
 #ifdef ENABLE_CLOUDVARS
     projectJSON.clear();
@@ -184,6 +231,11 @@ void Scratch::cleanupScratchProject() {
     Scratch::projectHeight = 360;
     Scratch::fencing = true;
     Scratch::miscellaneousLimits = true;
+    Scratch::interpolation = false;
+    TexturePolicy::reset();
+#ifdef ENABLE_PROFILER
+    Profiler::reset();
+#endif
     Render::renderMode = Render::TOP_SCREEN_ONLY;
     Unzip::filePath = "";
     Log::log("Cleaned up Scratch project.");
@@ -224,6 +276,7 @@ void cleanupSprites() {
     }
     sprites.clear();
     spritePool.clear();
+    Layers::clear();
 }
 
 std::vector<std::pair<double, double>> getCollisionPoints(Sprite *currentSprite) {
@@ -353,10 +406,15 @@ bool isColliding(std::string collisionType, Sprite *currentSprite, Sprite *targe
     } else if (collisionType == "sprite") {
         // Use targetSprite if provided, otherwise search by name
         if (targetSprite == nullptr && !targetName.empty()) {
-            for (Sprite *sprite : sprites) {
-                if (sprite->name == targetName && sprite->visible) {
-                    targetSprite = sprite;
-                    break;
+            targetSprite = findSprite(targetName);
+
+            // the original is hidden, so fall back to one of its visible clones
+            if (targetSprite == nullptr || !targetSprite->visible) {
+                for (Sprite *sprite : sprites) {
+                    if (sprite->isClone && sprite->visible && sprite->name == targetName) {
+                        targetSprite = sprite;
+                        break;
+                    }
                 }
             }
         }
@@ -446,308 +504,51 @@ void Scratch::fenceSpriteWithinBounds(Sprite *sprite) {
     }
 }
 
-void loadSprites(const nlohmann::json &json) {
-    Log::log("beginning to load sprites...");
-    sprites.reserve(400);
-    for (const auto &target : json["targets"]) { // "target" is sprite in Scratch speak, so for every sprite in sprites
-
-        Sprite *newSprite = MemoryTracker::allocate<Sprite>();
-        // Sprite *newSprite = new Sprite();
-        new (newSprite) Sprite();
-        if (target.contains("name")) {
-            newSprite->name = target["name"].get<std::string>();
-        }
-        newSprite->id = Math::generateRandomString(15);
-        if (target.contains("isStage")) {
-            newSprite->isStage = target["isStage"].get<bool>();
-        }
-        if (target.contains("draggable")) {
-            newSprite->draggable = target["draggable"].get<bool>();
-        }
-        if (target.contains("visible")) {
-            newSprite->visible = target["visible"].get<bool>();
-        } else newSprite->visible = true;
-        if (target.contains("currentCostume")) {
-            newSprite->currentCostume = target["currentCostume"].get<int>();
-        }
-        if (target.contains("volume")) {
-            newSprite->volume = target["volume"].get<int>();
-        }
-        if (target.contains("x")) {
-            newSprite->xPosition = target["x"].get<int>();
-        }
-        if (target.contains("y")) {
-            newSprite->yPosition = target["y"].get<int>();
-        }
-        if (target.contains("size")) {
-            newSprite->size = target["size"].get<int>();
-        } else newSprite->size = 100;
-        if (target.contains("direction")) {
-            newSprite->rotation = target["direction"].get<int>();
-        } else newSprite->rotation = 90;
-        if (target.contains("layerOrder")) {
-            newSprite->layer = target["layerOrder"].get<int>();
-        } else newSprite->layer = 0;
-        if (target.contains("rotationStyle")) {
-            if (target["rotationStyle"].get<std::string>() == "all around")
-                newSprite->rotationStyle = newSprite->ALL_AROUND;
-            else if (target["rotationStyle"].get<std::string>() == "left-right")
-                newSprite->rotationStyle = newSprite->LEFT_RIGHT;
-            else
-                newSprite->rotationStyle = newSprite->NONE;
-        }
-        newSprite->toDelete = false;
-        newSprite->isClone = false;
-        // std::cout<<"name = "<< newSprite.name << std::endl;
+/**
+ * Applies settings changed in the project settings menu, which win over the project's own.
+ * @param settingsFilePath The same file the controls get saved in.
+ */
+static void loadProjectSettings(const std::string &settingsFilePath) {
+    std::ifstream file(settingsFilePath);
+    if (!file.is_open()) return;
 
-        // set variables
-        for (const auto &[id, data] : target["variables"].items()) {
+    nlohmann::json settingsJson = nlohmann::json::parse(file, nullptr, false);
+    if (settingsJson.is_discarded() || !settingsJson.contains("settings")) return;
 
-            Variable newVariable;
-            newVariable.id = id;
-            newVariable.name = data[0];
-            newVariable.value = Value::fromJson(data[1]);
-#ifdef ENABLE_CLOUDVARS
-            newVariable.cloud = data.size() == 3;
-            cloudProject = cloudProject || newVariable.cloud;
-#endif
-            newSprite->variables[newVariable.id] = newVariable; // add variable to sprite
-        }
-
-        // set Blocks
-        for (const auto &[id, data] : target["blocks"].items()) {
-
-            Block newBlock;
-            newBlock.id = id;
-            if (data.contains("opcode")) {
-                newBlock.opcode = data["opcode"].get<std::string>();
-
-                if (newBlock.opcode == "event_whenthisspriteclicked") newSprite->shouldDoSpriteClick = true;
-            }
-            if (data.contains("next") && !data["next"].is_null()) {
-                newBlock.next = data["next"].get<std::string>();
-            }
-            if (data.contains("parent") && !data["parent"].is_null()) {
-                newBlock.parent = data["parent"].get<std::string>();
-            } else newBlock.parent = "null";
-            if (data.contains("fields")) {
-                newBlock.fields = data["fields"];
-            }
-            if (data.contains("inputs")) {
-
-                for (const auto &[inputName, inputData] : data["inputs"].items()) {
-                    ParsedInput parsedInput;
-
-                    int type = inputData[0];
-                    auto &inputValue = inputData[1];
-
-                    if (type == 1) {
-                        parsedInput.inputType = ParsedInput::LITERAL;
-                        parsedInput.literalValue = Value::fromJson(inputValue);
-
-                    } else if (type == 3) {
-                        if (inputValue.is_array()) {
-                            parsedInput.inputType = ParsedInput::VARIABLE;
-                            parsedInput.variableId = inputValue[2].get<std::string>();
-                        } else {
-                            parsedInput.inputType = ParsedInput::BLOCK;
-                            if (!inputValue.is_null())
-                                parsedInput.blockId = inputValue.get<std::string>();
-                        }
-                    } else if (type == 2) {
-                        parsedInput.inputType = ParsedInput::BOOLEAN;
-                        parsedInput.blockId = inputValue.get<std::string>();
-                    }
-                    newBlock.parsedInputs[inputName] = parsedInput;
-                    // std::cout << "input: " << inputName << ". type = " << parsedInput.inputType << std::endl;
-                }
-            }
-            if (data.contains("topLevel")) {
-                newBlock.topLevel = data["topLevel"].get<bool>();
-            }
-            if (data.contains("shadow")) {
-                newBlock.shadow = data["shadow"].get<bool>();
-            }
-            if (data.contains("mutation")) {
-                newBlock.mutation = data["mutation"];
-            }
-            newSprite->blocks[newBlock.id] = newBlock; // add block
-
-            // add custom function blocks
-            if (newBlock.opcode == "procedures_prototype") {
-                if (!data.is_array()) {
-                    CustomBlock newCustomBlock;
-                    newCustomBlock.name = data["mutation"]["proccode"];
-                    newCustomBlock.blockId = newBlock.id;
-
-                    // custom blocks uses a different json structure for some reason?? have to parse them.
-                    std::string rawArgumentNames = data["mutation"]["argumentnames"];
-                    nlohmann::json parsedAN = nlohmann::json::parse(rawArgumentNames);
-                    newCustomBlock.argumentNames = parsedAN.get<std::vector<std::string>>();
-
-                    std::string rawArgumentDefaults = data["mutation"]["argumentdefaults"];
-                    nlohmann::json parsedAD = nlohmann::json::parse(rawArgumentDefaults);
-                    // newCustomBlock.argumentDefaults = parsedAD.get<std::vector<std::string>>();
-
-                    for (const auto &item : parsedAD) {
-                        if (item.is_string()) {
-                            newCustomBlock.argumentDefaults.push_back(item.get<std::string>());
-                        } else if (item.is_number_integer()) {
-                            newCustomBlock.argumentDefaults.push_back(std::to_string(item.get<int>()));
-                        } else if (item.is_number_float()) {
-                            newCustomBlock.argumentDefaults.push_back(std::to_string(item.get<double>()));
-                        } else {
-                            newCustomBlock.argumentDefaults.push_back(item.dump());
-                        }
-                    }
-
-                    std::string rawArgumentIds = data["mutation"]["argumentids"];
-                    nlohmann::json parsedAID = nlohmann::json::parse(rawArgumentIds);
-                    newCustomBlock.argumentIds = parsedAID.get<std::vector<std::string>>();
-
-                    if (data["mutation"]["warp"] == "true") {
-                        newCustomBlock.runWithoutScreenRefresh = true;
-                    } else newCustomBlock.runWithoutScreenRefresh = false;
-
-                    newSprite->customBlocks[newCustomBlock.name] = newCustomBlock; // add custom block
-                } else {
-                    Log::logError("Unknown Custom block data: " + data.dump()); // TODO handle these
-                }
-            }
-        }
-
-        // set Lists
-        for (const auto &[id, data] : target["lists"].items()) {
-            List newList;
-            newList.id = id;
-            newList.name = data[0];
-            for (const auto &listItem : data[1]) {
-                newList.items.push_back(Value::fromJson(listItem));
-            }
-            newSprite->lists[newList.id] = newList; // add list
-        }
-
-        // set Sounds
-        for (const auto &[id, data] : target["sounds"].items()) {
-            Sound newSound;
-            newSound.id = data["assetId"];
-            newSound.name = data["name"];
-            newSound.fullName = data["md5ext"];
-            newSound.dataFormat = data["dataFormat"];
-            newSound.sampleRate = data["rate"];
-            newSound.sampleCount = data["sampleCount"];
-            newSprite->sounds[newSound.name] = newSound;
-        }
-
-        // set Costumes
-        for (const auto &[id, data] : target["costumes"].items()) {
-            Costume newCostume;
-            newCostume.id = data["assetId"];
-            if (data.contains("name")) {
-                newCostume.name = data["name"];
-            }
-            if (data.contains("bitmapResolution")) {
-                newCostume.bitmapResolution = data["bitmapResolution"];
-            }
-            if (data.contains("dataFormat")) {
-                newCostume.dataFormat = data["dataFormat"];
-            }
-            if (data.contains("md5ext")) {
-                newCostume.fullName = data["md5ext"];
-            }
-            if (data.contains("rotationCenterX")) {
-                newCostume.rotationCenterX = data["rotationCenterX"];
-            }
-            if (data.contains("rotationCenterY")) {
-                newCostume.rotationCenterY = data["rotationCenterY"];
-            }
-            newSprite->costumes.push_back(newCostume);
-        }
-
-        // set comments
-        for (const auto &[id, data] : target["comments"].items()) {
-            Comment newComment;
-            newComment.id = id;
-            if (data.contains("blockId") && !data["blockId"].is_null()) {
-                newComment.blockId = data["blockId"];
-            }
-            newComment.width = data["width"];
-            newComment.height = data["height"];
-            newComment.minimized = data["minimized"];
-            newComment.x = data["x"];
-            newComment.y = data["y"];
-            newComment.text = data["text"];
-            newSprite->comments[newComment.id] = newComment;
-        }
-
-        // set Broadcasts
-        for (const auto &[id, data] : target["broadcasts"].items()) {
-            Broadcast newBroadcast;
-            newBroadcast.id = id;
-            newBroadcast.name = data;
-            newSprite->broadcasts[newBroadcast.id] = newBroadcast;
-            // std::cout<<"broadcast name = "<< newBroadcast.name << std::endl;
-        }
-
-        sprites.push_back(newSprite);
+    const nlohmann::json &settings = settingsJson["settings"];
+    if (settings.contains("interpolation") && settings["interpolation"].is_boolean()) {
+        Scratch::interpolation = settings["interpolation"].get<bool>();
+        Log::log(std::string("Interpolation is ") + (Scratch::interpolation ? "true" : "false") + " from project settings");
     }
-
-    for (const auto &monitor : json["monitors"]) { // "monitor" is any variable shown on screen
-        Monitor newMonitor;
-
-        if (monitor.contains("id") && !monitor["id"].is_null())
-            newMonitor.id = monitor.at("id").get<std::string>();
-
-        if (monitor.contains("mode") && !monitor["mode"].is_null())
-            newMonitor.mode = monitor.at("mode").get<std::string>();
-
-        if (monitor.contains("opcode") && !monitor["opcode"].is_null())
-            newMonitor.opcode = monitor.at("opcode").get<std::string>();
-
-        if (monitor.contains("params") && monitor["params"].is_object()) {
-            for (const auto &param : monitor["params"].items()) {
-                std::string key = param.key();
-                std::string value = param.value().dump();
-                newMonitor.parameters[key] = value;
-            }
-        }
-
-        if (monitor.contains("spriteName") && !monitor["spriteName"].is_null())
-            newMonitor.spriteName = monitor.at("spriteName").get<std::string>();
-        else
-            newMonitor.spriteName = "";
-
-        if (monitor.contains("value") && !monitor["value"].is_null())
-            newMonitor.value = Value(Math::removeQuotations(monitor.at("value").dump()));
-
-        if (monitor.contains("x") && !monitor["x"].is_null())
-            newMonitor.x = monitor.at("x").get<int>();
-
-        if (monitor.contains("y") && !monitor["y"].is_null())
-            newMonitor.y = monitor.at("y").get<int>();
-
-        if (monitor.contains("visible") && !monitor["visible"].is_null())
-            newMonitor.visible = monitor.at("visible").get<bool>();
-
-        if (monitor.contains("isDiscrete") && !monitor["isDiscrete"].is_null())
-            newMonitor.isDiscrete = monitor.at("isDiscrete").get<bool>();
-
-        if (monitor.contains("sliderMin") && !monitor["sliderMin"].is_null())
-            newMonitor.sliderMin = monitor.at("sliderMin").get<double>();
-
-        if (monitor.contains("sliderMax") && !monitor["sliderMax"].is_null())
-            newMonitor.sliderMax = monitor.at("sliderMax").get<double>();
-
-        Render::visibleVariables.push_back(newMonitor);
+    if (settings.contains("compactTextures") && settings["compactTextures"].is_boolean()) {
+        TexturePolicy::enabled = settings["compactTextures"].get<bool>();
+        Log::log(std::string("Compact textures are ") + (TexturePolicy::enabled ? "on" : "off") + " from project settings");
     }
+}
 
+void setupSprites() {
     // load block lookup table
     blockLookup.clear();
     for (Sprite *sprite : sprites) {
         for (auto &[id, block] : sprite->blocks) {
             blockLookup[id] = &block;
+            block.visual = RenderState::isVisualOpcode(block.opcode);
         }
     }
+
+    // load sprite lookup table
+    spriteLookup.clear();
+    for (Sprite *sprite : sprites) {
+        if (sprite->isStage) spriteLookup["_stage_"] = sprite;
+        else spriteLookup[sprite->name] = sprite;
+    }
+
+    // point variable and list fields at what they pick, now the Stage can be found
+    for (Sprite *sprite : sprites) {
+        BlockExecutor::resolveDataFields(sprite);
+    }
+
+    Layers::loadFromSprites();
     // setup top level blocks
     for (Sprite *currentSprite : sprites) {
         for (auto &[id, block] : currentSprite->blocks) {
@@ -856,6 +657,12 @@ void loadSprites(const nlohmann::json &json) {
 
         Log::logWarning("no misc limits property.");
     }
+    try {
+        Scratch::interpolation = config["interpolation"].get<bool>();
+        Log::log(std::string("Interpolation is ") + (Scratch::interpolation ? "true" : "false"));
+    } catch (...) {
+        Log::logWarning("no interpolation property.");
+    }
     try {
         infClones = !config["runtimeOptions"]["maxClones"].is_null();
     } catch (...) {
@@ -869,22 +676,27 @@ void loadSprites(const nlohmann::json &json) {
     else
         Render::renderMode = Render::TOP_SCREEN_ONLY;
 
+    // before any images load, since it decides how they get stored
+    loadProjectSettings(OS::getScratchFolderLocation() + Unzip::filePath + ".json");
+
     // load initial sprite images
     Unzip::loadingState = "Loading images";
-    int sprIndex = 1;
-    if (projectType == UNZIPPED) {
-        for (auto &currentSprite : sprites) {
-            if (!currentSprite->visible || currentSprite->ghostEffect == 100) continue;
-            Unzip::loadingState = "Loading image " + std::to_string(sprIndex) + " / " + std::to_string(sprites.size());
-            Image::loadImageFromFile(currentSprite->costumes[currentSprite->currentCostume].fullName);
-            sprIndex++;
-        }
-    } else {
-        for (auto &currentSprite : sprites) {
-            if (!currentSprite->visible || currentSprite->ghostEffect == 100) continue;
-            Unzip::loadingState = "Loading image " + std::to_string(sprIndex) + " / " + std::to_string(sprites.size());
-            Image::loadImageFromSB3(&Unzip::zipArchive, currentSprite->costumes[currentSprite->currentCostume].fullName);
-            sprIndex++;
+    std::vector<std::string> initialCostumes;
+    for (auto &currentSprite : sprites) {
+        if (!currentSprite->visible || currentSprite->ghostEffect == 100) continue;
+        initialCostumes.push_back(currentSprite->costumes[currentSprite->currentCostume].fullName);
+    }
+    Image::loadImagesFromProject(initialCostumes, [&initialCostumes](size_t loadedCount) {
+        Unzip::loadingState = "Loading image " + std::to_string(loadedCount) + " / " + std::to_string(initialCostumes.size());
+    });
+    // the rest load while the project runs
+    CostumePrefetch::start();
+
+    // sounds that will likely play soon, loaded in the background while there's memory to spare
+    for (auto &currentSprite : sprites) {
+        if (!currentSprite->isStage && !currentSprite->visible) continue;
+        for (auto &[id, sound] : currentSprite->sounds) {
+            SoundPlayer::preloadSound(currentSprite, &Unzip::zipArchive, sound.fullName);
         }
     }
 
@@ -928,6 +740,29 @@ void loadSprites(const nlohmann::json &json) {
         }
     }
 
+    // resolve object menus that can't change at runtime
+    static const std::vector<std::pair<std::string, std::string>> objectMenus = {
+        {"motion_goto", "TO"},
+        {"motion_glideto", "TO"},
+        {"motion_pointtowards", "TOWARDS"},
+        {"sensing_distanceto", "DISTANCETOMENU"},
+        {"sensing_of", "OBJECT"},
+        {"sensing_touchingobject", "TOUCHINGOBJECTMENU"},
+        {"control_create_clone_of", "CLONE_OPTION"}};
+    for (Sprite *currentSprite : sprites) {
+        for (auto &[id, block] : currentSprite->blocks) {
+            for (const auto &[opcode, inputName] : objectMenus) {
+                if (block.opcode != opcode) continue;
+                auto inputFind = block.parsedInputs.find(inputName);
+                if (inputFind != block.parsedInputs.end() && inputFind->second.inputType == ParsedInput::LITERAL) {
+                    Sprite *objectSprite;
+                    resolveObjectMenu(block, inputName, currentSprite, &objectSprite);
+                }
+                break;
+            }
+        }
+    }
+
     Unzip::loadingState = "Running Flag block";
 
     Input::applyControls(OS::getScratchFolderLocation() + Unzip::filePath + ".json");
@@ -944,6 +779,53 @@ Block *findBlock(std::string blockId) {
     return nullptr;
 }
 
+Sprite *findSprite(const std::string &name) {
+    auto sprite = spriteLookup.find(name);
+    if (sprite != spriteLookup.end()) {
+        return sprite->second;
+    }
+
+    return nullptr;
+}
+
+const std::string &resolveObjectMenu(Block &block, const std::string &inputName, Sprite *sprite, Sprite **outSprite) {
+    if (block.objectMenuResolved) {
+        *outSprite = block.objectMenuSprite;
+        return block.objectMenuName;
+    }
+
+    auto inputFind = block.parsedInputs.find(inputName);
+    if (inputFind == block.parsedInputs.end()) {
+        *outSprite = nullptr;
+        block.objectMenuName.clear();
+        return block.objectMenuName;
+    }
+
+    std::string objectName;
+    bool isLiteral = inputFind->second.inputType == ParsedInput::LITERAL;
+    if (isLiteral) {
+        Block *menuBlock = findBlock(inputFind->second.literalValue.asString());
+        if (menuBlock != nullptr) {
+            const ParsedField *menuField = menuBlock->findField(inputName.c_str());
+            if (menuField != nullptr)
+                objectName = menuField->value;
+        }
+    } else {
+        // a reporter is dropped in the menu, only look it up again if it reports something new
+        objectName = Scratch::getInputValue(block, inputName, sprite).asString();
+        if (block.objectMenuSprite != nullptr && objectName == block.objectMenuName) {
+            *outSprite = block.objectMenuSprite;
+            return block.objectMenuName;
+        }
+    }
+
+    block.objectMenuName = objectName;
+    block.objectMenuSprite = findSprite(objectName);
+    block.objectMenuResolved = isLiteral;
+    *outSprite = block.objectMenuSprite;
+    return block.objectMenuName;
+}
+
 std::vector<Block *> getBlockChain(std::string blockId, std::string *outID) {
     std::vector<Block *> blockChain;
     Block *currentBlock = findBlock(blockId);
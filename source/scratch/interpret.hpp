@@ -29,6 +29,7 @@ extern std::vector<Sprite *> sprites;
 extern std::vector<Sprite> spritePool;
 extern std::vector<std::string> broadcastQueue;
 extern std::unordered_map<std::string, Block *> blockLookup;
+extern std::unordered_map<std::string, Sprite *> spriteLookup;
 extern bool toExit;
 extern std::string answer;
 
@@ -46,6 +47,7 @@ class Scratch {
     static int FPS;
     static bool fencing;
     static bool miscellaneousLimits;
+    static bool interpolation;
     static bool shouldStop;
 };
 
@@ -63,10 +65,10 @@ bool isSeparated(const std::vector<std::pair<double, double>> &poly1,
                  double axisX, double axisY);
 
 /**
- * Loads every Sprite from the Scratch's project.json file.
- * @param json The file to load
+ * Gets loaded sprites ready to run: lookup tables, layers, project settings, first costumes and block chains.
+ * Runs after sprites get loaded by `ProjectLoader` or from the project cache.
  */
-void loadSprites(const nlohmann::json &json);
+void setupSprites();
 
 /**
  * Frees every Sprite from memory.
@@ -99,6 +101,24 @@ Sprite *getAvailableSprite();
  */
 Block *findBlock(std::string blockId);
 
+/**
+ * Finds an original (non-clone) sprite from the `spriteLookup`.
+ * @param name Name of the sprite, or `_stage_` for the Stage.
+ * @return A `Sprite*` if it's found, `nullptr` otherwise.
+ */
+Sprite *findSprite(const std::string &name);
+
+/**
+ * Resolves the object menu of a block (e.g. the `TO` menu of 'go to'), and caches the result on the block.
+ * Menus holding a literal are only looked up once, menus holding a reporter are looked up again when their value changes.
+ * @param block The block that owns the menu input
+ * @param inputName Name of the menu input, which is also the name of the menu's field
+ * @param sprite The sprite running the block
+ * @param outSprite Set to the original `Sprite*` the menu points to, or `nullptr` for options like `_mouse_`.
+ * @return The name of the selected object.
+ */
+const std::string &resolveObjectMenu(Block &block, const std::string &inputName, Sprite *sprite, Sprite **outSprite);
+
 /**
  * Gets a Chain of Blocks with a specified `blockId`.
  * @param blockId ID of the block you want the chain for.
@@ -0,0 +1,98 @@
+#include "layers.hpp"
+#include "interpret.hpp"
+#include <algorithm>
+#include <vector>
+
+Sprite *Layers::bottom = nullptr;
+Sprite *Layers::top = nullptr;
+
+void Layers::loadFromSprites() {
+    clear();
+
+    std::vector<Sprite *> spritesByLayer;
+    for (Sprite *sprite : sprites) {
+        if (!sprite->isStage) spritesByLayer.push_back(sprite);
+    }
+    std::stable_sort(spritesByLayer.begin(), spritesByLayer.end(),
+                     [](const Sprite *a, const Sprite *b) {
+                         return a->layer < b->layer;
+                     });
+
+    for (Sprite *sprite : spritesByLayer) {
+        addToFront(sprite);
+    }
+}
+
+void Layers::clear() {
+    bottom = nullptr;
+    top = nullptr;
+}
+
+void Layers::addToFront(Sprite *sprite) {
+    sprite->layerBelow = top;
+    sprite->layerAbove = nullptr;
+    if (top) top->layerAbove = sprite;
+    else bottom = sprite;
+    top = sprite;
+}
+
+void Layers::addBehind(Sprite *sprite, Sprite *other) {
+    sprite->layerAbove = other;
+    sprite->layerBelow = other->layerBelow;
+    if (other->layerBelow) other->layerBelow->layerAbove = sprite;
+    else bottom = sprite;
+    other->layerBelow = sprite;
+}
+
+void Layers::remove(Sprite *sprite) {
+    if (sprite->layerBelow) sprite->layerBelow->layerAbove = sprite->layerAbove;
+    else if (bottom == sprite) bottom = sprite->layerAbove;
+    if (sprite->layerAbove) sprite->layerAbove->layerBelow = sprite->layerBelow;
+    else if (top == sprite) top = sprite->layerBelow;
+    sprite->layerBelow = nullptr;
+    sprite->layerAbove = nullptr;
+}
+
+void Layers::goToFront(Sprite *sprite) {
+    if (sprite->isStage || top == sprite) return;
+    remove(sprite);
+    addToFront(sprite);
+}
+
+void Layers::goToBack(Sprite *sprite) {
+    if (sprite->isStage || bottom == sprite) return;
+    remove(sprite);
+    sprite->layerAbove = bottom;
+    if (bottom) bottom->layerBelow = sprite;
+    else top = sprite;
+    bottom = sprite;
+}
+
+void Layers::moveBy(Sprite *sprite, int amount) {
+    if (sprite->isStage || amount == 0) return;
+
+    if (amount > 0) {
+        Sprite *target = sprite;
+        while (amount > 0 && target->layerAbove) {
+            target = target->layerAbove;
+            amount--;
+        }
+        if (target == sprite) return;
+        if (target == top) {
+            goToFront(sprite);
+            return;
+        }
+        Sprite *above = target->layerAbove;
+        remove(sprite);
+        addBehind(sprite, above);
+    } else {
+        Sprite *target = sprite;
+        while (amount < 0 && target->layerBelow) {
+            target = target->layerBelow;
+            amount++;
+        }
+        if (target == sprite) return;
+        remove(sprite);
+        addBehind(sprite, target);
+    }
+}
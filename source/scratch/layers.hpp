@@ -0,0 +1,64 @@
+#pragma once
+#include "sprite.hpp"
+
+/**
+ * The draw order of every sprite except the Stage, kept as a linked list
+ * through `Sprite::layerBelow` and `Sprite::layerAbove` so it never has to be sorted.
+ */
+class Layers {
+  public:
+    /**
+     * Builds the draw order from the `layer` every sprite was loaded with.
+     */
+    static void loadFromSprites();
+
+    /**
+     * Empties the draw order.
+     */
+    static void clear();
+
+    /**
+     * Adds a sprite that isn't in the draw order on top of every other sprite.
+     * @param sprite
+     */
+    static void addToFront(Sprite *sprite);
+
+    /**
+     * Adds a sprite that isn't in the draw order directly behind another sprite, like Scratch does with clones.
+     * @param sprite
+     * @param other A sprite that is already in the draw order.
+     */
+    static void addBehind(Sprite *sprite, Sprite *other);
+
+    /**
+     * Takes a sprite out of the draw order.
+     * @param sprite
+     */
+    static void remove(Sprite *sprite);
+
+    static void goToFront(Sprite *sprite);
+    static void goToBack(Sprite *sprite);
+
+    /**
+     * Moves a sprite forward or backward in the draw order.
+     * @param sprite
+     * @param amount Amount of layers to move by, negative to move backward.
+     */
+    static void moveBy(Sprite *sprite, int amount);
+
+    /**
+     * Gets the sprite that is drawn first. Follow `Sprite::layerAbove` to get the rest.
+     * @return The bottom `Sprite*`, or `nullptr` if there are no sprites.
+     */
+    static Sprite *getBottom() { return bottom; }
+
+    /**
+     * Gets the sprite that is drawn last.
+     * @return The top `Sprite*`, or `nullptr` if there are no sprites.
+     */
+    static Sprite *getTop() { return top; }
+
+  private:
+    static Sprite *bottom;
+    static Sprite *top;
+};
@@ -0,0 +1,55 @@
+#include "lruCache.hpp"
+#include "os.hpp"
+
+uint32_t LruCache::frame = 0;
+uint32_t LruCache::drawnFrame = 0;
+
+LruCache::LruCache(uint32_t maxUnusedFrames) : maxUnusedFrames(maxUnusedFrames) {
+}
+
+LruCache::Handle LruCache::add(const std::string &id, size_t memorySize) {
+    this->memorySize += memorySize;
+    entries.push_front({id, memorySize, frame});
+    return entries.begin();
+}
+
+void LruCache::touch(Handle entry) {
+    entry->lastUsed = frame;
+    if (entry != entries.begin()) entries.splice(entries.begin(), entries, entry);
+}
+
+void LruCache::remove(Handle entry) {
+    memorySize -= entry->memorySize;
+    entries.erase(entry);
+}
+
+void LruCache::clear() {
+    entries.clear();
+    memorySize = 0;
+}
+
+bool LruCache::hasExpired() const {
+    return !entries.empty() && frame - entries.back().lastUsed > maxUnusedFrames;
+}
+
+bool LruCache::isOldestInUse() const {
+    return !entries.empty() && entries.back().lastUsed == frame;
+}
+
+void LruCache::keepDrawn() {
+    if (drawnFrame == frame) return;
+    // entries are in the order they were used, so the ones from the last drawn frame are all at the front
+    for (Entry &entry : entries) {
+        if (entry.lastUsed < drawnFrame) break;
+        entry.lastUsed = frame;
+    }
+}
+
+void LruCache::nextFrame() {
+    frame++;
+}
+
+bool LruCache::isOverBudget(double fraction) {
+    return MemoryTracker::getVRAMUsage() > MemoryTracker::getMaxVRAMUsage() * fraction ||
+           MemoryTracker::getCurrentUsage() > MemoryTracker::getMaxRamUsage() * fraction;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+
+/**
+ * Keeps loaded assets (images, sounds) in the order they were last used, along with how much memory they take,
+ * so the least recently used one can be found without looking through all of them.
+ * The assets themselves stay in their own maps, each keeping the `Handle` it got from `add()`,
+ * which makes marking one as used, or removing it, take constant time.
+ */
+class LruCache {
+  public:
+    struct Entry {
+        std::string id; // key of the asset in its map
+        size_t memorySize;
+        uint32_t lastUsed; // the `getFrame()` the asset was last used on
+    };
+    using Handle = std::list<Entry>::iterator;
+
+    /**
+     * @param maxUnusedFrames How many frames an asset can go unused before it expires.
+     */
+    LruCache(uint32_t maxUnusedFrames);
+
+    /**
+     * Starts tracking an asset, as the most recently used one.
+     * @param id
+     * @param memorySize
+     * @return The handle to pass to `touch()` and `remove()`.
+     */
+    Handle add(const std::string &id, size_t memorySize);
+
+    /**
+     * Marks an asset as used this frame.
+     * @param entry
+     */
+    void touch(Handle entry);
+
+    /**
+     * Stops tracking an asset, once it's freed.
+     * @param entry
+     */
+    void remove(Handle entry);
+
+    /**
+     * Stops tracking every asset.
+     */
+    void clear();
+
+    bool empty() const { return entries.empty(); }
+
+    size_t getEntryCount() const { return entries.size(); }
+
+    /**
+     * Gets the asset that went unused the longest. The cache can't be empty.
+     * @return The entry of the asset. Copy its `id` before freeing the asset.
+     */
+    const Entry &getOldest() const { return entries.back(); }
+
+    /**
+     * Checks if the asset that went unused the longest has gone unused for more than `maxUnusedFrames`.
+     * @return `true` if it should be freed.
+     */
+    bool hasExpired() const;
+
+    /**
+     * Checks if the asset that went unused the longest was still used this frame, meaning every asset was.
+     * @return `true` if nothing can be freed without it having to be loaded again right away.
+     */
+    bool isOldestInUse() const;
+
+    /**
+     * Marks the images used on the last drawn frame as used this frame too, if nothing got drawn since.
+     * Skipped frames leave those images on screen, so they shouldn't expire while it stays the same.
+     */
+    void keepDrawn();
+
+    /**
+     * Gets the total memory taken by the tracked assets.
+     * @return size in bytes.
+     */
+    size_t getMemorySize() const { return memorySize; }
+
+    /**
+     * Moves on to the next frame. Call once per frame, after everything got drawn.
+     */
+    static void nextFrame();
+
+    static uint32_t getFrame() { return frame; }
+
+    /**
+     * Marks the current frame as one that got drawn, rather than skipped because nothing changed.
+     */
+    static void markDrawn() { drawnFrame = frame; }
+
+    /**
+     * Checks if either the RAM or the VRAM usage is above a fraction of its budget from `MemoryTracker`.
+     * @param fraction
+     * @return `true` if assets should be freed early.
+     */
+    static bool isOverBudget(double fraction);
+
+  private:
+    std::list<Entry> entries; // most recently used first
+    size_t memorySize = 0;
+    uint32_t maxUnusedFrames;
+
+    static uint32_t frame;
+    static uint32_t drawnFrame;
+};
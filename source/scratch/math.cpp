@@ -18,7 +18,7 @@ int Math::color(int r, int g, int b, int a) {
 
 #ifdef __3DS__
     return C2D_Color32(r, g, b, a);
-#elif defined(SDL_BUILD)
+#elif defined(SDL_BUILD) || defined(HEADLESS_BUILD)
     return (r << 24) |
            (g << 16) |
            (b << 8) |
@@ -27,7 +27,9 @@ int Math::color(int r, int g, int b, int a) {
 }
 
 bool Math::isNumber(const std::string &str) {
-    return std::regex_match(str, std::regex("^((0[xbo]\\d+)|(-?\\d+(\\.\\d+)?(e(-|\\+)?\\d+(\\.\\d+)?)?))$")); // I hope I never need to touch this again.
+    // built once, making it again for every value loaded from project.json was most of the load time
+    static const std::regex numberRegex("^((0[xbo]\\d+)|(-?\\d+(\\.\\d+)?(e(-|\\+)?\\d+(\\.\\d+)?)?))$"); // I hope I never need to touch this again.
+    return std::regex_match(str, numberRegex);
 }
 
 double Math::degreesToRadians(double degrees) {
@@ -373,6 +373,7 @@ void ProjectMenu::cleanup() {
 
 ProjectSettings::ProjectSettings(std::string projPath) {
     projectPath = projPath;
+    loadSettings();
     init();
 }
 ProjectSettings::~ProjectSettings() {
@@ -385,6 +386,11 @@ void ProjectSettings::init() {
     changeControlsButton->text->setColor(Math::color(0, 0, 0, 255));
     bottomScreenButton = new ButtonObject("Bottom Screen", "gfx/menu/projectBox.png", 200, 150);
     bottomScreenButton->text->setColor(Math::color(0, 0, 0, 255));
+    const char *interpolationNames[] = {"Interpolation: Default", "Interpolation: On", "Interpolation: Off"};
+    interpolationButton = new ButtonObject(interpolationNames[interpolation], "gfx/menu/projectBox.png", 200, 150);
+    interpolationButton->text->setColor(Math::color(0, 0, 0, 255));
+    compactTexturesButton = new ButtonObject(compactTextures ? "Compact Textures: On" : "Compact Textures: Off", "gfx/menu/projectBox.png", 200, 200);
+    compactTexturesButton->text->setColor(Math::color(0, 0, 0, 255));
     settingsControl = new ControlObject();
     backButton = new ButtonObject("", "gfx/menu/buttonBack.png", 375, 20);
     backButton->scale = 1.0;
@@ -395,14 +401,17 @@ void ProjectSettings::init() {
     changeControlsButton->isSelected = true;
 
     // link buttons
-    changeControlsButton->buttonDown = bottomScreenButton;
-    changeControlsButton->buttonUp = bottomScreenButton;
-    bottomScreenButton->buttonUp = changeControlsButton;
-    bottomScreenButton->buttonDown = changeControlsButton;
+    changeControlsButton->buttonDown = interpolationButton;
+    changeControlsButton->buttonUp = compactTexturesButton;
+    interpolationButton->buttonUp = changeControlsButton;
+    interpolationButton->buttonDown = compactTexturesButton;
+    compactTexturesButton->buttonUp = interpolationButton;
+    compactTexturesButton->buttonDown = changeControlsButton;
 
     // add buttons to control
     settingsControl->buttonObjects.push_back(changeControlsButton);
-    settingsControl->buttonObjects.push_back(bottomScreenButton);
+    settingsControl->buttonObjects.push_back(interpolationButton);
+    settingsControl->buttonObjects.push_back(compactTexturesButton);
 }
 void ProjectSettings::render() {
     Input::getInput();
@@ -417,6 +426,24 @@ void ProjectSettings::render() {
         controlsMenu.cleanup();
         init();
     }
+    if (interpolationButton->isPressed({"a"})) {
+        interpolation = static_cast<InterpolationSetting>((interpolation + 1) % 3);
+        saveSettings();
+        cleanup();
+        init();
+        settingsControl->selectedObject = interpolationButton;
+        changeControlsButton->isSelected = false;
+        interpolationButton->isSelected = true;
+    }
+    if (compactTexturesButton->isPressed({"a"})) {
+        compactTextures = !compactTextures;
+        saveSettings();
+        cleanup();
+        init();
+        settingsControl->selectedObject = compactTexturesButton;
+        changeControlsButton->isSelected = false;
+        compactTexturesButton->isSelected = true;
+    }
     // if (bottomScreenButton->isPressed()) {
     // }
     if (backButton->isPressed({"b", "y"})) {
@@ -427,6 +454,8 @@ void ProjectSettings::render() {
     Render::beginFrame(1, 147, 138, 168);
 
     changeControlsButton->render();
+    interpolationButton->render();
+    compactTexturesButton->render();
     // bottomScreenButton->render();
     settingsControl->render();
     backButton->render();
@@ -442,6 +471,14 @@ void ProjectSettings::cleanup() {
         delete bottomScreenButton;
         bottomScreenButton = nullptr;
     }
+    if (interpolationButton != nullptr) {
+        delete interpolationButton;
+        interpolationButton = nullptr;
+    }
+    if (compactTexturesButton != nullptr) {
+        delete compactTexturesButton;
+        compactTexturesButton = nullptr;
+    }
     if (settingsControl != nullptr) {
         delete settingsControl;
         settingsControl = nullptr;
@@ -456,6 +493,54 @@ void ProjectSettings::cleanup() {
     Render::endFrame();
 }
 
+void ProjectSettings::loadSettings() {
+    std::ifstream file(OS::getScratchFolderLocation() + projectPath + ".sb3" + ".json");
+    if (!file.is_open()) return;
+
+    nlohmann::json json = nlohmann::json::parse(file, nullptr, false);
+    if (json.is_discarded() || !json.contains("settings")) return;
+    if (json["settings"].contains("interpolation") && json["settings"]["interpolation"].is_boolean())
+        interpolation = json["settings"]["interpolation"].get<bool>() ? INTERPOLATION_ON : INTERPOLATION_OFF;
+    if (json["settings"].contains("compactTextures") && json["settings"]["compactTextures"].is_boolean())
+        compactTextures = json["settings"]["compactTextures"].get<bool>();
+}
+
+void ProjectSettings::saveSettings() {
+    std::string filePath = OS::getScratchFolderLocation() + projectPath + ".sb3" + ".json";
+    try {
+        std::filesystem::create_directories(std::filesystem::path(filePath).parent_path());
+    } catch (const std::filesystem::filesystem_error &e) {
+        Log::logError("Failed to create directories: " + std::string(e.what()));
+        return;
+    }
+
+    // keep the controls that are saved in the same file
+    nlohmann::json json = nlohmann::json::object();
+    std::ifstream existingFile(filePath);
+    if (existingFile.is_open()) {
+        json = nlohmann::json::parse(existingFile, nullptr, false);
+        if (json.is_discarded() || !json.is_object()) json = nlohmann::json::object();
+        existingFile.close();
+    }
+
+    if (interpolation == INTERPOLATION_DEFAULT) {
+        if (json.contains("settings")) json["settings"].erase("interpolation");
+    } else {
+        json["settings"]["interpolation"] = interpolation == INTERPOLATION_ON;
+    }
+    json["settings"]["compactTextures"] = compactTextures;
+
+    std::ofstream file(filePath);
+    if (!file) {
+        Log::logError("Failed to create JSON file: " + filePath);
+        return;
+    }
+    file << json.dump(2);
+    file.close();
+
+    Log::log("Settings saved to: " + filePath);
+}
+
 ControlsMenu::ControlsMenu(std::string projPath) {
     projectPath = projPath;
     init();
@@ -489,14 +574,15 @@ void ControlsMenu::init() {
                 // if no variable block is in the input
                 if (inputFind->second.inputType == ParsedInput::LITERAL) {
                     Block *inputBlock = findBlock(inputFind->second.literalValue.asString());
-                    if (!inputBlock->fields["KEY_OPTION"][0].is_null())
-                        buttonCheck = inputBlock->fields["KEY_OPTION"][0];
+                    const ParsedField *keyField = inputBlock->findField("KEY_OPTION");
+                    if (keyField != nullptr)
+                        buttonCheck = keyField->value;
                 } else {
                     buttonCheck = Scratch::getInputValue(block, "KEY_OPTION", sprite).asString();
                 }
 
             } else if (block.opcode == "event_whenkeypressed") {
-                buttonCheck = block.fields.at("KEY_OPTION")[0];
+                buttonCheck = block.getField("KEY_OPTION").value;
             } else continue;
             if (buttonCheck != "" && std::find(controls.begin(), controls.end(), buttonCheck) == controls.end()) {
                 Log::log("Found new control: " + buttonCheck);
@@ -685,8 +771,14 @@ void ControlsMenu::applyControls() {
         return;
     }
 
-    // Create a JSON object to hold control mappings
-    nlohmann::json json;
+    // Create a JSON object to hold control mappings, keeping the project settings saved in the same file
+    nlohmann::json json = nlohmann::json::object();
+    std::ifstream existingFile(filePath);
+    if (existingFile.is_open()) {
+        json = nlohmann::json::parse(existingFile, nullptr, false);
+        if (json.is_discarded() || !json.is_object()) json = nlohmann::json::object();
+        existingFile.close();
+    }
     json["controls"] = nlohmann::json::object();
 
     // Save each control in the form: "ControlName": "MappedKey"
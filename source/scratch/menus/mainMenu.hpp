@@ -58,15 +58,34 @@ class ProjectSettings {
     ButtonObject *backButton = nullptr;
     ButtonObject *changeControlsButton = nullptr;
     ButtonObject *bottomScreenButton = nullptr;
+    ButtonObject *interpolationButton = nullptr;
+    ButtonObject *compactTexturesButton = nullptr;
     bool shouldGoBack = false;
     std::string projectPath;
 
+    enum InterpolationSetting {
+        INTERPOLATION_DEFAULT, // whatever the project's TurboWarp settings say
+        INTERPOLATION_ON,
+        INTERPOLATION_OFF
+    };
+    InterpolationSetting interpolation = INTERPOLATION_DEFAULT;
+    bool compactTextures = false; // store costumes with `TexturePolicy`, so big projects fit in less memory
+
     ProjectSettings(std::string projPath = "");
     ~ProjectSettings();
 
     void init();
     void render();
     void cleanup();
+
+    /**
+     * Reads the settings saved for this project.
+     */
+    void loadSettings();
+    /**
+     * Saves the settings for this project, next to its controls.
+     */
+    void saveSettings();
 };
 
 class ControlsMenu {
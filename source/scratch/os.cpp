@@ -49,15 +49,26 @@ int Timer::getTimeMs() {
 
 // everyone else...
 #else
+#ifdef HEADLESS_BUILD
+bool Timer::useVirtualTime = false;
+double Timer::virtualTimeMs = 0.0;
+#endif
+
 Timer::Timer() {
     start();
 }
 
 void Timer::start() {
+#ifdef HEADLESS_BUILD
+    virtualStartTime = virtualTimeMs;
+#endif
     startTime = std::chrono::high_resolution_clock::now();
 }
 
 int Timer::getTimeMs() {
+#ifdef HEADLESS_BUILD
+    if (useVirtualTime) return static_cast<int>(virtualTimeMs - virtualStartTime);
+#endif
     auto currentTime = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime);
     return static_cast<int>(duration.count());
@@ -169,8 +169,23 @@ class Timer {
 #else
     std::chrono::high_resolution_clock::time_point startTime;
 #endif
+#ifdef HEADLESS_BUILD
+    double virtualStartTime;
+#endif
 
   public:
+#ifdef HEADLESS_BUILD
+    /**
+     * [Headless] If `true`, every Timer reads `virtualTimeMs` instead of the real clock,
+     * so runs with a fixed timestep behave the same no matter how fast the machine is.
+     */
+    static bool useVirtualTime;
+    /**
+     * [Headless] The current virtual time in milliseconds. Advanced by the renderer once per frame.
+     */
+    static double virtualTimeMs;
+#endif
+
     Timer();
     /**
      * Starts the clock.
@@ -0,0 +1,102 @@
+#include "penLayer.hpp"
+#include "image.hpp"
+#include "interpret.hpp"
+#include "unzip.hpp"
+#include <algorithm>
+#include <cmath>
+
+std::vector<PenLine> PenLayer::lines;
+std::vector<PenStamp> PenLayer::stamps;
+bool PenLayer::shouldClear = false;
+
+void PenLayer::penDown(Sprite *sprite) {
+    if (sprite->pen.down) return;
+    sprite->pen.down = true;
+    sprite->pen.lastX = sprite->xPosition;
+    sprite->pen.lastY = sprite->yPosition;
+
+    // putting the pen down draws a dot
+    lines.push_back({static_cast<float>(sprite->xPosition), static_cast<float>(sprite->yPosition),
+                     static_cast<float>(sprite->xPosition), static_cast<float>(sprite->yPosition),
+                     static_cast<float>(sprite->pen.size), sprite->pen.r, sprite->pen.g, sprite->pen.b, sprite->pen.a});
+}
+
+void PenLayer::penUp(Sprite *sprite) {
+    sprite->pen.down = false;
+}
+
+void PenLayer::moveTo(Sprite *sprite) {
+    PenState &pen = sprite->pen;
+    if (!pen.down || (pen.lastX == sprite->xPosition && pen.lastY == sprite->yPosition)) return;
+
+    lines.push_back({static_cast<float>(pen.lastX), static_cast<float>(pen.lastY),
+                     static_cast<float>(sprite->xPosition), static_cast<float>(sprite->yPosition),
+                     static_cast<float>(pen.size), pen.r, pen.g, pen.b, pen.a});
+    pen.lastX = sprite->xPosition;
+    pen.lastY = sprite->yPosition;
+}
+
+void PenLayer::stamp(Sprite *sprite) {
+    const Costume &costume = sprite->costumes[sprite->currentCostume];
+
+    // hidden sprites can be stamped too, so their costume might not be loaded yet
+    if (projectType == UNZIPPED) {
+        Image::loadImageFromFile(costume.fullName);
+    } else {
+        Image::loadImageFromSB3(&Unzip::zipArchive, costume.fullName);
+    }
+
+    stamps.push_back({costume.id, costume.fullName, sprite->xPosition, sprite->yPosition, sprite->size, sprite->rotation, sprite->rotationStyle,
+                      costume.rotationCenterX, costume.rotationCenterY, sprite->ghostEffect, sprite->effects, lines.size()});
+}
+
+void PenLayer::clear() {
+    lines.clear();
+    stamps.clear();
+    shouldClear = true;
+}
+
+void PenLayer::updateColor(PenState &pen) {
+    const double hue = std::fmod(pen.color, 100.0) / 100.0 * 6.0;
+    const double saturation = std::clamp(pen.saturation, 0.0, 100.0) / 100.0;
+    const double value = std::clamp(pen.brightness, 0.0, 100.0) / 100.0;
+
+    const int sector = static_cast<int>(std::floor(hue)) % 6;
+    const double fraction = hue - std::floor(hue);
+    const double p = value * (1 - saturation);
+    const double q = value * (1 - saturation * fraction);
+    const double t = value * (1 - saturation * (1 - fraction));
+
+    double r, g, b;
+    switch (sector) {
+    case 0:
+        r = value, g = t, b = p;
+        break;
+    case 1:
+        r = q, g = value, b = p;
+        break;
+    case 2:
+        r = p, g = value, b = t;
+        break;
+    case 3:
+        r = p, g = q, b = value;
+        break;
+    case 4:
+        r = t, g = p, b = value;
+        break;
+    default:
+        r = value, g = p, b = q;
+        break;
+    }
+
+    pen.r = static_cast<uint8_t>(std::round(r * 255));
+    pen.g = static_cast<uint8_t>(std::round(g * 255));
+    pen.b = static_cast<uint8_t>(std::round(b * 255));
+    pen.a = static_cast<uint8_t>(std::round((1 - std::clamp(pen.transparency, 0.0, 100.0) / 100.0) * 255));
+}
+
+void PenLayer::clearQueue() {
+    lines.clear();
+    stamps.clear();
+    shouldClear = false;
+}
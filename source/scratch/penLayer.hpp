@@ -0,0 +1,76 @@
+#pragma once
+#include "sprite.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct PenLine {
+    // in Scratch coordinates
+    float x1, y1;
+    float x2, y2;
+    float size;
+    uint8_t r, g, b, a;
+};
+
+struct PenStamp {
+    std::string costumeId;
+    std::string costumeFile;
+    double xPosition;
+    double yPosition;
+    double size;
+    double rotation;
+    Sprite::RotationStyle rotationStyle;
+    double rotationCenterX;
+    double rotationCenterY;
+    float ghostEffect;
+    GraphicEffects effects;
+    size_t lineCount; // how many lines were queued before this stamp, so they get drawn first
+};
+
+/**
+ * Everything the pen blocks draw. Drawing is queued up and every renderer
+ * applies the whole queue to its pen layer once per frame, between the Stage and the sprites.
+ */
+class PenLayer {
+  public:
+    static std::vector<PenLine> lines;
+    static std::vector<PenStamp> stamps;
+
+    /**
+     * If the pen layer has to be erased before drawing the queue.
+     */
+    static bool shouldClear;
+
+    static void penDown(Sprite *sprite);
+    static void penUp(Sprite *sprite);
+
+    /**
+     * Draws a line from where the pen last was to where the sprite is now, if its pen is down.
+     * @param sprite
+     */
+    static void moveTo(Sprite *sprite);
+
+    /**
+     * Draws the sprite's current costume onto the pen layer.
+     * @param sprite
+     */
+    static void stamp(Sprite *sprite);
+
+    /**
+     * Erases everything on the pen layer.
+     */
+    static void clear();
+
+    /**
+     * Updates the RGBA color of a sprite's pen after its Scratch color changed.
+     * @param pen
+     */
+    static void updateColor(PenState &pen);
+
+    /**
+     * Empties the queue, called by the renderer once it's drawn.
+     */
+    static void clearQueue();
+
+    static bool hasQueued() { return shouldClear || !lines.empty() || !stamps.empty(); }
+};
@@ -0,0 +1,247 @@
+#include "profiler.hpp"
+
+#ifdef ENABLE_PROFILER
+#include "os.hpp"
+#include "renderState.hpp"
+#include "sprite.hpp"
+#include "text.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <unordered_map>
+#include <vector>
+#ifdef __3DS__
+#include <3ds.h>
+#include <citro2d.h>
+#else
+#include <chrono>
+#endif
+
+bool Profiler::showOverlay = true;
+
+// the top scripts the overlay shows, and how many frames it waits before updating them
+#define OVERLAY_SCRIPTS 5
+#define OVERLAY_UPDATE_FRAMES 30
+
+struct ProfileNode {
+    std::string name;
+    int parent;
+    int depth; // 1 for sprites, 2 for scripts, 3 and up for blocks
+    std::vector<int> children;
+    uint64_t calls = 0;
+    uint64_t ticks = 0;      // including children
+    uint64_t frameTicks = 0; // the part of `ticks` from this frame
+    double recentMs = 0;     // time per frame, smoothed over the last few frames
+};
+
+static std::vector<ProfileNode> nodes = {{"root", -1, 0}};
+static std::vector<int> scriptNodes;
+// nodes entered but not left yet, with the tick they were entered at
+static std::vector<std::pair<int, uint64_t>> stack;
+static uint64_t frames = 0;
+static std::vector<TextObject *> overlayTexts;
+static size_t overlayCount = 0; // texts in use, the rest are kept to be reused
+
+/**
+ * Gets a tick count that's as cheap to read as the platform allows.
+ */
+static uint64_t getTicks() {
+#ifdef __3DS__
+    return svcGetSystemTick();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+static double ticksToMs(uint64_t ticks) {
+#ifdef __3DS__
+    return ticks * 1000.0 / SYSCLOCK_ARM11;
+#else
+    return ticks * 1000.0 * std::chrono::steady_clock::period::num / std::chrono::steady_clock::period::den;
+#endif
+}
+
+static int findChild(int parent, const std::string &name) {
+    for (int child : nodes[parent].children) {
+        if (nodes[child].name == name) return child;
+    }
+    const int child = nodes.size();
+    nodes.push_back({name, parent, nodes[parent].depth + 1});
+    nodes[parent].children.push_back(child);
+    if (nodes[child].depth == 2) scriptNodes.push_back(child);
+    return child;
+}
+
+static void enter(const std::string &name) {
+    const int node = findChild(stack.empty() ? 0 : stack.back().first, name);
+    nodes[node].calls++;
+    stack.push_back({node, getTicks()});
+}
+
+static void leave() {
+    const uint64_t elapsed = getTicks() - stack.back().second;
+    ProfileNode &node = nodes[stack.back().first];
+    node.ticks += elapsed;
+    node.frameTicks += elapsed;
+    stack.pop_back();
+}
+
+Profiler::BlockScope::BlockScope(const Block &block, Sprite *sprite) : entered(1) {
+    if (stack.empty()) {
+        // clones count as the sprite they were cloned from
+        enter(sprite->isStage ? "Stage" : sprite->name);
+
+        // hat blocks don't have a top level parent, since they're the top of their script
+        std::string script = block.opcode + " " + block.id;
+        auto hatFind = sprite->blocks.find(block.topLevelParentBlock);
+        if (hatFind != sprite->blocks.end()) script = hatFind->second.opcode + " " + hatFind->second.id;
+        enter(script);
+        entered += 2;
+    }
+    enter(block.opcode);
+}
+
+Profiler::BlockScope::~BlockScope() {
+    for (int i = 0; i < entered; i++) {
+        leave();
+    }
+}
+
+void Profiler::endFrame() {
+    frames++;
+    for (ProfileNode &node : nodes) {
+        node.recentMs = node.recentMs * 0.9 + ticksToMs(node.frameTicks) * 0.1;
+        node.frameTicks = 0;
+    }
+
+    // the overlay is drawn with the sprites, so a project that doesn't change anything on screen still needs it redrawn
+    if (showOverlay && frames % OVERLAY_UPDATE_FRAMES == 0) RenderState::markChanged();
+}
+
+/**
+ * Gets the path of a node in the tree, the way folded stacks write it.
+ */
+static std::string getPath(int node) {
+    std::string path = nodes[node].name;
+    for (int parent = nodes[node].parent; parent > 0; parent = nodes[parent].parent) {
+        path = nodes[parent].name + ";" + path;
+    }
+    return path;
+}
+
+static uint64_t getSelfTicks(const ProfileNode &node) {
+    uint64_t childTicks = 0;
+    for (int child : node.children) {
+        childTicks += nodes[child].ticks;
+    }
+    return node.ticks > childTicks ? node.ticks - childTicks : 0;
+}
+
+void Profiler::save(const std::string &path) {
+    if (nodes.size() == 1) return;
+
+    struct OpcodeStats {
+        uint64_t calls = 0;
+        uint64_t ticks = 0;
+        uint64_t selfTicks = 0;
+    };
+    std::unordered_map<std::string, OpcodeStats> opcodes;
+    nlohmann::json scripts = nlohmann::json::array();
+    nlohmann::json sprites = nlohmann::json::array();
+    std::ofstream folded(path + ".folded");
+
+    for (size_t i = 1; i < nodes.size(); i++) {
+        const ProfileNode &node = nodes[i];
+        const uint64_t selfTicks = getSelfTicks(node);
+        if (selfTicks > 0) folded << getPath(i) << " " << static_cast<uint64_t>(ticksToMs(selfTicks) * 1000) << "\n";
+
+        if (node.depth == 1) {
+            sprites.push_back({{"sprite", node.name}, {"totalMs", ticksToMs(node.ticks)}});
+        } else if (node.depth == 2) {
+            scripts.push_back({{"sprite", nodes[node.parent].name}, {"script", node.name}, {"calls", node.calls}, {"totalMs", ticksToMs(node.ticks)}});
+        } else {
+            // a block inside itself (like a recursive custom block) gets its total counted again for every level
+            OpcodeStats &stats = opcodes[node.name];
+            stats.calls += node.calls;
+            stats.ticks += node.ticks;
+            stats.selfTicks += selfTicks;
+        }
+    }
+
+    nlohmann::json opcodeList = nlohmann::json::array();
+    for (auto &[opcode, stats] : opcodes) {
+        opcodeList.push_back({{"opcode", opcode}, {"calls", stats.calls}, {"totalMs", ticksToMs(stats.ticks)}, {"selfMs", ticksToMs(stats.selfTicks)}});
+    }
+    const auto byTotal = [](const nlohmann::json &a, const nlohmann::json &b) { return a["totalMs"].get<double>() > b["totalMs"].get<double>(); };
+    std::sort(opcodeList.begin(), opcodeList.end(), [](const nlohmann::json &a, const nlohmann::json &b) {
+        return a["selfMs"].get<double>() > b["selfMs"].get<double>();
+    });
+    std::sort(scripts.begin(), scripts.end(), byTotal);
+    std::sort(sprites.begin(), sprites.end(), byTotal);
+
+    nlohmann::json profile = {{"frames", frames}, {"sprites", sprites}, {"scripts", scripts}, {"opcodes", opcodeList}};
+    std::ofstream json(path + ".json");
+    json << profile.dump(2);
+    if (!json || !folded) {
+        Log::logWarning("Couldn't save profile to " + path);
+        return;
+    }
+
+    Log::log("Saved profile of " + std::to_string(frames) + " frames to " + path + ".json and .folded");
+    for (size_t i = 0; i < scripts.size() && i < OVERLAY_SCRIPTS; i++) {
+        Log::log("  " + scripts[i]["sprite"].get<std::string>() + ": " + scripts[i]["script"].get<std::string>() + " took " +
+                 std::to_string(scripts[i]["totalMs"].get<double>()) + " ms");
+    }
+}
+
+void Profiler::renderOverlay() {
+    if (!showOverlay) return;
+
+    if (frames % OVERLAY_UPDATE_FRAMES == 0 || overlayCount == 0) {
+        std::vector<int> top = scriptNodes;
+        const size_t count = std::min(top.size(), static_cast<size_t>(OVERLAY_SCRIPTS));
+        std::partial_sort(top.begin(), top.begin() + count, top.end(), [](int a, int b) {
+            return nodes[a].recentMs > nodes[b].recentMs;
+        });
+
+        overlayCount = count;
+        for (size_t i = 0; i < count; i++) {
+            char time[16];
+            snprintf(time, sizeof(time), "%.2f ms ", nodes[top[i]].recentMs);
+            const std::string line = time + nodes[nodes[top[i]].parent].name + ": " + nodes[top[i]].name;
+            if (i == overlayTexts.size()) {
+                overlayTexts.push_back(createTextObject(line, 0, 0));
+                overlayTexts[i]->setCenterAligned(false);
+#ifdef __3DS__
+                overlayTexts[i]->setColor(C2D_Color32(0, 0, 0, 255));
+#else
+                overlayTexts[i]->setColor(0x000000FF);
+#endif
+                overlayTexts[i]->setScale(0.5f);
+            } else if (overlayTexts[i]->getText() != line) {
+                overlayTexts[i]->setText(line);
+            }
+        }
+    }
+
+    int y = 4;
+    for (size_t i = 0; i < overlayCount; i++) {
+        overlayTexts[i]->render(4, y);
+        y += static_cast<int>(overlayTexts[i]->getSize()[1]) + 2;
+    }
+}
+
+void Profiler::reset() {
+    nodes = {{"root", -1, 0}};
+    scriptNodes.clear();
+    stack.clear();
+    frames = 0;
+    for (TextObject *text : overlayTexts) {
+        delete text;
+    }
+    overlayTexts.clear();
+    overlayCount = 0;
+}
+
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+struct Block;
+class Sprite;
+
+/**
+ * Measures how long blocks take to run, by sprite, by script and by opcode, for finding what slows a project down.
+ * Only built with `ENABLE_PROFILER`, so the hooks cost nothing otherwise.
+ * Time is kept as a tree of sprite, then script (by its hat block), then every block on the way to the one running,
+ * which is what flame graphs show.
+ */
+class Profiler {
+  public:
+    /**
+     * Times a block from its creation until it goes out of scope, along with everything the block runs.
+     * The first block of a sprite's script to run also starts timing the sprite and script.
+     */
+    class BlockScope {
+      public:
+        BlockScope(const Block &block, Sprite *sprite);
+        ~BlockScope();
+
+      private:
+        int entered; // how many levels of the tree got entered, to leave them all again
+    };
+
+    // if the top scripts get drawn over the project
+    static bool showOverlay;
+
+    /**
+     * Moves on to the next frame, updating the per frame times the overlay shows. Call once per project frame.
+     */
+    static void endFrame();
+
+    /**
+     * Writes everything measured so far to `<path>.json` (totals by opcode, script and sprite) and
+     * `<path>.folded` (one line per tree path with its self time in microseconds, for flamegraph.pl or speedscope).
+     * @param path Path of the files, without the extension.
+     */
+    static void save(const std::string &path);
+
+    /**
+     * Draws the scripts that took the most time recently in the top left corner, if `showOverlay` is set.
+     */
+    static void renderOverlay();
+
+    /**
+     * Forgets everything measured, for when the project is closed.
+     */
+    static void reset();
+};
+
+#ifdef ENABLE_PROFILER
+#define PROFILE_BLOCK(block, sprite) Profiler::BlockScope profilerScope(block, sprite)
+#else
+#define PROFILE_BLOCK(block, sprite)
+#endif
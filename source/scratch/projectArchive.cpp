@@ -0,0 +1,128 @@
+#include "unzip.hpp"
+#include <cstdio>
+#include <cstring>
+
+// mapping the whole sb3 costs (almost) no memory until parts of it get read
+#if defined(__PC__) && !defined(_WIN32)
+#define MAP_ARCHIVE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(HEADLESS_BUILD)
+#include <mutex>
+#elif !defined(__3DS__)
+#include <SDL2/SDL.h>
+#endif
+
+std::string Unzip::archivePath = "";
+
+#ifdef MAP_ARCHIVE
+
+static void *archiveMapping = nullptr;
+static size_t archiveMappingSize = 0;
+
+bool Unzip::openArchive(const std::string &path) {
+    memset(&zipArchive, 0, sizeof(zipArchive));
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        Log::logError("Failed to open SB3: " + path);
+        return false;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    void *mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (mapping == MAP_FAILED) {
+        Log::logError("Failed to map SB3: " + path);
+        return false;
+    }
+    // costumes and sounds get read whenever they're needed, not in order
+    madvise(mapping, fileStat.st_size, MADV_RANDOM);
+
+    archiveMapping = mapping;
+    archiveMappingSize = fileStat.st_size;
+    if (!mz_zip_reader_init_mem(&zipArchive, archiveMapping, archiveMappingSize, 0)) {
+        closeArchive();
+        return false;
+    }
+    return true;
+}
+
+void Unzip::closeArchive() {
+    mz_zip_reader_end(&zipArchive);
+    memset(&zipArchive, 0, sizeof(zipArchive));
+    if (archiveMapping) munmap(archiveMapping, archiveMappingSize);
+    archiveMapping = nullptr;
+    archiveMappingSize = 0;
+}
+
+#else
+
+// without mmap, miniz reads the central directory once and every file from disk when it's extracted
+static FILE *archiveFile = nullptr;
+
+// costumes and sounds can get extracted from worker threads at the same time
+#ifdef __3DS__
+static void lockArchive() {}
+static void unlockArchive() {}
+#elif defined(HEADLESS_BUILD)
+static std::mutex archiveMutex;
+static void lockArchive() { archiveMutex.lock(); }
+static void unlockArchive() { archiveMutex.unlock(); }
+#else
+static SDL_mutex *archiveMutex = nullptr;
+static void lockArchive() { SDL_LockMutex(archiveMutex); }
+static void unlockArchive() { SDL_UnlockMutex(archiveMutex); }
+#endif
+
+static size_t readArchive(void *opaque, mz_uint64 offset, void *buffer, size_t size) {
+    lockArchive();
+    size_t read = 0;
+    if (fseek(archiveFile, static_cast<long>(offset), SEEK_SET) == 0) read = fread(buffer, 1, size, archiveFile);
+    unlockArchive();
+    return read;
+}
+
+bool Unzip::openArchive(const std::string &path) {
+    memset(&zipArchive, 0, sizeof(zipArchive));
+
+#if !defined(__3DS__) && !defined(HEADLESS_BUILD)
+    if (!archiveMutex) archiveMutex = SDL_CreateMutex();
+    if (!archiveMutex) return false;
+#endif
+
+    archiveFile = fopen(path.c_str(), "rb");
+    if (!archiveFile) {
+        Log::logError("Failed to open SB3: " + path);
+        return false;
+    }
+    fseek(archiveFile, 0, SEEK_END);
+    const long size = ftell(archiveFile);
+    if (size <= 0) {
+        closeArchive();
+        return false;
+    }
+
+    zipArchive.m_pRead = readArchive;
+    zipArchive.m_pIO_opaque = &zipArchive;
+    if (!mz_zip_reader_init(&zipArchive, size, 0)) {
+        closeArchive();
+        return false;
+    }
+    return true;
+}
+
+void Unzip::closeArchive() {
+    mz_zip_reader_end(&zipArchive);
+    memset(&zipArchive, 0, sizeof(zipArchive));
+    if (archiveFile) fclose(archiveFile);
+    archiveFile = nullptr;
+}
+
+#endif
@@ -0,0 +1,699 @@
+#include "projectCache.hpp"
+#include "interpret.hpp"
+#include "os.hpp"
+#include "render.hpp"
+#include "sprite.hpp"
+#include "unzip.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef ENABLE_CLOUDVARS
+extern std::string projectJSON;
+extern bool cloudProject;
+#endif
+
+static const char CACHE_MAGIC[8] = {'S', 'E', 'C', 'A', 'C', 'H', 'E', '\0'};
+// caches are written in the byte order of whatever wrote them
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// tells apart the project.json a cache was made from, without having to read it
+struct CacheKey {
+    uint32_t crc32;
+    uint64_t size;
+};
+
+static bool getCacheKey(CacheKey &key) {
+    if (projectType == UNZIPPED) return false;
+    int fileIndex = mz_zip_reader_locate_file(&Unzip::zipArchive, "project.json", nullptr, 0);
+    if (fileIndex < 0) return false;
+
+    mz_zip_archive_file_stat fileStat;
+    if (!mz_zip_reader_file_stat(&Unzip::zipArchive, fileIndex, &fileStat)) return false;
+    key.crc32 = fileStat.m_crc32;
+    key.size = fileStat.m_uncomp_size;
+    return true;
+}
+
+enum JsonTag : uint8_t {
+    JSON_NULL,
+    JSON_BOOLEAN,
+    JSON_INTEGER,
+    JSON_UNSIGNED,
+    JSON_FLOAT,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+};
+
+class CacheWriter {
+  public:
+    std::vector<char> data;
+
+    template <typename T>
+    void write(T value) {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+
+    void writeBool(bool value) { write<uint8_t>(value ? 1 : 0); }
+
+    void writeString(const std::string &value) {
+        write<uint32_t>(value.size());
+        data.insert(data.end(), value.begin(), value.end());
+    }
+
+    void writeValue(const Value &value) {
+        write<uint8_t>(static_cast<uint8_t>(value.getType()));
+        switch (value.getType()) {
+        case ValueType::INTEGER:
+            write<int32_t>(value.asInt());
+            break;
+        case ValueType::DOUBLE:
+            write<double>(value.asDouble());
+            break;
+        case ValueType::BOOLEAN:
+            writeBool(value.asString() == "true");
+            break;
+        case ValueType::STRING:
+            writeString(value.asString());
+            break;
+        }
+    }
+
+    void writeJson(const nlohmann::json &json) {
+        switch (json.type()) {
+        case nlohmann::json::value_t::boolean:
+            write<uint8_t>(JSON_BOOLEAN);
+            writeBool(json.get<bool>());
+            break;
+        case nlohmann::json::value_t::number_integer:
+            write<uint8_t>(JSON_INTEGER);
+            write<int64_t>(json.get<int64_t>());
+            break;
+        case nlohmann::json::value_t::number_unsigned:
+            write<uint8_t>(JSON_UNSIGNED);
+            write<uint64_t>(json.get<uint64_t>());
+            break;
+        case nlohmann::json::value_t::number_float:
+            write<uint8_t>(JSON_FLOAT);
+            write<double>(json.get<double>());
+            break;
+        case nlohmann::json::value_t::string:
+            write<uint8_t>(JSON_STRING);
+            writeString(json.get_ref<const std::string &>());
+            break;
+        case nlohmann::json::value_t::array:
+            write<uint8_t>(JSON_ARRAY);
+            write<uint32_t>(json.size());
+            for (const auto &item : json) {
+                writeJson(item);
+            }
+            break;
+        case nlohmann::json::value_t::object:
+            write<uint8_t>(JSON_OBJECT);
+            write<uint32_t>(json.size());
+            for (const auto &[key, item] : json.items()) {
+                writeString(key);
+                writeJson(item);
+            }
+            break;
+        default:
+            write<uint8_t>(JSON_NULL);
+            break;
+        }
+    }
+
+    void writeJsonMap(const std::unordered_map<std::string, nlohmann::json> &map) {
+        write<uint32_t>(map.size());
+        for (const auto &[key, item] : map) {
+            writeString(key);
+            writeJson(item);
+        }
+    }
+
+    void writeStrings(const std::vector<std::string> &strings) {
+        write<uint32_t>(strings.size());
+        for (const std::string &string : strings) {
+            writeString(string);
+        }
+    }
+};
+
+/**
+ * Reads back what `CacheWriter` wrote. Reading past the end, or anything else that doesn't make sense,
+ * sets `failed` and returns empty values from then on, so a broken cache can't crash anything.
+ */
+class CacheReader {
+  public:
+    const char *data;
+    size_t size;
+    size_t offset = 0;
+    bool failed = false;
+
+    CacheReader(const char *data, size_t size) : data(data), size(size) {}
+
+    template <typename T>
+    T read() {
+        T value = T();
+        if (failed || size - offset < sizeof(T)) {
+            failed = true;
+            return value;
+        }
+        memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    bool readBool() { return read<uint8_t>() != 0; }
+
+    /**
+     * Reads how many items come next. Every item takes at least a byte, so there can't be more than there are bytes left.
+     */
+    uint32_t readCount() {
+        const uint32_t count = read<uint32_t>();
+        if (count > size - offset) {
+            failed = true;
+            return 0;
+        }
+        return count;
+    }
+
+    std::string readString() {
+        const uint32_t length = readCount();
+        if (failed) return "";
+        std::string value(data + offset, length);
+        offset += length;
+        return value;
+    }
+
+    Value readValue() {
+        switch (static_cast<ValueType>(read<uint8_t>())) {
+        case ValueType::INTEGER:
+            return Value(static_cast<int>(read<int32_t>()));
+        case ValueType::DOUBLE:
+            return Value(read<double>());
+        case ValueType::BOOLEAN:
+            return Value(readBool());
+        case ValueType::STRING:
+            return Value(readString());
+        }
+        failed = true;
+        return Value();
+    }
+
+    nlohmann::json readJson(int depth = 0) {
+        // nothing Scratch makes goes anywhere near this deep
+        if (depth > 64) {
+            failed = true;
+            return nullptr;
+        }
+
+        switch (read<uint8_t>()) {
+        case JSON_NULL:
+            return nullptr;
+        case JSON_BOOLEAN:
+            return readBool();
+        case JSON_INTEGER:
+            return read<int64_t>();
+        case JSON_UNSIGNED:
+            return read<uint64_t>();
+        case JSON_FLOAT:
+            return read<double>();
+        case JSON_STRING:
+            return readString();
+        case JSON_ARRAY: {
+            nlohmann::json array = nlohmann::json::array();
+            const uint32_t count = readCount();
+            for (uint32_t i = 0; i < count && !failed; i++) {
+                array.push_back(readJson(depth + 1));
+            }
+            return array;
+        }
+        case JSON_OBJECT: {
+            nlohmann::json object = nlohmann::json::object();
+            const uint32_t count = readCount();
+            for (uint32_t i = 0; i < count && !failed; i++) {
+                std::string key = readString();
+                object[key] = readJson(depth + 1);
+            }
+            return object;
+        }
+        }
+        failed = true;
+        return nullptr;
+    }
+
+    void readJsonMap(std::unordered_map<std::string, nlohmann::json> &map) {
+        const uint32_t count = readCount();
+        for (uint32_t i = 0; i < count && !failed; i++) {
+            std::string key = readString();
+            map[key] = readJson();
+        }
+    }
+
+    void readStrings(std::vector<std::string> &strings) {
+        const uint32_t count = readCount();
+        for (uint32_t i = 0; i < count && !failed; i++) {
+            strings.push_back(readString());
+        }
+    }
+};
+
+/**
+ * Gets a map's items in the order project.json has them in, since nlohmann keeps object keys sorted.
+ * Putting them back in that order makes the maps iterate the same as when they're loaded from the JSON,
+ * which decides things like which of two scripts with the same hat starts first.
+ */
+template <typename Map>
+static std::vector<const typename Map::value_type *> inJsonOrder(const Map &map) {
+    std::vector<const typename Map::value_type *> items;
+    items.reserve(map.size());
+    for (const auto &item : map) {
+        items.push_back(&item);
+    }
+    std::sort(items.begin(), items.end(), [](const auto *a, const auto *b) { return a->first < b->first; });
+    return items;
+}
+
+static void writeBlock(CacheWriter &writer, const Block &block) {
+    writer.writeString(block.id);
+    writer.writeString(block.opcode);
+    writer.writeString(block.next);
+    writer.writeString(block.parent);
+    writer.writeBool(block.topLevel);
+    writer.writeBool(block.shadow);
+    writer.write<uint32_t>(block.fields.size());
+    for (const ParsedField &field : block.fields) {
+        writer.writeString(field.name);
+        writer.writeString(field.value);
+        writer.writeString(field.id);
+    }
+    writer.writeString(block.procCode);
+
+    writer.write<uint32_t>(block.parsedInputs.size());
+    for (const auto &[name, input] : block.parsedInputs) {
+        writer.writeString(name);
+        writer.write<uint8_t>(input.inputType);
+        writer.writeValue(input.literalValue);
+        writer.writeString(input.variableId);
+        writer.writeString(input.blockId);
+    }
+}
+
+static void readBlock(CacheReader &reader, Block &block) {
+    block.id = reader.readString();
+    block.opcode = reader.readString();
+    block.next = reader.readString();
+    block.parent = reader.readString();
+    block.topLevel = reader.readBool();
+    block.shadow = reader.readBool();
+    const uint32_t fieldCount = reader.readCount();
+    for (uint32_t i = 0; i < fieldCount && !reader.failed; i++) {
+        ParsedField field;
+        field.name = reader.readString();
+        field.value = reader.readString();
+        field.id = reader.readString();
+        block.fields.push_back(field);
+    }
+    block.procCode = reader.readString();
+
+    const uint32_t inputCount = reader.readCount();
+    for (uint32_t i = 0; i < inputCount && !reader.failed; i++) {
+        std::string name = reader.readString();
+        ParsedInput input;
+        const uint8_t inputType = reader.read<uint8_t>();
+        if (inputType > ParsedInput::BOOLEAN) reader.failed = true;
+        input.inputType = static_cast<ParsedInput::InputType>(inputType);
+        input.literalValue = reader.readValue();
+        input.variableId = reader.readString();
+        input.blockId = reader.readString();
+        block.parsedInputs[name] = input;
+    }
+}
+
+static void writeSprite(CacheWriter &writer, const Sprite *sprite) {
+    writer.writeString(sprite->name);
+    writer.writeBool(sprite->isStage);
+    writer.writeBool(sprite->draggable);
+    writer.writeBool(sprite->visible);
+    writer.writeBool(sprite->shouldDoSpriteClick);
+    writer.write<int32_t>(sprite->currentCostume);
+    writer.write<float>(sprite->volume);
+    writer.write<double>(sprite->xPosition);
+    writer.write<double>(sprite->yPosition);
+    writer.write<double>(sprite->size);
+    writer.write<double>(sprite->rotation);
+    writer.write<int32_t>(sprite->layer);
+    writer.write<uint8_t>(sprite->rotationStyle);
+
+    writer.write<uint32_t>(sprite->variables.size());
+    for (const auto *item : inJsonOrder(sprite->variables)) {
+        const Variable &variable = item->second;
+        writer.writeString(variable.id);
+        writer.writeString(variable.name);
+        writer.writeValue(variable.value);
+        writer.writeBool(variable.cloud);
+    }
+
+    writer.write<uint32_t>(sprite->blocks.size());
+    for (const auto *item : inJsonOrder(sprite->blocks)) {
+        writeBlock(writer, item->second);
+    }
+
+    // custom blocks get added as their prototype blocks are loaded
+    std::vector<const CustomBlock *> customBlocks;
+    for (const auto &[name, customBlock] : sprite->customBlocks) {
+        customBlocks.push_back(&customBlock);
+    }
+    std::sort(customBlocks.begin(), customBlocks.end(), [](const CustomBlock *a, const CustomBlock *b) { return a->blockId < b->blockId; });
+    writer.write<uint32_t>(customBlocks.size());
+    for (const CustomBlock *item : customBlocks) {
+        const CustomBlock &customBlock = *item;
+        writer.writeString(customBlock.name);
+        writer.writeString(customBlock.blockId);
+        writer.writeStrings(customBlock.argumentIds);
+        writer.writeStrings(customBlock.argumentNames);
+        writer.writeStrings(customBlock.argumentDefaults);
+        writer.writeBool(customBlock.runWithoutScreenRefresh);
+    }
+
+    writer.write<uint32_t>(sprite->lists.size());
+    for (const auto *item : inJsonOrder(sprite->lists)) {
+        const List &list = item->second;
+        writer.writeString(list.id);
+        writer.writeString(list.name);
+        writer.write<uint32_t>(list.items.size());
+        for (const Value &item : list.items) {
+            writer.writeValue(item);
+        }
+    }
+
+    writer.write<uint32_t>(sprite->sounds.size());
+    for (const auto &[name, sound] : sprite->sounds) {
+        writer.writeString(sound.id);
+        writer.writeString(sound.name);
+        writer.writeString(sound.fullName);
+        writer.writeString(sound.dataFormat);
+        writer.write<int32_t>(sound.sampleRate);
+        writer.write<int32_t>(sound.sampleCount);
+    }
+
+    writer.write<uint32_t>(sprite->costumes.size());
+    for (const Costume &costume : sprite->costumes) {
+        writer.writeString(costume.id);
+        writer.writeString(costume.name);
+        writer.writeString(costume.fullName);
+        writer.writeString(costume.dataFormat);
+        writer.write<int32_t>(costume.bitmapResolution);
+        writer.write<double>(costume.rotationCenterX);
+        writer.write<double>(costume.rotationCenterY);
+    }
+
+    writer.write<uint32_t>(sprite->comments.size());
+    for (const auto *item : inJsonOrder(sprite->comments)) {
+        const Comment &comment = item->second;
+        writer.writeString(comment.id);
+        writer.writeString(comment.blockId);
+        writer.writeString(comment.text);
+        writer.writeBool(comment.minimized);
+        writer.write<int32_t>(comment.x);
+        writer.write<int32_t>(comment.y);
+        writer.write<int32_t>(comment.width);
+        writer.write<int32_t>(comment.height);
+    }
+
+    writer.write<uint32_t>(sprite->broadcasts.size());
+    for (const auto *item : inJsonOrder(sprite->broadcasts)) {
+        const Broadcast &broadcast = item->second;
+        writer.writeString(broadcast.id);
+        writer.writeString(broadcast.name);
+    }
+}
+
+static void readSprite(CacheReader &reader, Sprite *sprite) {
+    sprite->name = reader.readString();
+    sprite->id = Math::generateRandomString(15);
+    sprite->isStage = reader.readBool();
+    sprite->draggable = reader.readBool();
+    sprite->visible = reader.readBool();
+    sprite->shouldDoSpriteClick = reader.readBool();
+    sprite->currentCostume = reader.read<int32_t>();
+    sprite->volume = reader.read<float>();
+    sprite->xPosition = reader.read<double>();
+    sprite->yPosition = reader.read<double>();
+    sprite->size = reader.read<double>();
+    sprite->rotation = reader.read<double>();
+    sprite->layer = reader.read<int32_t>();
+    const uint8_t rotationStyle = reader.read<uint8_t>();
+    if (rotationStyle > Sprite::ALL_AROUND) reader.failed = true;
+    sprite->rotationStyle = static_cast<Sprite::RotationStyle>(rotationStyle);
+    sprite->toDelete = false;
+    sprite->isClone = false;
+
+    const uint32_t variableCount = reader.readCount();
+    for (uint32_t i = 0; i < variableCount && !reader.failed; i++) {
+        Variable variable;
+        variable.id = reader.readString();
+        variable.name = reader.readString();
+        variable.value = reader.readValue();
+        variable.cloud = reader.readBool();
+#ifdef ENABLE_CLOUDVARS
+        cloudProject = cloudProject || variable.cloud;
+#endif
+        sprite->variableIdsByName[variable.name] = variable.id;
+        sprite->variables[variable.id] = variable;
+    }
+
+    const uint32_t blockCount = reader.readCount();
+    for (uint32_t i = 0; i < blockCount && !reader.failed; i++) {
+        Block block;
+        readBlock(reader, block);
+        sprite->blocks[block.id] = block;
+    }
+
+    const uint32_t customBlockCount = reader.readCount();
+    for (uint32_t i = 0; i < customBlockCount && !reader.failed; i++) {
+        CustomBlock customBlock;
+        customBlock.name = reader.readString();
+        customBlock.blockId = reader.readString();
+        reader.readStrings(customBlock.argumentIds);
+        reader.readStrings(customBlock.argumentNames);
+        reader.readStrings(customBlock.argumentDefaults);
+        customBlock.runWithoutScreenRefresh = reader.readBool();
+        sprite->customBlocks[customBlock.name] = customBlock;
+    }
+
+    const uint32_t listCount = reader.readCount();
+    for (uint32_t i = 0; i < listCount && !reader.failed; i++) {
+        List list;
+        list.id = reader.readString();
+        list.name = reader.readString();
+        const uint32_t itemCount = reader.readCount();
+        list.items.reserve(itemCount);
+        for (uint32_t j = 0; j < itemCount && !reader.failed; j++) {
+            list.items.push_back(reader.readValue());
+        }
+        sprite->lists[list.id] = list;
+    }
+
+    const uint32_t soundCount = reader.readCount();
+    for (uint32_t i = 0; i < soundCount && !reader.failed; i++) {
+        Sound sound;
+        sound.id = reader.readString();
+        sound.name = reader.readString();
+        sound.fullName = reader.readString();
+        sound.dataFormat = reader.readString();
+        sound.sampleRate = reader.read<int32_t>();
+        sound.sampleCount = reader.read<int32_t>();
+        sprite->sounds[sound.name] = sound;
+    }
+
+    const uint32_t costumeCount = reader.readCount();
+    for (uint32_t i = 0; i < costumeCount && !reader.failed; i++) {
+        Costume costume;
+        costume.id = reader.readString();
+        costume.name = reader.readString();
+        costume.fullName = reader.readString();
+        costume.dataFormat = reader.readString();
+        costume.bitmapResolution = reader.read<int32_t>();
+        costume.rotationCenterX = reader.read<double>();
+        costume.rotationCenterY = reader.read<double>();
+        sprite->costumes.push_back(costume);
+    }
+
+    const uint32_t commentCount = reader.readCount();
+    for (uint32_t i = 0; i < commentCount && !reader.failed; i++) {
+        Comment comment;
+        comment.id = reader.readString();
+        comment.blockId = reader.readString();
+        comment.text = reader.readString();
+        comment.minimized = reader.readBool();
+        comment.x = reader.read<int32_t>();
+        comment.y = reader.read<int32_t>();
+        comment.width = reader.read<int32_t>();
+        comment.height = reader.read<int32_t>();
+        sprite->comments[comment.id] = comment;
+    }
+
+    const uint32_t broadcastCount = reader.readCount();
+    for (uint32_t i = 0; i < broadcastCount && !reader.failed; i++) {
+        Broadcast broadcast;
+        broadcast.id = reader.readString();
+        broadcast.name = reader.readString();
+        sprite->broadcasts[broadcast.id] = broadcast;
+    }
+}
+
+static void writeMonitor(CacheWriter &writer, const Monitor &monitor) {
+    writer.writeString(monitor.id);
+    writer.writeString(monitor.mode);
+    writer.writeString(monitor.opcode);
+    writer.writeJsonMap(monitor.parameters);
+    writer.writeString(monitor.spriteName);
+    writer.writeValue(monitor.value);
+    writer.write<int32_t>(monitor.x);
+    writer.write<int32_t>(monitor.y);
+    writer.writeBool(monitor.visible);
+    writer.writeBool(monitor.isDiscrete);
+    writer.write<double>(monitor.sliderMin);
+    writer.write<double>(monitor.sliderMax);
+}
+
+static void readMonitor(CacheReader &reader, Monitor &monitor) {
+    monitor.id = reader.readString();
+    monitor.mode = reader.readString();
+    monitor.opcode = reader.readString();
+    reader.readJsonMap(monitor.parameters);
+    monitor.spriteName = reader.readString();
+    monitor.value = reader.readValue();
+    monitor.x = reader.read<int32_t>();
+    monitor.y = reader.read<int32_t>();
+    monitor.visible = reader.readBool();
+    monitor.isDiscrete = reader.readBool();
+    monitor.sliderMin = reader.read<double>();
+    monitor.sliderMax = reader.read<double>();
+}
+
+std::string ProjectCache::getCachePath() {
+    if (projectType == UNZIPPED || Unzip::archivePath.empty()) return "";
+    return Unzip::archivePath + ".cache";
+}
+
+bool ProjectCache::load() {
+    CacheKey key;
+    const std::string path = getCachePath();
+    if (path.empty() || !getCacheKey(key)) return false;
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    std::vector<char> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    if (!file.read(data.data(), data.size())) return false;
+    file.close();
+
+    // the last 4 bytes are a checksum of everything else, so a cache that got damaged on disk doesn't get used
+    uint32_t checksum = 0;
+    if (data.size() < sizeof(checksum)) return false;
+    memcpy(&checksum, data.data() + data.size() - sizeof(checksum), sizeof(checksum));
+    data.resize(data.size() - sizeof(checksum));
+    if (mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char *>(data.data()), data.size()) != checksum) {
+        Log::logWarning("Project cache is broken, loading project.json instead.");
+        return false;
+    }
+
+    CacheReader reader(data.data(), data.size());
+    char magic[sizeof(CACHE_MAGIC)];
+    for (char &c : magic) {
+        c = reader.read<char>();
+    }
+    if (memcmp(magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || reader.read<uint32_t>() != BYTE_ORDER_MARK ||
+        reader.read<uint32_t>() != FORMAT_VERSION || reader.read<uint32_t>() != key.crc32 || reader.read<uint64_t>() != key.size) {
+        Log::log("Project cache is out of date.");
+        return false;
+    }
+
+    Log::log("Loading project from cache...");
+    std::vector<Sprite *> cachedSprites;
+    const uint32_t spriteCount = reader.readCount();
+    for (uint32_t i = 0; i < spriteCount && !reader.failed; i++) {
+        Sprite *sprite = MemoryTracker::allocate<Sprite>();
+        new (sprite) Sprite();
+        readSprite(reader, sprite);
+        cachedSprites.push_back(sprite);
+    }
+
+    std::vector<Monitor> monitors;
+    const uint32_t monitorCount = reader.readCount();
+    for (uint32_t i = 0; i < monitorCount && !reader.failed; i++) {
+        monitors.emplace_back();
+        readMonitor(reader, monitors.back());
+    }
+
+    if (reader.failed || reader.offset != data.size()) {
+        Log::logWarning("Project cache is broken, loading project.json instead.");
+        for (Sprite *sprite : cachedSprites) {
+            sprite->~Sprite();
+            MemoryTracker::deallocate<Sprite>(sprite);
+        }
+#ifdef ENABLE_CLOUDVARS
+        cloudProject = false;
+#endif
+        return false;
+    }
+
+#ifdef ENABLE_CLOUDVARS
+    // cloud variables are keyed by a hash of the project's JSON
+    int fileIndex = mz_zip_reader_locate_file(&Unzip::zipArchive, "project.json", nullptr, 0);
+    size_t jsonSize;
+    char *jsonData = static_cast<char *>(mz_zip_reader_extract_to_heap(&Unzip::zipArchive, fileIndex, &jsonSize, 0));
+    if (jsonData) {
+        projectJSON = std::string(jsonData, jsonSize);
+        mz_free(jsonData);
+    }
+#endif
+
+    sprites.reserve(400);
+    sprites.insert(sprites.end(), cachedSprites.begin(), cachedSprites.end());
+    Render::visibleVariables.insert(Render::visibleVariables.end(), monitors.begin(), monitors.end());
+    return true;
+}
+
+void ProjectCache::save() {
+    CacheKey key;
+    const std::string path = getCachePath();
+    if (path.empty() || !getCacheKey(key)) return;
+
+    CacheWriter writer;
+    writer.data.insert(writer.data.end(), CACHE_MAGIC, CACHE_MAGIC + sizeof(CACHE_MAGIC));
+    writer.write<uint32_t>(BYTE_ORDER_MARK);
+    writer.write<uint32_t>(FORMAT_VERSION);
+    writer.write<uint32_t>(key.crc32);
+    writer.write<uint64_t>(key.size);
+
+    writer.write<uint32_t>(sprites.size());
+    for (const Sprite *sprite : sprites) {
+        writeSprite(writer, sprite);
+    }
+    writer.write<uint32_t>(Render::visibleVariables.size());
+    for (const Monitor &monitor : Render::visibleVariables) {
+        writeMonitor(writer, monitor);
+    }
+    writer.write<uint32_t>(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char *>(writer.data.data()), writer.data.size()));
+
+    // write somewhere else first, so a crash halfway through can't leave a broken cache behind
+    const std::string tempPath = path + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file) return;
+    const bool written = static_cast<bool>(file.write(writer.data.data(), writer.data.size()));
+    file.close();
+    std::remove(path.c_str());
+    if (!written || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        Log::logWarning("Couldn't save project cache: " + path);
+        return;
+    }
+    Log::log("Saved project cache (" + std::to_string(writer.data.size() / 1024) + " KB).");
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/**
+ * Saves the sprites and monitors loaded from an sb3's project.json in a binary file next to it,
+ * so launching the same project again doesn't have to parse the JSON.
+ * The cache is only used while the project.json in the sb3 is the same one it was made from.
+ */
+class ProjectCache {
+  public:
+    // bump whenever something written to the cache changes, so old caches get made again
+    static constexpr uint32_t FORMAT_VERSION = 3;
+
+    /**
+     * Loads `sprites` and the monitors from the cache of the open sb3, if it has an up to date one.
+     * @return `true` if everything got loaded from the cache. If not, nothing was loaded.
+     */
+    static bool load();
+
+    /**
+     * Writes the cache for the open sb3, from the sprites and monitors `ProjectLoader` just loaded.
+     * Does nothing for unzipped projects, and fails quietly where the sb3's folder can't be written to.
+     */
+    static void save();
+
+    /**
+     * Gets where the cache of the open sb3 goes.
+     * @return The path, or an empty string if the project isn't an sb3.
+     */
+    static std::string getCachePath();
+};
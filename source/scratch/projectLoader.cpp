@@ -0,0 +1,587 @@
+#include "projectLoader.hpp"
+#include "interpret.hpp"
+#include "math.hpp"
+#include "os.hpp"
+#include "render.hpp"
+#include "sprite.hpp"
+#include <algorithm>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef ENABLE_CLOUDVARS
+extern bool cloudProject;
+#endif
+
+// a target ("sprite" in Scratch speak) that's still being parsed
+struct LoadingTarget {
+    Sprite *sprite = nullptr;
+    nlohmann::json properties = nlohmann::json::object(); // everything that isn't a list of things, like name and x
+    std::vector<Variable> variables;
+    std::vector<Block> blocks;
+    std::vector<CustomBlock> customBlocks;
+    std::vector<List> lists;
+    std::vector<Comment> comments;
+    std::vector<Broadcast> broadcasts;
+};
+
+/**
+ * Takes a string out of an item, instead of copying it. Items get thrown away once they're loaded.
+ */
+static std::string takeString(nlohmann::json &value) {
+    return std::move(value.get_ref<std::string &>());
+}
+
+static void loadSpriteProperties(Sprite *newSprite, const nlohmann::json &target) {
+    if (target.contains("name")) {
+        newSprite->name = target["name"].get<std::string>();
+    }
+    if (target.contains("isStage")) {
+        newSprite->isStage = target["isStage"].get<bool>();
+    }
+    if (target.contains("draggable")) {
+        newSprite->draggable = target["draggable"].get<bool>();
+    }
+    if (target.contains("visible")) {
+        newSprite->visible = target["visible"].get<bool>();
+    } else newSprite->visible = true;
+    if (target.contains("currentCostume")) {
+        newSprite->currentCostume = target["currentCostume"].get<int>();
+    }
+    if (target.contains("volume")) {
+        newSprite->volume = target["volume"].get<int>();
+    }
+    if (target.contains("x")) {
+        newSprite->xPosition = target["x"].get<int>();
+    }
+    if (target.contains("y")) {
+        newSprite->yPosition = target["y"].get<int>();
+    }
+    if (target.contains("size")) {
+        newSprite->size = target["size"].get<int>();
+    } else newSprite->size = 100;
+    if (target.contains("direction")) {
+        newSprite->rotation = target["direction"].get<int>();
+    } else newSprite->rotation = 90;
+    if (target.contains("layerOrder")) {
+        newSprite->layer = target["layerOrder"].get<int>();
+    } else newSprite->layer = 0;
+    if (target.contains("rotationStyle")) {
+        if (target["rotationStyle"].get<std::string>() == "all around")
+            newSprite->rotationStyle = newSprite->ALL_AROUND;
+        else if (target["rotationStyle"].get<std::string>() == "left-right")
+            newSprite->rotationStyle = newSprite->LEFT_RIGHT;
+        else
+            newSprite->rotationStyle = newSprite->NONE;
+    }
+    newSprite->toDelete = false;
+    newSprite->isClone = false;
+}
+
+static Variable loadVariable(const std::string &id, const nlohmann::json &data) {
+    Variable newVariable;
+    newVariable.id = id;
+    newVariable.name = data[0];
+    newVariable.value = Value::fromJson(data[1]);
+    newVariable.cloud = data.size() == 3;
+#ifdef ENABLE_CLOUDVARS
+    cloudProject = cloudProject || newVariable.cloud;
+#endif
+    return newVariable;
+}
+
+/**
+ * Turns one of a block's fields into a `ParsedField`.
+ * Fields are `[value, id]`, where the id is only there if the field picks a variable, list or broadcast.
+ * @return `false` if nothing is picked in the field.
+ */
+static bool loadField(ParsedField &field, nlohmann::json &data) {
+    if (!data.is_array() || data.empty() || data[0].is_null()) return false;
+    field.value = data[0].is_string() ? takeString(data[0]) : data[0].dump();
+    if (data.size() > 1 && data[1].is_string()) {
+        field.id = takeString(data[1]);
+    }
+    return true;
+}
+
+static Block loadBlock(LoadingTarget &target, const std::string &id, nlohmann::json &data) {
+    Block newBlock;
+    newBlock.id = id;
+    if (data.contains("opcode")) {
+        newBlock.opcode = takeString(data["opcode"]);
+
+        if (newBlock.opcode == "event_whenthisspriteclicked") target.sprite->shouldDoSpriteClick = true;
+    }
+    if (data.contains("next") && !data["next"].is_null()) {
+        newBlock.next = takeString(data["next"]);
+    }
+    if (data.contains("parent") && !data["parent"].is_null()) {
+        newBlock.parent = takeString(data["parent"]);
+    } else newBlock.parent = "null";
+    if (data.contains("fields")) {
+        for (auto &[fieldName, fieldData] : data["fields"].items()) {
+            ParsedField field;
+            field.name = fieldName;
+            if (loadField(field, fieldData)) newBlock.fields.push_back(std::move(field));
+        }
+    }
+    if (data.contains("inputs")) {
+
+        for (auto &[inputName, inputData] : data["inputs"].items()) {
+            ParsedInput parsedInput;
+
+            int type = inputData[0];
+            auto &inputValue = inputData[1];
+
+            if (type == 1) {
+                parsedInput.inputType = ParsedInput::LITERAL;
+                parsedInput.literalValue = Value::fromJson(inputValue);
+
+            } else if (type == 3) {
+                if (inputValue.is_array()) {
+                    parsedInput.inputType = ParsedInput::VARIABLE;
+                    parsedInput.variableId = takeString(inputValue[2]);
+                } else {
+                    parsedInput.inputType = ParsedInput::BLOCK;
+                    if (!inputValue.is_null())
+                        parsedInput.blockId = takeString(inputValue);
+                }
+            } else if (type == 2) {
+                parsedInput.inputType = ParsedInput::BOOLEAN;
+                parsedInput.blockId = takeString(inputValue);
+            }
+            newBlock.parsedInputs.emplace(inputName, std::move(parsedInput));
+        }
+    }
+    if (data.contains("topLevel")) {
+        newBlock.topLevel = data["topLevel"].get<bool>();
+    }
+    if (data.contains("shadow")) {
+        newBlock.shadow = data["shadow"].get<bool>();
+    }
+    if (data.contains("mutation") && data["mutation"].contains("proccode") && data["mutation"]["proccode"].is_string()) {
+        newBlock.procCode = data["mutation"]["proccode"].get<std::string>();
+    }
+
+    // add custom function blocks
+    if (newBlock.opcode == "procedures_prototype") {
+        if (!data.is_array()) {
+            CustomBlock newCustomBlock;
+            newCustomBlock.name = data["mutation"]["proccode"];
+            newCustomBlock.blockId = newBlock.id;
+
+            // custom blocks uses a different json structure for some reason?? have to parse them.
+            std::string rawArgumentNames = data["mutation"]["argumentnames"];
+            nlohmann::json parsedAN = nlohmann::json::parse(rawArgumentNames);
+            newCustomBlock.argumentNames = parsedAN.get<std::vector<std::string>>();
+
+            std::string rawArgumentDefaults = data["mutation"]["argumentdefaults"];
+            nlohmann::json parsedAD = nlohmann::json::parse(rawArgumentDefaults);
+
+            for (const auto &item : parsedAD) {
+                if (item.is_string()) {
+                    newCustomBlock.argumentDefaults.push_back(item.get<std::string>());
+                } else if (item.is_number_integer()) {
+                    newCustomBlock.argumentDefaults.push_back(std::to_string(item.get<int>()));
+                } else if (item.is_number_float()) {
+                    newCustomBlock.argumentDefaults.push_back(std::to_string(item.get<double>()));
+                } else {
+                    newCustomBlock.argumentDefaults.push_back(item.dump());
+                }
+            }
+
+            std::string rawArgumentIds = data["mutation"]["argumentids"];
+            nlohmann::json parsedAID = nlohmann::json::parse(rawArgumentIds);
+            newCustomBlock.argumentIds = parsedAID.get<std::vector<std::string>>();
+
+            if (data["mutation"]["warp"] == "true") {
+                newCustomBlock.runWithoutScreenRefresh = true;
+            } else newCustomBlock.runWithoutScreenRefresh = false;
+
+            target.customBlocks.push_back(newCustomBlock);
+        } else {
+            Log::logError("Unknown Custom block data: " + data.dump()); // TODO handle these
+        }
+    }
+    return newBlock;
+}
+
+static List loadList(const std::string &id, const nlohmann::json &data) {
+    List newList;
+    newList.id = id;
+    newList.name = data[0];
+    newList.items.reserve(data[1].size());
+    for (const auto &listItem : data[1]) {
+        newList.items.push_back(Value::fromJson(listItem));
+    }
+    return newList;
+}
+
+static Sound loadSound(const nlohmann::json &data) {
+    Sound newSound;
+    newSound.id = data["assetId"];
+    newSound.name = data["name"];
+    newSound.fullName = data["md5ext"];
+    newSound.dataFormat = data["dataFormat"];
+    newSound.sampleRate = data["rate"];
+    newSound.sampleCount = data["sampleCount"];
+    return newSound;
+}
+
+static Costume loadCostume(const nlohmann::json &data) {
+    Costume newCostume;
+    newCostume.id = data["assetId"];
+    if (data.contains("name")) {
+        newCostume.name = data["name"];
+    }
+    if (data.contains("bitmapResolution")) {
+        newCostume.bitmapResolution = data["bitmapResolution"];
+    }
+    if (data.contains("dataFormat")) {
+        newCostume.dataFormat = data["dataFormat"];
+    }
+    if (data.contains("md5ext")) {
+        newCostume.fullName = data["md5ext"];
+    }
+    if (data.contains("rotationCenterX")) {
+        newCostume.rotationCenterX = data["rotationCenterX"];
+    }
+    if (data.contains("rotationCenterY")) {
+        newCostume.rotationCenterY = data["rotationCenterY"];
+    }
+    return newCostume;
+}
+
+static Comment loadComment(const std::string &id, const nlohmann::json &data) {
+    Comment newComment;
+    newComment.id = id;
+    if (data.contains("blockId") && !data["blockId"].is_null()) {
+        newComment.blockId = data["blockId"];
+    }
+    newComment.width = data["width"];
+    newComment.height = data["height"];
+    newComment.minimized = data["minimized"];
+    newComment.x = data["x"];
+    newComment.y = data["y"];
+    newComment.text = data["text"];
+    return newComment;
+}
+
+static Monitor loadMonitor(const nlohmann::json &monitor) {
+    Monitor newMonitor;
+
+    if (monitor.contains("id") && !monitor["id"].is_null())
+        newMonitor.id = monitor.at("id").get<std::string>();
+
+    if (monitor.contains("mode") && !monitor["mode"].is_null())
+        newMonitor.mode = monitor.at("mode").get<std::string>();
+
+    if (monitor.contains("opcode") && !monitor["opcode"].is_null())
+        newMonitor.opcode = monitor.at("opcode").get<std::string>();
+
+    if (monitor.contains("params") && monitor["params"].is_object()) {
+        for (const auto &param : monitor["params"].items()) {
+            std::string key = param.key();
+            std::string value = param.value().dump();
+            newMonitor.parameters[key] = value;
+        }
+    }
+
+    if (monitor.contains("spriteName") && !monitor["spriteName"].is_null())
+        newMonitor.spriteName = monitor.at("spriteName").get<std::string>();
+    else
+        newMonitor.spriteName = "";
+
+    if (monitor.contains("value") && !monitor["value"].is_null())
+        newMonitor.value = Value(Math::removeQuotations(monitor.at("value").dump()));
+
+    if (monitor.contains("x") && !monitor["x"].is_null())
+        newMonitor.x = monitor.at("x").get<int>();
+
+    if (monitor.contains("y") && !monitor["y"].is_null())
+        newMonitor.y = monitor.at("y").get<int>();
+
+    if (monitor.contains("visible") && !monitor["visible"].is_null())
+        newMonitor.visible = monitor.at("visible").get<bool>();
+
+    if (monitor.contains("isDiscrete") && !monitor["isDiscrete"].is_null())
+        newMonitor.isDiscrete = monitor.at("isDiscrete").get<bool>();
+
+    if (monitor.contains("sliderMin") && !monitor["sliderMin"].is_null())
+        newMonitor.sliderMin = monitor.at("sliderMin").get<double>();
+
+    if (monitor.contains("sliderMax") && !monitor["sliderMax"].is_null())
+        newMonitor.sliderMax = monitor.at("sliderMax").get<double>();
+
+    return newMonitor;
+}
+
+/**
+ * Puts a target's items into one of its sprite's maps, in the order a parsed project.json would list them
+ * (nlohmann keeps object keys sorted). That way the maps iterate the same as they always have,
+ * which decides things like which of two scripts with the same hat starts first.
+ * @param map
+ * @param items Emptied afterwards.
+ * @param orderKey What project.json has the items listed by.
+ * @param mapKey What the map has the items stored by.
+ */
+template <typename T>
+static void addInJsonOrder(std::unordered_map<std::string, T> &map, std::vector<T> &items, std::string T::*orderKey, std::string T::*mapKey) {
+    std::vector<T *> sorted;
+    sorted.reserve(items.size());
+    for (T &item : items) {
+        sorted.push_back(&item);
+    }
+    // stable, so the last of two items with the same id wins, like it would in parsed JSON
+    std::stable_sort(sorted.begin(), sorted.end(), [orderKey](const T *a, const T *b) { return a->*orderKey < b->*orderKey; });
+    for (T *item : sorted) {
+        const std::string key = item->*mapKey;
+        map.insert_or_assign(key, std::move(*item));
+    }
+    items.clear();
+    items.shrink_to_fit();
+}
+
+/**
+ * Gets handed project.json piece by piece by nlohmann's SAX parser.
+ * Each block, variable, list, costume, sound, comment, broadcast and monitor gets collected as a small
+ * JSON value of its own, turned into its runtime struct, and thrown away, so only one is ever kept at a time.
+ */
+class ProjectParser : public nlohmann::json_sax<nlohmann::json> {
+  public:
+    bool null() override { return addValue(nullptr); }
+    bool boolean(bool val) override { return addValue(val); }
+    bool number_integer(number_integer_t val) override { return addValue(val); }
+    bool number_unsigned(number_unsigned_t val) override { return addValue(val); }
+    bool number_float(number_float_t val, const string_t &) override { return addValue(val); }
+    bool string(string_t &val) override { return addValue(std::move(val)); }
+    bool binary(binary_t &val) override { return addValue(nlohmann::json::binary(val)); }
+
+    bool start_object(std::size_t) override { return startContainer(nlohmann::json::object()); }
+    bool start_array(std::size_t) override { return startContainer(nlohmann::json::array()); }
+    bool end_object() override { return endContainer(); }
+    bool end_array() override { return endContainer(); }
+
+    bool key(string_t &val) override {
+        if (skipDepth > 0) return true;
+        if (!itemStack.empty()) {
+            itemKey = std::move(val);
+        } else {
+            placeKey = std::move(val);
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string &, const nlohmann::json::exception &ex) override {
+        Log::logError("Failed to parse project.json at byte " + std::to_string(position) + ": " + ex.what());
+        return false;
+    }
+
+    /**
+     * Frees the sprite of a target that didn't finish parsing.
+     */
+    void cleanup() {
+        if (target.sprite == nullptr) return;
+        target.sprite->~Sprite();
+        MemoryTracker::deallocate<Sprite>(target.sprite);
+        target = LoadingTarget();
+    }
+
+  private:
+    // the objects and arrays the parser is in, above the item being collected
+    enum class Place {
+        ROOT,
+        TARGETS,
+        TARGET,
+        TARGET_ITEMS, // an object of a target's variables, blocks, lists, comments or broadcasts, by id
+        TARGET_ARRAY, // a target's costumes or sounds
+        MONITORS
+    };
+
+    struct Frame {
+        Place place;
+        std::string collection; // the target's key the items are under
+    };
+
+    std::vector<Frame> places;
+    std::string placeKey; // the last key seen outside of an item
+
+    // the item being collected
+    nlohmann::json item;
+    std::vector<nlohmann::json *> itemStack; // its objects and arrays that haven't ended yet
+    std::string itemKey;
+
+    int skipDepth = 0; // how deep the parser is into something nothing gets loaded from
+    LoadingTarget target;
+
+    nlohmann::json *addToItem(nlohmann::json &&value) {
+        nlohmann::json *parent = itemStack.back();
+        if (parent->is_object()) {
+            nlohmann::json &member = (*parent)[itemKey];
+            member = std::move(value);
+            return &member;
+        }
+        parent->push_back(std::move(value));
+        return &parent->back();
+    }
+
+    bool isItem() const {
+        if (places.empty()) return false;
+        const Place place = places.back().place;
+        return place == Place::TARGET || place == Place::TARGET_ITEMS || place == Place::TARGET_ARRAY || place == Place::MONITORS;
+    }
+
+    bool addValue(nlohmann::json &&value) {
+        if (skipDepth > 0) return true;
+        if (!itemStack.empty()) {
+            addToItem(std::move(value));
+            return true;
+        }
+        if (isItem()) {
+            item = std::move(value);
+            finishItem();
+        }
+        return true;
+    }
+
+    bool startContainer(nlohmann::json &&container) {
+        if (skipDepth > 0) {
+            skipDepth++;
+            return true;
+        }
+        if (!itemStack.empty()) {
+            itemStack.push_back(addToItem(std::move(container)));
+            return true;
+        }
+
+        const bool isObject = container.is_object();
+        if (places.empty()) {
+            if (isObject) places.push_back({Place::ROOT, ""});
+            else skipDepth = 1;
+            return true;
+        }
+
+        const Place place = places.back().place;
+        if (place == Place::ROOT) {
+            if (placeKey == "targets" && !isObject) places.push_back({Place::TARGETS, ""});
+            else if (placeKey == "monitors" && !isObject) places.push_back({Place::MONITORS, ""});
+            else skipDepth = 1;
+        } else if (place == Place::TARGETS) {
+            if (isObject) {
+                startTarget();
+                places.push_back({Place::TARGET, ""});
+            } else skipDepth = 1;
+        } else if (place == Place::TARGET && (placeKey == "variables" || placeKey == "blocks" || placeKey == "lists" || placeKey == "comments" || placeKey == "broadcasts")) {
+            if (isObject) places.push_back({Place::TARGET_ITEMS, placeKey});
+            else skipDepth = 1;
+        } else if (place == Place::TARGET && (placeKey == "costumes" || placeKey == "sounds")) {
+            if (!isObject) places.push_back({Place::TARGET_ARRAY, placeKey});
+            else skipDepth = 1;
+        } else {
+            item = std::move(container);
+            itemStack.push_back(&item);
+        }
+        return true;
+    }
+
+    bool endContainer() {
+        if (skipDepth > 0) {
+            skipDepth--;
+            return true;
+        }
+        if (!itemStack.empty()) {
+            itemStack.pop_back();
+            if (itemStack.empty()) finishItem();
+            return true;
+        }
+        if (places.back().place == Place::TARGET) finishTarget();
+        places.pop_back();
+        return true;
+    }
+
+    void finishItem() {
+        const Frame &frame = places.back();
+        if (frame.place == Place::TARGET) {
+            target.properties[placeKey] = std::move(item);
+        } else if (frame.place == Place::MONITORS) {
+            Render::visibleVariables.push_back(loadMonitor(item));
+        } else if (frame.collection == "variables") {
+            target.variables.push_back(loadVariable(placeKey, item));
+        } else if (frame.collection == "blocks") {
+            target.blocks.push_back(loadBlock(target, placeKey, item));
+        } else if (frame.collection == "lists") {
+            target.lists.push_back(loadList(placeKey, item));
+        } else if (frame.collection == "comments") {
+            target.comments.push_back(loadComment(placeKey, item));
+        } else if (frame.collection == "broadcasts") {
+            Broadcast newBroadcast;
+            newBroadcast.id = placeKey;
+            newBroadcast.name = item;
+            target.broadcasts.push_back(newBroadcast);
+        } else if (frame.collection == "sounds") {
+            Sound newSound = loadSound(item);
+            target.sprite->sounds[newSound.name] = newSound;
+        } else if (frame.collection == "costumes") {
+            target.sprite->costumes.push_back(loadCostume(item));
+        }
+        item = nullptr;
+    }
+
+    void startTarget() {
+        target = LoadingTarget();
+        target.sprite = MemoryTracker::allocate<Sprite>();
+        new (target.sprite) Sprite();
+        target.sprite->id = Math::generateRandomString(15);
+    }
+
+    void finishTarget() {
+        Sprite *newSprite = target.sprite;
+        loadSpriteProperties(newSprite, target.properties);
+
+        std::stable_sort(target.variables.begin(), target.variables.end(), [](const Variable &a, const Variable &b) { return a.id < b.id; });
+        for (const Variable &variable : target.variables) {
+            newSprite->variableIdsByName[variable.name] = variable.id;
+        }
+        addInJsonOrder(newSprite->variables, target.variables, &Variable::id, &Variable::id);
+        addInJsonOrder(newSprite->blocks, target.blocks, &Block::id, &Block::id);
+        // custom blocks get added in the order of their prototype blocks
+        addInJsonOrder(newSprite->customBlocks, target.customBlocks, &CustomBlock::blockId, &CustomBlock::name);
+        addInJsonOrder(newSprite->lists, target.lists, &List::id, &List::id);
+        addInJsonOrder(newSprite->comments, target.comments, &Comment::id, &Comment::id);
+        addInJsonOrder(newSprite->broadcasts, target.broadcasts, &Broadcast::id, &Broadcast::id);
+
+        sprites.push_back(newSprite);
+        target = LoadingTarget();
+    }
+};
+
+/**
+ * Undoes whatever got loaded from a project.json that turned out not to be valid JSON.
+ */
+static bool finishParsing(bool parsed, ProjectParser &parser) {
+    if (parsed) return true;
+
+    parser.cleanup();
+    cleanupSprites();
+    Render::visibleVariables.clear();
+#ifdef ENABLE_CLOUDVARS
+    cloudProject = false;
+#endif
+    return false;
+}
+
+bool ProjectLoader::load(const char *json, size_t size) {
+    Log::log("beginning to load sprites...");
+    sprites.reserve(400);
+    ProjectParser parser;
+    return finishParsing(nlohmann::json::sax_parse(json, json + size, &parser), parser);
+}
+
+bool ProjectLoader::load(std::istream &file) {
+    Log::log("beginning to load sprites...");
+    sprites.reserve(400);
+    ProjectParser parser;
+    return finishParsing(nlohmann::json::sax_parse(file, &parser), parser);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <istream>
+
+/**
+ * Loads every Sprite and monitor from a Scratch project.json while it's being parsed,
+ * one block, variable or list at a time, so the whole file never has to be kept parsed in memory.
+ * `setupSprites()` has to run afterwards.
+ */
+class ProjectLoader {
+  public:
+    /**
+     * Loads the project from a project.json in memory.
+     * @param json
+     * @param size
+     * @return `true` if the project.json could be parsed.
+     */
+    static bool load(const char *json, size_t size);
+
+    /**
+     * Loads the project from a project.json file.
+     * @param file
+     * @return `true` if the project.json could be parsed.
+     */
+    static bool load(std::istream &file);
+};
@@ -51,6 +51,16 @@ class Render {
      */
     static int getHeight();
 
+    /**
+     * Gets how many times a second the screen can show a new frame.
+     */
+    static int getRefreshRate();
+
+    /**
+     * Checks if presenting a frame waits for the screen to refresh, which paces drawing by itself.
+     */
+    static bool hasVsync();
+
     /**
      * Renders every sprite to the screen.
      */
@@ -68,16 +78,6 @@ class Render {
      */
     static bool appShouldRun();
 
-    /**
-     * Returns whether or not enough time has passed to advance a frame.
-     * @return True if we should go to the next frame, False otherwise.
-     */
-    static bool checkFramerate() {
-        static Timer frameTimer;
-        int frameDuration = 1000 / Scratch::FPS;
-        return frameTimer.hasElapsedAndRestart(frameDuration);
-    }
-
     enum RenderModes {
         TOP_SCREEN_ONLY,
         BOTTOM_SCREEN_ONLY,
@@ -0,0 +1,25 @@
+#include "renderState.hpp"
+#include "lruCache.hpp"
+#include "penLayer.hpp"
+
+uint64_t RenderState::version = 1;
+bool RenderState::redrawn = false;
+
+static uint64_t drawnVersion = 0;
+
+bool RenderState::shouldRedraw() {
+    redrawn = version != drawnVersion || PenLayer::hasQueued();
+    if (!redrawn) return false;
+    drawnVersion = version;
+    LruCache::markDrawn();
+    return true;
+}
+
+bool RenderState::isVisualOpcode(const std::string &opcode) {
+    return opcode.compare(0, 7, "motion_") == 0 ||
+           opcode.compare(0, 6, "looks_") == 0 ||
+           opcode.compare(0, 4, "pen_") == 0 ||
+           opcode == "control_create_clone_of" ||
+           opcode == "control_delete_this_clone" ||
+           opcode == "sensing_askandwait";
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/**
+ * Keeps track of whether anything on screen changed, so renderers can skip frames where nothing did.
+ */
+class RenderState {
+  private:
+    static bool redrawn;
+
+  public:
+    /**
+     * Goes up every time something that changes what's on screen changes.
+     */
+    static uint64_t version;
+
+    /**
+     * Marks the screen as needing to be redrawn.
+     */
+    static void markChanged() { version++; }
+
+    /**
+     * Checks if the screen has to be redrawn since the last time this returned `true`.
+     * Variables and lists shown by a visible monitor mark the screen as changed themselves when they change.
+     * @return `true` if something changed.
+     */
+    static bool shouldRedraw();
+
+    /**
+     * Checks if the last call to `shouldRedraw()` returned `true`, so the last frame got drawn and presented.
+     */
+    static bool didRedraw() { return redrawn; }
+
+    /**
+     * Checks if running a block can change what's on screen. Used once per block when the project loads, to set `Block::visual`.
+     * @param opcode
+     * @return `true` if running a block with `opcode` has to redraw the screen.
+     */
+    static bool isVisualOpcode(const std::string &opcode);
+};
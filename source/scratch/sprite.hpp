@@ -2,20 +2,22 @@
 #include "os.hpp"
 #include "value.hpp"
 #include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class Sprite;
+struct List;
 
 struct Variable {
     std::string id;
     std::string name;
-#ifdef ENABLE_CLOUDVARS
-    bool cloud;
-#endif
+    bool cloud = false; // kept even without ENABLE_CLOUDVARS, so project caches work with builds that have it
     Value value;
+    bool monitored = false; // shown by a visible monitor, so changing it has to redraw the screen
 };
 
 struct ParsedInput {
@@ -34,6 +36,17 @@ struct ParsedInput {
     ParsedInput() : inputType(LITERAL), literalValue(Value(0)) {}
 };
 
+struct ParsedField {
+    std::string name;
+    std::string value; // what's picked in the field, like a menu option or the name of a variable
+    std::string id;    // the variable, list or broadcast that's picked, if the field picks one
+
+    // the variable or list `id` picks, found when the project loads (or a clone gets made) instead of on every run
+    Variable *variable = nullptr;
+    List *list = nullptr;
+    Sprite *localTo = nullptr; // the sprite it belongs to if it isn't the Stage's, since a clone's inputs still run the original's blocks
+};
+
 struct Block {
 
     std::string id;
@@ -43,10 +56,11 @@ struct Block {
     std::string parent;
     std::string blockChainID;
     std::map<std::string, ParsedInput> parsedInputs;
-    std::unordered_map<std::string, nlohmann::json> fields;
-    std::unordered_map<std::string, nlohmann::json> mutation;
+    std::vector<ParsedField> fields; // blocks only have one or two, so looking through them beats hashing
+    std::string procCode;            // the custom block a 'procedures_call' or 'procedures_prototype' is for
     bool shadow;
     bool topLevel;
+    bool visual = false; // if running it can change what's on screen, worked out once by `RenderState::isVisualOpcode()`
     std::string topLevelParentBlock;
 
     /* variables that some blocks need*/
@@ -62,6 +76,34 @@ struct Block {
     std::vector<std::pair<Block *, Sprite *>> broadcastsRun;
     std::vector<std::string> substackBlocksRan;
     std::string waitingIfBlock = "";
+
+    /* cached target of an object menu ('go to', 'distance to', 'create clone of', ...) */
+    bool objectMenuResolved = false;
+    std::string objectMenuName;
+    Sprite *objectMenuSprite = nullptr;
+
+    /**
+     * Finds one of the block's fields.
+     * @param name
+     * @return The field, or `nullptr` if the block doesn't have one with that name.
+     */
+    const ParsedField *findField(const char *name) const {
+        for (const ParsedField &field : fields) {
+            if (field.name == name) return &field;
+        }
+        return nullptr;
+    }
+
+    /**
+     * Gets one of the block's fields.
+     * @param name
+     * @return The field, or an empty one if the block doesn't have one with that name.
+     */
+    const ParsedField &getField(const char *name) const {
+        static const ParsedField empty;
+        const ParsedField *field = findField(name);
+        return field != nullptr ? *field : empty;
+    }
 };
 
 struct CustomBlock {
@@ -80,6 +122,7 @@ struct List {
     std::string id;
     std::string name;
     std::vector<Value> items;
+    bool monitored = false; // shown by a visible monitor, so changing it has to redraw the screen
 };
 
 struct Sound {
@@ -137,6 +180,53 @@ struct Monitor {
     bool isDiscrete;
 };
 
+struct GraphicEffects {
+    // the values set by the looks blocks, all 0 when there's no effect
+    double color = 0;
+    double brightness = 0;
+    double fisheye = 0;
+    double whirl = 0;
+    double pixelate = 0;
+    double mosaic = 0;
+};
+
+struct SoundEffects {
+    // the values set by the sound blocks, all 0 when there's no effect
+    double pitch = 0;
+    double pan = 0;
+};
+
+struct PenState {
+    bool down = false;
+    double size = 1;
+
+    // Scratch's pen color, all 0-100
+    double color = 66.66;
+    double saturation = 100;
+    double brightness = 100;
+    double transparency = 0;
+    double shade = 50; // only used by the old Scratch 2 shade blocks
+
+    // the color above as RGBA, updated whenever it changes
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 255;
+    uint8_t a = 255;
+
+    // where the last pen line ended
+    double lastX = 0;
+    double lastY = 0;
+};
+
+struct InterpolationState {
+    bool valid = false; // false until the first tick snapshot, so new clones don't slide in from somewhere
+    double xPosition = 0;
+    double yPosition = 0;
+    double rotation = 0;
+    double size = 0;
+    int costume = 0;
+};
+
 class Sprite {
   public:
     std::string name;
@@ -151,16 +241,19 @@ class Sprite {
     int currentCostume;
     std::string lastCostumeId = "";
     float volume;
+    SoundEffects soundEffects;
     double xPosition;
     double yPosition;
     int rotationCenterX;
     int rotationCenterY;
     double size;
     double rotation;
-    int layer;
+    int layer; // only used to build the draw order when loading
+    Sprite *layerBelow = nullptr;
+    Sprite *layerAbove = nullptr;
 
     float ghostEffect;
-    double colorEffect = -99999;
+    GraphicEffects effects;
 
     enum RotationStyle {
         NONE,
@@ -169,11 +262,14 @@ class Sprite {
     };
 
     RotationStyle rotationStyle;
+    PenState pen;
+    InterpolationState interpolation; // where the sprite was at the start of the last tick
     std::vector<std::pair<double, double>> collisionPoints;
     int spriteWidth;
     int spriteHeight;
 
     std::unordered_map<std::string, Variable> variables;
+    std::unordered_map<std::string, std::string> variableIdsByName;
     std::unordered_map<std::string, Block> blocks;
     std::unordered_map<std::string, List> lists;
     std::unordered_map<std::string, Sound> sounds;
@@ -185,6 +281,7 @@ class Sprite {
 
     ~Sprite() {
         variables.clear();
+        variableIdsByName.clear();
         blocks.clear();
         lists.clear();
         sounds.clear();
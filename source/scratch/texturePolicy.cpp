@@ -0,0 +1,184 @@
+#include "texturePolicy.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+bool TexturePolicy::enabled = false;
+
+// costumes are stored at full size, or shrunk to 1/2 or 1/4, so a sprite that keeps growing only makes them load again twice
+static constexpr double MIN_SCALE = 0.25;
+
+// the biggest each costume has been drawn, in screen pixels per costume pixel
+static std::unordered_map<std::string, double> maxScales;
+static std::vector<std::string> reloads;
+
+TexturePolicy::Layout TexturePolicy::getFullLayout(int width, int height) {
+    Layout layout;
+    layout.width = width;
+    layout.height = height;
+    layout.textureWidth = width;
+    layout.textureHeight = height;
+    return layout;
+}
+
+TexturePolicy::Layout TexturePolicy::plan(const uint8_t *rgba, int width, int height, double scale) {
+    // find the smallest rectangle with every visible pixel in it
+    int minX = width, minY = height, maxX = -1, maxY = -1;
+    for (int y = 0; y < height; y++) {
+        const uint8_t *row = rgba + static_cast<size_t>(y) * width * 4;
+        for (int x = 0; x < width; x++) {
+            if (row[x * 4 + 3] == 0) continue;
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+        }
+    }
+
+    Layout layout;
+    if (maxX == -1) {
+        // nothing to see, but keep a pixel so it still has a texture
+        layout.width = 1;
+        layout.height = 1;
+    } else {
+        layout.x = minX;
+        layout.y = minY;
+        layout.width = maxX - minX + 1;
+        layout.height = maxY - minY + 1;
+    }
+    layout.scale = scale;
+    layout.textureWidth = std::max(1, static_cast<int>(std::ceil(layout.width * scale)));
+    layout.textureHeight = std::max(1, static_cast<int>(std::ceil(layout.height * scale)));
+
+    bool opaque = true;
+    bool oneColor = true;
+    bool foundColor = false;
+    uint32_t color = 0;
+    for (int y = layout.y; y < layout.y + layout.height; y++) {
+        const uint8_t *row = rgba + (static_cast<size_t>(y) * width + layout.x) * 4;
+        for (int x = 0; x < layout.width; x++) {
+            const uint8_t *pixel = &row[x * 4];
+            if (pixel[3] != 255) opaque = false;
+            if (pixel[3] == 0 || !oneColor) continue;
+
+            uint32_t pixelColor;
+            std::memcpy(&pixelColor, pixel, 4);
+            pixelColor &= 0x00FFFFFF;
+            if (!foundColor) {
+                color = pixelColor;
+                foundColor = true;
+            } else if (pixelColor != color) {
+                oneColor = false;
+            }
+        }
+    }
+
+    if (oneColor) {
+        layout.format = A8;
+        layout.color = color;
+    } else if (opaque) {
+        layout.format = RGB565;
+    } else {
+        layout.format = RGBA4444;
+    }
+    return layout;
+}
+
+static uint8_t reduceBits(uint8_t value, int bits) {
+    const int max = (1 << bits) - 1;
+    const int reduced = (value * max + 127) / 255;
+    return static_cast<uint8_t>((reduced * 255 + max / 2) / max);
+}
+
+std::vector<uint8_t> TexturePolicy::apply(const Layout &layout, const uint8_t *rgba, int width) {
+    std::vector<uint8_t> out(static_cast<size_t>(layout.textureWidth) * layout.textureHeight * 4);
+
+    for (int y = 0; y < layout.textureHeight; y++) {
+        const int startY = layout.y + y * layout.height / layout.textureHeight;
+        const int endY = std::max(startY + 1, layout.y + (y + 1) * layout.height / layout.textureHeight);
+        for (int x = 0; x < layout.textureWidth; x++) {
+            const int startX = layout.x + x * layout.width / layout.textureWidth;
+            const int endX = std::max(startX + 1, layout.x + (x + 1) * layout.width / layout.textureWidth);
+
+            // average the pixels this one covers with premultiplied alpha, so transparent ones don't darken the edges
+            uint32_t red = 0, green = 0, blue = 0, alpha = 0;
+            for (int sourceY = startY; sourceY < endY; sourceY++) {
+                for (int sourceX = startX; sourceX < endX; sourceX++) {
+                    const uint8_t *pixel = &rgba[(static_cast<size_t>(sourceY) * width + sourceX) * 4];
+                    red += pixel[0] * pixel[3];
+                    green += pixel[1] * pixel[3];
+                    blue += pixel[2] * pixel[3];
+                    alpha += pixel[3];
+                }
+            }
+            const uint32_t count = (endX - startX) * (endY - startY);
+
+            uint8_t *pixel = &out[(static_cast<size_t>(y) * layout.textureWidth + x) * 4];
+            pixel[3] = static_cast<uint8_t>((alpha + count / 2) / count);
+            if (alpha > 0) {
+                pixel[0] = static_cast<uint8_t>((red + alpha / 2) / alpha);
+                pixel[1] = static_cast<uint8_t>((green + alpha / 2) / alpha);
+                pixel[2] = static_cast<uint8_t>((blue + alpha / 2) / alpha);
+            }
+
+            switch (layout.format) {
+            case RGBA4444:
+                for (int channel = 0; channel < 4; channel++) {
+                    pixel[channel] = reduceBits(pixel[channel], 4);
+                }
+                break;
+            case RGB565:
+                pixel[0] = reduceBits(pixel[0], 5);
+                pixel[1] = reduceBits(pixel[1], 6);
+                pixel[2] = reduceBits(pixel[2], 5);
+                pixel[3] = 255;
+                break;
+            case A8:
+                std::memcpy(pixel, &layout.color, 3);
+                break;
+            case RGBA8888:
+                break;
+            }
+        }
+    }
+    return out;
+}
+
+size_t TexturePolicy::getMemorySize(const Layout &layout) {
+    size_t bytesPerPixel = 4;
+    if (layout.format == RGBA4444 || layout.format == RGB565) bytesPerPixel = 2;
+    else if (layout.format == A8) bytesPerPixel = 1;
+    return static_cast<size_t>(layout.textureWidth) * layout.textureHeight * bytesPerPixel;
+}
+
+double TexturePolicy::getScale(const std::string &costumeId) {
+    auto scaleFind = maxScales.find(costumeId);
+    if (scaleFind == maxScales.end()) return 1.0;
+
+    double scale = 1.0;
+    while (scale > MIN_SCALE && scale / 2 >= scaleFind->second) {
+        scale /= 2;
+    }
+    return scale;
+}
+
+void TexturePolicy::observeScale(const std::string &costumeId, const std::string &fileName, double screenScale, const Layout &layout) {
+    double &maxScale = maxScales[costumeId];
+    if (screenScale > maxScale) maxScale = screenScale;
+
+    if (getScale(costumeId) == layout.scale) return;
+    if (std::find(reloads.begin(), reloads.end(), fileName) == reloads.end()) reloads.push_back(fileName);
+}
+
+std::vector<std::string> TexturePolicy::takeReloads() {
+    std::vector<std::string> taken;
+    taken.swap(reloads);
+    return taken;
+}
+
+void TexturePolicy::reset() {
+    enabled = false;
+    maxScales.clear();
+    reloads.clear();
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * An opt-in way of storing costumes in less memory, for consoles that can't fit big projects otherwise.
+ * Fully transparent borders get trimmed off, costumes are kept no bigger than they've been drawn on screen,
+ * and 16 or 8 bit formats get used instead of 32 bit RGBA when the costume allows it.
+ */
+class TexturePolicy {
+  public:
+    enum Format {
+        RGBA8888,
+        RGBA4444, // costumes with transparency
+        RGB565,   // costumes without any transparency
+        A8        // costumes that are all one color, with only the opacity changing
+    };
+
+    // which part of a costume gets stored, and how
+    struct Layout {
+        int x = 0; // where the stored part starts in the costume, in costume pixels
+        int y = 0;
+        int width = 0; // size of the stored part, in costume pixels
+        int height = 0;
+        int textureWidth = 0; // size it's stored at, which is smaller than `width` if the costume was shrunk
+        int textureHeight = 0;
+        double scale = 1.0; // the `getScale()` it was stored at
+        Format format = RGBA8888;
+        uint32_t color = 0; // for `A8`, the RGBA bytes every pixel has, apart from the alpha
+    };
+
+    // if costumes get stored this way, set from the project settings
+    static bool enabled;
+
+    /**
+     * Gets a layout that stores a whole costume as it is.
+     * @param width
+     * @param height
+     * @return The layout.
+     */
+    static Layout getFullLayout(int width, int height);
+
+    /**
+     * Works out how to store a costume.
+     * @param rgba The decoded costume, 4 bytes per pixel with straight alpha.
+     * @param width
+     * @param height
+     * @param scale From `getScale()`.
+     * @return The layout to pass to `apply()`.
+     */
+    static Layout plan(const uint8_t *rgba, int width, int height, double scale);
+
+    /**
+     * Trims, shrinks and reduces the precision of a costume, as planned.
+     * @param layout
+     * @param rgba The decoded costume, 4 bytes per pixel with straight alpha.
+     * @param width
+     * @return `layout.textureWidth * layout.textureHeight` pixels, still 4 bytes each so any renderer can show them,
+     *         but with only as much precision as `layout.format` can hold.
+     */
+    static std::vector<uint8_t> apply(const Layout &layout, const uint8_t *rgba, int width);
+
+    /**
+     * Gets how much memory a costume stored with a layout takes.
+     * @param layout
+     * @return size in bytes.
+     */
+    static size_t getMemorySize(const Layout &layout);
+
+    /**
+     * Gets the size a costume should be stored at, from the biggest it's been drawn so far.
+     * Only call from the main thread.
+     * @param costumeId
+     * @return 1 if it's been drawn at full size or bigger (or not at all yet), otherwise 1/2 or 1/4.
+     */
+    static double getScale(const std::string &costumeId);
+
+    /**
+     * Remembers how big a costume got drawn, and queues it to be loaded again if it should now be stored at another size.
+     * @param costumeId
+     * @param fileName File name of the costume in the project, to load it again.
+     * @param screenScale Screen pixels per costume pixel.
+     * @param layout How the costume is stored right now.
+     */
+    static void observeScale(const std::string &costumeId, const std::string &fileName, double screenScale, const Layout &layout);
+
+    /**
+     * Takes the costumes `observeScale()` queued to be loaded again.
+     * @return Their file names.
+     */
+    static std::vector<std::string> takeReloads();
+
+    /**
+     * Forgets how big every costume got drawn, and turns the policy off, for when the project is closed.
+     */
+    static void reset();
+};
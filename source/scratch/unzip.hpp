@@ -1,5 +1,7 @@
 #include "interpret.hpp"
 #include "os.hpp"
+#include "projectCache.hpp"
+#include "projectLoader.hpp"
 #include <filesystem>
 #include <fstream>
 #ifdef GAMECUBE
@@ -18,7 +20,20 @@ class Unzip {
     static volatile bool threadFinished;
     static std::string filePath;
     static mz_zip_archive zipArchive;
-    static std::vector<char> zipBuffer;
+    static std::string archivePath; // the sb3 `openFile()` found, if the project isn't unzipped
+
+    /**
+     * Opens an sb3 into `zipArchive` without reading all of it into memory.
+     * PC maps the file into memory; everywhere else, files get read from disk when they're extracted.
+     * @param path
+     * @return `true` if the sb3 was opened.
+     */
+    static bool openArchive(const std::string &path);
+
+    /**
+     * Closes the sb3 opened by `openArchive()`.
+     */
+    static void closeArchive();
 
     static void openScratchProject(void *arg) {
         loadingState = "Opening Scratch project";
@@ -36,15 +51,30 @@ class Unzip {
             return;
         }
         loadingState = "Unzipping Scratch project";
-        nlohmann::json project_json = unzipProject(&file);
-        if (project_json.empty()) {
-            Log::logError("Project.json is empty.");
-            Unzip::projectOpened = -2;
-            Unzip::threadFinished = true;
-            return;
+        if (projectType != UNZIPPED) {
+            // the sb3 gets opened again by path, so it doesn't have to be read into memory all at once
+            file.close();
+            Log::log("Opening SB3 file...");
+            if (!openArchive(archivePath)) {
+                Log::logError("Failed to open SB3 file.");
+                Unzip::projectOpened = -2;
+                Unzip::threadFinished = true;
+                return;
+            }
+        }
+
+        // a cache from an earlier launch skips parsing project.json
+        if (!ProjectCache::load()) {
+            if (!unzipProject(&file)) {
+                Log::logError("Failed to load project.json.");
+                Unzip::projectOpened = -2;
+                Unzip::threadFinished = true;
+                return;
+            }
+            ProjectCache::save();
         }
         loadingState = "Loading Sprites";
-        loadSprites(project_json);
+        setupSprites();
         Unzip::projectOpened = 1;
         Unzip::threadFinished = true;
         return;
@@ -97,49 +127,33 @@ class Unzip {
     }
 #endif
 
-    static nlohmann::json unzipProject(std::ifstream *file) {
+    static bool unzipProject(std::ifstream *file) {
 
-        nlohmann::json project_json;
+        bool loaded;
 
         if (projectType != UNZIPPED) {
-            // read the file
-            Log::log("Reading SB3...");
-            std::streamsize size = file->tellg(); // gets the size of the file
-            file->seekg(0, std::ios::beg);        // go to the beginning of the file
-            zipBuffer.resize(size);
-            if (!file->read(zipBuffer.data(), size)) {
-                return project_json;
-            }
-            size_t bufferSize = zipBuffer.size();
-
-            // Track memory
-            MemoryTracker::allocate(bufferSize);
-
-            // open ZIP file from the thing that we just did
-            Log::log("Opening SB3 file...");
-            memset(&zipArchive, 0, sizeof(zipArchive));
-            if (!mz_zip_reader_init_mem(&zipArchive, zipBuffer.data(), zipBuffer.size(), 0)) {
-                return project_json;
-            }
-
             // extract project.json
             Log::log("Extracting project.json...");
             int file_index = mz_zip_reader_locate_file(&zipArchive, "project.json", NULL, 0);
             if (file_index < 0) {
-                return project_json;
+                return false;
             }
 
             size_t json_size;
             const char *json_data = static_cast<const char *>(mz_zip_reader_extract_to_heap(&zipArchive, file_index, &json_size, 0));
+            if (json_data == nullptr) {
+                return false;
+            }
 
 #ifdef ENABLE_CLOUDVARS
             projectJSON = std::string(json_data, json_size);
 #endif
 
-            // Parse JSON file
+            // sprites get loaded while the JSON is parsed, it never gets parsed into one big document
             Log::log("Parsing project.json...");
+            loadingState = "Loading Sprites";
             MemoryTracker::allocate(json_size);
-            project_json = nlohmann::json::parse(std::string(json_data, json_size));
+            loaded = ProjectLoader::load(json_data, json_size);
             mz_free((void *)json_data);
             MemoryTracker::deallocate(nullptr, json_size);
 
@@ -149,13 +163,16 @@ class Unzip {
             // if project is unzipped
             file->clear();                 // Clear any EOF flags
             file->seekg(0, std::ios::beg); // Go to the start of the file
+            loadingState = "Loading Sprites";
 #ifdef ENABLE_CLOUDVARS
             projectJSON = {std::istreambuf_iterator<char>(*file), std::istreambuf_iterator<char>()};
+            loaded = ProjectLoader::load(projectJSON.data(), projectJSON.size());
+#else
+            loaded = ProjectLoader::load(*file);
 #endif
-            (*file) >> project_json;
         }
         Image::loadImages(&zipArchive);
-        return project_json;
+        return loaded;
     }
 
     static int openFile(std::ifstream *file);
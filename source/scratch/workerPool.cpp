@@ -0,0 +1,174 @@
+#include "workerPool.hpp"
+#include "os.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifdef HEADLESS_BUILD
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#elif !defined(__3DS__)
+#include <SDL2/SDL.h>
+#endif
+
+// more threads than this just fight over memory bandwidth
+#define MAX_WORKER_THREADS 8
+
+int WorkerPool::getThreadCount() {
+#ifdef __3DS__
+    return 1;
+#elif defined(HEADLESS_BUILD)
+    return std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, MAX_WORKER_THREADS);
+#else
+    return std::clamp(SDL_GetCPUCount(), 1, MAX_WORKER_THREADS);
+#endif
+}
+
+static void runOnCallingThread(size_t jobCount, const std::function<void(size_t)> &work, const std::function<void(size_t)> &finish) {
+    for (size_t i = 0; i < jobCount; i++) {
+        work(i);
+        finish(i);
+    }
+}
+
+#ifdef __3DS__
+
+void WorkerPool::run(size_t jobCount, const std::function<void(size_t)> &work, const std::function<void(size_t)> &finish) {
+    runOnCallingThread(jobCount, work, finish);
+}
+
+#else
+
+struct PoolState {
+    const std::function<void(size_t)> *work;
+    size_t jobCount;
+    size_t nextJob = 0;
+    std::vector<size_t> finishedJobs;
+#ifdef HEADLESS_BUILD
+    std::mutex mutex;
+    std::condition_variable condition;
+#else
+    SDL_mutex *mutex;
+    SDL_cond *condition;
+#endif
+};
+
+static void lockPool(PoolState &state) {
+#ifdef HEADLESS_BUILD
+    state.mutex.lock();
+#else
+    SDL_LockMutex(state.mutex);
+#endif
+}
+
+static void unlockPool(PoolState &state) {
+#ifdef HEADLESS_BUILD
+    state.mutex.unlock();
+#else
+    SDL_UnlockMutex(state.mutex);
+#endif
+}
+
+static int workerThread(void *data) {
+    PoolState &state = *static_cast<PoolState *>(data);
+    lockPool(state);
+    while (state.nextJob < state.jobCount) {
+        const size_t job = state.nextJob++;
+        unlockPool(state);
+        (*state.work)(job);
+        lockPool(state);
+
+        state.finishedJobs.push_back(job);
+#ifdef HEADLESS_BUILD
+        state.condition.notify_one();
+#else
+        SDL_CondSignal(state.condition);
+#endif
+    }
+    unlockPool(state);
+    return 0;
+}
+
+void WorkerPool::run(size_t jobCount, const std::function<void(size_t)> &work, const std::function<void(size_t)> &finish) {
+    const size_t threadCount = std::min(static_cast<size_t>(getThreadCount()), jobCount);
+    if (threadCount <= 1) {
+        runOnCallingThread(jobCount, work, finish);
+        return;
+    }
+
+    PoolState state;
+    state.work = &work;
+    state.jobCount = jobCount;
+
+#ifdef HEADLESS_BUILD
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < threadCount; i++) {
+        threads.emplace_back(workerThread, &state);
+    }
+#else
+    state.mutex = SDL_CreateMutex();
+    state.condition = SDL_CreateCond();
+    if (!state.mutex || !state.condition) {
+        if (state.mutex) SDL_DestroyMutex(state.mutex);
+        if (state.condition) SDL_DestroyCond(state.condition);
+        runOnCallingThread(jobCount, work, finish);
+        return;
+    }
+
+    std::vector<SDL_Thread *> threads;
+    for (size_t i = 0; i < threadCount; i++) {
+        SDL_Thread *thread = SDL_CreateThread(workerThread, "Worker", &state);
+        if (!thread) {
+            Log::logWarning("Failed to create SDL thread: " + std::string(SDL_GetError()));
+            break;
+        }
+        threads.push_back(thread);
+    }
+    if (threads.empty()) {
+        SDL_DestroyMutex(state.mutex);
+        SDL_DestroyCond(state.condition);
+        runOnCallingThread(jobCount, work, finish);
+        return;
+    }
+#endif
+
+    size_t finishedCount = 0;
+    std::vector<size_t> finishedJobs;
+    while (finishedCount < jobCount) {
+#ifdef HEADLESS_BUILD
+        {
+            std::unique_lock<std::mutex> lock(state.mutex);
+            state.condition.wait(lock, [&state] { return !state.finishedJobs.empty(); });
+            finishedJobs.swap(state.finishedJobs);
+        }
+#else
+        SDL_LockMutex(state.mutex);
+        while (state.finishedJobs.empty()) {
+            SDL_CondWait(state.condition, state.mutex);
+        }
+        finishedJobs.swap(state.finishedJobs);
+        SDL_UnlockMutex(state.mutex);
+#endif
+
+        for (size_t job : finishedJobs) {
+            finish(job);
+        }
+        finishedCount += finishedJobs.size();
+        finishedJobs.clear();
+    }
+
+#ifdef HEADLESS_BUILD
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+#else
+    for (SDL_Thread *thread : threads) {
+        SDL_WaitThread(thread, nullptr);
+    }
+    SDL_DestroyMutex(state.mutex);
+    SDL_DestroyCond(state.condition);
+#endif
+}
+
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+/**
+ * Spreads independent jobs (like decoding costumes) over worker threads.
+ */
+class WorkerPool {
+  public:
+    /**
+     * Runs `work` for every job on worker threads, and `finish` on the calling thread for each job that's done.
+     * `finish` runs as soon as its job is done while the others keep going, so it's the place for anything
+     * only the main thread can do, like making textures. Returns once every job has finished.
+     * Platforms without threads to spare run both on the calling thread, one job after another.
+     * @param jobCount
+     * @param work Gets the index of the job. Can't touch anything that other jobs or the calling thread use.
+     * @param finish Gets the index of the job.
+     */
+    static void run(size_t jobCount, const std::function<void(size_t)> &work, const std::function<void(size_t)> &finish);
+
+    /**
+     * Gets how many worker threads `run()` uses at most.
+     */
+    static int getThreadCount();
+};
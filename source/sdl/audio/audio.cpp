@@ -1,12 +1,19 @@
-
 #include "../scratch/audio.hpp"
+#include "../scratch/audioMixer.hpp"
 #include "../scratch/os.hpp"
 #include "audio.hpp"
 #include "interpret.hpp"
 #include "miniz/miniz.h"
 #include "sprite.hpp"
+#include <deque>
+#include <fstream>
 #include <string>
 #include <unordered_map>
+#include <vector>
+#ifdef ENABLE_AUDIO
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_thread.h>
+#endif
 #ifdef __3DS__
 #include <3ds.h>
 #endif
@@ -15,7 +22,7 @@ std::unordered_map<std::string, SDL_Audio *> SDL_Sounds;
 std::string currentStreamedSound = "";
 
 #ifdef ENABLE_AUDIO
-SDL_Audio::SDL_Audio() : audioChunk(nullptr) {}
+SDL_Audio::SDL_Audio() : audioChunk(nullptr), music(nullptr) {}
 #endif
 
 SDL_Audio::~SDL_Audio() {
@@ -28,224 +35,480 @@ SDL_Audio::~SDL_Audio() {
         audioChunk = nullptr;
     }
     if (music != nullptr) {
-        // Mix_FreeMusic(music);
-        // music = nullptr;
+        // stops it first if it's playing, which has to happen before musicData goes away
+        Mix_FreeMusic(music);
+        music = nullptr;
     }
 #endif
 }
 
-// code down here kinda messy,,, TODO fix that
-
-int soundLoaderThread(void *data) {
-    SDL_Audio::SoundLoadParams *params = static_cast<SDL_Audio::SoundLoadParams *>(data);
-    bool success = false;
-    if (projectType != UNZIPPED)
-        success = params->player->loadSoundFromSB3(params->sprite, params->zip, params->soundId, params->streamed);
-    else
-        success = params->player->loadSoundFromFile(params->sprite, "project/" + params->soundId, params->streamed);
-
-    delete params;
+#ifdef ENABLE_AUDIO
 
-    return success ? 0 : 1;
-}
+// threads decoding sounds at once, since more of them just fight over the SD card and the audio thread
+#if defined(__3DS__) || defined(__OGC__) || defined(__WIIU__) || defined(VITA)
+#define SOUND_LOADER_THREADS 1
+#else
+#define SOUND_LOADER_THREADS 2
+#endif
 
-void NDS_soundLoaderThread(void *data) {
-    SDL_Audio::SoundLoadParams *params = static_cast<SDL_Audio::SoundLoadParams *>(data);
-    if (projectType != UNZIPPED)
-        params->player->loadSoundFromSB3(params->sprite, params->zip, params->soundId, params->streamed);
-    else
-        params->player->loadSoundFromFile(params->sprite, "project/" + params->soundId, params->streamed);
+// sounds read into memory and waiting for, or being decoded by, a loader thread
+#define MAX_SOUND_JOBS_PENDING (SOUND_LOADER_THREADS * 2)
 
-    delete params;
+// fraction of the RAM budget loaded sounds can take before the least recently played ones get freed
+#if defined(__3DS__) || defined(__OGC__)
+#define SOUND_BUDGET_FRACTION 0.125
+#else
+#define SOUND_BUDGET_FRACTION 0.25
+#endif
 
-    return;
+// loaded sounds by when they were last played. They don't expire, and only get freed when over the budget
+static LruCache soundCache(0);
+
+// sounds that aren't streamed play through `AudioMixer`, for the pitch and pan effects
+enum MixerState {
+    MIXER_NOT_STARTED,
+    MIXER_RUNNING,
+    MIXER_UNSUPPORTED // the audio device has a format the mixer can't write, so SDL_mixer channels get used instead
+};
+static MixerState mixerState = MIXER_NOT_STARTED;
+static int mixerChannels = 2;
+static SDL_mutex *mixerMutex = nullptr;
+
+struct SoundLoadJob {
+    std::string soundId;
+    std::string path; // the file to load, if it isn't in the sb3
+    std::vector<char> data; // otherwise the file, read from the sb3 on the main thread
+    bool streamed = false;
+    Mix_Chunk *chunk = nullptr;
+    Mix_Music *music = nullptr;
+};
+
+// a sound that was asked for but isn't loaded yet. Only the main thread touches these
+struct PendingSound {
+    bool streamed;
+    bool play;   // a script is waiting for it, instead of it being preloaded
+    float volume;
+    bool dispatched; // handed to a loader thread already
+    mz_zip_archive *zip;
+};
+
+static std::unordered_map<std::string, PendingSound> pendingSounds;
+static std::deque<std::string> playQueue;    // sounds scripts asked for, loaded first
+static std::deque<std::string> preloadQueue; // sounds that might get played, loaded while there's memory to spare
+static size_t dispatchedCount = 0;
+
+static SDL_mutex *loaderMutex = nullptr;
+static SDL_cond *loaderCondition = nullptr;
+static std::deque<SoundLoadJob *> loaderJobs;
+static std::deque<SoundLoadJob *> loaderResults;
+static int loaderThreadCount = 0;
+
+/**
+ * Checks if a sprite's sounds should be streamed instead of decoded into memory all at once.
+ */
+static bool shouldStream(Sprite *sprite) {
+#if defined(__OGC__) || defined(VITA)
+    return false; // streamed sounds crash on wii. vita does not like them either.
+#else
+    return sprite->isStage; // stage sprites get streamed audio
+#endif
 }
 
-void SoundPlayer::startSoundLoaderThread(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId) {
-#ifdef ENABLE_AUDIO
+/**
+ * Checks if a file is a sound SDL_mixer can load.
+ */
+static bool isSoundFile(const std::string &fileName) {
+    if (fileName.size() < 4) return false;
+    std::string ext = fileName.substr(fileName.size() - 4);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".mp3" || ext == ".wav" || ext == ".ogg";
+}
 
-    if (SDL_Sounds.find(soundId) != SDL_Sounds.end()) {
-        return;
+/**
+ * Gets a sound of the project ready to decode. Only call from the main thread, since it reads from the sb3.
+ * @return `false` if it isn't there.
+ */
+static bool readSoundFile(mz_zip_archive *zip, SoundLoadJob &job) {
+    if (projectType == UNZIPPED) {
+        // the loader thread can read these itself
+        job.path = "project/" + job.soundId;
+#if defined(__WIIU__) || defined(__OGC__)
+        job.path = "romfs:/" + job.path;
+#endif
+        std::error_code error;
+        return std::filesystem::exists(job.path, error);
     }
 
-    // SDL_Audio *audio = new SDL_Audio();
-    SDL_Audio *audio = MemoryTracker::allocate<SDL_Audio>();
-    new (audio) SDL_Audio();
-    SDL_Sounds[soundId] = audio;
+    if (!zip) return false;
+    int fileIndex = mz_zip_reader_locate_file(zip, job.soundId.c_str(), nullptr, 0);
+    if (fileIndex < 0) return false;
+    size_t fileSize;
+    void *fileData = mz_zip_reader_extract_to_heap(zip, fileIndex, &fileSize, 0);
+    if (!fileData || fileSize == 0) {
+        Log::logWarning("Failed to extract: " + job.soundId);
+        if (fileData) mz_free(fileData);
+        return false;
+    }
+    job.data.assign(static_cast<const char *>(fileData), static_cast<const char *>(fileData) + fileSize);
+    mz_free(fileData);
+    return true;
+}
 
-    SDL_Audio::SoundLoadParams *params = new SDL_Audio::SoundLoadParams{
-        .sprite = sprite,
-        .zip = zip,
-        .soundId = soundId,
-        .streamed = sprite->isStage}; // stage sprites get streamed audio
+/**
+ * Turns a sound file into something SDL_mixer can play. Doesn't touch anything shared, so it's safe on loader threads.
+ * @return `false` if the sound couldn't be decoded.
+ */
+static bool decodeSound(SoundLoadJob &job) {
+    if (!job.path.empty()) {
+        if (!job.streamed) job.chunk = Mix_LoadWAV(job.path.c_str());
+        else job.music = Mix_LoadMUS(job.path.c_str());
+
+        if (!job.chunk && !job.music) {
+            Log::logWarning("Failed to load audio file: " + job.path + " - SDL_mixer Error: " + Mix_GetError());
+            return false;
+        }
+        return true;
+    }
 
-#if defined(__OGC__) || defined(VITA)
-    params->streamed = false; // streamed sounds crash on wii. vita does not like them either.
-#endif
+    if (!job.streamed) {
+        SDL_RWops *rw = SDL_RWFromConstMem(job.data.data(), (int)job.data.size());
+        if (!rw) {
+            Log::logWarning("Failed to create RWops for: " + job.soundId);
+            return false;
+        }
+        // Log::log("Converting sound into SDL sound...");
+        job.chunk = Mix_LoadWAV_RW(rw, 1);
 
-// do 3DS threads so it can actually run in the background
-#ifdef __3DS__
-    s32 mainPrio = 0;
-    svcGetThreadPriority(&mainPrio, CUR_THREAD_HANDLE);
-
-    threadCreate(
-        NDS_soundLoaderThread,
-        params,
-        0x10000,
-        mainPrio + 1,
-        1,
-        true);
-#else
+        if (!job.chunk) {
+            Log::logWarning("Failed to load audio from memory: " + job.soundId + " - SDL_mixer Error: " + Mix_GetError());
+            return false;
+        }
+        return true;
+    }
 
-    SDL_Thread *thread = SDL_CreateThread(soundLoaderThread, "SoundLoader", params);
+    // streamed straight from the file in memory, which has to stay around until the music is freed
+    SDL_RWops *rw = SDL_RWFromConstMem(job.data.data(), (int)job.data.size());
+    if (!rw) {
+        Log::logWarning("Failed to create RWops for: " + job.soundId);
+        return false;
+    }
+    // Log::log("Converting sound into SDL streamed music...");
+    job.music = Mix_LoadMUS_RW(rw, 1);
 
-    if (!thread) {
-        Log::logWarning("Failed to create SDL thread: " + std::string(SDL_GetError()));
-    } else {
-        SDL_DetachThread(thread);
+    if (!job.music) {
+        Log::logWarning("Failed to load music from memory: " + job.soundId + " - SDL_mixer Error: " + Mix_GetError());
+        return false;
     }
-#endif
+    return true;
+}
 
-#endif
+static void mixAudio(void *userData, Uint8 *stream, int length) {
+    SDL_LockMutex(mixerMutex);
+    AudioMixer::mix(reinterpret_cast<int16_t *>(stream), length / (sizeof(int16_t) * mixerChannels));
+    SDL_UnlockMutex(mixerMutex);
 }
 
-bool SoundPlayer::loadSoundFromSB3(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId, const bool &streamed) {
-#ifdef ENABLE_AUDIO
-    if (!zip) {
-        Log::logWarning("Error: Zip archive is null");
+/**
+ * Hooks `AudioMixer` into SDL_mixer's output the first time it's needed, once the audio device is open.
+ * @return `false` if sounds have to play on SDL_mixer channels instead.
+ */
+static bool startMixer() {
+    if (mixerState != MIXER_NOT_STARTED) return mixerState == MIXER_RUNNING;
+
+    int frequency;
+    Uint16 format;
+    int channels;
+    if (!Mix_QuerySpec(&frequency, &format, &channels) || format != AUDIO_S16SYS || channels > 2) {
+        Log::logWarning("Audio device format isn't supported by the mixer, so pitch and pan won't work.");
+        mixerState = MIXER_UNSUPPORTED;
         return false;
     }
+    mixerMutex = SDL_CreateMutex();
+    mixerChannels = channels;
+    AudioMixer::init(channels);
+    Mix_SetPostMix(mixAudio, nullptr);
+    mixerState = MIXER_RUNNING;
+    return true;
+}
 
-    // Log::log("Loading sound: '" + soundId + "'");
+static size_t getSoundBudget() {
+    return MemoryTracker::getMaxRamUsage() * SOUND_BUDGET_FRACTION;
+}
 
-    int file_count = (int)mz_zip_reader_get_num_files(zip);
-    if (file_count <= 0) {
-        Log::logWarning("Error: No files found in zip archive");
-        return false;
+/**
+ * Frees the least recently played sounds until the loaded ones fit in the budget. Sounds that are playing are kept.
+ */
+static void trimSoundCache() {
+    // every sound gets looked at once at most, in case they're all playing
+    size_t remaining = soundCache.getEntryCount();
+    while (soundCache.getMemorySize() > getSoundBudget() && remaining > 0) {
+        remaining--;
+        const std::string id = soundCache.getOldest().id;
+        SDL_Audio *audio = SDL_Sounds[id];
+        if (SoundPlayer::isSoundPlaying(id)) {
+            soundCache.touch(audio->cacheEntry);
+            continue;
+        }
+        SoundPlayer::freeAudio(id);
     }
+}
 
-    for (int i = 0; i < file_count; i++) {
-        mz_zip_archive_file_stat file_stat;
-        if (!mz_zip_reader_file_stat(zip, i, &file_stat)) continue;
+/**
+ * Starts tracking a loaded sound in the sound cache, freeing older ones if it doesn't fit.
+ */
+static void trackSound(const std::string &soundId, SDL_Audio *audio) {
+    if (audio->isCached) soundCache.remove(audio->cacheEntry);
+    audio->cacheEntry = soundCache.add(soundId, audio->memorySize);
+    audio->isCached = true;
+    trimSoundCache();
+}
 
-        std::string zipFileName = file_stat.m_filename;
+/**
+ * Adds a decoded sound to `SDL_Sounds`, and plays it if asked to.
+ */
+static void addLoadedSound(const std::string &soundId, SoundLoadJob &job, bool play, float volume) {
+    // Log::log("Creating SDL sound object...");
 
-        bool isAudio = false;
-        std::string extension = "";
+    // Create SDL_Audio object
+    SDL_Audio *audio;
+    auto it = SDL_Sounds.find(soundId);
+    if (it != SDL_Sounds.end()) {
+        audio = it->second;
+    } else {
+        // audio = new SDL_Audio();
+        audio = MemoryTracker::allocate<SDL_Audio>();
+        new (audio) SDL_Audio();
+        SDL_Sounds[soundId] = audio;
+    }
 
-        if (zipFileName.size() >= 4) {
-            std::string ext4 = zipFileName.substr(zipFileName.size() - 4);
-            std::transform(ext4.begin(), ext4.end(), ext4.begin(), ::tolower);
+    if (!job.streamed) {
+        audio->audioChunk = job.chunk;
+        audio->memorySize = job.chunk->alen; // the decoded samples
+    } else {
+        audio->music = job.music;
+        audio->musicData = std::move(job.data);
+        audio->isStreaming = true;
+        audio->memorySize = audio->musicData.size() + 64 * 1024; // the file, plus a streaming buffer of ~64kb
+    }
+    MemoryTracker::allocate(audio->memorySize);
+    audio->audioId = soundId;
+    audio->isLoaded = true;
 
-            if (ext4 == ".mp3" || ext4 == ".wav" || ext4 == ".ogg") {
-                isAudio = true;
-                extension = ext4;
-            }
-        }
+    Log::log("Successfully loaded audio!");
+    // Log::log("memory usage: " + std::to_string(MemoryTracker::getCurrentUsage() / 1024) + " KB");
+    if (play) {
+        SoundPlayer::playSound(soundId);
+        SoundPlayer::setSoundVolume(soundId, volume);
+    }
+    // after it started playing, so it doesn't get freed right away
+    trackSound(soundId, audio);
+}
 
-        if (isAudio) {
-            if (zipFileName != soundId) {
-                continue;
-            }
+static void runSoundLoader() {
+    SDL_LockMutex(loaderMutex);
+    while (true) {
+        if (loaderJobs.empty()) {
+            SDL_CondWait(loaderCondition, loaderMutex);
+            continue;
+        }
+        SoundLoadJob *job = loaderJobs.front();
+        loaderJobs.pop_front();
 
-            size_t file_size;
-            // Log::log("Extracting sound from sb3...");
-            void *file_data = mz_zip_reader_extract_to_heap(zip, i, &file_size, 0);
-            if (!file_data || file_size == 0) {
-                Log::logWarning("Failed to extract: " + zipFileName);
-                return false;
-            }
+        SDL_UnlockMutex(loaderMutex);
+        decodeSound(*job);
+        if (!job->music) job->data.clear();
+        SDL_LockMutex(loaderMutex);
 
-            Mix_Music *music = nullptr;
-            Mix_Chunk *chunk = nullptr;
+        loaderResults.push_back(job);
+    }
+}
 
-            if (!streamed) {
-                SDL_RWops *rw = SDL_RWFromMem(file_data, (int)file_size);
-                if (!rw) {
-                    Log::logWarning("Failed to create RWops for: " + zipFileName);
-                    mz_free(file_data);
-                    return false;
-                }
-                // Log::log("Converting sound into SDL sound...");
-                chunk = Mix_LoadWAV_RW(rw, 1);
-                mz_free(file_data);
+#ifdef __3DS__
+// do 3DS threads so it can actually run in the background
+static void soundLoaderThread(void *data) {
+    runSoundLoader();
+}
+#else
+static int soundLoaderThread(void *data) {
+    runSoundLoader();
+    return 0;
+}
+#endif
 
-                if (!chunk) {
-                    Log::logWarning("Failed to load audio from memory: " + zipFileName + " - SDL_mixer Error: " + Mix_GetError());
-                    return false;
-                }
-            } else {
-                // need to write to a temp file because this is a zip file
-                std::string tempDir = OS::getScratchFolderLocation() + "/cache";
-                std::string tempFile = tempDir + "/temp_" + soundId;
-
-                // make cache directory
-                try {
-                    std::filesystem::create_directories(tempDir);
-                } catch (const std::exception &e) {
-                    Log::logWarning(std::string("Failed to create temp directory: ") + e.what());
-                    mz_free(file_data);
-                    return false;
-                }
+/**
+ * Starts the loader threads the first time a sound gets loaded. They wait for more sounds until the app closes.
+ */
+static void startLoaderThreads() {
+    if (loaderMutex) return;
+    loaderMutex = SDL_CreateMutex();
+    loaderCondition = SDL_CreateCond();
 
-                FILE *fp = fopen(tempFile.c_str(), "wb");
-                if (!fp) {
-                    Log::logWarning("Failed to create temp file for streaming");
-                    mz_free(file_data);
-                    return false;
-                }
+    for (int i = 0; i < SOUND_LOADER_THREADS; i++) {
+#ifdef __3DS__
+        s32 mainPrio = 0;
+        svcGetThreadPriority(&mainPrio, CUR_THREAD_HANDLE);
+        if (!threadCreate(soundLoaderThread, nullptr, 0x10000, mainPrio + 1, 1, true)) {
+            Log::logWarning("Failed to create sound loader thread");
+            break;
+        }
+#else
+        SDL_Thread *thread = SDL_CreateThread(soundLoaderThread, "SoundLoader", nullptr);
+        if (!thread) {
+            Log::logWarning("Failed to create SDL thread: " + std::string(SDL_GetError()));
+            break;
+        }
+        SDL_DetachThread(thread);
+#endif
+        loaderThreadCount++;
+    }
+}
 
-                fwrite(file_data, 1, file_size, fp);
-                fclose(fp);
-                mz_free(file_data);
+/**
+ * Checks if there's memory left to preload sounds nothing is playing yet.
+ */
+static bool hasMemoryForPreload() {
+    return MemoryTracker::getCurrentUsage() < MemoryTracker::getMaxRamUsage() / 2 &&
+           soundCache.getMemorySize() < getSoundBudget() / 2;
+}
 
-                // Log::log("Converting sound into SDL streamed music...");
-                music = Mix_LoadMUS(tempFile.c_str());
+/**
+ * Reads the next sounds to load and hands them to the loader threads, sounds scripts asked for first.
+ */
+static void dispatchSoundJobs() {
+    while (dispatchedCount < MAX_SOUND_JOBS_PENDING) {
+        std::deque<std::string> *queue = &playQueue;
+        if (queue->empty()) {
+            if (preloadQueue.empty() || !hasMemoryForPreload()) return;
+            queue = &preloadQueue;
+        }
+        const std::string soundId = queue->front();
+        queue->pop_front();
+
+        // it could be queued twice if a script asked for a preloading sound
+        auto pendingFind = pendingSounds.find(soundId);
+        if (pendingFind == pendingSounds.end() || pendingFind->second.dispatched) continue;
+
+        SoundLoadJob *job = new SoundLoadJob();
+        job->soundId = soundId;
+        job->streamed = pendingFind->second.streamed;
+        if (!isSoundFile(soundId) || !readSoundFile(pendingFind->second.zip, *job)) {
+            Log::logWarning("Audio not found: " + soundId);
+            delete job;
+            pendingSounds.erase(pendingFind);
+            // so scripts waiting for it to finish playing don't wait forever
+            SoundPlayer::freeAudio(soundId);
+            continue;
+        }
+        pendingFind->second.dispatched = true;
+        dispatchedCount++;
+
+        if (loaderThreadCount == 0) {
+            decodeSound(*job);
+            if (!job->music) job->data.clear();
+            loaderResults.push_back(job);
+            continue;
+        }
+        SDL_LockMutex(loaderMutex);
+        loaderJobs.push_back(job);
+        SDL_CondSignal(loaderCondition);
+        SDL_UnlockMutex(loaderMutex);
+    }
+}
 
-                // Clean up temp file
-                remove(tempFile.c_str());
+/**
+ * Queues a sound for the loader threads, unless it's loaded or queued already.
+ */
+static void requestSound(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId, bool play) {
+    if (SDL_Sounds.find(soundId) != SDL_Sounds.end()) return;
+
+    auto pendingFind = pendingSounds.find(soundId);
+    if (pendingFind != pendingSounds.end()) {
+        // a script wants a sound that was only preloading, so it skips ahead
+        if (play && !pendingFind->second.play) {
+            pendingFind->second.play = true;
+            pendingFind->second.volume = sprite->volume;
+            if (!pendingFind->second.dispatched) playQueue.push_back(soundId);
+        }
+    } else {
+        pendingSounds[soundId] = {shouldStream(sprite), play, sprite->volume, false, zip};
+        (play ? playQueue : preloadQueue).push_back(soundId);
+    }
 
-                if (!music) {
-                    Log::logWarning("Failed to load music from memory: " + zipFileName + " - SDL_mixer Error: " + Mix_GetError());
-                    return false;
-                }
-            }
+    if (play) {
+        // a placeholder, so the sound counts as playing while it loads
+        // SDL_Audio *audio = new SDL_Audio();
+        SDL_Audio *audio = MemoryTracker::allocate<SDL_Audio>();
+        new (audio) SDL_Audio();
+        SDL_Sounds[soundId] = audio;
+    }
 
-            // Log::log("Creating SDL sound object...");
+    startLoaderThreads();
+    dispatchSoundJobs();
+}
 
-            // Create SDL_Audio object
-            SDL_Audio *audio;
-            auto it = SDL_Sounds.find(soundId);
-            if (it != SDL_Sounds.end()) {
-                audio = it->second;
-            } else {
-                // audio = new SDL_Audio();
-                audio = MemoryTracker::allocate<SDL_Audio>();
-                new (audio) SDL_Audio();
-                SDL_Sounds[soundId] = audio;
-            }
+#endif
 
-            if (!streamed) {
-                audio->audioChunk = chunk;
-                audio->memorySize = file_size * 2; // Rough estimate..
-                MemoryTracker::allocate(audio->memorySize);
-            } else {
-                audio->music = music;
-                audio->isStreaming = true;
-                audio->memorySize = 64 * 1024; // streaming buffer is ~64kb
-                MemoryTracker::allocate(audio->memorySize);
-            }
-            audio->audioId = soundId;
+void SoundPlayer::startSoundLoader(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId) {
+#ifdef ENABLE_AUDIO
+    requestSound(sprite, zip, soundId, true);
+#endif
+}
 
-            SDL_Sounds[soundId] = audio;
+void SoundPlayer::preloadSound(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId) {
+#ifdef ENABLE_AUDIO
+    requestSound(sprite, zip, soundId, false);
+#endif
+}
 
-            Log::log("Successfully loaded audio!");
-            // Log::log("memory usage: " + std::to_string(MemoryTracker::getCurrentUsage() / 1024) + " KB");
-            SDL_Sounds[soundId]->isLoaded = true;
-            playSound(soundId);
-            setSoundVolume(soundId, sprite->volume);
-            return true;
+void SoundPlayer::updateSoundLoader() {
+#ifdef ENABLE_AUDIO
+    if (!loaderMutex) return;
+
+    std::deque<SoundLoadJob *> results;
+    SDL_LockMutex(loaderMutex);
+    results.swap(loaderResults);
+    SDL_UnlockMutex(loaderMutex);
+
+    for (SoundLoadJob *job : results) {
+        dispatchedCount--;
+
+        // the project might have been closed while it was loading
+        auto pendingFind = pendingSounds.find(job->soundId);
+        if (pendingFind == pendingSounds.end()) {
+            if (job->chunk) Mix_FreeChunk(job->chunk);
+            if (job->music) Mix_FreeMusic(job->music);
+        } else if (!job->chunk && !job->music) {
+            pendingSounds.erase(pendingFind);
+            freeAudio(job->soundId);
+        } else {
+            addLoadedSound(job->soundId, *job, pendingFind->second.play, pendingFind->second.volume);
+            pendingSounds.erase(pendingFind);
         }
+        delete job;
+    }
+
+    // sounds that were playing when the cache filled up can go now
+    trimSoundCache();
+    dispatchSoundJobs();
+#endif
+}
+
+bool SoundPlayer::loadSoundFromSB3(Sprite *sprite, mz_zip_archive *zip, const std::string &soundId, const bool &streamed) {
+#ifdef ENABLE_AUDIO
+    if (!zip) {
+        Log::logWarning("Error: Zip archive is null");
+        return false;
+    }
+
+    // Log::log("Loading sound: '" + soundId + "'");
+
+    SoundLoadJob job;
+    job.soundId = soundId;
+    job.streamed = streamed;
+    if (isSoundFile(soundId) && readSoundFile(zip, job)) {
+        if (!decodeSound(job)) return false;
+        addLoadedSound(soundId, job, true, sprite->volume);
+        return true;
     }
 #endif
     Log::logWarning("Audio not found: " + soundId);
@@ -288,16 +551,7 @@ bool SoundPlayer::loadSoundFromFile(Sprite *sprite, std::string fileName, const
             Log::logWarning("Failed to load audio file: " + fileName + " - SDL_mixer Error: " + Mix_GetError());
             return false;
         }
-        // estimate memory based on file size
-        FILE *file = fopen(fileName.c_str(), "rb");
-        if (file) {
-            fseek(file, 0, SEEK_END);
-            long file_size = ftell(file);
-            fclose(file);
-            audioMemorySize = file_size * 2; // rough estimate
-        } else {
-            audioMemorySize = 1024 * 1024; // 1MB defualt
-        }
+        audioMemorySize = chunk->alen; // the decoded samples
         MemoryTracker::allocate(audioMemorySize);
     } else {
         music = Mix_LoadMUS(fileName.c_str());
@@ -328,6 +582,7 @@ bool SoundPlayer::loadSoundFromFile(Sprite *sprite, std::string fileName, const
     SDL_Sounds[fileName]->isLoaded = true;
     playSound(fileName);
     setSoundVolume(fileName, sprite->volume);
+    trackSound(fileName, audio);
     return true;
 #endif
     return false;
@@ -337,6 +592,7 @@ int SoundPlayer::playSound(const std::string &soundId) {
 #ifdef ENABLE_AUDIO
     auto it = SDL_Sounds.find(soundId);
     if (it != SDL_Sounds.end()) {
+        if (it->second->isCached) soundCache.touch(it->second->cacheEntry);
 
         if (!currentStreamedSound.empty() && it->second->isStreaming) {
             stopStreamedSound();
@@ -344,7 +600,16 @@ int SoundPlayer::playSound(const std::string &soundId) {
 
         it->second->isPlaying = true;
 
-        if (!it->second->isStreaming) {
+        if (!it->second->isStreaming && startMixer()) {
+            SDL_Audio *audio = it->second;
+            // SDL_mixer converted the samples to the device's format when loading them
+            const size_t frameCount = audio->audioChunk->alen / (sizeof(int16_t) * mixerChannels);
+            SDL_LockMutex(mixerMutex);
+            audio->channelId = AudioMixer::play(reinterpret_cast<const int16_t *>(audio->audioChunk->abuf), frameCount,
+                                                audio->volume, audio->pitch, audio->pan);
+            SDL_UnlockMutex(mixerMutex);
+            return audio->channelId;
+        } else if (!it->second->isStreaming) {
             int channel = Mix_PlayChannel(-1, it->second->audioChunk, 0);
             if (channel != -1) {
                 SDL_Sounds[soundId]->channelId = channel;
@@ -373,10 +638,15 @@ void SoundPlayer::setSoundVolume(const std::string &soundId, float volume) {
 
         float clampedVolume = std::clamp(volume, 0.0f, 100.0f);
         int sdlVolume = (int)((clampedVolume / 100.0f) * 128.0f);
+        soundFind->second->volume = clampedVolume;
 
         int channel = soundFind->second->channelId;
         if (soundFind->second->isStreaming) {
             Mix_VolumeMusic(sdlVolume);
+        } else if (startMixer()) {
+            SDL_LockMutex(mixerMutex);
+            AudioMixer::setVolume(channel, clampedVolume);
+            SDL_UnlockMutex(mixerMutex);
         } else {
             Mix_Volume(channel, sdlVolume);
         }
@@ -392,6 +662,8 @@ float SoundPlayer::getSoundVolume(const std::string &soundId) {
 
         if (soundFind->second->isStreaming) {
             sdlVolume = Mix_VolumeMusic(-1);
+        } else if (startMixer()) {
+            return soundFind->second->volume;
         } else {
             int channel = soundFind->second->channelId;
             if (channel != -1) {
@@ -411,12 +683,33 @@ float SoundPlayer::getSoundVolume(const std::string &soundId) {
     return -1.0f;
 }
 
+void SoundPlayer::setSoundEffects(const std::string &soundId, float pitch, float pan) {
+#ifdef ENABLE_AUDIO
+    auto soundFind = SDL_Sounds.find(soundId);
+    if (soundFind != SDL_Sounds.end()) {
+        soundFind->second->pitch = pitch;
+        soundFind->second->pan = pan;
+        if (!soundFind->second->isStreaming && startMixer()) {
+            SDL_LockMutex(mixerMutex);
+            AudioMixer::setEffects(soundFind->second->channelId, pitch, pan);
+            SDL_UnlockMutex(mixerMutex);
+        }
+    }
+#endif
+}
+
 void SoundPlayer::stopSound(const std::string &soundId) {
 #ifdef ENABLE_AUDIO
     auto soundFind = SDL_Sounds.find(soundId);
     if (soundFind != SDL_Sounds.end()) {
         int channel = soundFind->second->channelId;
-        Mix_HaltChannel(channel);
+        if (mixerState == MIXER_RUNNING && !soundFind->second->isStreaming) {
+            SDL_LockMutex(mixerMutex);
+            AudioMixer::stop(channel);
+            SDL_UnlockMutex(mixerMutex);
+        } else if (channel != -1) {
+            Mix_HaltChannel(channel);
+        }
     } else {
         Log::logWarning("No active channel found for sound: " + soundId);
     }
@@ -451,7 +744,12 @@ bool SoundPlayer::isSoundPlaying(const std::string &soundId) {
         if (!soundFind->second->isLoaded) return true;
         if (!soundFind->second->isPlaying) return false;
         int channel = soundFind->second->channelId;
-        if (!soundFind->second->isStreaming)
+        if (!soundFind->second->isStreaming && mixerState == MIXER_RUNNING) {
+            SDL_LockMutex(mixerMutex);
+            const bool playing = AudioMixer::isPlaying(channel);
+            SDL_UnlockMutex(mixerMutex);
+            return playing;
+        } else if (!soundFind->second->isStreaming)
             return Mix_Playing(channel) != 0;
         else
             return Mix_PlayingMusic() != 0;
@@ -472,6 +770,16 @@ void SoundPlayer::freeAudio(const std::string &soundId) {
     auto it = SDL_Sounds.find(soundId);
     if (it != SDL_Sounds.end()) {
         SDL_Audio *audio = it->second;
+        if (soundId == currentStreamedSound) currentStreamedSound = "";
+#ifdef ENABLE_AUDIO
+        if (audio->isCached) soundCache.remove(audio->cacheEntry);
+        if (mixerState == MIXER_RUNNING && !audio->isStreaming) {
+            // the mixer can't be left reading samples that are about to be freed
+            SDL_LockMutex(mixerMutex);
+            AudioMixer::stop(audio->channelId);
+            SDL_UnlockMutex(mixerMutex);
+        }
+#endif
         // MemoryTracker::deallocate(audio->memorySize);
         // delete audio;
         audio->~SDL_Audio();
@@ -485,6 +793,11 @@ void SoundPlayer::cleanupAudio() {
 #ifdef ENABLE_AUDIO
     Mix_HaltMusic();
     Mix_HaltChannel(-1);
+    if (mixerState == MIXER_RUNNING) {
+        SDL_LockMutex(mixerMutex);
+        AudioMixer::stopAll();
+        SDL_UnlockMutex(mixerMutex);
+    }
 
     // Track memory cleanup
     for (auto &pair : SDL_Sounds) {
@@ -494,6 +807,21 @@ void SoundPlayer::cleanupAudio() {
         MemoryTracker::deallocate<SDL_Audio>(pair.second);
     }
     SDL_Sounds.clear();
+    soundCache.clear();
+
+    // sounds still loading get thrown away by updateSoundLoader() once they're done
+    pendingSounds.clear();
+    playQueue.clear();
+    preloadQueue.clear();
+    if (loaderMutex) {
+        SDL_LockMutex(loaderMutex);
+        for (SoundLoadJob *job : loaderJobs) {
+            delete job;
+            dispatchedCount--;
+        }
+        loaderJobs.clear();
+        SDL_UnlockMutex(loaderMutex);
+    }
 
 #endif
 }
@@ -503,6 +831,12 @@ void SoundPlayer::deinit() {
     Mix_HaltMusic();
     Mix_HaltChannel(-1);
     cleanupAudio();
+    if (mixerState == MIXER_RUNNING) {
+        Mix_SetPostMix(nullptr, nullptr);
+        SDL_DestroyMutex(mixerMutex);
+        mixerMutex = nullptr;
+    }
+    mixerState = MIXER_NOT_STARTED;
     Mix_CloseAudio();
     Mix_Quit();
 #endif
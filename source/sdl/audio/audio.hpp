@@ -2,32 +2,32 @@
 #ifdef ENABLE_AUDIO
 #include <SDL2/SDL_mixer.h>
 #endif
+#include "lruCache.hpp"
 #include <string>
 #include <unordered_map>
+#include <vector>
 class SDL_Audio {
   public:
 #ifdef ENABLE_AUDIO
     Mix_Chunk *audioChunk;
     Mix_Music *music;
 #endif
+    std::vector<char> musicData; // the file `music` streams from, if it was loaded from memory
     std::string audioId;
-    int channelId;
+    int channelId = -1; // the voice it's playing on, when the mixer is running
+    float volume = 100; // volume and sound effects it gets played with, from the sprite that played it last
+    float pitch = 0;
+    float pan = 0;
     bool isLoaded = false;
     bool isPlaying = false;
     bool isStreaming = false;
     bool needsToBePlayed = true;
     size_t memorySize = 0;
+    bool isCached = false; // tracked by the sound cache, which it is once loaded
+    LruCache::Handle cacheEntry;
 
     SDL_Audio();
     ~SDL_Audio();
-
-    struct SoundLoadParams {
-        SoundPlayer *player;
-        Sprite *sprite;
-        mz_zip_archive *zip;
-        std::string soundId;
-        bool streamed;
-    };
 };
 
 extern std::unordered_map<std::string, SDL_Audio *> SDL_Sounds;
\ No newline at end of file
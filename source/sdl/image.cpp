@@ -1,8 +1,17 @@
 #include "../scratch/image.hpp"
+#include "../scratch/costumePrefetch.hpp"
+#include "../scratch/frameScheduler.hpp"
+#include "../scratch/lruCache.hpp"
 #include "../scratch/os.hpp"
+#include "../scratch/texturePolicy.hpp"
+#include "../scratch/unzip.hpp"
+#include "effects.hpp"
 #include "image.hpp"
+#include "interpret.hpp"
 #include "miniz/miniz.h"
 #include "render.hpp"
+#include "renderState.hpp"
+#include "workerPool.hpp"
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_pixels.h>
 #include <SDL2/SDL_rect.h>
@@ -10,16 +19,671 @@
 #include <SDL2/SDL_rwops.h>
 #include <SDL2/SDL_stdinc.h>
 #include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_mutex.h>
 #include <algorithm>
 #include <cctype>
+#include <cmath>
+#include <cstring>
 #include <cstddef>
+#include <deque>
+#include <fstream>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
+#define NANOSVG_IMPLEMENTATION
+#include "nanosvg.h"
+#define NANOSVGRAST_IMPLEMENTATION
+#include "nanosvgrast.h"
 
 std::unordered_map<std::string, SDL_Image *> images;
 static std::vector<std::string> toDelete;
 
+// frames an image can go unused before it's freed
+#ifdef GAMECUBE
+#define MAX_UNUSED_FRAMES 2
+#else
+#define MAX_UNUSED_FRAMES 480
+#endif
+
+// fractions of the RAM or VRAM budget where images start getting freed before they expire, and where that stops
+#define LOW_MEMORY_START 0.8
+#define LOW_MEMORY_STOP 0.5
+
+// costumes by when they were last drawn. Prefetched ones only join once something asks for them
+static LruCache imageCache(MAX_UNUSED_FRAMES);
+
+#ifdef __OGC__
+#define ATLAS_PAGE_SIZE 1024
+#else
+#define ATLAS_PAGE_SIZE 2048
+#endif
+#define ATLAS_PADDING 1
+#define ATLAS_PAGE_MEMORY (static_cast<size_t>(ATLAS_PAGE_SIZE) * ATLAS_PAGE_SIZE * 4)
+
+// decoded costumes that graphic effects get applied to, since textures can't be read back
+struct EffectSource {
+    std::vector<Uint32> pixels;
+    int width = 0;
+    int height = 0;
+    LruCache::Handle cacheEntry;
+};
+
+static std::unordered_map<std::string, EffectSource> effectSources;
+// costumes with graphic effects applied, by `Effects::getCacheKey()`
+static std::unordered_map<std::string, SDL_Image *> effectImages;
+// both share one budget
+static LruCache effectSourceCache(MAX_UNUSED_FRAMES);
+static LruCache effectImageCache(MAX_UNUSED_FRAMES);
+
+#ifdef __OGC__
+#define MAX_SVG_RESOLUTION 2
+#else
+#define MAX_SVG_RESOLUTION 8
+#endif
+
+// an SVG costume waiting to be rasterized, or done being rasterized, on the SVG thread
+struct SVGRasterJob {
+    std::string key;
+    std::string svgData;
+    int resolution;
+    int width;
+    int height;
+    std::vector<Uint32> pixels; // empty if rasterizing failed
+};
+
+// SVG costumes rasterized bigger than their native size, by costume ID and resolution
+static std::unordered_map<std::string, SDL_Image *> svgImages;
+static std::unordered_set<std::string> svgPending;
+static LruCache svgImageCache(MAX_UNUSED_FRAMES);
+
+static SDL_mutex *svgMutex = nullptr;
+static SDL_cond *svgCondition = nullptr;
+static bool svgThreadRunning = false;
+static std::deque<SVGRasterJob *> svgJobs;
+static std::deque<SVGRasterJob *> svgResults;
+
+// a prefetched costume waiting to be decoded, or done being decoded, on the prefetch thread
+struct PrefetchJob {
+    std::string fileName;
+    std::string data;
+    SDL_Surface *surface = nullptr;
+};
+
+// jobs handed to the prefetch thread at once, so it never holds much more than it's working on
+#define MAX_PREFETCH_PENDING 4
+
+static std::deque<std::string> prefetchQueue;
+static std::unordered_set<std::string> prefetchPending;
+// prefetched images nothing has asked for yet, which don't expire
+static std::unordered_set<std::string> prefetchedImages;
+
+static SDL_mutex *prefetchMutex = nullptr;
+static SDL_cond *prefetchCondition = nullptr;
+static bool prefetchThreadRunning = false;
+static std::deque<PrefetchJob *> prefetchJobs;
+static std::deque<PrefetchJob *> prefetchResults;
+
+struct AtlasPage {
+    SDL_Texture *texture = nullptr;
+    int shelfY = 0;
+    int shelfHeight = 0;
+    int cursorX = 0;
+    int imageCount = 0;
+    std::vector<SDL_Rect> freeRects;
+};
+
+static std::vector<AtlasPage> atlasPages;
+
+/**
+ * Finds space for a `width` x `height` rectangle in one of the atlas pages, making a new page if none have room.
+ * @return The index of the page, or -1 if a page couldn't be made.
+ */
+static int allocateAtlasRect(int width, int height, SDL_Rect *outRect) {
+    int emptySlot = -1;
+    for (size_t i = 0; i < atlasPages.size(); i++) {
+        AtlasPage &page = atlasPages[i];
+        if (page.texture == nullptr) {
+            if (emptySlot == -1) emptySlot = i;
+            continue;
+        }
+
+        // reuse space from freed images first, taking the smallest that fits and giving back what's left over
+        auto best = page.freeRects.end();
+        for (auto it = page.freeRects.begin(); it != page.freeRects.end(); ++it) {
+            if (it->w >= width && it->h >= height && (best == page.freeRects.end() || it->w * it->h < best->w * best->h)) best = it;
+        }
+        if (best != page.freeRects.end()) {
+            const SDL_Rect space = *best;
+            page.freeRects.erase(best);
+            if (space.w > width) page.freeRects.push_back({space.x + width, space.y, space.w - width, height});
+            if (space.h > height) page.freeRects.push_back({space.x, space.y + height, space.w, space.h - height});
+            page.imageCount++;
+            *outRect = {space.x, space.y, width, height};
+            return i;
+        }
+
+        // then pack onto the current shelf, or start a new one below it
+        int x = page.cursorX;
+        int y = page.shelfY;
+        int shelfHeight = page.shelfHeight;
+        if (x + width > ATLAS_PAGE_SIZE) {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        if (y + height > ATLAS_PAGE_SIZE) continue;
+
+        page.cursorX = x + width;
+        page.shelfY = y;
+        page.shelfHeight = std::max(shelfHeight, height);
+        page.imageCount++;
+        *outRect = {x, y, width, height};
+        return i;
+    }
+
+    SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+    if (!texture) {
+        Log::logWarning(std::string("Failed to create atlas page: ") + SDL_GetError());
+        return -1;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    MemoryTracker::allocateVRAM(ATLAS_PAGE_MEMORY);
+
+    if (emptySlot == -1) {
+        emptySlot = atlasPages.size();
+        atlasPages.emplace_back();
+    }
+    AtlasPage &page = atlasPages[emptySlot];
+    page.texture = texture;
+    page.cursorX = width;
+    page.shelfY = 0;
+    page.shelfHeight = height;
+    page.imageCount = 1;
+    *outRect = {0, 0, width, height};
+    return emptySlot;
+}
+
+/**
+ * Destroys an atlas page's texture, leaving its slot free for a new page.
+ */
+static void destroyAtlasPage(AtlasPage &page) {
+    SDL_DestroyTexture(page.texture);
+    MemoryTracker::deallocateVRAM(ATLAS_PAGE_MEMORY);
+    page = AtlasPage();
+}
+
+/**
+ * Gives the space an image used back to its atlas page, and destroys the page once no images use it.
+ */
+static void freeAtlasRect(int pageIndex, SDL_Rect rect) {
+    if (pageIndex < 0 || pageIndex >= static_cast<int>(atlasPages.size())) return;
+    AtlasPage &page = atlasPages[pageIndex];
+    page.imageCount--;
+    if (page.imageCount <= 0) {
+        destroyAtlasPage(page);
+        return;
+    }
+
+    // join it with free neighbours that share a whole edge, so freed space doesn't stay cut up into small pieces
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (auto it = page.freeRects.begin(); it != page.freeRects.end(); ++it) {
+            if (it->y == rect.y && it->h == rect.h && (it->x + it->w == rect.x || rect.x + rect.w == it->x)) {
+                rect.x = std::min(rect.x, it->x);
+                rect.w += it->w;
+            } else if (it->x == rect.x && it->w == rect.w && (it->y + it->h == rect.y || rect.y + rect.h == it->y)) {
+                rect.y = std::min(rect.y, it->y);
+                rect.h += it->h;
+            } else continue;
+            page.freeRects.erase(it);
+            merged = true;
+            break;
+        }
+    }
+    page.freeRects.push_back(rect);
+}
+
+bool createImageTexture(SDL_Image *image, SDL_Surface *surface, bool useAtlas) {
+    const int width = surface->w;
+    const int height = surface->h;
+
+    if (useAtlas && width > 0 && height > 0 &&
+        width + ATLAS_PADDING * 2 <= ATLAS_PAGE_SIZE / 2 && height + ATLAS_PADDING * 2 <= ATLAS_PAGE_SIZE / 2) {
+        SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_Rect rect;
+        int pageIndex = converted ? allocateAtlasRect(width + ATLAS_PADDING * 2, height + ATLAS_PADDING * 2, &rect) : -1;
+
+        if (pageIndex != -1) {
+            // copy into a buffer with a transparent border, so neighbours don't bleed in when filtering
+            const int paddedWidth = width + ATLAS_PADDING * 2;
+            std::vector<Uint32> pixels(paddedWidth * (height + ATLAS_PADDING * 2), 0);
+            SDL_LockSurface(converted);
+            for (int y = 0; y < height; y++) {
+                const Uint8 *row = static_cast<const Uint8 *>(converted->pixels) + y * converted->pitch;
+                std::memcpy(&pixels[(y + ATLAS_PADDING) * paddedWidth + ATLAS_PADDING], row, width * 4);
+            }
+            SDL_UnlockSurface(converted);
+
+            SDL_Rect uploadRect = {rect.x, rect.y, paddedWidth, height + ATLAS_PADDING * 2};
+            SDL_UpdateTexture(atlasPages[pageIndex].texture, &uploadRect, pixels.data(), paddedWidth * 4);
+            SDL_FreeSurface(converted);
+
+            image->spriteTexture = atlasPages[pageIndex].texture;
+            image->atlasPage = pageIndex;
+            image->atlasRect = rect;
+            image->textureWidth = ATLAS_PAGE_SIZE;
+            image->textureHeight = ATLAS_PAGE_SIZE;
+            image->width = width;
+            image->height = height;
+            image->renderRect = {0, 0, width, height};
+            image->textureRect = {rect.x + ATLAS_PADDING, rect.y + ATLAS_PADDING, width, height};
+            image->layout = TexturePolicy::getFullLayout(width, height);
+            // the page's VRAM is counted when it's made, so this is only the image's share of it for the cache
+            image->memorySize = width * height * 4;
+            return true;
+        }
+        if (converted) SDL_FreeSurface(converted);
+    }
+
+    image->spriteTexture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (!image->spriteTexture) return false;
+
+    SDL_QueryTexture(image->spriteTexture, NULL, NULL, &image->width, &image->height);
+    image->textureWidth = image->width;
+    image->textureHeight = image->height;
+    image->renderRect = {0, 0, image->width, image->height};
+    image->textureRect = {0, 0, image->width, image->height};
+    image->layout = TexturePolicy::getFullLayout(image->width, image->height);
+
+    // calculate VRAM usage
+    Uint32 format;
+    SDL_QueryTexture(image->spriteTexture, &format, NULL, NULL, NULL);
+    int bpp;
+    Uint32 Rmask, Gmask, Bmask, Amask;
+    SDL_PixelFormatEnumToMasks(format, &bpp, &Rmask, &Gmask, &Bmask, &Amask);
+    image->memorySize = (image->width * image->height * bpp) / 8;
+    MemoryTracker::allocateVRAM(image->memorySize);
+    return true;
+}
+
+/**
+ * Creates the texture of a project costume, stored the way `TexturePolicy` says if it's on.
+ * SVGs are left as they are, since they get rasterized again at other sizes anyway.
+ * @param image Needs `isSVG` set already.
+ * @param surface Still has to be freed by the caller.
+ * @param imgId
+ * @return `true` if the texture was created, `false` otherwise.
+ */
+static bool createCostumeTexture(SDL_Image *image, SDL_Surface *surface, const std::string &imgId) {
+    if (!TexturePolicy::enabled || image->isSVG) return createImageTexture(image, surface, true);
+
+    SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (!converted) return createImageTexture(image, surface, true);
+    const int width = converted->w;
+    const int height = converted->h;
+    std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+    SDL_LockSurface(converted);
+    for (int y = 0; y < height; y++) {
+        std::memcpy(&rgba[static_cast<size_t>(y) * width * 4], static_cast<const Uint8 *>(converted->pixels) + y * converted->pitch, width * 4);
+    }
+    SDL_UnlockSurface(converted);
+    SDL_FreeSurface(converted);
+
+    const TexturePolicy::Layout layout = TexturePolicy::plan(rgba.data(), width, height, TexturePolicy::getScale(imgId));
+    std::vector<uint8_t> pixels = TexturePolicy::apply(layout, rgba.data(), width);
+    rgba = std::vector<uint8_t>();
+
+    // SDL has no alpha only format that can be tinted, so one color costumes use RGBA4444 too
+    SDL_Surface *stored = SDL_CreateRGBSurfaceWithFormatFrom(pixels.data(), layout.textureWidth, layout.textureHeight, 32, layout.textureWidth * 4,
+                                                             SDL_PIXELFORMAT_RGBA32);
+    SDL_Surface *reduced = stored ? SDL_ConvertSurfaceFormat(stored, layout.format == TexturePolicy::RGB565 ? SDL_PIXELFORMAT_RGB565 : SDL_PIXELFORMAT_RGBA4444, 0) : nullptr;
+    if (stored) SDL_FreeSurface(stored);
+    if (!reduced) return createImageTexture(image, surface, true);
+
+    // atlas pages are 32 bit, so it gets its own texture
+    const bool created = createImageTexture(image, reduced, false);
+    SDL_FreeSurface(reduced);
+    if (!created) return false;
+    // RGB565 has no alpha, so SDL would draw it without blending, and the ghost effect wouldn't show
+    SDL_SetTextureBlendMode(image->spriteTexture, SDL_BLENDMODE_BLEND);
+    image->layout = layout;
+    image->width = width;
+    image->height = height;
+    return true;
+}
+
+/**
+ * Starts freeing an image once it goes unused, as the most recently used one in `cache`.
+ */
+static void trackImage(LruCache &cache, const std::string &id, SDL_Image *image) {
+    image->cache = &cache;
+    image->cacheEntry = cache.add(id, image->memorySize);
+}
+
+static void freeEffectImage(std::unordered_map<std::string, SDL_Image *>::iterator it) {
+    it->second->~SDL_Image();
+    MemoryTracker::deallocate<SDL_Image>(it->second);
+    effectImages.erase(it);
+}
+
+static void freeEffectSource(std::unordered_map<std::string, EffectSource>::iterator it) {
+    effectSourceCache.remove(it->second.cacheEntry);
+    effectSources.erase(it);
+}
+
+/**
+ * Frees whichever effect image or decoded costume went unused the longest.
+ */
+static void freeOldestEffect() {
+    if (effectSourceCache.empty() ||
+        (!effectImageCache.empty() && effectImageCache.getOldest().lastUsed <= effectSourceCache.getOldest().lastUsed)) {
+        freeEffectImage(effectImages.find(effectImageCache.getOldest().id));
+    } else {
+        freeEffectSource(effectSources.find(effectSourceCache.getOldest().id));
+    }
+}
+
+/**
+ * Frees whatever went unused the longest until `size` more bytes fit in the effect cache.
+ */
+static void trimEffectCache(size_t size) {
+    const size_t maxSize = MemoryTracker::getMaxVRAMUsage() / 8;
+    while (effectImageCache.getMemorySize() + effectSourceCache.getMemorySize() + size > maxSize &&
+           (!effectImageCache.empty() || !effectSourceCache.empty())) {
+        freeOldestEffect();
+    }
+}
+
+/**
+ * Decodes a costume from the project again, as RGBA32 pixels.
+ */
+static bool decodeEffectSource(const std::string &fileName, EffectSource &source) {
+    SDL_Surface *surface = nullptr;
+    if (projectType == UNZIPPED) {
+        std::string path;
+#if defined(__WIIU__) || defined(__OGC__)
+        path = "romfs:/";
+#endif
+        path = path + "project/" + fileName;
+        surface = IMG_Load(path.c_str());
+    } else {
+        int fileIndex = mz_zip_reader_locate_file(&Unzip::zipArchive, fileName.c_str(), nullptr, 0);
+        if (fileIndex < 0) return false;
+
+        size_t fileSize;
+        void *fileData = mz_zip_reader_extract_to_heap(&Unzip::zipArchive, fileIndex, &fileSize, 0);
+        if (!fileData) return false;
+
+        SDL_RWops *rw = SDL_RWFromMem(fileData, fileSize);
+        if (rw) {
+            surface = IMG_Load_RW(rw, 0);
+            SDL_RWclose(rw);
+        }
+        mz_free(fileData);
+    }
+    if (!surface) return false;
+
+    SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(surface);
+    if (!converted) return false;
+
+    source.width = converted->w;
+    source.height = converted->h;
+    source.pixels.resize(source.width * source.height);
+    SDL_LockSurface(converted);
+    for (int y = 0; y < source.height; y++) {
+        const Uint8 *row = static_cast<const Uint8 *>(converted->pixels) + y * converted->pitch;
+        std::memcpy(&source.pixels[y * source.width], row, source.width * 4);
+    }
+    SDL_UnlockSurface(converted);
+    SDL_FreeSurface(converted);
+    return true;
+}
+
+SDL_Image *getEffectImage(const std::string &costumeId, const std::string &fileName, const GraphicEffects &effects) {
+    const std::string key = Effects::getCacheKey(costumeId, effects);
+    auto effectFind = effectImages.find(key);
+    if (effectFind != effectImages.end()) {
+        effectFind->second->markUsed();
+        return effectFind->second;
+    }
+
+    auto imgFind = images.find(costumeId);
+    if (imgFind == images.end()) return nullptr;
+    const SDL_Image *costumeImage = imgFind->second;
+
+    auto sourceFind = effectSources.find(costumeId);
+    if (sourceFind == effectSources.end()) {
+        EffectSource source;
+        if (!decodeEffectSource(fileName, source)) {
+            Log::logWarning("Failed to decode costume for graphic effects: " + fileName);
+            return nullptr;
+        }
+        trimEffectCache(source.pixels.size() * sizeof(Uint32));
+        source.cacheEntry = effectSourceCache.add(costumeId, source.pixels.size() * sizeof(Uint32));
+        sourceFind = effectSources.emplace(costumeId, std::move(source)).first;
+    }
+    EffectSource &source = sourceFind->second;
+    effectSourceCache.touch(source.cacheEntry);
+
+    std::vector<Uint32> pixels(source.pixels.size());
+    Effects::apply(source.pixels.data(), pixels.data(), source.width, source.height, Effects::quantize(effects));
+
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormatFrom(pixels.data(), source.width, source.height, 32, source.width * 4, SDL_PIXELFORMAT_RGBA32);
+    if (!surface) return nullptr;
+
+    trimEffectCache(pixels.size() * sizeof(Uint32));
+    SDL_Image *image = MemoryTracker::allocate<SDL_Image>();
+    new (image) SDL_Image();
+    image->isSVG = costumeImage->isSVG;
+
+    // effect results get their own texture, so atlas pages don't fill up with them
+    const bool created = createImageTexture(image, surface, false);
+    SDL_FreeSurface(surface);
+    if (!created) {
+        image->~SDL_Image();
+        MemoryTracker::deallocate<SDL_Image>(image);
+        return nullptr;
+    }
+
+    trackImage(effectImageCache, key, image);
+    effectImages[key] = image;
+    return image;
+}
+
+static void rasterizeSVG(SVGRasterJob &job) {
+    NSVGimage *svg = nsvgParse(job.svgData.data(), "px", 96.0f);
+    if (!svg) return;
+
+    NSVGrasterizer *rasterizer = nsvgCreateRasterizer();
+    if (rasterizer) {
+        job.pixels.resize(job.width * job.height);
+        nsvgRasterize(rasterizer, svg, 0, 0, job.resolution, reinterpret_cast<unsigned char *>(job.pixels.data()), job.width, job.height, job.width * 4);
+        nsvgDeleteRasterizer(rasterizer);
+    }
+    nsvgDelete(svg);
+}
+
+static int svgThread(void *data) {
+    SDL_LockMutex(svgMutex);
+    while (true) {
+        if (svgJobs.empty()) {
+            SDL_CondWait(svgCondition, svgMutex);
+            continue;
+        }
+        SVGRasterJob *job = svgJobs.front();
+        svgJobs.pop_front();
+
+        SDL_UnlockMutex(svgMutex);
+        rasterizeSVG(*job);
+        SDL_LockMutex(svgMutex);
+
+        svgResults.push_back(job);
+    }
+    return 0;
+}
+
+/**
+ * Reads a costume file from the project, without decoding it.
+ */
+static bool readCostumeFile(const std::string &fileName, std::string &data) {
+    if (projectType == UNZIPPED) {
+        std::string path;
+#if defined(__WIIU__) || defined(__OGC__)
+        path = "romfs:/";
+#endif
+        path = path + "project/" + fileName;
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    int fileIndex = mz_zip_reader_locate_file(&Unzip::zipArchive, fileName.c_str(), nullptr, 0);
+    if (fileIndex < 0) return false;
+
+    size_t fileSize;
+    void *fileData = mz_zip_reader_extract_to_heap(&Unzip::zipArchive, fileIndex, &fileSize, 0);
+    if (!fileData) return false;
+    data.assign(static_cast<const char *>(fileData), fileSize);
+    mz_free(fileData);
+    return true;
+}
+
+static void freeSVGImage(std::unordered_map<std::string, SDL_Image *>::iterator it) {
+    it->second->~SDL_Image();
+    MemoryTracker::deallocate<SDL_Image>(it->second);
+    svgImages.erase(it);
+}
+
+/**
+ * Starts rasterizing an SVG costume at a bigger resolution in the background.
+ */
+static void requestSVGImage(const std::string &key, const std::string &fileName, const SDL_Image *costumeImage, int resolution) {
+    const size_t memorySize = static_cast<size_t>(costumeImage->width * resolution) * costumeImage->height * resolution * 4;
+    if (memorySize > MemoryTracker::getMaxVRAMUsage() / 4) return;
+
+    SVGRasterJob *job = new SVGRasterJob();
+    job->key = key;
+    job->resolution = resolution;
+    job->width = costumeImage->width * resolution;
+    job->height = costumeImage->height * resolution;
+    if (!readCostumeFile(fileName, job->svgData)) {
+        Log::logWarning("Failed to read SVG costume: " + fileName);
+        delete job;
+        return;
+    }
+
+    if (!svgMutex) {
+        svgMutex = SDL_CreateMutex();
+        svgCondition = SDL_CreateCond();
+        SDL_Thread *thread = SDL_CreateThread(svgThread, "SVGRasterizer", nullptr);
+        if (!thread) {
+            Log::logWarning("Failed to create SDL thread: " + std::string(SDL_GetError()));
+        } else {
+            SDL_DetachThread(thread);
+            svgThreadRunning = true;
+        }
+    }
+
+    svgPending.insert(key);
+    if (!svgThreadRunning) rasterizeSVG(*job);
+
+    SDL_LockMutex(svgMutex);
+    if (svgThreadRunning) {
+        svgJobs.push_back(job);
+        SDL_CondSignal(svgCondition);
+    } else {
+        svgResults.push_back(job);
+    }
+    SDL_UnlockMutex(svgMutex);
+}
+
+/**
+ * Turns SVGs the background thread finished into textures, since only the main thread can make them.
+ */
+static void collectSVGImages() {
+    if (!svgMutex) return;
+
+    std::deque<SVGRasterJob *> results;
+    SDL_LockMutex(svgMutex);
+    results.swap(svgResults);
+    SDL_UnlockMutex(svgMutex);
+
+    for (SVGRasterJob *job : results) {
+        // the project might have been closed while it was rasterizing
+        if (svgPending.erase(job->key) == 0 || job->pixels.empty()) {
+            delete job;
+            continue;
+        }
+
+        const size_t memorySize = job->pixels.size() * sizeof(Uint32);
+        const size_t maxSize = MemoryTracker::getMaxVRAMUsage() / 4;
+        while (!svgImageCache.empty() && svgImageCache.getMemorySize() + memorySize > maxSize) {
+            freeSVGImage(svgImages.find(svgImageCache.getOldest().id));
+        }
+
+        SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormatFrom(job->pixels.data(), job->width, job->height, 32, job->width * 4, SDL_PIXELFORMAT_RGBA32);
+        SDL_Image *image = MemoryTracker::allocate<SDL_Image>();
+        new (image) SDL_Image();
+        image->isSVG = true;
+
+        if (!surface || !createImageTexture(image, surface, false)) {
+            image->~SDL_Image();
+            MemoryTracker::deallocate<SDL_Image>(image);
+        } else {
+            image->layout.width = job->width / job->resolution;
+            image->layout.height = job->height / job->resolution;
+            image->layout.scale = job->resolution;
+            trackImage(svgImageCache, job->key, image);
+            svgImages[job->key] = image;
+            RenderState::markChanged();
+        }
+        if (surface) SDL_FreeSurface(surface);
+        delete job;
+    }
+}
+
+SDL_Image *getSVGImage(const std::string &costumeId, const std::string &fileName, double screenScale) {
+    auto imgFind = images.find(costumeId);
+    if (imgFind == images.end()) return nullptr;
+    SDL_Image *costumeImage = imgFind->second;
+    if (!costumeImage->isSVG || screenScale <= 1) return costumeImage;
+
+    // resolutions go up in powers of 2, so scaling a sprite doesn't rasterize it again every frame
+    int resolution = 2;
+    while (resolution < screenScale && resolution < MAX_SVG_RESOLUTION) {
+        resolution *= 2;
+    }
+    while (resolution > 1 && (costumeImage->width * resolution > ATLAS_PAGE_SIZE || costumeImage->height * resolution > ATLAS_PAGE_SIZE)) {
+        resolution /= 2;
+    }
+    if (resolution == 1) return costumeImage;
+
+    const std::string key = costumeId + "@" + std::to_string(resolution);
+    auto svgFind = svgImages.find(key);
+    if (svgFind != svgImages.end()) {
+        svgFind->second->markUsed();
+        return svgFind->second;
+    }
+    if (svgPending.find(key) == svgPending.end()) requestSVGImage(key, fileName, costumeImage, resolution);
+
+    // use the closest resolution that's ready in the meantime
+    SDL_Image *closest = costumeImage;
+    int closestDistance = resolution - 1;
+    for (int other = 2; other <= MAX_SVG_RESOLUTION; other *= 2) {
+        auto otherFind = svgImages.find(costumeId + "@" + std::to_string(other));
+        if (otherFind == svgImages.end() || std::abs(other - resolution) >= closestDistance) continue;
+        closest = otherFind->second;
+        closestDistance = std::abs(other - resolution);
+    }
+    closest->markUsed();
+    return closest;
+}
+
 Image::Image(std::string filePath) {
     if (!loadImageFromFile(filePath, false)) return;
     std::string imgId = filePath.substr(0, filePath.find_last_of('.'));
@@ -58,7 +722,7 @@ void Image::render(double xPos, double yPos, bool centered) {
 
         SDL_Point center = {image->renderRect.w / 2, image->renderRect.h / 2};
 
-        image->freeTimer = image->maxFreeTime;
+        image->markUsed();
         SDL_RenderCopyEx(renderer, image->spriteTexture, &image->textureRect, &image->renderRect, rotation, &center, SDL_FLIP_NONE);
     }
 }
@@ -146,13 +810,24 @@ void Image::loadImages(mz_zip_archive *zip) {
     // }
 }
 
+/**
+ * Makes a prefetched image expire like any other, now that something asked for it.
+ */
+static void claimPrefetchedImage(const std::string &imgId, SDL_Image *image) {
+    if (prefetchedImages.erase(imgId) != 0) trackImage(imageCache, imgId, image);
+}
+
 /**
  * Loads a single `SDL_Image` from an unzipped filepath .
  * @param filePath
  */
 bool Image::loadImageFromFile(std::string filePath, bool fromScratchProject) {
     std::string imgId = filePath.substr(0, filePath.find_last_of('.'));
-    if (images.find(imgId) != images.end()) return true;
+    auto imgFind = images.find(imgId);
+    if (imgFind != images.end()) {
+        claimPrefetchedImage(imgId, imgFind->second);
+        return true;
+    }
 
     std::string finalPath;
 
@@ -164,28 +839,56 @@ bool Image::loadImageFromFile(std::string filePath, bool fromScratchProject) {
 
     finalPath = finalPath + filePath;
 
-    // SDL_Image *image = new SDL_Image(finalPath);
-    SDL_Image *image = MemoryTracker::allocate<SDL_Image>();
-    new (image) SDL_Image(finalPath);
-
     // Check if it's an SVG file
     bool isSVG = filePath.size() >= 4 &&
                  (filePath.substr(filePath.size() - 4) == ".svg" ||
                   filePath.substr(filePath.size() - 4) == ".SVG");
 
-    if (isSVG) image->isSVG = true;
-
-    // Track texture memory
-    if (image->spriteTexture) {
-        size_t textureMemory = image->width * image->height * 4;
-        MemoryTracker::allocateVRAM(textureMemory);
-        image->memorySize = textureMemory;
+    // SDL_Image *image = new SDL_Image(finalPath);
+    SDL_Image *image = MemoryTracker::allocate<SDL_Image>();
+    if (fromScratchProject && TexturePolicy::enabled) {
+        new (image) SDL_Image();
+        image->isSVG = isSVG;
+        SDL_Surface *surface = IMG_Load(finalPath.c_str());
+        if (!surface) {
+            Log::logWarning(std::string("Error loading image: ") + IMG_GetError());
+        } else {
+            if (!createCostumeTexture(image, surface, imgId)) Log::logWarning("Error creating texture");
+            SDL_FreeSurface(surface);
+        }
+    } else {
+        new (image) SDL_Image(finalPath, fromScratchProject);
     }
 
+    if (isSVG) image->isSVG = true;
+
+    trackImage(imageCache, imgId, image);
     images[imgId] = image;
     return true;
 }
 
+static std::string getExtension(const std::string &fileName) {
+    const size_t dot = fileName.find_last_of('.');
+    if (dot == std::string::npos) return "";
+    std::string ext = fileName.substr(dot);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext;
+}
+
+/**
+ * Checks if a file is a bitmap or SVG that SDL_image can load.
+ */
+static bool isImageFile(const std::string &fileName) {
+    const std::string ext = getExtension(fileName);
+    return ext == ".svg" ||
+           ext == ".bmp" || ext == ".gif" || ext == ".jpg" || ext == ".jpeg" ||
+           ext == ".lbm" || ext == ".iff" || ext == ".pcx" || ext == ".png" ||
+           ext == ".pnm" || ext == ".ppm" || ext == ".pgm" || ext == ".pbm" ||
+           ext == ".qoi" || ext == ".tga" || ext == ".tiff" || ext == ".xcf" ||
+           ext == ".xpm" || ext == ".xv" || ext == ".ico" || ext == ".cur" ||
+           ext == ".ani" || ext == ".webp" || ext == ".avif" || ext == ".jxl";
+}
+
 /**
  * Loads a single image from a Scratch sb3 zip file by filename.
  * @param zip Pointer to the zip archive
@@ -193,7 +896,11 @@ bool Image::loadImageFromFile(std::string filePath, bool fromScratchProject) {
  */
 void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId) {
     std::string imgId = costumeId.substr(0, costumeId.find_last_of('.'));
-    if (images.find(imgId) != images.end()) return;
+    auto imgFind = images.find(imgId);
+    if (imgFind != images.end()) {
+        claimPrefetchedImage(imgId, imgFind->second);
+        return;
+    }
 
     // Log::log("Loading single image: " + costumeId);
 
@@ -212,20 +919,8 @@ void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId)
     }
 
     // Check if file is bitmap or SVG
-    bool isBitmap = costumeId.size() > 4 && ([](std::string ext) {
-                        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-                        return ext == ".bmp" || ext == ".gif" || ext == ".jpg" || ext == ".jpeg" ||
-                               ext == ".lbm" || ext == ".iff" || ext == ".pcx" || ext == ".png" ||
-                               ext == ".pnm" || ext == ".ppm" || ext == ".pgm" || ext == ".pbm" ||
-                               ext == ".qoi" || ext == ".tga" || ext == ".tiff" || ext == ".xcf" ||
-                               ext == ".xpm" || ext == ".xv" || ext == ".ico" || ext == ".cur" ||
-                               ext == ".ani" || ext == ".webp" || ext == ".avif" || ext == ".jxl";
-                    }(costumeId.substr(costumeId.find_last_of('.'))));
-    bool isSVG = costumeId.size() >= 4 &&
-                 (costumeId.substr(costumeId.size() - 4) == ".svg" ||
-                  costumeId.substr(costumeId.size() - 4) == ".SVG");
-
-    if (!isBitmap && !isSVG) {
+    bool isSVG = getExtension(costumeId) == ".svg";
+    if (!isImageFile(costumeId)) {
         Log::logWarning("File is not a supported image format: " + costumeId);
         return;
     }
@@ -256,49 +951,252 @@ void Image::loadImageFromSB3(mz_zip_archive *zip, const std::string &costumeId)
         return;
     }
 
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
-    if (!texture) {
+    // Build SDL_Image object
+    SDL_Image *image = MemoryTracker::allocate<SDL_Image>();
+    new (image) SDL_Image();
+    if (isSVG) image->isSVG = true;
+
+    if (!createCostumeTexture(image, surface, imgId)) {
         Log::logWarning("Failed to create texture: " + costumeId);
         SDL_FreeSurface(surface);
+        image->~SDL_Image();
+        MemoryTracker::deallocate<SDL_Image>(image);
         return;
     }
 
     SDL_FreeSurface(surface);
 
-    // Build SDL_Image object
-    SDL_Image *image = MemoryTracker::allocate<SDL_Image>();
-    new (image) SDL_Image();
-    if (isSVG) image->isSVG = true;
-    image->spriteTexture = texture;
-    SDL_QueryTexture(texture, nullptr, nullptr, &image->width, &image->height);
-    image->renderRect = {0, 0, image->width, image->height};
-    image->textureRect = {0, 0, image->width, image->height};
-
-    // calculate VRAM usage
-    Uint32 format;
-    int w, h;
-    SDL_QueryTexture(texture, &format, NULL, &w, &h);
-    int bpp;
-    Uint32 Rmask, Gmask, Bmask, Amask;
-    SDL_PixelFormatEnumToMasks(format, &bpp, &Rmask, &Gmask, &Bmask, &Amask);
-    image->memorySize = (w * h * bpp) / 8;
-    MemoryTracker::allocateVRAM(image->memorySize);
-
     // Log::log("Successfully loaded image: " + costumeId);
+    trackImage(imageCache, imgId, image);
     images[imgId] = image;
 }
 
+struct DecodeJob {
+    std::string fileName;
+    std::string data;
+    SDL_Surface *surface = nullptr;
+    bool found = false;
+};
+
+void Image::loadImagesFromProject(const std::vector<std::string> &fileNames, const std::function<void(size_t)> &onLoaded) {
+    std::vector<DecodeJob> jobs;
+    for (const std::string &fileName : fileNames) {
+        const std::string imgId = fileName.substr(0, fileName.find_last_of('.'));
+        if (images.find(imgId) != images.end()) continue;
+        if (std::any_of(jobs.begin(), jobs.end(), [&fileName](const DecodeJob &job) { return job.fileName == fileName; })) continue;
+        if (!isImageFile(fileName)) {
+            Log::logWarning("File is not a supported image format: " + fileName);
+            continue;
+        }
+        jobs.emplace_back();
+        jobs.back().fileName = fileName;
+    }
+
+    size_t loadedCount = 0;
+    WorkerPool::run(
+        jobs.size(),
+        [&jobs](size_t i) {
+            DecodeJob &job = jobs[i];
+            job.found = readCostumeFile(job.fileName, job.data);
+            if (!job.found) return;
+
+            // SDL_image loads the other decoders the first time they're used, which isn't safe to do from many threads
+            const std::string ext = getExtension(job.fileName);
+            if (ext != ".png" && ext != ".jpg" && ext != ".jpeg" && ext != ".svg") return;
+            SDL_RWops *rw = SDL_RWFromConstMem(job.data.data(), job.data.size());
+            if (rw) job.surface = IMG_Load_RW(rw, 1);
+            job.data.clear();
+            job.data.shrink_to_fit();
+        },
+        [&jobs, &loadedCount, &onLoaded](size_t i) {
+            DecodeJob &job = jobs[i];
+            loadedCount++;
+            if (onLoaded) onLoaded(loadedCount);
+
+            if (!job.found) {
+                Log::logWarning("Image file not found: " + job.fileName);
+                return;
+            }
+            if (!job.surface && !job.data.empty()) {
+                SDL_RWops *rw = SDL_RWFromConstMem(job.data.data(), job.data.size());
+                if (rw) job.surface = IMG_Load_RW(rw, 1);
+                job.data.clear();
+            }
+            if (!job.surface) {
+                Log::logWarning("Failed to load image: " + job.fileName);
+                return;
+            }
+
+            SDL_Image *image = MemoryTracker::allocate<SDL_Image>();
+            new (image) SDL_Image();
+            image->isSVG = getExtension(job.fileName) == ".svg";
+            const std::string imgId = job.fileName.substr(0, job.fileName.find_last_of('.'));
+            if (createCostumeTexture(image, job.surface, imgId)) {
+                trackImage(imageCache, imgId, image);
+                images[imgId] = image;
+            } else {
+                Log::logWarning("Failed to create texture: " + job.fileName);
+                image->~SDL_Image();
+                MemoryTracker::deallocate<SDL_Image>(image);
+            }
+            SDL_FreeSurface(job.surface);
+            job.surface = nullptr;
+        });
+}
+
+static void decodePrefetchJob(PrefetchJob &job) {
+    SDL_RWops *rw = SDL_RWFromConstMem(job.data.data(), job.data.size());
+    if (rw) job.surface = IMG_Load_RW(rw, 1);
+    job.data.clear();
+    job.data.shrink_to_fit();
+}
+
+static int prefetchThread(void *data) {
+    SDL_LockMutex(prefetchMutex);
+    while (true) {
+        if (prefetchJobs.empty()) {
+            SDL_CondWait(prefetchCondition, prefetchMutex);
+            continue;
+        }
+        PrefetchJob *job = prefetchJobs.front();
+        prefetchJobs.pop_front();
+
+        SDL_UnlockMutex(prefetchMutex);
+        decodePrefetchJob(*job);
+        SDL_LockMutex(prefetchMutex);
+
+        prefetchResults.push_back(job);
+    }
+    return 0;
+}
+
+static void deletePrefetchJob(PrefetchJob *job) {
+    if (job->surface) SDL_FreeSurface(job->surface);
+    delete job;
+}
+
+void Image::prefetchImages(const std::vector<std::string> &fileNames) {
+    for (const std::string &fileName : fileNames) {
+        // SDL_image loads the other decoders the first time they're used, which isn't safe to do from another thread
+        const std::string ext = getExtension(fileName);
+        if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".svg") prefetchQueue.push_back(fileName);
+    }
+    if (prefetchQueue.empty() || prefetchMutex) return;
+
+    prefetchMutex = SDL_CreateMutex();
+    prefetchCondition = SDL_CreateCond();
+    SDL_Thread *thread = SDL_CreateThread(prefetchThread, "CostumePrefetch", nullptr);
+    if (!thread) {
+        Log::logWarning("Failed to create SDL thread: " + std::string(SDL_GetError()));
+    } else {
+        SDL_DetachThread(thread);
+        prefetchThreadRunning = true;
+    }
+}
+
+/**
+ * Turns costumes the prefetch thread finished into textures, and hands it the next one.
+ * Files get read here instead of on the prefetch thread, so closing the project can't close the sb3 mid-read.
+ */
+void Image::updatePrefetch() {
+    if (!prefetchMutex) return;
+
+    std::deque<PrefetchJob *> results;
+    SDL_LockMutex(prefetchMutex);
+    results.swap(prefetchResults);
+    SDL_UnlockMutex(prefetchMutex);
+
+    for (PrefetchJob *job : results) {
+        const std::string imgId = job->fileName.substr(0, job->fileName.find_last_of('.'));
+
+        // the project might have been closed, or the costume loaded anyway, while it was decoding
+        if (prefetchPending.erase(job->fileName) == 0 || !job->surface || images.find(imgId) != images.end()) {
+            deletePrefetchJob(job);
+            continue;
+        }
+
+        SDL_Image *image = MemoryTracker::allocate<SDL_Image>();
+        new (image) SDL_Image();
+        image->isSVG = getExtension(job->fileName) == ".svg";
+        if (createCostumeTexture(image, job->surface, imgId)) {
+            images[imgId] = image;
+            prefetchedImages.insert(imgId);
+        } else {
+            image->~SDL_Image();
+            MemoryTracker::deallocate<SDL_Image>(image);
+        }
+        deletePrefetchJob(job);
+    }
+
+    const double startTime = FrameScheduler::getTimeMs();
+    while (!prefetchQueue.empty() && prefetchPending.size() < MAX_PREFETCH_PENDING && CostumePrefetch::hasMemoryForMore() &&
+           FrameScheduler::getTimeMs() - startTime < CostumePrefetch::MS_PER_FRAME) {
+        const std::string fileName = prefetchQueue.front();
+        prefetchQueue.pop_front();
+        if (images.find(fileName.substr(0, fileName.find_last_of('.'))) != images.end()) continue;
+
+        PrefetchJob *job = new PrefetchJob();
+        job->fileName = fileName;
+        if (!readCostumeFile(fileName, job->data)) {
+            delete job;
+            continue;
+        }
+        prefetchPending.insert(fileName);
+        if (!prefetchThreadRunning) decodePrefetchJob(*job);
+
+        SDL_LockMutex(prefetchMutex);
+        if (prefetchThreadRunning) {
+            prefetchJobs.push_back(job);
+            SDL_CondSignal(prefetchCondition);
+        } else {
+            prefetchResults.push_back(job);
+        }
+        SDL_UnlockMutex(prefetchMutex);
+    }
+}
+
 void Image::cleanupImages() {
     for (auto &[id, image] : images) {
-        if (image->memorySize > 0) {
-            MemoryTracker::deallocateVRAM(image->memorySize);
-        }
-        // delete image;
         image->~SDL_Image();
         MemoryTracker::deallocate<SDL_Image>(image);
     }
     images.clear();
     toDelete.clear();
+    for (AtlasPage &page : atlasPages) {
+        if (page.texture) destroyAtlasPage(page);
+    }
+    atlasPages.clear();
+
+    while (!effectImages.empty()) {
+        freeEffectImage(effectImages.begin());
+    }
+    effectSources.clear();
+    effectSourceCache.clear();
+
+    while (!svgImages.empty()) {
+        freeSVGImage(svgImages.begin());
+    }
+    svgPending.clear();
+    if (svgMutex) {
+        SDL_LockMutex(svgMutex);
+        for (SVGRasterJob *job : svgJobs) {
+            delete job;
+        }
+        svgJobs.clear();
+        SDL_UnlockMutex(svgMutex);
+    }
+
+    prefetchQueue.clear();
+    prefetchPending.clear();
+    prefetchedImages.clear();
+    if (prefetchMutex) {
+        SDL_LockMutex(prefetchMutex);
+        for (PrefetchJob *job : prefetchJobs) {
+            deletePrefetchJob(job);
+        }
+        prefetchJobs.clear();
+        SDL_UnlockMutex(prefetchMutex);
+    }
 }
 
 /**
@@ -316,98 +1214,89 @@ void Image::freeImage(const std::string &costumeId) {
         MemoryTracker::deallocate<SDL_Image>(image);
 
         images.erase(imageIt);
+        prefetchedImages.erase(costumeId);
     }
 }
 
 /**
- * Checks every `SDL_Image` in memory to see if they can be freed.
- * An `SDL_Image` will get freed if it goes unused for 120 frames.
+ * Frees the costume that went unused the longest.
+ */
+static void freeOldestImage() {
+    const std::string id = imageCache.getOldest().id;
+    Image::freeImage(id);
+}
+
+/**
+ * Loads costumes `TexturePolicy` wants stored at another size again.
+ */
+static void reloadResizedImages() {
+    for (const std::string &fileName : TexturePolicy::takeReloads()) {
+        const std::string imgId = fileName.substr(0, fileName.find_last_of('.'));
+        if (images.find(imgId) == images.end()) continue;
+        Image::freeImage(imgId);
+        if (projectType == UNZIPPED) Image::loadImageFromFile(fileName);
+        else Image::loadImageFromSB3(&Unzip::zipArchive, fileName);
+    }
+}
+
+/**
+ * Frees every `SDL_Image` that went unused for `MAX_UNUSED_FRAMES` frames,
+ * and when RAM or VRAM runs low, prefetched costumes and then every costume that wasn't drawn this frame until enough is free.
  */
 void Image::FlushImages() {
+    for (const std::string &id : toDelete) {
+        Image::freeImage(id);
+    }
+    toDelete.clear();
+    reloadResizedImages();
 
-    // Free images if ram usage is too high
-    if (MemoryTracker::getVRAMUsage() + MemoryTracker::getCurrentUsage() > MemoryTracker::getMaxVRAMUsage() * 0.8) {
-
-        size_t times = 0;
-        while (MemoryTracker::getVRAMUsage() + MemoryTracker::getCurrentUsage() > MemoryTracker::getMaxVRAMUsage() * 0.5 && !images.empty()) {
-            SDL_Image *imgToDelete = nullptr;
-            std::string toDeleteStr = "";
-
-            for (auto &[id, img] : images) {
-                if (imgToDelete == nullptr && img->freeTimer != img->maxFreeTime) {
-                    imgToDelete = img;
-                    toDeleteStr = id;
-                    continue;
-                }
-                if (imgToDelete != nullptr && img->freeTimer < imgToDelete->freeTimer && img->freeTimer != img->maxFreeTime) {
-                    imgToDelete = img;
-                    toDeleteStr = id;
-                }
-            }
+    imageCache.keepDrawn();
+    effectImageCache.keepDrawn();
+    effectSourceCache.keepDrawn();
+    svgImageCache.keepDrawn();
 
-            if (toDeleteStr != "") {
-                Image::freeImage(toDeleteStr);
-            } else {
-                break;
-            }
-            times++;
-            if (times > 15) break;
+    if (LruCache::isOverBudget(LOW_MEMORY_START)) {
+        // prefetched images nothing asked for yet go first
+        while (LruCache::isOverBudget(LOW_MEMORY_STOP) && !prefetchedImages.empty()) {
+            const std::string id = *prefetchedImages.begin();
+            Image::freeImage(id);
         }
-    } else {
-        // Free images based on a timer
-        for (auto &[id, img] : images) {
-            if (img->freeTimer <= 0) {
-                toDelete.push_back(id);
-            } else {
-                img->freeTimer -= 1;
-            }
+        while (LruCache::isOverBudget(LOW_MEMORY_STOP) && !imageCache.empty() && !imageCache.isOldestInUse()) {
+            freeOldestImage();
         }
+    }
+    while (imageCache.hasExpired()) {
+        freeOldestImage();
+    }
 
-        for (const std::string &id : toDelete) {
-            Image::freeImage(id);
-        }
-        toDelete.clear();
+    while (effectImageCache.hasExpired()) {
+        freeEffectImage(effectImages.find(effectImageCache.getOldest().id));
+    }
+    while (effectSourceCache.hasExpired()) {
+        freeEffectSource(effectSources.find(effectSourceCache.getOldest().id));
+    }
+
+    collectSVGImages();
+    while (svgImageCache.hasExpired()) {
+        freeSVGImage(svgImages.find(svgImageCache.getOldest().id));
     }
+
+    LruCache::nextFrame();
 }
 
 SDL_Image::SDL_Image() {}
 
-SDL_Image::SDL_Image(std::string filePath) {
+SDL_Image::SDL_Image(std::string filePath, bool useAtlas) {
     spriteSurface = IMG_Load(filePath.c_str());
     if (spriteSurface == NULL) {
         Log::logWarning(std::string("Error loading image: ") + IMG_GetError());
         return;
     }
-    spriteTexture = SDL_CreateTextureFromSurface(renderer, spriteSurface);
-    if (spriteTexture == NULL) {
+    if (!createImageTexture(this, spriteSurface, useAtlas)) {
         Log::logWarning("Error creating texture");
-        return;
     }
     SDL_FreeSurface(spriteSurface);
 
-    // get width and height of image
-    int texW = 0;
-    int texH = 0;
-    SDL_QueryTexture(spriteTexture, NULL, NULL, &texW, &texH);
-    width = texW;
-    height = texH;
-    renderRect.w = width;
-    renderRect.h = height;
-    textureRect.w = width;
-    textureRect.h = height;
-    textureRect.x = 0;
-    textureRect.y = 0;
-
-    // calculate VRAM usage
-    Uint32 format;
-    int w, h;
-    SDL_QueryTexture(spriteTexture, &format, NULL, &w, &h);
-    int bpp;
-    Uint32 Rmask, Gmask, Bmask, Amask;
-    SDL_PixelFormatEnumToMasks(format, &bpp, &Rmask, &Gmask, &Bmask, &Amask);
-    memorySize = (w * h * bpp) / 8;
-    MemoryTracker::allocateVRAM(memorySize);
-
     // Log::log("Image loaded!");
 }
 
@@ -419,14 +1308,23 @@ void Image::queueFreeImage(const std::string &costumeId) {
 }
 
 SDL_Image::~SDL_Image() {
-    MemoryTracker::deallocateVRAM(memorySize);
-    SDL_DestroyTexture(spriteTexture);
+    if (cache) cache->remove(cacheEntry);
+    if (atlasPage != -1) {
+        freeAtlasRect(atlasPage, atlasRect);
+    } else {
+        MemoryTracker::deallocateVRAM(memorySize);
+        if (spriteTexture) SDL_DestroyTexture(spriteTexture);
+    }
+}
+
+void SDL_Image::markUsed() {
+    if (cache) cache->touch(cacheEntry);
 }
 
 void SDL_Image::setScale(float amount) {
     scale = amount;
-    renderRect.w = width * amount;
-    renderRect.h = height * amount;
+    renderRect.w = layout.width * amount;
+    renderRect.h = layout.height * amount;
 }
 
 void SDL_Image::setRotation(float rotate) {
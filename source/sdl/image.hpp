@@ -1,5 +1,8 @@
 #pragma once
 
+#include "lruCache.hpp"
+#include "sprite.hpp"
+#include "texturePolicy.hpp"
 #include <SDL2/SDL_image.h>
 #include <string>
 #include <unordered_map>
@@ -7,22 +10,27 @@
 class SDL_Image {
   public:
     SDL_Surface *spriteSurface;
-    SDL_Texture *spriteTexture;
+    SDL_Texture *spriteTexture = nullptr;
     SDL_Rect renderRect;  // this rect is for rendering to the screen
     SDL_Rect textureRect; // this is for like texture UV's
-    size_t memorySize;
+    int textureWidth;     // size of `spriteTexture`, which is bigger than the image if it's in an atlas page
+    int textureHeight;
+    int atlasPage = -1; // the atlas page the image is packed into, or -1 if it has its own texture
+    SDL_Rect atlasRect; // the space taken in the atlas page, including padding
+    size_t memorySize = 0;
     float scale = 1.0f;
-    int width;
+    TexturePolicy::Layout layout; // the part of the costume in the texture, and texture pixels per costume pixel as `scale`
+    int width;                    // size of the whole costume, or of the texture for SVGs rasterized bigger than their native size
     int height;
     bool isSVG = false;
     float rotation = 0.0f;
-#ifdef GAMECUBE
-    int maxFreeTime = 2;
-#else
-    int maxFreeTime = 480;
-#endif
+    LruCache *cache = nullptr; // the cache that frees the image once it goes unused, if any
+    LruCache::Handle cacheEntry;
 
-    int freeTimer = maxFreeTime;
+    /**
+     * Marks the image as used this frame, so it doesn't get freed.
+     */
+    void markUsed();
 
     /**
      * Scales an image by a scale factor.
@@ -42,10 +50,41 @@ class SDL_Image {
     /**
      * A Simple Image object using SDL.
      * @param filePath
+     * @param useAtlas If the image is allowed to be packed into an atlas page.
      */
-    SDL_Image(std::string filePath);
+    SDL_Image(std::string filePath, bool useAtlas = false);
 
     ~SDL_Image();
 };
 
-extern std::unordered_map<std::string, SDL_Image *> images;
\ No newline at end of file
+/**
+ * Creates the texture of an `SDL_Image` from a surface.
+ * Small enough images get packed into a shared atlas page, so many sprites can be drawn with one texture.
+ * @param image
+ * @param surface Still has to be freed by the caller.
+ * @param useAtlas If the image is allowed to be packed into an atlas page.
+ * @return `true` if the texture was created, `false` otherwise.
+ */
+bool createImageTexture(SDL_Image *image, SDL_Surface *surface, bool useAtlas);
+
+extern std::unordered_map<std::string, SDL_Image *> images;
+/**
+ * Gets a costume with graphic effects applied. Results (and the decoded costume they come from)
+ * are cached, up to an eighth of the max VRAM usage.
+ * @param costumeId
+ * @param fileName File name of the costume in the project, used to decode it again.
+ * @param effects
+ * @return The image with effects, or `nullptr` if the costume isn't loaded or couldn't be decoded.
+ */
+SDL_Image *getEffectImage(const std::string &costumeId, const std::string &fileName, const GraphicEffects &effects);
+
+/**
+ * Gets the sharpest version of an SVG costume for drawing at `screenScale` screen pixels per costume pixel.
+ * Versions bigger than the native size get rasterized on a background thread, and until one is ready
+ * the closest version that's already done is returned. They're cached, up to a quarter of the max VRAM usage.
+ * @param costumeId
+ * @param fileName File name of the costume in the project, used to rasterize it again.
+ * @param screenScale
+ * @return The image to draw, or `nullptr` if the costume isn't loaded.
+ */
+SDL_Image *getSVGImage(const std::string &costumeId, const std::string &fileName, double screenScale);
@@ -1,10 +1,17 @@
 #include "../scratch/render.hpp"
 #include "../scratch/audio.hpp"
 #include "../scratch/unzip.hpp"
+#include "effects.hpp"
+#include "frameScheduler.hpp"
 #include "image.hpp"
 #include "interpret.hpp"
+#include "layers.hpp"
+#include "lruCache.hpp"
 #include "math.hpp"
+#include "penLayer.hpp"
+#include "profiler.hpp"
 #include "render.hpp"
+#include "renderState.hpp"
 #include "sprite.hpp"
 #include "text.hpp"
 #include <SDL2/SDL.h>
@@ -53,6 +60,15 @@ int windowHeight = 360;
 SDL_Window *window = nullptr;
 SDL_Renderer *renderer = nullptr;
 
+// everything the pen has drawn, between the Stage and the sprites
+static SDL_Texture *penTexture = nullptr;
+static bool penTextureFailed = false;
+
+// vsync gets asked for, but not every driver gives it. without it, presents get limited to the display's refresh rate
+static bool vsyncEnabled = false;
+static int refreshRate = 60;
+static FrameScheduler presentScheduler;
+
 Render::RenderModes Render::renderMode = Render::TOP_SCREEN_ONLY;
 bool Render::hasFrameBegan;
 std::vector<Monitor> Render::visibleVariables;
@@ -160,11 +176,17 @@ postAccount:
     window = SDL_CreateWindow("Scratch Runtime", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, windowWidth, windowHeight, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
     renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
 
+    SDL_RendererInfo rendererInfo;
+    if (SDL_GetRendererInfo(renderer, &rendererInfo) == 0) vsyncEnabled = rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC;
+    SDL_DisplayMode displayMode;
+    if (SDL_GetCurrentDisplayMode(0, &displayMode) == 0 && displayMode.refresh_rate > 0) refreshRate = displayMode.refresh_rate;
+
     if (SDL_NumJoysticks() > 0) controller = SDL_GameControllerOpen(0);
 
     return true;
 }
 void Render::deInit() {
+    if (penTexture) SDL_DestroyTexture(penTexture);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SoundPlayer::deinit();
@@ -195,6 +217,12 @@ int Render::getHeight() {
     SDL_GetWindowSizeInPixels(window, &windowWidth, &windowHeight);
     return windowHeight;
 }
+int Render::getRefreshRate() {
+    return refreshRate;
+}
+bool Render::hasVsync() {
+    return vsyncEnabled;
+}
 
 void Render::beginFrame(int screen, int colorR, int colorG, int colorB) {
     if (!hasFrameBegan) {
@@ -206,7 +234,8 @@ void Render::beginFrame(int screen, int colorR, int colorG, int colorB) {
 
 void Render::endFrame(bool shouldFlush) {
     SDL_RenderPresent(renderer);
-    SDL_Delay(16);
+    if (!vsyncEnabled) presentScheduler.waitForFrame(refreshRate);
+    LruCache::markDrawn();
     if (shouldFlush) Image::FlushImages();
     hasFrameBegan = false;
 }
@@ -285,7 +314,293 @@ void drawBlackBars(int screenWidth, int screenHeight) {
     }
 }
 
+static std::vector<SDL_Vertex> batchVertices;
+static std::vector<int> batchIndices;
+static SDL_Texture *batchTexture = nullptr;
+
+/**
+ * Draws every sprite queued with `batchSprite()` in a single `SDL_RenderGeometry` call.
+ */
+static void flushSpriteBatch() {
+    if (!batchIndices.empty()) {
+        SDL_RenderGeometry(renderer, batchTexture, batchVertices.data(), batchVertices.size(), batchIndices.data(), batchIndices.size());
+    }
+    batchVertices.clear();
+    batchIndices.clear();
+    batchTexture = nullptr;
+}
+
+/**
+ * Queues an image to be drawn at its `renderRect`, rotated around its center.
+ * Images sharing a texture (like costumes in the same atlas page) are drawn together.
+ * @param image
+ * @param rotation In radians
+ * @param flip
+ * @param alpha
+ */
+static void batchSprite(SDL_Image *image, double rotation, SDL_RendererFlip flip, Uint8 alpha) {
+    if (image->spriteTexture != batchTexture) {
+        flushSpriteBatch();
+        batchTexture = image->spriteTexture;
+    }
+
+    const float halfWidth = image->renderRect.w / 2.0f;
+    const float halfHeight = image->renderRect.h / 2.0f;
+    const float centerX = image->renderRect.x + image->renderRect.w / 2;
+    const float centerY = image->renderRect.y + image->renderRect.h / 2;
+    const float cosRotation = std::cos(rotation);
+    const float sinRotation = std::sin(rotation);
+
+    float u0 = static_cast<float>(image->textureRect.x) / image->textureWidth;
+    float u1 = static_cast<float>(image->textureRect.x + image->textureRect.w) / image->textureWidth;
+    const float v0 = static_cast<float>(image->textureRect.y) / image->textureHeight;
+    const float v1 = static_cast<float>(image->textureRect.y + image->textureRect.h) / image->textureHeight;
+    if (flip == SDL_FLIP_HORIZONTAL) std::swap(u0, u1);
+
+    const float corners[4][4] = {
+        {-halfWidth, -halfHeight, u0, v0},
+        {halfWidth, -halfHeight, u1, v0},
+        {halfWidth, halfHeight, u1, v1},
+        {-halfWidth, halfHeight, u0, v1}};
+
+    const int firstVertex = batchVertices.size();
+    for (const auto &corner : corners) {
+        SDL_Vertex vertex;
+        vertex.position.x = centerX + corner[0] * cosRotation - corner[1] * sinRotation;
+        vertex.position.y = centerY + corner[0] * sinRotation + corner[1] * cosRotation;
+        vertex.color = {255, 255, 255, alpha};
+        vertex.tex_coord.x = corner[2];
+        vertex.tex_coord.y = corner[3];
+        batchVertices.push_back(vertex);
+    }
+    for (int index : {0, 1, 2, 0, 2, 3}) {
+        batchIndices.push_back(firstVertex + index);
+    }
+}
+
+/**
+ * Queues a pen line as a quad with a half circle on each end.
+ * @param line
+ * @param scale Screen pixels per Scratch unit
+ * @param originX Where Scratch's (0, 0) is on the render target
+ * @param originY
+ */
+static void batchLine(const PenLine &line, double scale, int originX, int originY) {
+    if (batchTexture != nullptr) flushSpriteBatch();
+
+    const float x1 = originX + line.x1 * scale;
+    const float y1 = originY - line.y1 * scale;
+    const float x2 = originX + line.x2 * scale;
+    const float y2 = originY - line.y2 * scale;
+    const float radius = std::max(0.5, line.size * scale / 2);
+    const float length = std::hypot(x2 - x1, y2 - y1);
+    const float angle = length > 0 ? std::atan2(y2 - y1, x2 - x1) : 0;
+    const int segments = std::clamp(static_cast<int>(radius), 4, 32);
+    const SDL_Color color = {line.r, line.g, line.b, line.a};
+
+    auto addVertex = [&](float x, float y) {
+        SDL_Vertex vertex;
+        vertex.position.x = x;
+        vertex.position.y = y;
+        vertex.color = color;
+        vertex.tex_coord.x = 0;
+        vertex.tex_coord.y = 0;
+        batchVertices.push_back(vertex);
+    };
+
+    // half circle around each end, facing away from the other end
+    for (int end = 0; end < 2; end++) {
+        const float centerX = end == 0 ? x1 : x2;
+        const float centerY = end == 0 ? y1 : y2;
+        const float startAngle = angle + (end == 0 ? M_PI / 2 : -M_PI / 2);
+
+        const int center = batchVertices.size();
+        addVertex(centerX, centerY);
+        for (int i = 0; i <= segments; i++) {
+            const float pointAngle = startAngle + M_PI * i / segments;
+            addVertex(centerX + std::cos(pointAngle) * radius, centerY + std::sin(pointAngle) * radius);
+        }
+        for (int i = 0; i < segments; i++) {
+            batchIndices.push_back(center);
+            batchIndices.push_back(center + 1 + i);
+            batchIndices.push_back(center + 2 + i);
+        }
+    }
+
+    if (length > 0) {
+        const float normalX = -std::sin(angle) * radius;
+        const float normalY = std::cos(angle) * radius;
+        const int firstVertex = batchVertices.size();
+        addVertex(x1 + normalX, y1 + normalY);
+        addVertex(x2 + normalX, y2 + normalY);
+        addVertex(x2 - normalX, y2 - normalY);
+        addVertex(x1 - normalX, y1 - normalY);
+        for (int index : {0, 1, 2, 0, 2, 3}) {
+            batchIndices.push_back(firstVertex + index);
+        }
+    }
+}
+
+/**
+ * Scales and positions a costume image the way Scratch places it, for both sprites and pen stamps.
+ * @param image
+ * @param xPosition
+ * @param yPosition
+ * @param size
+ * @param direction
+ * @param rotationStyle
+ * @param costumeCenterX Rotation center of the costume
+ * @param costumeCenterY
+ * @param scale Screen pixels per Scratch unit
+ * @param originX Where Scratch's (0, 0) is on the render target
+ * @param originY
+ * @param flip Gets set to how the image should be flipped
+ * @return The rotation to draw the image with, in radians
+ */
+static double placeCostume(SDL_Image *image, double xPosition, double yPosition, double size, double direction, Sprite::RotationStyle rotationStyle,
+                           int costumeCenterX, int costumeCenterY, double scale, int originX, int originY, SDL_RendererFlip *flip) {
+    image->setScale((size * 0.01) * scale / 2.0f);
+    const int spriteWidth = image->layout.width / 2;
+    const int spriteHeight = image->layout.height / 2;
+    if (image->isSVG) {
+        image->setScale(image->scale * 2);
+    }
+    const double rotation = Math::degreesToRadians(direction - 90.0f);
+    double renderRotation = rotation;
+    *flip = SDL_FLIP_NONE;
+
+    if (rotationStyle == Sprite::LEFT_RIGHT) {
+        if (std::cos(rotation) < 0) {
+            *flip = SDL_FLIP_HORIZONTAL;
+        }
+        renderRotation = 0;
+    }
+    if (rotationStyle == Sprite::NONE) {
+        renderRotation = 0;
+    }
+
+    // measured from the part of the costume that's in the texture, in case `TexturePolicy` trimmed the rest
+    double rotationCenterX = ((((costumeCenterX - image->layout.x - spriteWidth)) / 2) * scale);
+    double rotationCenterY = ((((costumeCenterY - image->layout.y - spriteHeight)) / 2) * scale);
+
+    const double offsetX = rotationCenterX * (size * 0.01);
+    const double offsetY = rotationCenterY * (size * 0.01);
+
+    image->renderRect.x = ((xPosition * scale) + originX - (image->renderRect.w / 2)) - offsetX * std::cos(rotation) + offsetY * std::sin(renderRotation);
+    image->renderRect.y = ((yPosition * -scale) + originY - (image->renderRect.h / 2)) - offsetX * std::sin(rotation) - offsetY * std::cos(renderRotation);
+    return renderRotation;
+}
+
+/**
+ * Tells `TexturePolicy` how big a costume is about to be drawn, if it's on.
+ * @param screenScale Screen pixels per pixel of the costume.
+ */
+static void observeScale(const std::string &costumeId, const std::string &fileName, const SDL_Image *image, double screenScale) {
+    if (!TexturePolicy::enabled || image->isSVG) return;
+    TexturePolicy::observeScale(costumeId, fileName, screenScale, image->layout);
+}
+
+/**
+ * Makes sure the pen texture is the size of the Stage on screen, keeping what was drawn on it.
+ * @param width
+ * @param height
+ * @return `false` if the renderer can't draw to textures.
+ */
+static bool updatePenTexture(int width, int height) {
+    int currentWidth = 0;
+    int currentHeight = 0;
+    if (penTexture) SDL_QueryTexture(penTexture, nullptr, nullptr, &currentWidth, &currentHeight);
+    if (penTexture && currentWidth == width && currentHeight == height) return true;
+    if (penTextureFailed || width <= 0 || height <= 0) return false;
+
+    SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    if (!texture) {
+        Log::logWarning("Pen is not supported by this renderer: " + std::string(SDL_GetError()));
+        penTextureFailed = true;
+        return false;
+    }
+
+    // the pen texture ends up premultiplied, since it's drawn onto with normal blending while transparent
+    const SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                                                   SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    if (SDL_SetTextureBlendMode(texture, premultiplied) != 0) {
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    }
+
+    SDL_SetRenderTarget(renderer, texture);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+    if (penTexture) {
+        SDL_RenderCopy(renderer, penTexture, nullptr, nullptr);
+        SDL_DestroyTexture(penTexture);
+    }
+    SDL_SetRenderTarget(renderer, nullptr);
+
+    penTexture = texture;
+    return true;
+}
+
+/**
+ * Draws everything the pen blocks queued up since the last frame onto the pen texture.
+ * @param stageRect Where the Stage is on screen
+ * @param scale Screen pixels per Scratch unit
+ */
+static void drawPenQueue(const SDL_Rect &stageRect, double scale) {
+    if (!updatePenTexture(stageRect.w, stageRect.h)) {
+        PenLayer::clearQueue();
+        return;
+    }
+
+    SDL_BlendMode drawBlendMode;
+    SDL_GetRenderDrawBlendMode(renderer, &drawBlendMode);
+    SDL_SetRenderTarget(renderer, penTexture);
+    if (PenLayer::shouldClear) {
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+    }
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+    const int originX = stageRect.w / 2;
+    const int originY = stageRect.h / 2;
+    size_t line = 0;
+    for (const PenStamp &stamp : PenLayer::stamps) {
+        for (; line < stamp.lineCount; line++) {
+            batchLine(PenLayer::lines[line], scale, originX, originY);
+        }
+
+        auto imgFind = images.find(stamp.costumeId);
+        if (imgFind == images.end()) continue;
+        SDL_Image *image = imgFind->second;
+        image->markUsed();
+        observeScale(stamp.costumeId, stamp.costumeFile, image, stamp.size * 0.01 * scale / 2);
+        if (Effects::isActive(stamp.effects)) {
+            SDL_Image *effectImage = getEffectImage(stamp.costumeId, stamp.costumeFile, stamp.effects);
+            if (effectImage) image = effectImage;
+        } else if (image->isSVG) {
+            image = getSVGImage(stamp.costumeId, stamp.costumeFile, stamp.size * 0.01 * scale);
+        }
+
+        SDL_RendererFlip flip;
+        const double renderRotation = placeCostume(image, stamp.xPosition, stamp.yPosition, stamp.size, stamp.rotation, stamp.rotationStyle,
+                                                   stamp.rotationCenterX, stamp.rotationCenterY, scale, originX, originY, &flip);
+        float ghost = std::clamp(stamp.ghostEffect, 0.0f, 100.0f);
+        Uint8 alpha = static_cast<Uint8>(255 * (1.0f - ghost / 100.0f));
+        if (alpha > 0) batchSprite(image, renderRotation, flip, alpha);
+    }
+    for (; line < PenLayer::lines.size(); line++) {
+        batchLine(PenLayer::lines[line], scale, originX, originY);
+    }
+    flushSpriteBatch();
+
+    SDL_SetRenderTarget(renderer, nullptr);
+    SDL_SetRenderDrawBlendMode(renderer, drawBlendMode);
+    PenLayer::clearQueue();
+}
+
 void Render::renderSprites() {
+    // nothing changed, so the last frame is still on screen
+    if (!RenderState::shouldRedraw()) return;
+
     SDL_GetWindowSizeInPixels(window, &windowWidth, &windowHeight);
     SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
     SDL_RenderClear(renderer);
@@ -295,37 +610,48 @@ void Render::renderSprites() {
     double scale;
     scale = std::min(scaleX, scaleY);
 
+    SDL_Rect stageRect = {0, 0, 0, 0};
+    if (static_cast<float>(windowWidth) / windowHeight > static_cast<float>(Scratch::projectWidth) / Scratch::projectHeight) {
+        stageRect.x = std::ceil((windowWidth - Scratch::projectWidth * (static_cast<float>(windowHeight) / Scratch::projectHeight)) / 2.0f);
+        stageRect.w = windowWidth - stageRect.x * 2;
+        stageRect.h = windowHeight;
+    } else {
+        stageRect.y = std::ceil((windowHeight - Scratch::projectHeight * (static_cast<float>(windowWidth) / Scratch::projectWidth)) / 2.0f);
+        stageRect.h = windowHeight - stageRect.y * 2;
+        stageRect.w = windowWidth;
+    }
+
     auto stage = *std::find_if(sprites.begin(), sprites.end(), [](const Sprite *sprite) {
         return sprite->isStage;
     }); // TODO: Add handling for the stage is missing for some reason
     auto stageImgFind = images.find(stage->costumes[stage->currentCostume].id);
 
     if (stageImgFind != images.end()) {
-        SDL_Rect renderRect = {0, 0, 0, 0};
-
-        if (static_cast<float>(windowWidth) / windowHeight > static_cast<float>(Scratch::projectWidth) / Scratch::projectHeight) {
-            renderRect.x = std::ceil((windowWidth - Scratch::projectWidth * (static_cast<float>(windowHeight) / Scratch::projectHeight)) / 2.0f);
-            renderRect.w = windowWidth - renderRect.x * 2;
-            renderRect.h = windowHeight;
-        } else {
-            renderRect.y = std::ceil((windowHeight - Scratch::projectHeight * (static_cast<float>(windowWidth) / Scratch::projectWidth)) / 2.0f);
-            renderRect.h = windowHeight - renderRect.y * 2;
-            renderRect.w = windowWidth;
+        SDL_Image *stageImage = stageImgFind->second;
+        const Costume &costume = stage->costumes[stage->currentCostume];
+        observeScale(costume.id, costume.fullName, stageImage, static_cast<double>(stageRect.w) / stageImage->width);
+        if (Effects::isActive(stage->effects)) {
+            SDL_Image *effectImage = getEffectImage(costume.id, costume.fullName, stage->effects);
+            if (effectImage) stageImage = effectImage;
         }
 
-        SDL_RenderCopy(renderer, stageImgFind->second->spriteTexture, NULL, &renderRect);
+        // only the part of the backdrop that's in the texture
+        const TexturePolicy::Layout &layout = stageImage->layout;
+        SDL_Rect backdropRect = stageRect;
+        if (layout.width != stageImage->width || layout.height != stageImage->height) {
+            backdropRect.x = stageRect.x + layout.x * stageRect.w / stageImage->width;
+            backdropRect.y = stageRect.y + layout.y * stageRect.h / stageImage->height;
+            backdropRect.w = layout.width * stageRect.w / stageImage->width;
+            backdropRect.h = layout.height * stageRect.h / stageImage->height;
+        }
+        SDL_RenderCopy(renderer, stageImage->spriteTexture, &stageImage->textureRect, &backdropRect);
     }
 
-    // Sort sprites by layer first
-    std::vector<Sprite *> spritesByLayer = sprites;
-    std::sort(spritesByLayer.begin(), spritesByLayer.end(),
-              [](const Sprite *a, const Sprite *b) {
-                  return a->layer < b->layer;
-              });
+    if (PenLayer::hasQueued()) drawPenQueue(stageRect, scale);
+    if (penTexture) SDL_RenderCopy(renderer, penTexture, nullptr, &stageRect);
 
-    for (Sprite *currentSprite : spritesByLayer) {
+    for (Sprite *currentSprite = Layers::getBottom(); currentSprite != nullptr; currentSprite = currentSprite->layerAbove) {
         if (!currentSprite->visible) continue;
-        if (currentSprite->isStage) continue;
 
         bool legacyDrawing = false;
         auto imgFind = images.find(currentSprite->costumes[currentSprite->currentCostume].id);
@@ -337,45 +663,31 @@ void Render::renderSprites() {
         }
         if (!legacyDrawing) {
             SDL_Image *image = imgFind->second;
-            image->freeTimer = image->maxFreeTime;
-            SDL_RendererFlip flip = SDL_FLIP_NONE;
-
-            image->setScale((currentSprite->size * 0.01) * scale / 2.0f);
-            currentSprite->spriteWidth = image->textureRect.w / 2;
-            currentSprite->spriteHeight = image->textureRect.h / 2;
-            if (image->isSVG) {
-                image->setScale(image->scale * 2);
-            }
-            const double rotation = Math::degreesToRadians(currentSprite->rotation - 90.0f);
-            double renderRotation = rotation;
-
-            if (currentSprite->rotationStyle == currentSprite->LEFT_RIGHT) {
-                if (std::cos(rotation) < 0) {
-                    flip = SDL_FLIP_HORIZONTAL;
-                }
-                renderRotation = 0;
-            }
-            if (currentSprite->rotationStyle == currentSprite->NONE) {
-                renderRotation = 0;
+            image->markUsed();
+            currentSprite->spriteWidth = image->width / 2;
+            currentSprite->spriteHeight = image->height / 2;
+            const Costume &costume = currentSprite->costumes[currentSprite->currentCostume];
+            observeScale(costume.id, costume.fullName, image, currentSprite->size * 0.01 * scale / 2);
+            if (Effects::isActive(currentSprite->effects)) {
+                SDL_Image *effectImage = getEffectImage(costume.id, costume.fullName, currentSprite->effects);
+                if (effectImage) image = effectImage;
+            } else if (image->isSVG) {
+                // SVGs are drawn at their native size when the sprite is at 100%, so bigger sprites get a sharper version
+                image = getSVGImage(costume.id, costume.fullName, currentSprite->size * 0.01 * scale);
             }
 
-            double rotationCenterX = ((((currentSprite->rotationCenterX - currentSprite->spriteWidth)) / 2) * scale);
-            double rotationCenterY = ((((currentSprite->rotationCenterY - currentSprite->spriteHeight)) / 2) * scale);
-
-            const double offsetX = rotationCenterX * (currentSprite->size * 0.01);
-            const double offsetY = rotationCenterY * (currentSprite->size * 0.01);
-
-            image->renderRect.x = ((currentSprite->xPosition * scale) + (windowWidth / 2) - (image->renderRect.w / 2)) - offsetX * std::cos(rotation) + offsetY * std::sin(renderRotation);
-            image->renderRect.y = ((currentSprite->yPosition * -scale) + (windowHeight / 2) - (image->renderRect.h / 2)) - offsetX * std::sin(rotation) - offsetY * std::cos(renderRotation);
-            SDL_Point center = {image->renderRect.w / 2, image->renderRect.h / 2};
+            SDL_RendererFlip flip;
+            const double renderRotation = placeCostume(image, currentSprite->xPosition, currentSprite->yPosition, currentSprite->size, currentSprite->rotation,
+                                                       currentSprite->rotationStyle, currentSprite->rotationCenterX, currentSprite->rotationCenterY,
+                                                       scale, windowWidth / 2, windowHeight / 2, &flip);
 
             // ghost effect
             float ghost = std::clamp(currentSprite->ghostEffect, 0.0f, 100.0f);
             Uint8 alpha = static_cast<Uint8>(255 * (1.0f - ghost / 100.0f));
-            SDL_SetTextureAlphaMod(image->spriteTexture, alpha);
 
-            SDL_RenderCopyEx(renderer, image->spriteTexture, &image->textureRect, &image->renderRect, Math::radiansToDegrees(renderRotation), &center, flip);
+            if (alpha > 0) batchSprite(image, renderRotation, flip, alpha);
         } else {
+            flushSpriteBatch();
             currentSprite->spriteWidth = 64;
             currentSprite->spriteHeight = 64;
             SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
@@ -404,12 +716,15 @@ void Render::renderSprites() {
         //     SDL_RenderFillRect(renderer, &debugPointRect);
         // }
     }
+    flushSpriteBatch();
 
     drawBlackBars(windowWidth, windowHeight);
     renderVisibleVariables();
+#ifdef ENABLE_PROFILER
+    Profiler::renderOverlay();
+#endif
 
     SDL_RenderPresent(renderer);
-    Image::FlushImages();
 }
 
 std::unordered_map<std::string, TextObject *> Render::monitorTexts;
@@ -471,6 +786,10 @@ bool Render::appShouldRun() {
         case SDL_CONTROLLERDEVICEADDED:
             controller = SDL_GameControllerOpen(0);
             break;
+        case SDL_WINDOWEVENT:
+            // resized or uncovered, so the window has to be drawn again
+            RenderState::markChanged();
+            break;
         case SDL_FINGERDOWN:
             touchActive = true;
             touchPosition = {
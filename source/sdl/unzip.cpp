@@ -18,7 +18,6 @@ volatile bool Unzip::threadFinished;
 std::string Unzip::filePath = "";
 std::string Unzip::loadingState = "";
 mz_zip_archive Unzip::zipArchive;
-std::vector<char> Unzip::zipBuffer;
 
 int Unzip::openFile(std::ifstream *file) {
     Log::log("Unzipping Scratch project...");
@@ -42,6 +41,7 @@ int Unzip::openFile(std::ifstream *file) {
         Log::logWarning("No unzipped project, trying embedded.");
         projectType = EMBEDDED;
         file->open(embeddedFilename, std::ios::binary | std::ios::ate);
+        archivePath = embeddedFilename;
         if (!(*file)) {
 
             // Main menu
@@ -53,7 +53,8 @@ int Unzip::openFile(std::ifstream *file) {
             } else {
                 // SD card Project
                 Log::logWarning("Main Menu already done, loading SD card project.");
-                file->open(OS::getScratchFolderLocation() + filePath, std::ios::binary | std::ios::ate);
+                archivePath = OS::getScratchFolderLocation() + filePath;
+                file->open(archivePath, std::ios::binary | std::ios::ate);
                 if (!(*file)) {
                     Log::logError("Couldn't find file. jinkies.");
                     return 0;